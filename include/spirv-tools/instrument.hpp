@@ -23,8 +23,9 @@
 // communicate with shaders instrumented by passes created by:
 //
 //   CreateInstBindlessCheckPass
+//   CreateInstProfilePass
 //
-// More detailed documentation of this routine can be found in optimizer.hpp
+// More detailed documentation of these routines can be found in optimizer.hpp
 
 namespace spvtools {
 
@@ -130,6 +131,23 @@ static const int kInstErrorBindlessBounds = 0;
 // This is the output buffer written by InstBindlessCheckPass.
 static const int kDebugOutputBindingStream = 0;
 
+// This is the counter buffer written by InstProfilePass.
+static const int kDebugOutputBindingProfile = 1;
+
+// Profile Counter Buffer
+//
+// The counter buffer written by InstProfilePass has the same layout as the
+// debug output buffer. Its first word is not used. The counters start at
+// word kDebugOutputDataOffset, and each is a 32-bit unsigned integer which is
+// atomically incremented each time the block or the edge it counts is
+// executed. The counters must be initialized to zero, and wrap around at
+// 2^32. The shader does not check the size of the buffer, which must hold
+// all the counters.
+//
+// Which block or edge each counter counts is not written by the shader. It
+// is computed again from the module before instrumentation by
+// GetProfileCounterCount and GetProfileBlockCounts in optimizer.hpp.
+
 }  // namespace spvtools
 
 #endif  // INCLUDE_SPIRV_TOOLS_INSTRUMENT_HPP_
@@ -442,6 +442,34 @@ typedef enum {
   spv_validator_limit_max_id_bound,
 } spv_validator_limit;
 
+// Groups of SPIR-V Validator rules that can be disabled when a caller only
+// needs part of the checks. The structural rules (id bounds and
+// SSA form, module layout order, control flow structure, capabilities and
+// type consistency of instructions) are always checked. A disabled group
+// skips both its checks and the bookkeeping they need.
+//
+// Documented profiles:
+// - Structural (spv_validator_rule_group_none): a sanity check of a module
+//   that is known to come from a trusted producer.
+// - Layout (spv_validator_rule_group_decorations): also checks decorations,
+//   block layouts and entry point interfaces, for runtimes that rely on the
+//   module's memory layout.
+// - Full (spv_validator_rule_group_all): the default.
+typedef enum {
+  spv_validator_rule_group_none = 0,
+  // Decoration rules, uniform/storage block layout and interface rules.
+  spv_validator_rule_group_decorations = 0x1,
+  // BuiltIn variable rules.
+  spv_validator_rule_group_builtins = 0x2,
+  // Image, sampler and sampled image rules.
+  spv_validator_rule_group_image = 0x4,
+  // Atomic, barrier, memory semantics and scope rules.
+  spv_validator_rule_group_atomics = 0x8,
+  // Extension and extended instruction set rules.
+  spv_validator_rule_group_extensions = 0x10,
+  spv_validator_rule_group_all = 0x1f,
+} spv_validator_rule_group;
+
 // Returns a string describing the given SPIR-V target environment.
 SPIRV_TOOLS_EXPORT const char* spvTargetEnvDescription(spv_target_env env);
 
@@ -522,6 +550,12 @@ SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetScalarBlockLayout(
 SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetSkipBlockLayout(
     spv_validator_options options, bool val);
 
+// Records the groups of rules the validator checks, as a bitwise OR of
+// spv_validator_rule_group values. The structural rules are always checked.
+// Defaults to spv_validator_rule_group_all.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetRuleGroups(
+    spv_validator_options options, uint32_t groups);
+
 // Creates an optimizer options object with default options. Returns a valid
 // options object. The object remains valid until it is passed into
 // |spvOptimizerOptionsDestroy|.
@@ -16,12 +16,21 @@
 #define INCLUDE_SPIRV_TOOLS_LIBSPIRV_HPP_
 
 #include <functional>
+#include <iosfwd>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "spirv-tools/libspirv.h"
 
+// Records the stream to which the validator reports the resource utilization
+// (CPU/WALL/USR/SYS time, RSS delta and number of calls) of each validation
+// pass, aggregated across all instructions, and of each parsing phase. Passing
+// nullptr disables the report. The report is only produced when the library
+// is built with timers enabled (SPIRV_TIMER_ENABLED).
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetTimeReport(
+    spv_validator_options options, std::ostream* out);
+
 namespace spvtools {
 
 // Message consumer. The C strings for source and message are only alive for the
@@ -110,6 +119,18 @@ class ValidatorOptions {
     spvValidatorOptionsSetRelaxLogicalPointer(options_, val);
   }
 
+  // Sets the groups of rules to check, as a bitwise OR of
+  // spv_validator_rule_group values. See spvValidatorOptionsSetRuleGroups().
+  void SetRuleGroups(uint32_t groups) {
+    spvValidatorOptionsSetRuleGroups(options_, groups);
+  }
+
+  // Reports the resource utilization of each validation pass to |out|. See
+  // spvValidatorOptionsSetTimeReport().
+  void SetTimeReport(std::ostream* out) {
+    spvValidatorOptionsSetTimeReport(options_, out);
+  }
+
  private:
   spv_validator_options options_;
 };
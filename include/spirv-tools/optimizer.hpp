@@ -29,6 +29,16 @@ namespace opt {
 class Pass;
 }
 
+// The execution count of a block in a profile of a module, such as the counts
+// read back from the counters of a module instrumented by
+// CreateInstProfilePass.  The block and its function are identified by their
+// result ids.
+struct ProfileBlockCount {
+  uint32_t function_id;
+  uint32_t block_id;
+  uint64_t count;
+};
+
 // C++ interface for SPIR-V optimization functionalities. It wraps the context
 // (including target environment and the corresponding SPIR-V grammar) and
 // provides methods for registering optimization passes and optimizing.
@@ -194,6 +204,15 @@ class Optimizer {
   // |out| output stream.
   Optimizer& SetTimeReport(std::ostream* out);
 
+  // Sets the execution profile of the modules to optimize to |profile|.  The
+  // counts of the profile are given to the blocks of the module, and guide
+  // the passes which make a tradeoff between hot and cold code: the heuristic
+  // inliner, the automatic loop unroller and if-conversion.  The entries of
+  // the profile for the same block are added up, and the entries for blocks
+  // which are not in the module are ignored.  The profile must come from the
+  // same module, since it is keyed by its ids.
+  Optimizer& SetProfile(const std::vector<ProfileBlockCount>& profile);
+
  private:
   struct Impl;                  // Opaque struct for holding internal data.
   std::unique_ptr<Impl> impl_;  // Unique pointer to internal data.
@@ -307,7 +326,9 @@ Optimizer::PassToken CreateEliminateDeadConstantPass();
 // Creates a strength-reduction pass.
 // A strength-reduction pass will look for opportunities to replace an
 // instruction with an equivalent and less expensive one.  For example,
-// multiplying by a power of 2 can be replaced by a bit shift.
+// multiplying by a power of 2 can be replaced by a bit shift, and the division
+// or remainder of a 32-bit or 64-bit integer by a constant can be replaced by
+// shifts or by a multiplication by the reciprocal of the constant.
 Optimizer::PassToken CreateStrengthReductionPass();
 
 // Creates a block merge pass.
@@ -639,6 +660,9 @@ Optimizer::PassToken CreateCCPPass();
 Optimizer::PassToken CreateWorkaround1209Pass();
 
 // Creates a pass that converts if-then-else like assignments into OpSelect.
+// When the profile given to Optimizer::SetProfile shows that a divergent
+// branch almost always goes the same way, the values computed on its sides
+// are not speculated to replace it.
 Optimizer::PassToken CreateIfConversionPass();
 
 // Creates a pass that will replace instructions that are not valid for the
@@ -717,6 +741,221 @@ Optimizer::PassToken CreateInstBindlessCheckPass(uint32_t desc_set,
 // conform to that model's requirements.
 Optimizer::PassToken CreateUpgradeMemoryModelPass();
 
+// Creates a code sinking pass.
+// This pass moves instructions into the successor of their block that
+// dominates all of their uses, when that successor has no other predecessor.
+// Only instructions without side effects and loads from read-only memory are
+// moved, and only when it lowers the number of values live at the end of
+// their original block, so the register pressure is never increased.
+// Instructions that need implicit derivatives are not moved.
+Optimizer::PassToken CreateCodeSinkingPass();
+
+// Creates a redundant load elimination pass.
+// This pass removes loads from memory of any storage class whose value is
+// already available, either from a store to the same address or from an
+// earlier load of the same address that dominates it, with no instruction in
+// between that may write that memory.  Unlike the local load/store passes, it
+// works across blocks and on Uniform, StorageBuffer and Workgroup memory.
+// Barriers, atomics, function calls, and volatile or coherent accesses are
+// treated as writing memory.
+Optimizer::PassToken CreateRedundantLoadElimPass();
+
+// Creates a dead store elimination pass.
+// This pass removes stores to memory outside of the Function storage class
+// that are always overwritten by another store to the same address before the
+// memory may be read, synchronized, or the function returns.
+Optimizer::PassToken CreateDeadStoreElimPass();
+
+// Creates a range folding pass.
+// This pass computes the range of values of the 32-bit integer and boolean
+// scalars, starting from constants and from the induction variables of loops
+// with a known trip count, and propagating through arithmetic, comparisons and
+// the GLSL.std.450 integer min, max and clamp instructions.  Comparisons whose
+// result is known are replaced by constants, and min, max, clamp, mask and
+// select instructions that always return one of their operands are replaced by
+// that operand.  Branches that become constant are left to dead branch
+// elimination.
+Optimizer::PassToken CreateRangeFoldPass();
+
+// Creates an automatic loop unroller pass.
+// This pass fully or partially unrolls the loops that meet the criteria of
+// LoopUtils::CanPerformUnroll and do not have the DontUnroll flag, choosing for
+// each loop from its trip count, the size of its body and the estimated
+// register pressure of the unrolled loop.  Each function grows by at most
+// |size_budget| instructions.  Loops that never ran in the profile given to
+// Optimizer::SetProfile are not unrolled, unless they have the Unroll flag.
+Optimizer::PassToken CreateLoopUnrollAutoPass(uint32_t size_budget = 1024);
+
+// Creates a heuristic inlining pass.
+// This pass inlines the function calls of the entry point call trees for which
+// the cost model finds it profitable.  A callee is inlined if it is only called
+// once and is not exported, or if its size is below a threshold that grows with
+// the number of constant arguments of the call and with the loop depth of the
+// call site.  The inlining of calls that are not called only once is limited to
+// |size_budget| instructions in total.  Calls passing or returning an opaque
+// type or a pointer are always inlined, as they must be for legalization.
+// Calls to functions with early return in a loop are not inlined.  Calls in
+// blocks that never ran in the profile given to Optimizer::SetProfile are only
+// inlined if they must be, or if they are the only call to their callee.
+Optimizer::PassToken CreateInlineHeuristicPass(uint32_t size_budget = 1024);
+
+// Creates an interprocedural constant propagation pass.
+// This pass walks the entry point call trees, callers first.  When every call
+// to a function that is not visible outside of the module passes the same
+// constant for a parameter, the uses of the parameter are replaced by the
+// constant.  Then, for the combinations of constant arguments shared by the
+// most calls, the function is cloned with the constants substituted for the
+// parameters, and the calls are redirected to the clone.  The clones keep the
+// signature of the original function.  Cloning stops once the clones would add
+// more than |size_budget| instructions to the module.
+//
+// This pass does not fold the code it specializes, nor does it remove the
+// functions whose calls were all redirected to clones.  The --ipcp flag of
+// spirv-opt runs CCP and dead branch elimination after it for the former, and
+// dead function elimination for the latter.
+Optimizer::PassToken CreateIPCPPass(uint32_t size_budget = 1024);
+
+// Creates a function merging pass.
+// This pass finds the functions whose bodies are identical except for the ids
+// they define, and that have the same decorations.  The calls to all but one of
+// them are redirected to the remaining copy, and the other copies are removed.
+// Entry points and exported functions are never removed.  Merging functions can
+// make their callers identical, so the pass repeats until no more functions are
+// merged.
+Optimizer::PassToken CreateMergeFunctionsPass();
+
+// Creates a pass to instrument the module for profiling.
+// This pass adds to every function with a body the atomic increment of
+// counters in a storage buffer, so that the execution count of every block
+// can be known.  If |count_edges| is false, every block has its own counter.
+// Otherwise the edges of the control flow graph are counted, and only those
+// outside of a spanning tree of the graph get a counter, which needs fewer
+// counters.  Edges which can only be counted by splitting them get a new
+// block.  The layout of the counter buffer is described in instrument.hpp.
+// It is in descriptor set |desc_set|.
+//
+// The counters are read back with GetProfileBlockCounts, from the module
+// before instrumentation.  This pass should be run last, after any
+// optimization.
+Optimizer::PassToken CreateInstProfilePass(uint32_t desc_set,
+                                           bool count_edges = false);
+
+// Returns the number of counters that |binary|, for |env|, uses once it is
+// instrumented by CreateInstProfilePass with |count_edges|, or 0 if |binary|
+// cannot be parsed.
+uint32_t GetProfileCounterCount(spv_target_env env,
+                                const std::vector<uint32_t>& binary,
+                                bool count_edges);
+
+// Computes in |counts| the execution count of every block of |binary|, for
+// |env|, from the |counter_count| |counters| written by that module once it
+// is instrumented by CreateInstProfilePass with |count_edges|.  The counters
+// start at word kDebugOutputDataOffset of the counter buffer.  The blocks
+// are identified by the ids of |binary|.  Returns false if |binary| cannot be
+// parsed or if it does not use |counter_count| counters.
+bool GetProfileBlockCounts(spv_target_env env,
+                           const std::vector<uint32_t>& binary,
+                           bool count_edges, const uint32_t* counters,
+                           size_t counter_count,
+                           std::vector<ProfileBlockCount>* counts);
+
+// Returns |profile| in the text format read by ParseProfileText.
+std::string ProfileToText(const std::vector<ProfileBlockCount>& profile);
+
+// Parses the text format of a profile in |text| into |profile|.  Each line of
+// the text gives the execution count of a block as three decimal numbers: the
+// id of the function, the id of the block, and the count.  Empty lines and
+// lines starting with the character '#' are ignored.  Returns false if a line
+// is not in that format.
+bool ParseProfileText(const std::string& text,
+                      std::vector<ProfileBlockCount>* profile);
+
+// Creates a superword-level parallelism vectorization pass.
+// This pass looks in each block for the OpCompositeConstruct of a vector from
+// scalars which are computed by the same arithmetic operation, and replaces
+// them by a single operation on vectors of the type of the construct.  The
+// operands of the vector operation are found the same way, recursively.  The
+// operands which are the components of existing vectors become those
+// vectors, or an OpVectorShuffle of them, and the constant operands become a
+// constant vector.  The others are collected with an OpCompositeConstruct.
+//
+// A tree is only vectorized if the scalar instructions it removes outnumber
+// the vector instructions it adds.  In this count, a construct costs one
+// instruction per component it collects.  The scalar instructions which have
+// other users are kept.
+//
+// The --slp-vectorize flag of spirv-opt runs the vector DCE and simplification
+// passes after this pass, to clean up the extracts left behind.
+Optimizer::PassToken CreateSLPVectorizerPass();
+
+// Creates a loop interchange pass.
+// This pass looks for perfect nests of two loops, where the outer loop only
+// contains the inner loop, and both loops have a single induction variable
+// and a constant trip count.  It swaps the two loops when the memory accesses
+// of the body walk through memory with a smaller stride along the outer loop
+// than along the inner loop, and when the dependence analysis shows that no
+// dependence is reversed by the swap.
+Optimizer::PassToken CreateLoopInterchangePass();
+
+// Creates a loop tiling pass.
+// This pass looks for the same nests as the loop interchange pass, where some
+// memory accesses are contiguous along the inner loop and others along the
+// outer loop, as in a transpose.  It splits the inner loop into tiles of
+// |tile_size| iterations and moves the loop over the tiles out of the outer
+// loop, so that the accesses of both kinds stay within a tile.  The inner loop
+// must count up with a constant step to a constant bound, and its trip count
+// must be a multiple of |tile_size|.
+Optimizer::PassToken CreateLoopTilePass(uint32_t tile_size);
+
+// Creates a jump threading pass.
+// This pass looks for a selection merge block whose conditional branch is
+// decided on incoming edges, because its condition is a phi, or the negation
+// of a phi, of constants.  If it is decided on each incoming edge, each
+// predecessor is branched directly to its target, the block is removed, and
+// the selection construct that ended at the block ends at the merge block of
+// the block instead, so that the control flow stays structured.  The block
+// must contain nothing else, and both of its targets must be taken by some
+// predecessor.
+//
+// If the branch is decided on some edges only, each of those is branched to a
+// copy of its target, or directly to the merge block of the block if that is
+// the target.  The other edges still go through the block, which is given a
+// new merge block in front of the old one.  The targets must be small blocks
+// of straight-line code that only the block enters and that branch to its
+// merge block.
+//
+// Loop headers, merge blocks and continue targets are never threaded, so
+// jumps around the back edge of a loop are left as they are.
+//
+// This pass also copies each small return block reached by unconditional
+// branches from several predecessors into those predecessors.  The copies of
+// targets and return blocks add at most |size_budget| instructions to each
+// function.  A return block left without predecessors is removed, or is
+// replaced by OpUnreachable if it is still the merge block of a construct.
+Optimizer::PassToken CreateJumpThreadingPass(uint32_t size_budget = 64);
+
+// Creates a switch-to-table pass.
+// This pass looks for an OpSwitch on a 32-bit integer whose targets only
+// select constants, either as the incoming values of the phis of the merge
+// block, or as the value each of them stores to the same pointer.  The switch
+// is replaced by a load from a private array of those constants, indexed by
+// the selector minus the smallest case, and a select of the default value
+// when the selector has no case.  Only scalar values are handled, and the
+// cases must cover at least half of an array of at most 64 entries.
+Optimizer::PassToken CreateSwitchToTablePass();
+
+// Creates a partial redundancy elimination pass.
+// This pass numbers the values of each function like the redundancy
+// elimination pass, and walks the dominator tree.  A computation dominated by
+// another of the same value is removed.  A computation whose value is already
+// computed on some of the edges into its block is replaced by a phi, after
+// computing the value at the end of the predecessors where it is missing.
+// Those predecessors must be post-dominated by the block, and be in the same
+// loop, so that no path computes the value more often than before.  No value
+// is made live out of a block that already needs |max_registers| registers.
+Optimizer::PassToken CreatePartialRedundancyEliminationPass(
+    size_t max_registers = 64);
+
 }  // namespace spvtools
 
 #endif  // INCLUDE_SPIRV_TOOLS_OPTIMIZER_HPP_
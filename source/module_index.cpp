@@ -0,0 +1,85 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/module_index.h"
+
+#include <utility>
+
+#include "source/operand.h"
+#include "source/val/basic_block.h"
+#include "source/val/function.h"
+#include "source/val/instruction.h"
+#include "source/val/validation_state.h"
+
+namespace spvtools {
+namespace {
+
+// Fills the flat table |table| and its |offsets| from the (id, entry) pairs in
+// |entries|, keeping the relative order of the entries of each id.
+template <typename T>
+void BuildFlatTable(uint32_t id_bound,
+                    const std::vector<std::pair<uint32_t, T>>& entries,
+                    std::vector<uint32_t>* offsets, std::vector<T>* table) {
+  offsets->assign(id_bound + 1, 0);
+  for (const auto& entry : entries) ++(*offsets)[entry.first + 1];
+  for (uint32_t id = 0; id < id_bound; ++id) {
+    (*offsets)[id + 1] += (*offsets)[id];
+  }
+
+  std::vector<uint32_t> next(offsets->begin(), offsets->end() - 1);
+  table->resize(entries.size());
+  for (const auto& entry : entries) {
+    (*table)[next[entry.first]++] = entry.second;
+  }
+}
+
+}  // namespace
+
+ModuleIndex::ModuleIndex(const val::ValidationState_t& state)
+    : id_bound_(state.getIdBound()) {
+  const auto& insts = state.ordered_instructions();
+  opcodes_.reserve(insts.size());
+  result_ids_.reserve(insts.size());
+  defs_.assign(id_bound_, kNoOrdinal);
+
+  std::vector<std::pair<uint32_t, Use>> uses;
+  for (uint32_t ordinal = 0; ordinal < insts.size(); ++ordinal) {
+    const val::Instruction& inst = insts[ordinal];
+    opcodes_.push_back(inst.opcode());
+    result_ids_.push_back(inst.id());
+    if (inst.id() != 0 && inst.id() < id_bound_) defs_[inst.id()] = ordinal;
+
+    const auto& operands = inst.operands();
+    for (uint32_t i = 0; i < operands.size(); ++i) {
+      const spv_operand_type_t type = operands[i].type;
+      if (!spvIsIdType(type) || type == SPV_OPERAND_TYPE_RESULT_ID) continue;
+      const uint32_t id = inst.word(operands[i].offset);
+      if (id < id_bound_) uses.emplace_back(id, Use{ordinal, i});
+    }
+  }
+  BuildFlatTable(id_bound_, uses, &use_offsets_, &uses_);
+
+  functions_.reserve(state.functions().size());
+  for (const val::Function& function : state.functions()) {
+    functions_.push_back({function.id(), {}});
+    auto& blocks = functions_.back().blocks;
+    blocks.reserve(function.ordered_blocks().size());
+    for (const val::BasicBlock* block : function.ordered_blocks()) {
+      const val::BasicBlock* idom = block->immediate_dominator();
+      blocks.push_back({block->id(), idom ? idom->id() : 0});
+    }
+  }
+}
+
+}  // namespace spvtools
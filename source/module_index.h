@@ -0,0 +1,135 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_MODULE_INDEX_H_
+#define SOURCE_MODULE_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "source/latest_version_spirv_header.h"
+
+namespace spvtools {
+namespace val {
+class ValidationState_t;
+}  // namespace val
+
+// A read-only index of a valid module.  It holds the tables that both the
+// validator and the optimizer compute over a module: a flat definition table,
+// the use lists of each id, and the blocks and immediate dominators of each
+// function.
+//
+// Instructions are identified by their ordinal, i.e. their position in the
+// module binary starting at 0.  Debug line instructions (OpLine, OpNoLine)
+// count as instructions.
+//
+// The index is built from the state of a successful validation run, so a
+// validate-then-optimize pipeline can seed the initial analyses of the
+// optimizer instead of computing them a second time.
+class ModuleIndex {
+ public:
+  // Returned by |def| for ids that have no definition.
+  static const uint32_t kNoOrdinal = ~0u;
+
+  // A use of an id.
+  struct Use {
+    uint32_t user;           // Ordinal of the instruction using the id.
+    uint32_t operand_index;  // Index of the id in the operands of |user|,
+                             // counting the result type and the result id.
+  };
+
+  // A block of a function.
+  struct Block {
+    uint32_t label_id;
+    // The label id of the immediate dominator.  It is |label_id| for the entry
+    // block, and 0 for blocks that are unreachable from the entry block.
+    uint32_t immediate_dominator;
+  };
+
+  // A function and its blocks, in the order they appear in the module.
+  struct Function {
+    uint32_t id;
+    std::vector<Block> blocks;
+  };
+
+  // A contiguous range of entries in one of the flat tables.
+  template <typename T>
+  class Range {
+   public:
+    Range(const T* first, const T* last) : first_(first), last_(last) {}
+
+    const T* begin() const { return first_; }
+    const T* end() const { return last_; }
+    size_t size() const { return static_cast<size_t>(last_ - first_); }
+    bool empty() const { return first_ == last_; }
+
+   private:
+    const T* first_;
+    const T* last_;
+  };
+
+  // Builds the index from the state of a validator run that returned
+  // SPV_SUCCESS.
+  explicit ModuleIndex(const val::ValidationState_t& state);
+
+  ModuleIndex(const ModuleIndex&) = delete;
+  ModuleIndex& operator=(const ModuleIndex&) = delete;
+
+  // Returns the id bound of the module.
+  uint32_t id_bound() const { return id_bound_; }
+
+  // Returns the number of instructions in the module.
+  size_t num_instructions() const { return opcodes_.size(); }
+
+  // Returns the opcode of the instruction at |ordinal|.
+  SpvOp opcode(uint32_t ordinal) const { return opcodes_[ordinal]; }
+
+  // Returns the result id of the instruction at |ordinal|, or 0 if it has
+  // none.
+  uint32_t result_id(uint32_t ordinal) const { return result_ids_[ordinal]; }
+
+  // Returns the ordinal of the instruction defining |id|, or kNoOrdinal.
+  uint32_t def(uint32_t id) const {
+    return id < defs_.size() ? defs_[id] : kNoOrdinal;
+  }
+
+  // Returns the uses of |id|, ordered by user and then by operand index.
+  Range<Use> uses(uint32_t id) const { return Slice(use_offsets_, uses_, id); }
+
+  // Returns the functions of the module, in module order.
+  const std::vector<Function>& functions() const { return functions_; }
+
+ private:
+  // Returns the entries of |table| for |id|, where |offsets| holds the start
+  // of the entries of each id followed by the size of |table|.
+  template <typename T>
+  static Range<T> Slice(const std::vector<uint32_t>& offsets,
+                        const std::vector<T>& table, uint32_t id) {
+    if (id + 1 >= offsets.size()) return Range<T>(nullptr, nullptr);
+    return Range<T>(table.data() + offsets[id], table.data() + offsets[id + 1]);
+  }
+
+  uint32_t id_bound_;
+  std::vector<SpvOp> opcodes_;
+  std::vector<uint32_t> result_ids_;
+  std::vector<uint32_t> defs_;
+  std::vector<uint32_t> use_offsets_;
+  std::vector<Use> uses_;
+  std::vector<Function> functions_;
+};
+
+}  // namespace spvtools
+
+#endif  // SOURCE_MODULE_INDEX_H_
@@ -0,0 +1,190 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/alias_analysis.h"
+
+#include <algorithm>
+
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+const uint32_t kTypePointerStorageClassInIdx = 0;
+const uint32_t kDecorationValueInIdx = 2;
+
+// Returns the value of |inst| if it is a scalar integer OpConstant of at most
+// 64 bits.  Returns false otherwise.
+bool GetConstantValue(const Instruction* inst, uint64_t* value) {
+  if (inst == nullptr || inst->opcode() != SpvOpConstant) return false;
+  const Operand& operand = inst->GetInOperand(0);
+  if (operand.words.size() == 1) {
+    *value = operand.words[0];
+    return true;
+  }
+  if (operand.words.size() == 2) {
+    *value = static_cast<uint64_t>(operand.words[1]) << 32 | operand.words[0];
+    return true;
+  }
+  return false;
+}
+}  // namespace
+
+AliasAnalysis::AliasAnalysis(IRContext* context)
+    : context_(context), logical_addressing_(true) {
+  const Instruction* memory_model = context_->module()->GetMemoryModel();
+  if (memory_model != nullptr) {
+    logical_addressing_ =
+        memory_model->GetSingleWordInOperand(0) == SpvAddressingModelLogical;
+  }
+}
+
+AliasAnalysis::AliasResult AliasAnalysis::Alias(uint32_t a, uint32_t b) const {
+  if (a == b) return AliasResult::kMustAlias;
+
+  uint32_t storage_class_a = GetStorageClass(a);
+  uint32_t storage_class_b = GetStorageClass(b);
+  if (storage_class_a != storage_class_b &&
+      storage_class_a != SpvStorageClassGeneric &&
+      storage_class_b != SpvStorageClassGeneric) {
+    return AliasResult::kNoAlias;
+  }
+
+  ValueNumberTable* vn_table = context_->GetValueNumberTable();
+  uint32_t value_a = vn_table->GetValueNumber(a);
+  if (value_a != 0 && value_a == vn_table->GetValueNumber(b)) {
+    return AliasResult::kMustAlias;
+  }
+
+  std::vector<uint32_t> indexes_a;
+  std::vector<uint32_t> indexes_b;
+  Instruction* root_a = GetAccessPath(a, &indexes_a);
+  Instruction* root_b = GetAccessPath(b, &indexes_b);
+  if (root_a != root_b) {
+    return RootsMayAlias(root_a, root_b) ? AliasResult::kMayAlias
+                                         : AliasResult::kNoAlias;
+  }
+
+  // Both pointers are derived from the same pointer.  They point to disjoint
+  // memory if they select different elements at some level.
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  size_t depth = std::min(indexes_a.size(), indexes_b.size());
+  for (size_t i = 0; i < depth; ++i) {
+    if (indexes_a[i] == indexes_b[i]) continue;
+    uint64_t index_a = 0;
+    uint64_t index_b = 0;
+    if (!GetConstantValue(def_use_mgr->GetDef(indexes_a[i]), &index_a) ||
+        !GetConstantValue(def_use_mgr->GetDef(indexes_b[i]), &index_b)) {
+      return AliasResult::kMayAlias;
+    }
+    if (index_a != index_b) return AliasResult::kNoAlias;
+  }
+
+  // One pointer points into the memory of the other if their paths have
+  // different lengths.
+  return indexes_a.size() == indexes_b.size() ? AliasResult::kMustAlias
+                                              : AliasResult::kMayAlias;
+}
+
+uint32_t AliasAnalysis::GetStorageClass(uint32_t pointer_id) const {
+  if (!logical_addressing_) return SpvStorageClassGeneric;
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  Instruction* pointer = def_use_mgr->GetDef(pointer_id);
+  Instruction* type = def_use_mgr->GetDef(pointer->type_id());
+  if (type == nullptr || type->opcode() != SpvOpTypePointer) {
+    return SpvStorageClassGeneric;
+  }
+  return type->GetSingleWordInOperand(kTypePointerStorageClassInIdx);
+}
+
+Instruction* AliasAnalysis::GetAccessPath(
+    uint32_t pointer_id, std::vector<uint32_t>* indexes) const {
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  Instruction* inst = def_use_mgr->GetDef(pointer_id);
+  std::vector<Instruction*> chains;
+  for (;;) {
+    if (inst->opcode() == SpvOpAccessChain ||
+        inst->opcode() == SpvOpInBoundsAccessChain) {
+      chains.push_back(inst);
+    } else if (inst->opcode() != SpvOpCopyObject) {
+      break;
+    }
+    inst = def_use_mgr->GetDef(inst->GetSingleWordInOperand(0));
+  }
+
+  if (indexes != nullptr) {
+    for (auto it = chains.rbegin(); it != chains.rend(); ++it) {
+      for (uint32_t i = 1; i < (*it)->NumInOperands(); ++i) {
+        indexes->push_back((*it)->GetSingleWordInOperand(i));
+      }
+    }
+  }
+  return inst;
+}
+
+bool AliasAnalysis::RootsMayAlias(Instruction* root_a,
+                                  Instruction* root_b) const {
+  auto is_declaration = [](Instruction* inst) {
+    return inst->opcode() == SpvOpVariable ||
+           inst->opcode() == SpvOpFunctionParameter;
+  };
+
+  // A Restrict declaration is the only way to access its memory.
+  if ((is_declaration(root_a) &&
+       HasDecoration(root_a->result_id(), SpvDecorationRestrict)) ||
+      (is_declaration(root_b) &&
+       HasDecoration(root_b->result_id(), SpvDecorationRestrict))) {
+    return false;
+  }
+
+  // Function parameters may point into any object of the caller, and other
+  // pointers, such as variable pointers, cannot be traced.
+  if (root_a->opcode() != SpvOpVariable || root_b->opcode() != SpvOpVariable) {
+    return true;
+  }
+  if (HaveSameBinding(root_a, root_b)) return true;
+  return HasDecoration(root_a->result_id(), SpvDecorationAliased) &&
+         HasDecoration(root_b->result_id(), SpvDecorationAliased);
+}
+
+bool AliasAnalysis::HasDecoration(uint32_t id, uint32_t decoration) const {
+  return !context_->get_decoration_mgr()->WhileEachDecoration(
+      id, decoration, [](const Instruction&) { return false; });
+}
+
+bool AliasAnalysis::HaveSameBinding(Instruction* a, Instruction* b) const {
+  analysis::DecorationManager* decoration_mgr = context_->get_decoration_mgr();
+  auto get_value = [decoration_mgr](Instruction* var, uint32_t decoration,
+                                    uint32_t* value) {
+    return !decoration_mgr->WhileEachDecoration(
+        var->result_id(), decoration, [value](const Instruction& inst) {
+          *value = inst.GetSingleWordInOperand(kDecorationValueInIdx);
+          return false;
+        });
+  };
+
+  uint32_t set_a = 0;
+  uint32_t set_b = 0;
+  uint32_t binding_a = 0;
+  uint32_t binding_b = 0;
+  return get_value(a, SpvDecorationDescriptorSet, &set_a) &&
+         get_value(b, SpvDecorationDescriptorSet, &set_b) &&
+         get_value(a, SpvDecorationBinding, &binding_a) &&
+         get_value(b, SpvDecorationBinding, &binding_b) && set_a == set_b &&
+         binding_a == binding_b;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,95 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_ALIAS_ANALYSIS_H_
+#define SOURCE_OPT_ALIAS_ANALYSIS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "source/opt/instruction.h"
+
+namespace spvtools {
+namespace opt {
+
+class IRContext;
+
+// Answers whether two pointers may point to overlapping memory.
+//
+// Pointers into different storage classes never alias.  Otherwise a pointer is
+// traced back through its access chains to the memory object it points into.
+// Pointers into the same object alias unless a constant index selects
+// different elements at some level.  Distinct memory object declarations are
+// assumed not to alias, as allowed by the Logical addressing model, unless both
+// are decorated Aliased or they are bound to the same descriptor set and
+// binding.  A declaration decorated Restrict never aliases another one.  When
+// the object cannot be found, for instance for a function parameter or a
+// pointer loaded from memory, the pointers may alias.
+class AliasAnalysis {
+ public:
+  enum class AliasResult {
+    kNoAlias,    // The pointers never point to overlapping memory.
+    kMayAlias,   // The pointers may point to overlapping memory.
+    kMustAlias,  // The pointers always point to the same memory.
+  };
+
+  explicit AliasAnalysis(IRContext* context);
+
+  AliasAnalysis(const AliasAnalysis&) = delete;
+  AliasAnalysis& operator=(const AliasAnalysis&) = delete;
+
+  // Returns how the memory pointed to by the pointers |a| and |b| overlaps.
+  AliasResult Alias(uint32_t a, uint32_t b) const;
+
+  // Returns true if the pointers |a| and |b| may point to overlapping memory.
+  bool MayAlias(uint32_t a, uint32_t b) const {
+    return Alias(a, b) != AliasResult::kNoAlias;
+  }
+
+  // Returns true if the pointers |a| and |b| always point to the same memory.
+  bool MustAlias(uint32_t a, uint32_t b) const {
+    return Alias(a, b) == AliasResult::kMustAlias;
+  }
+
+  // Returns the storage class of the memory pointed to by |pointer_id|.  All
+  // memory is in the Generic storage class when the addressing model is not
+  // Logical.
+  uint32_t GetStorageClass(uint32_t pointer_id) const;
+
+  // Returns the instruction defining the pointer that |pointer_id| is derived
+  // from through access chains and copies.  If |indexes| is not nullptr, the
+  // indexes applied to that pointer are appended to it, outermost first.
+  Instruction* GetAccessPath(uint32_t pointer_id,
+                             std::vector<uint32_t>* indexes) const;
+
+ private:
+  // Returns true if the memory pointed to by the distinct |root_a| and
+  // |root_b| may overlap.
+  bool RootsMayAlias(Instruction* root_a, Instruction* root_b) const;
+
+  // Returns true if |id| is decorated with |decoration|.
+  bool HasDecoration(uint32_t id, uint32_t decoration) const;
+
+  // Returns true if the variables |a| and |b| have the same descriptor set and
+  // binding.
+  bool HaveSameBinding(Instruction* a, Instruction* b) const;
+
+  IRContext* context_;
+  bool logical_addressing_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_ALIAS_ANALYSIS_H_
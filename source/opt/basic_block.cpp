@@ -39,6 +39,7 @@ BasicBlock* BasicBlock::Clone(IRContext* context) const {
     // Use the incoming context
     clone->AddInstruction(std::unique_ptr<Instruction>(inst.Clone(context)));
   }
+  if (has_profile_count_) clone->SetProfileCount(profile_count_);
 
   if (context->AreAnalysesValid(
           IRContext::Analysis::kAnalysisInstrToBlockMapping)) {
@@ -65,6 +65,21 @@ class BasicBlock {
   // Return the enclosing function
   inline Function* GetParent() const { return function_; }
 
+  // Returns true if the execution count of this block is known from a
+  // profile.  Blocks created by the optimizer have no count, except for the
+  // clones of a block with a count, which have the same count.
+  bool HasProfileCount() const { return has_profile_count_; }
+
+  // Returns the execution count of this block from a profile.  Only valid if
+  // HasProfileCount() is true.
+  uint64_t profile_count() const { return profile_count_; }
+
+  // Sets the execution count of this block from a profile to |count|.
+  void SetProfileCount(uint64_t count) {
+    profile_count_ = count;
+    has_profile_count_ = true;
+  }
+
   // Appends an instruction to this basic block.
   inline void AddInstruction(std::unique_ptr<Instruction> i);
 
@@ -227,13 +242,20 @@ class BasicBlock {
   std::unique_ptr<Instruction> label_;
   // Instructions inside this basic block, but not the OpLabel.
   InstructionList insts_;
+  // True if |profile_count_| is the execution count of this block from a
+  // profile.
+  bool has_profile_count_;
+  uint64_t profile_count_;
 };
 
 // Pretty-prints |block| to |str|. Returns |str|.
 std::ostream& operator<<(std::ostream& str, const BasicBlock& block);
 
 inline BasicBlock::BasicBlock(std::unique_ptr<Instruction> label)
-    : function_(nullptr), label_(std::move(label)) {}
+    : function_(nullptr),
+      label_(std::move(label)),
+      has_profile_count_(false),
+      profile_count_(0) {}
 
 inline void BasicBlock::AddInstruction(std::unique_ptr<Instruction> i) {
   insts_.push_back(std::move(i));
@@ -0,0 +1,281 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/code_sink.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/reflect.h"
+#include "source/opt/register_pressure.h"
+#include "spirv/1.2/GLSL.std.450.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+const uint32_t kLoadMemoryAccessInIdx = 1;
+
+// Returns true if |inst| holds a value in a register.  This mirrors the
+// definition used by the register liveness analysis.
+bool CreatesRegisterUsage(Instruction* inst) {
+  if (!inst->HasResultId()) return false;
+  if (inst->opcode() == SpvOpUndef) return false;
+  if (IsConstantInst(inst->opcode())) return false;
+  if (inst->opcode() == SpvOpLabel) return false;
+  return true;
+}
+
+// Returns true if the result of |opcode| depends on the control flow that
+// reaches it, through implicit derivatives, or if it must stay in the block
+// of the instructions it feeds.
+bool DependsOnPosition(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpSampledImage:
+    case SpvOpImage:
+    case SpvOpImageTexelPointer:
+    case SpvOpImageRead:
+    case SpvOpImageSampleImplicitLod:
+    case SpvOpImageSampleDrefImplicitLod:
+    case SpvOpImageSampleProjImplicitLod:
+    case SpvOpImageSampleProjDrefImplicitLod:
+    case SpvOpImageSparseSampleImplicitLod:
+    case SpvOpImageSparseSampleDrefImplicitLod:
+    case SpvOpImageSparseSampleProjImplicitLod:
+    case SpvOpImageSparseSampleProjDrefImplicitLod:
+    case SpvOpImageQueryLod:
+    case SpvOpDPdx:
+    case SpvOpDPdy:
+    case SpvOpFwidth:
+    case SpvOpDPdxFine:
+    case SpvOpDPdyFine:
+    case SpvOpFwidthFine:
+    case SpvOpDPdxCoarse:
+    case SpvOpDPdyCoarse:
+    case SpvOpFwidthCoarse:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+Pass::Status CodeSinkingPass::Process() {
+  bool modified = false;
+  for (Function& function : *get_module()) {
+    modified |= SinkInstructionsInFunction(&function);
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+bool CodeSinkingPass::SinkInstructionsInFunction(Function* function) {
+  if (function->begin() == function->end()) return false;
+
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(function);
+  const RegisterLiveness* liveness =
+      context()->GetLivenessAnalysis()->Get(function);
+
+  // Blocks are visited in dominator tree order, so an instruction sunk into a
+  // block can be sunk again when that block is visited.  Moving instructions
+  // from a block into a successor whose only predecessor is that block does
+  // not change the values live out of any other block.
+  bool modified = false;
+  for (DominatorTreeNode& node : dom->GetDomTree()) {
+    const RegisterLiveness::RegionRegisterLiveness* bb_liveness =
+        liveness->Get(node.bb_);
+    if (bb_liveness == nullptr) continue;
+    LiveSet live_out = bb_liveness->live_out_;
+    modified |= SinkInstructionsInBlock(node.bb_, dom, &live_out);
+  }
+  return modified;
+}
+
+bool CodeSinkingPass::SinkInstructionsInBlock(BasicBlock* bb,
+                                              DominatorAnalysis* dom,
+                                              LiveSet* live_out) {
+  std::vector<Instruction*> insts;
+  bb->ForEachInst([&insts](Instruction* inst) {
+    if (inst->opcode() == SpvOpPhi || IsDebugLineInst(inst->opcode())) return;
+    insts.push_back(inst);
+  });
+
+  bool modified = false;
+  std::unordered_set<Instruction*> moved;
+  for (auto it = insts.rbegin(); it != insts.rend(); ++it) {
+    Instruction* candidate = *it;
+    if (moved.count(candidate) || !IsSinkable(candidate)) continue;
+
+    BasicBlock* target = FindSinkTarget(candidate, bb, dom);
+    if (target == nullptr) continue;
+
+    // Collect the operands of the candidate that are defined in |bb| and are
+    // only needed once the candidate is sunk.  They move with it, so that
+    // sinking a chain of instructions is evaluated as a whole.
+    std::unordered_set<Instruction*> group = {candidate};
+    std::unordered_set<uint32_t> wanted;
+    candidate->ForEachInId(
+        [&wanted](const uint32_t* id) { wanted.insert(*id); });
+    for (auto op_it = it + 1; op_it != insts.rend(); ++op_it) {
+      Instruction* inst = *op_it;
+      if (!wanted.count(inst->result_id()) || moved.count(inst)) continue;
+      if (!IsSinkable(inst) || !UsesAreDominatedBy(inst, target, group, dom)) {
+        continue;
+      }
+      group.insert(inst);
+      inst->ForEachInId([&wanted](const uint32_t* id) { wanted.insert(*id); });
+    }
+
+    // The values of the group that are live out of |bb| stop being live out of
+    // it, and the operands the group reads from outside of it start being live
+    // out of it.  Only sink if that lowers the number of live values.  The
+    // pressure in |target| does not grow: its live-in set changes by the same
+    // amount, and is unchanged after the group.
+    size_t removed = 0;
+    for (Instruction* inst : group) removed += live_out->count(inst);
+    // Values defined outside of functions, such as global variables, are not
+    // counted.
+    std::unordered_set<Instruction*> added;
+    for (Instruction* inst : group) {
+      inst->ForEachInId([this, &group, &added, live_out](const uint32_t* id) {
+        Instruction* def = get_def_use_mgr()->GetDef(*id);
+        if (!CreatesRegisterUsage(def) || group.count(def) ||
+            live_out->count(def) || IsGlobalValue(def)) {
+          return;
+        }
+        added.insert(def);
+      });
+    }
+    if (added.size() >= removed) continue;
+
+    std::vector<Instruction*> ordered;
+    for (Instruction* inst : insts) {
+      if (group.count(inst)) ordered.push_back(inst);
+    }
+    MoveInstructions(ordered, target);
+    for (Instruction* inst : group) {
+      moved.insert(inst);
+      live_out->erase(inst);
+    }
+    live_out->insert(added.begin(), added.end());
+    modified = true;
+  }
+  return modified;
+}
+
+BasicBlock* CodeSinkingPass::FindSinkTarget(Instruction* inst, BasicBlock* bb,
+                                            DominatorAnalysis* dom) {
+  std::vector<BasicBlock*> use_blocks;
+  bool used_in_bb = false;
+  get_def_use_mgr()->ForEachUse(
+      inst, [this, bb, &use_blocks, &used_in_bb](Instruction* user,
+                                                 uint32_t index) {
+        BasicBlock* use_block = GetUseBlock(user, index);
+        if (use_block == nullptr) return;
+        if (use_block == bb) used_in_bb = true;
+        use_blocks.push_back(use_block);
+      });
+  if (used_in_bb || use_blocks.empty()) return nullptr;
+
+  BasicBlock* target = nullptr;
+  bb->ForEachSuccessorLabel([this, bb, dom, &use_blocks,
+                             &target](const uint32_t label_id) {
+    if (target != nullptr || label_id == bb->id()) return;
+    if (cfg()->preds(label_id).size() != 1) return;
+    BasicBlock* succ = cfg()->block(label_id);
+    if (std::all_of(use_blocks.begin(), use_blocks.end(),
+                    [dom, succ](BasicBlock* use_block) {
+                      return dom->Dominates(succ, use_block);
+                    })) {
+      target = succ;
+    }
+  });
+  return target;
+}
+
+bool CodeSinkingPass::UsesAreDominatedBy(
+    Instruction* inst, BasicBlock* target,
+    const std::unordered_set<Instruction*>& group, DominatorAnalysis* dom) {
+  return get_def_use_mgr()->WhileEachUse(
+      inst, [this, target, &group, dom](Instruction* user, uint32_t index) {
+        if (group.count(user)) return true;
+        BasicBlock* use_block = GetUseBlock(user, index);
+        return use_block == nullptr || dom->Dominates(target, use_block);
+      });
+}
+
+BasicBlock* CodeSinkingPass::GetUseBlock(Instruction* user, uint32_t index) {
+  if (user->opcode() == SpvOpPhi) {
+    return cfg()->block(user->GetSingleWordOperand(index + 1));
+  }
+  // Uses outside of functions, such as names and decorations, do not constrain
+  // where the value is computed.
+  return context()->get_instr_block(user);
+}
+
+bool CodeSinkingPass::IsGlobalValue(Instruction* inst) {
+  return inst->opcode() != SpvOpFunctionParameter &&
+         context()->get_instr_block(inst) == nullptr;
+}
+
+bool CodeSinkingPass::IsSinkable(Instruction* inst) {
+  if (!CreatesRegisterUsage(inst)) return false;
+  if (inst->opcode() == SpvOpLoad) {
+    if (!inst->IsReadOnlyLoad()) return false;
+    if (inst->NumInOperands() > kLoadMemoryAccessInIdx &&
+        (inst->GetSingleWordInOperand(kLoadMemoryAccessInIdx) &
+         SpvMemoryAccessVolatileMask)) {
+      return false;
+    }
+    return true;
+  }
+  if (inst->opcode() == SpvOpPhi || inst->opcode() == SpvOpVariable ||
+      DependsOnPosition(inst->opcode())) {
+    return false;
+  }
+  if (!context()->IsCombinatorInstruction(inst)) return false;
+
+  // Extended instructions that need implicit derivatives, such as the GLSL
+  // InterpolateAt* instructions, are combinators but must not be moved into
+  // non-uniform control flow.
+  if (inst->opcode() == SpvOpExtInst &&
+      inst->GetSingleWordInOperand(0) ==
+          context()->get_feature_mgr()->GetExtInstImportId_GLSLstd450()) {
+    uint32_t ext_opcode = inst->GetSingleWordInOperand(1);
+    if (ext_opcode == GLSLstd450InterpolateAtCentroid ||
+        ext_opcode == GLSLstd450InterpolateAtSample ||
+        ext_opcode == GLSLstd450InterpolateAtOffset) {
+      return false;
+    }
+  }
+
+  // An OpSampledImage must be in the same block as the instructions using it.
+  return inst->WhileEachInId([this](const uint32_t* id) {
+    Instruction* def = get_def_use_mgr()->GetDef(*id);
+    return def == nullptr || def->opcode() != SpvOpSampledImage;
+  });
+}
+
+void CodeSinkingPass::MoveInstructions(const std::vector<Instruction*>& group,
+                                       BasicBlock* target) {
+  auto insert_point = target->begin();
+  while (insert_point->opcode() == SpvOpPhi) ++insert_point;
+  for (Instruction* inst : group) {
+    inst->InsertBefore(&*insert_point);
+    context()->set_instr_block(inst, target);
+  }
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,91 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_CODE_SINK_H_
+#define SOURCE_OPT_CODE_SINK_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/dominator_analysis.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/module.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class CodeSinkingPass : public Pass {
+ public:
+  const char* name() const override { return "code-sink"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  using LiveSet = std::unordered_set<Instruction*>;
+
+  // Sinks the instructions of every block of |function|.  Returns true if the
+  // function was modified.
+  bool SinkInstructionsInFunction(Function* function);
+
+  // Sinks instructions defined in |bb| into successors of |bb| when that
+  // lowers the number of values live out of |bb|.  |live_out| holds the values
+  // live out of |bb|, and is updated as instructions are moved.  Returns true
+  // if an instruction was moved.
+  bool SinkInstructionsInBlock(BasicBlock* bb, DominatorAnalysis* dom,
+                               LiveSet* live_out);
+
+  // Returns the successor of |bb| that dominates every use of |inst|, and whose
+  // only predecessor is |bb|.  Returns nullptr if there is none, or if |inst|
+  // is used in |bb|.
+  BasicBlock* FindSinkTarget(Instruction* inst, BasicBlock* bb,
+                             DominatorAnalysis* dom);
+
+  // Returns true if all of the uses of |inst| are either instructions in
+  // |group|, or in blocks dominated by |target|.
+  bool UsesAreDominatedBy(Instruction* inst, BasicBlock* target,
+                          const std::unordered_set<Instruction*>& group,
+                          DominatorAnalysis* dom);
+
+  // Returns the block in which the value of |inst| is used by the operand
+  // |index| of |user|.  For an OpPhi this is the incoming block of the value.
+  BasicBlock* GetUseBlock(Instruction* user, uint32_t index);
+
+  // Returns true if |inst| is defined outside of the functions of the module.
+  bool IsGlobalValue(Instruction* inst);
+
+  // Returns true if |inst| has no side effects and can be executed later
+  // without changing its result: combinators that do not need implicit
+  // derivatives, and loads from read-only storage.
+  bool IsSinkable(Instruction* inst);
+
+  // Moves the instructions in |group| to the start of |target|, after its
+  // OpPhi instructions, keeping their relative order.
+  void MoveInstructions(const std::vector<Instruction*>& group,
+                        BasicBlock* target);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_CODE_SINK_H_
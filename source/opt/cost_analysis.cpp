@@ -0,0 +1,401 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/cost_analysis.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <list>
+#include <sstream>
+
+#include "source/opcode.h"
+#include "source/opt/register_pressure.h"
+#include "source/opt/scalar_analysis.h"
+#include "source/table.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kEntryPointExecutionModelInIdx = 0;
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+const uint32_t kEntryPointNameInIdx = 2;
+const uint32_t kFunctionCallFunctionIdInIdx = 0;
+const uint32_t kBranchConditionalFirstWeightInIdx = 3;
+
+// Returns the number of iterations of a loop whose induction variable starts
+// at |init|, is increased by |step| at each iteration, and whose loop
+// continues while the comparison |opcode| of the variable with |bound| holds.
+// Returns -1 if the loop does not terminate.
+int64_t CountIterations(SpvOp opcode, int64_t init, int64_t step,
+                        int64_t bound) {
+  switch (opcode) {
+    case SpvOpSLessThanEqual:
+    case SpvOpULessThanEqual:
+      ++bound;
+      // Fall through.
+    case SpvOpSLessThan:
+    case SpvOpULessThan:
+      if (init >= bound) return 0;
+      if (step <= 0) return -1;
+      return (bound - init + step - 1) / step;
+    case SpvOpSGreaterThanEqual:
+    case SpvOpUGreaterThanEqual:
+      --bound;
+      // Fall through.
+    case SpvOpSGreaterThan:
+    case SpvOpUGreaterThan:
+      if (init <= bound) return 0;
+      if (step >= 0) return -1;
+      return (init - bound - step - 1) / -step;
+    default:
+      return -1;
+  }
+}
+
+}  // anonymous namespace
+
+CostTable::CostTable() : default_cost_({4, 1}) {
+  // Instructions that do not execute.
+  for (SpvOp opcode :
+       {SpvOpNop, SpvOpLabel, SpvOpPhi, SpvOpSelectionMerge, SpvOpLoopMerge,
+        SpvOpLine, SpvOpNoLine, SpvOpUndef, SpvOpVariable}) {
+    costs_[opcode] = {0, 0};
+  }
+  for (SpvOp opcode :
+       {SpvOpBranch, SpvOpBranchConditional, SpvOpSwitch, SpvOpReturn,
+        SpvOpReturnValue, SpvOpKill, SpvOpUnreachable}) {
+    costs_[opcode] = {0, 1};
+  }
+  costs_[SpvOpFunctionCall] = {0, 2};
+
+  // Arithmetic that is slower than the default.
+  for (SpvOp opcode : {SpvOpMatrixTimesScalar, SpvOpVectorTimesMatrix,
+                       SpvOpMatrixTimesVector, SpvOpMatrixTimesMatrix,
+                       SpvOpOuterProduct}) {
+    costs_[opcode] = {8, 4};
+  }
+  for (SpvOp opcode : {SpvOpFDiv, SpvOpFRem, SpvOpFMod, SpvOpExtInst}) {
+    costs_[opcode] = {16, 4};
+  }
+  for (SpvOp opcode :
+       {SpvOpSDiv, SpvOpUDiv, SpvOpSRem, SpvOpSMod, SpvOpUMod}) {
+    costs_[opcode] = {32, 8};
+  }
+
+  // Memory and images.
+  costs_[SpvOpLoad] = {20, 1};
+  costs_[SpvOpStore] = {1, 1};
+  for (SpvOp opcode :
+       {SpvOpImageSampleImplicitLod, SpvOpImageSampleExplicitLod,
+        SpvOpImageSampleDrefImplicitLod, SpvOpImageSampleDrefExplicitLod,
+        SpvOpImageSampleProjImplicitLod, SpvOpImageSampleProjExplicitLod,
+        SpvOpImageSampleProjDrefImplicitLod,
+        SpvOpImageSampleProjDrefExplicitLod, SpvOpImageFetch,
+        SpvOpImageGather, SpvOpImageDrefGather, SpvOpImageRead}) {
+    costs_[opcode] = {200, 4};
+  }
+  costs_[SpvOpImageWrite] = {1, 4};
+}
+
+const OpcodeCost& CostTable::GetCost(SpvOp opcode) const {
+  auto it = costs_.find(opcode);
+  return it != costs_.end() ? it->second : default_cost_;
+}
+
+bool CostTable::ParseText(const std::string& text, std::string* error) {
+  spv_opcode_table opcode_table = nullptr;
+  spvOpcodeTableGet(&opcode_table, SPV_ENV_UNIVERSAL_1_3);
+
+  std::istringstream lines(text);
+  std::string line;
+  for (uint32_t line_number = 1; std::getline(lines, line); ++line_number) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string name;
+    if (!(fields >> name)) continue;
+
+    OpcodeCost cost;
+    std::string extra;
+    if (!(fields >> cost.latency >> cost.issue) || fields >> extra ||
+        cost.latency < 0 || cost.issue < 0) {
+      *error = "line " + std::to_string(line_number) +
+               ": expected an opcode followed by two non-negative numbers";
+      return false;
+    }
+    if (name == "default") {
+      default_cost_ = cost;
+      continue;
+    }
+    if (name.compare(0, 2, "Op") == 0) name = name.substr(2);
+    spv_opcode_desc entry = nullptr;
+    if (spvOpcodeTableNameLookup(SPV_ENV_UNIVERSAL_1_3, opcode_table,
+                                 name.c_str(), &entry) != SPV_SUCCESS) {
+      *error = "line " + std::to_string(line_number) + ": unknown opcode Op" +
+               name;
+      return false;
+    }
+    costs_[entry->opcode] = cost;
+  }
+  return true;
+}
+
+void CostAnalysis::SetProfile(const std::vector<ProfileBlockCount>& profile) {
+  profile_.clear();
+  for (const ProfileBlockCount& count : profile) {
+    profile_[count.function_id][count.block_id] += count.count;
+  }
+  function_costs_.clear();
+}
+
+std::vector<EntryPointCost> CostAnalysis::EstimateEntryPoints() {
+  std::vector<EntryPointCost> costs;
+  for (auto& entry_point : context_->module()->entry_points()) {
+    Function* func = context_->GetFunction(
+        entry_point.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+    if (func == nullptr) continue;
+    EntryPointCost cost;
+    cost.name = reinterpret_cast<const char*>(
+        entry_point.GetInOperand(kEntryPointNameInIdx).words.data());
+    cost.execution_model = static_cast<SpvExecutionModel>(
+        entry_point.GetSingleWordInOperand(kEntryPointExecutionModelInIdx));
+    cost.function_id = func->result_id();
+    cost.cycles = GetFunctionCost(func);
+    cost.max_registers = GetMaxRegisters(func);
+    costs.push_back(cost);
+  }
+  return costs;
+}
+
+double CostAnalysis::GetFunctionCost(Function* func) {
+  auto it = function_costs_.find(func->result_id());
+  if (it != function_costs_.end()) return it->second;
+  // Recursion is not allowed, but guard against it in invalid modules.
+  function_costs_[func->result_id()] = 0;
+
+  const RegisterLiveness* liveness =
+      context_->GetLivenessAnalysis()->Get(func);
+  std::unordered_map<uint32_t, double> frequencies = GetBlockFrequencies(func);
+  double cycles = 0;
+  for (auto& bb : *func) {
+    auto frequency_it = frequencies.find(bb.id());
+    if (frequency_it == frequencies.end() || frequency_it->second == 0)
+      continue;
+    double block_cycles = GetBlockCost(&bb);
+    const RegisterLiveness::RegionRegisterLiveness* bb_liveness =
+        liveness->Get(&bb);
+    if (bb_liveness != nullptr &&
+        bb_liveness->used_registers_ > options_.register_budget) {
+      block_cycles += options_.spill_cost * (bb_liveness->used_registers_ -
+                                             options_.register_budget);
+    }
+    cycles += frequency_it->second * block_cycles;
+  }
+  function_costs_[func->result_id()] = cycles;
+  return cycles;
+}
+
+std::unordered_map<uint32_t, double> CostAnalysis::GetBlockFrequencies(
+    Function* func) {
+  std::unordered_map<uint32_t, double> frequencies;
+  if (func->begin() == func->end()) return frequencies;
+
+  // A profile gives the frequencies directly.
+  auto profile_it = profile_.find(func->result_id());
+  if (profile_it != profile_.end()) {
+    const auto& counts = profile_it->second;
+    auto entry_it = counts.find(func->entry()->id());
+    if (entry_it != counts.end() && entry_it->second != 0) {
+      for (auto& bb : *func) {
+        auto count_it = counts.find(bb.id());
+        frequencies[bb.id()] =
+            count_it != counts.end()
+                ? static_cast<double>(count_it->second) / entry_it->second
+                : 0;
+      }
+      return frequencies;
+    }
+  }
+
+  // Otherwise propagate the frequencies forward in structured order, which
+  // visits the predecessors of a block before it, except along back edges.
+  const LoopDescriptor& loops = *context_->GetLoopDescriptor(func);
+  std::list<BasicBlock*> order;
+  context_->cfg()->ComputeStructuredOrder(func, &*func->begin(), &order);
+  frequencies[func->entry()->id()] = 1;
+  for (BasicBlock* bb : order) {
+    Loop* loop = loops[bb];
+    double frequency = frequencies[bb->id()];
+    if (loop != nullptr && loop->GetHeaderBlock() == bb) {
+      frequency *= GetTripCount(loop);
+      frequencies[bb->id()] = frequency;
+    }
+    for (const auto& successor : GetSuccessorProbabilities(bb, loops)) {
+      Loop* succ_loop = loops[successor.first];
+      if (succ_loop != nullptr &&
+          succ_loop->GetHeaderBlock()->id() == successor.first &&
+          succ_loop->IsInsideLoop(bb)) {
+        continue;
+      }
+      double edge_frequency = frequency * successor.second;
+      for (Loop* l = loop; l != nullptr && !l->IsInsideLoop(successor.first);
+           l = l->GetParent()) {
+        edge_frequency /= GetTripCount(l);
+      }
+      frequencies[successor.first] += edge_frequency;
+    }
+  }
+  return frequencies;
+}
+
+std::vector<std::pair<uint32_t, double>>
+CostAnalysis::GetSuccessorProbabilities(BasicBlock* bb,
+                                        const LoopDescriptor& loops) {
+  std::vector<uint32_t> successors;
+  bb->ForEachSuccessorLabel([&successors](uint32_t succ) {
+    if (std::find(successors.begin(), successors.end(), succ) ==
+        successors.end()) {
+      successors.push_back(succ);
+    }
+  });
+
+  // The weights of the successors that stay in the loop of |bb|.
+  Loop* loop = loops[bb];
+  std::vector<double> weights(successors.size(), 1);
+  Instruction* branch = bb->terminator();
+  if (branch->opcode() == SpvOpBranchConditional &&
+      branch->NumInOperands() > kBranchConditionalFirstWeightInIdx + 1 &&
+      successors.size() == 2) {
+    weights[0] =
+        branch->GetSingleWordInOperand(kBranchConditionalFirstWeightInIdx);
+    weights[1] =
+        branch->GetSingleWordInOperand(kBranchConditionalFirstWeightInIdx + 1);
+  }
+  double total = 0;
+  for (size_t i = 0; i < successors.size(); ++i) {
+    if (loop == nullptr || loop->IsInsideLoop(successors[i]))
+      total += weights[i];
+  }
+
+  std::vector<std::pair<uint32_t, double>> probabilities;
+  for (size_t i = 0; i < successors.size(); ++i) {
+    double probability = 1;
+    if (loop == nullptr || loop->IsInsideLoop(successors[i]))
+      probability = total > 0 ? weights[i] / total : 0;
+    probabilities.push_back({successors[i], probability});
+  }
+  return probabilities;
+}
+
+double CostAnalysis::GetBlockCost(BasicBlock* bb) {
+  // The cycles at which the result of each instruction of |bb| is ready.
+  std::unordered_map<uint32_t, double> ready;
+  double issue_cycles = 0;
+  double critical_path = 0;
+  for (auto& inst : *bb) {
+    const OpcodeCost& cost = table_.GetCost(inst.opcode());
+    issue_cycles += cost.issue;
+    double start = 0;
+    inst.ForEachInId([&ready, &start](const uint32_t* id) {
+      auto it = ready.find(*id);
+      if (it != ready.end()) start = std::max(start, it->second);
+    });
+    double end = start + cost.latency;
+    if (inst.opcode() == SpvOpFunctionCall) {
+      Function* callee = context_->GetFunction(
+          inst.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx));
+      if (callee != nullptr) {
+        double callee_cycles = GetFunctionCost(callee);
+        issue_cycles += callee_cycles;
+        end += callee_cycles;
+      }
+    }
+    if (inst.result_id() != 0) ready[inst.result_id()] = end;
+    critical_path = std::max(critical_path, end);
+  }
+  return std::max(issue_cycles, critical_path);
+}
+
+uint32_t CostAnalysis::GetTripCount(const Loop* loop) {
+  BasicBlock* condition_block = loop->FindConditionBlock();
+  Instruction* condition = loop->GetConditionInst();
+  if (condition_block != nullptr && condition != nullptr) {
+    Instruction* induction = loop->FindConditionVariable(condition_block);
+    size_t iterations = 0;
+    if (induction != nullptr &&
+        loop->FindNumberOfIterations(induction, &*condition_block->tail(),
+                                     &iterations)) {
+      return static_cast<uint32_t>(std::max<size_t>(iterations, 1));
+    }
+  }
+  uint32_t iterations = GetTripCountFromScalarEvolution(loop);
+  return iterations != 0 ? iterations : options_.default_trip_count;
+}
+
+uint32_t CostAnalysis::GetTripCountFromScalarEvolution(const Loop* loop) {
+  Instruction* condition = loop->GetConditionInst();
+  if (condition == nullptr || !loop->IsSupportedCondition(condition->opcode()))
+    return 0;
+
+  // The condition must compare a recurrence of the loop with a value that
+  // folds to a constant, in that order.
+  ScalarEvolutionAnalysis* scev = context_->GetScalarEvolutionAnalysis();
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  SENode* variable = scev->SimplifyExpression(scev->AnalyzeInstruction(
+      def_use_mgr->GetDef(condition->GetSingleWordInOperand(0))));
+  SENode* bound = scev->SimplifyExpression(scev->AnalyzeInstruction(
+      def_use_mgr->GetDef(condition->GetSingleWordInOperand(1))));
+  SERecurrentNode* recurrence = variable->AsSERecurrentNode();
+  if (recurrence == nullptr || recurrence->GetLoop() != loop ||
+      bound->AsSEConstantNode() == nullptr ||
+      recurrence->GetOffset()->AsSEConstantNode() == nullptr ||
+      recurrence->GetCoefficient()->AsSEConstantNode() == nullptr) {
+    return 0;
+  }
+  int64_t iterations = CountIterations(
+      condition->opcode(),
+      recurrence->GetOffset()->AsSEConstantNode()->FoldToSingleValue(),
+      recurrence->GetCoefficient()->AsSEConstantNode()->FoldToSingleValue(),
+      bound->AsSEConstantNode()->FoldToSingleValue());
+  if (iterations <= 0 || iterations > UINT32_MAX) return 0;
+  return static_cast<uint32_t>(iterations);
+}
+
+size_t CostAnalysis::GetMaxRegisters(Function* func) {
+  auto it = function_registers_.find(func->result_id());
+  if (it != function_registers_.end()) return it->second;
+  function_registers_[func->result_id()] = 0;
+
+  const RegisterLiveness* liveness =
+      context_->GetLivenessAnalysis()->Get(func);
+  size_t max_registers = 0;
+  for (auto& bb : *func) {
+    const RegisterLiveness::RegionRegisterLiveness* bb_liveness =
+        liveness->Get(&bb);
+    if (bb_liveness != nullptr)
+      max_registers = std::max(max_registers, bb_liveness->used_registers_);
+    for (auto& inst : bb) {
+      if (inst.opcode() != SpvOpFunctionCall) continue;
+      Function* callee = context_->GetFunction(
+          inst.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx));
+      if (callee != nullptr)
+        max_registers = std::max(max_registers, GetMaxRegisters(callee));
+    }
+  }
+  function_registers_[func->result_id()] = max_registers;
+  return max_registers;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,161 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_COST_ANALYSIS_H_
+#define SOURCE_OPT_COST_ANALYSIS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
+#include "spirv-tools/optimizer.hpp"
+
+namespace spvtools {
+namespace opt {
+
+// The cost of one instruction, in cycles.
+struct OpcodeCost {
+  // The cycles until its result can be used by the next instruction.
+  double latency;
+  // The cycles during which it keeps the next instruction from being issued,
+  // the inverse of its throughput.
+  double issue;
+};
+
+// The cost of each opcode.  Opcodes without an entry of their own have the
+// default cost.
+class CostTable {
+ public:
+  // Creates a table with a rough estimate of the cost of each opcode on a GPU.
+  CostTable();
+
+  // Returns the cost of an instruction with opcode |opcode|.
+  const OpcodeCost& GetCost(SpvOp opcode) const;
+
+  void SetCost(SpvOp opcode, const OpcodeCost& cost) { costs_[opcode] = cost; }
+  void SetDefaultCost(const OpcodeCost& cost) { default_cost_ = cost; }
+
+  // Updates the table from |text|.  Each line gives the name of an opcode, with
+  // or without its "Op" prefix, or "default", followed by its latency and issue
+  // cycles.  Empty lines and text following a '#' are ignored.  Returns false,
+  // and describes the first line that cannot be parsed in |error|, if the text
+  // is not in that format.
+  bool ParseText(const std::string& text, std::string* error);
+
+ private:
+  std::unordered_map<uint32_t, OpcodeCost> costs_;
+  OpcodeCost default_cost_;
+};
+
+// The parameters of the cost estimate that do not depend on opcodes.
+struct CostOptions {
+  // The trip count assumed for loops whose trip count is not known.
+  uint32_t default_trip_count = 8;
+  // The values that can be live at the same time without spilling.
+  uint32_t register_budget = 64;
+  // The cycles added each time a block runs for each live value above the
+  // budget.
+  double spill_cost = 20;
+};
+
+// The estimated cost of one invocation of an entry point.
+struct EntryPointCost {
+  std::string name;
+  SpvExecutionModel execution_model;
+  uint32_t function_id;
+  double cycles;
+  // The most values live at the same time in the entry point, or in the
+  // functions it calls.
+  size_t max_registers;
+};
+
+// Estimates the cycles that the entry points of a module take to run, without
+// running them.  Each block costs the larger of the issue cycles of its
+// instructions and the latency of their longest dependency chain, plus the
+// cost of the functions it calls and of the values it spills.  The cost of a
+// function is the cost of its blocks weighted by how often they run.  Block
+// frequencies come from a profile when one is given for the function, and
+// otherwise from the trip counts of the loops and static branch probabilities.
+class CostAnalysis {
+ public:
+  CostAnalysis(IRContext* context, const CostTable& table,
+               const CostOptions& options = CostOptions())
+      : context_(context), table_(table), options_(options) {}
+
+  // Uses the block counts of |profile| as the frequencies of the blocks of the
+  // functions it covers.
+  void SetProfile(const std::vector<ProfileBlockCount>& profile);
+
+  // Returns the estimated cost of each entry point of the module, in the order
+  // of the OpEntryPoint instructions.
+  std::vector<EntryPointCost> EstimateEntryPoints();
+
+  // Returns the estimated cycles of one call to |func|, including the
+  // functions it calls.
+  double GetFunctionCost(Function* func);
+
+  // Returns the number of times each reachable block of |func| runs for each
+  // call to |func|, by block id.
+  std::unordered_map<uint32_t, double> GetBlockFrequencies(Function* func);
+
+  // Returns the estimated cycles of one run of |bb|, including the functions
+  // it calls but not its spills.
+  double GetBlockCost(BasicBlock* bb);
+
+  // Returns the trip count of |loop|, or the default trip count if it cannot
+  // be computed.
+  uint32_t GetTripCount(const Loop* loop);
+
+  // Returns the most values live at the same time in |func|, or in the
+  // functions it calls.
+  size_t GetMaxRegisters(Function* func);
+
+ private:
+  // Returns the trip count of |loop| computed by the scalar evolution of its
+  // induction variable and of the bound it is compared to, or 0 if it is not
+  // known.
+  uint32_t GetTripCountFromScalarEvolution(const Loop* loop);
+
+  // Returns each successor of |bb| with the probability that |bb| branches to
+  // it.  Successors outside of the innermost loop of |bb| have probability 1:
+  // the frequency of |bb| is divided by the trip counts of the loops the edge
+  // leaves instead.  The other successors share the remaining probability
+  // according to the branch weights, or equally.
+  std::vector<std::pair<uint32_t, double>> GetSuccessorProbabilities(
+      BasicBlock* bb, const LoopDescriptor& loops);
+
+  IRContext* context_;
+  CostTable table_;
+  CostOptions options_;
+
+  // The block counts of the profile, by function id and block id.
+  std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint64_t>>
+      profile_;
+
+  // The cost and register pressure of the functions already estimated.
+  std::unordered_map<uint32_t, double> function_costs_;
+  std::unordered_map<uint32_t, size_t> function_registers_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_COST_ANALYSIS_H_
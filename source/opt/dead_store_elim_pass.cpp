@@ -0,0 +1,88 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/dead_store_elim_pass.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+Pass::Status DeadStoreElimPass::Process() {
+  bool modified = false;
+  for (Function& function : *get_module()) {
+    modified |= EliminateDeadStores(&function);
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+bool DeadStoreElimPass::EliminateDeadStores(Function* function) {
+  if (function->begin() == function->end()) return false;
+
+  MemorySSA* memory_ssa = context()->GetMemorySSAAnalysis()->Get(function);
+  std::vector<Instruction*> dead_stores;
+  for (BasicBlock& bb : *function) {
+    for (Instruction& inst : bb) {
+      if (inst.opcode() != SpvOpStore) continue;
+      for (const MemoryAccess* def : memory_ssa->GetDefs(&inst)) {
+        if (def->pointer_id() != 0 &&
+            def->partition() != SpvStorageClassFunction &&
+            IsOverwritten(def)) {
+          dead_stores.push_back(&inst);
+        }
+      }
+    }
+  }
+
+  for (Instruction* inst : dead_stores) {
+    context()->KillInst(inst);
+  }
+  return !dead_stores.empty();
+}
+
+bool DeadStoreElimPass::IsOverwritten(const MemoryAccess* store) {
+  // Follow the versions of memory that still hold the value written by
+  // |store|.  They end at stores to the same address.  Any other access that
+  // may see the value, and any merge of versions, keeps the store.
+  AliasAnalysis* alias_analysis = context()->GetAliasAnalysis();
+  bool overwritten = false;
+  std::vector<const MemoryAccess*> worklist = {store};
+  std::unordered_set<const MemoryAccess*> visited;
+  while (!worklist.empty()) {
+    const MemoryAccess* current = worklist.back();
+    worklist.pop_back();
+    if (!visited.insert(current).second) continue;
+
+    for (const MemoryAccess* user : current->users()) {
+      if (user->IsPhi() || user->pointer_id() == 0) return false;
+      AliasAnalysis::AliasResult alias =
+          alias_analysis->Alias(user->pointer_id(), store->pointer_id());
+      if (user->IsUse()) {
+        if (alias != AliasAnalysis::AliasResult::kNoAlias) return false;
+        continue;
+      }
+      if (alias == AliasAnalysis::AliasResult::kMustAlias) {
+        overwritten = true;
+        continue;
+      }
+      if (alias == AliasAnalysis::AliasResult::kMayAlias) return false;
+      worklist.push_back(user);
+    }
+  }
+  return overwritten;
+}
+
+}  // namespace opt
+}  // namespace spvtools
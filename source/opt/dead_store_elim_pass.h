@@ -0,0 +1,57 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_DEAD_STORE_ELIM_PASS_H_
+#define SOURCE_OPT_DEAD_STORE_ELIM_PASS_H_
+
+#include "source/opt/ir_context.h"
+#include "source/opt/memory_ssa.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// This pass removes stores to memory outside of the Function storage class
+// that are overwritten before they can be observed.  A store is removed if, on
+// every path from it, a store to the same address comes before any instruction
+// that may read the memory it wrote, any barrier, atomic or function call, and
+// the end of the function.  Stores to Function memory are left to the local
+// load/store elimination passes.
+class DeadStoreElimPass : public Pass {
+ public:
+  const char* name() const override { return "eliminate-dead-stores"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // Removes the dead stores of |function|.  Returns true if the function was
+  // modified.
+  bool EliminateDeadStores(Function* function);
+
+  // Returns true if the memory written by the plain store |store| is always
+  // overwritten before it is read.
+  bool IsOverwritten(const MemoryAccess* store);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_DEAD_STORE_ELIM_PASS_H_
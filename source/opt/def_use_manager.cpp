@@ -229,6 +229,46 @@ void DefUseManager::AnalyzeDefUse(Module* module) {
       std::bind(&DefUseManager::AnalyzeInstUse, this, std::placeholders::_1));
 }
 
+void DefUseManager::AnalyzeDefUse(const ModuleIndex& index,
+                                  const std::vector<Instruction*>& insts) {
+  id_to_def_.reserve(index.id_bound());
+  inst_to_used_ids_.reserve(insts.size());
+  for (uint32_t ordinal = 0; ordinal < insts.size(); ++ordinal) {
+    Instruction* inst = insts[ordinal];
+    // Debug line instructions are not analyzed, as in AnalyzeDefUse(Module*).
+    if (IsDebugLineInst(inst->opcode())) continue;
+    if (inst->result_id() != 0) id_to_def_[inst->result_id()] = inst;
+
+    auto& used_ids = inst_to_used_ids_[inst];
+    for (uint32_t i = 0; i < inst->NumOperands(); ++i) {
+      switch (inst->GetOperand(i).type) {
+        case SPV_OPERAND_TYPE_ID:
+        case SPV_OPERAND_TYPE_TYPE_ID:
+        case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
+        case SPV_OPERAND_TYPE_SCOPE_ID:
+          used_ids.push_back(inst->GetSingleWordOperand(i));
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // Definitions and their users are visited in module order, which is also the
+  // order of their unique ids, so every entry is inserted at the end of the
+  // users map.
+  for (uint32_t ordinal = 0; ordinal < insts.size(); ++ordinal) {
+    Instruction* def = insts[ordinal];
+    if (def->result_id() == 0 || IsDebugLineInst(def->opcode())) continue;
+    for (const ModuleIndex::Use& use : index.uses(def->result_id())) {
+      if (use.user >= insts.size()) continue;
+      Instruction* user = insts[use.user];
+      if (IsDebugLineInst(user->opcode())) continue;
+      id_to_users_.emplace_hint(id_to_users_.end(), def, user);
+    }
+  }
+}
+
 void DefUseManager::ClearInst(Instruction* inst) {
   auto iter = inst_to_used_ids_.find(inst);
   if (iter != inst_to_used_ids_.end()) {
@@ -21,6 +21,7 @@
 #include <utility>
 #include <vector>
 
+#include "source/module_index.h"
 #include "source/opt/instruction.h"
 #include "source/opt/module.h"
 #include "spirv-tools/libspirv.hpp"
@@ -105,6 +106,13 @@ class DefUseManager {
   // outlive this instance.
   DefUseManager(Module* module) { AnalyzeDefUse(module); }
 
+  // Constructs a def-use manager from the use lists of |index|.  |insts| maps
+  // the ordinals of |index| to the instructions of the module it describes.
+  DefUseManager(const ModuleIndex& index,
+                const std::vector<Instruction*>& insts) {
+    AnalyzeDefUse(index, insts);
+  }
+
   DefUseManager(const DefUseManager&) = delete;
   DefUseManager(DefUseManager&&) = delete;
   DefUseManager& operator=(const DefUseManager&) = delete;
@@ -243,6 +251,11 @@ class DefUseManager {
   // structures in this class. Does nothing if |module| is nullptr.
   void AnalyzeDefUse(Module* module);
 
+  // Populates the data structures in this class from the tables of |index|
+  // instead of analyzing every instruction.
+  void AnalyzeDefUse(const ModuleIndex& index,
+                     const std::vector<Instruction*>& insts);
+
   IdToDefMap id_to_def_;      // Mapping from ids to their definitions
   IdToUsersMap id_to_users_;  // Mapping from ids to their users
   // Mapping from instructions to the ids used in the instruction.
@@ -0,0 +1,340 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/divergence_analysis.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+const uint32_t kBranchConditionInIdx = 0;
+const uint32_t kLoadPointerInIdx = 0;
+const uint32_t kGroupOperationInIdx = 1;
+const uint32_t kDecorationValueInIdx = 2;
+const uint32_t kTypePointerStorageClassInIdx = 0;
+const uint32_t kTypePointerTypeInIdx = 1;
+
+// Returns true if |opcode| is a non-uniform group operation taking a group
+// operation operand.
+bool IsGroupArithmetic(SpvOp opcode) {
+  return (opcode >= SpvOpGroupNonUniformIAdd &&
+          opcode <= SpvOpGroupNonUniformLogicalXor) ||
+         opcode == SpvOpGroupNonUniformBallotBitCount;
+}
+
+// Returns true if all invocations of a subgroup read the same value from the
+// builtin |builtin|.
+bool IsUniformBuiltIn(uint32_t builtin) {
+  switch (builtin) {
+    case SpvBuiltInNumWorkgroups:
+    case SpvBuiltInWorkgroupSize:
+    case SpvBuiltInWorkgroupId:
+    case SpvBuiltInSubgroupSize:
+    case SpvBuiltInNumSubgroups:
+    case SpvBuiltInSubgroupId:
+    case SpvBuiltInBaseVertex:
+    case SpvBuiltInBaseInstance:
+    case SpvBuiltInDrawIndex:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+bool DivergenceAnalysis::IsDivergent(Instruction* inst) {
+  if (inst->opcode() == SpvOpFunctionParameter) {
+    return !HasDecoration(inst->result_id(), SpvDecorationUniform);
+  }
+  BasicBlock* bb = context_->get_instr_block(inst);
+  if (bb == nullptr) return false;
+  const uint32_t id_bound = GetAnalyzedIdBound(bb->GetParent());
+  // Values created since the function was analyzed are unknown.
+  if (inst->result_id() >= id_bound) return true;
+  return divergent_ids_.count(inst->result_id()) != 0;
+}
+
+bool DivergenceAnalysis::IsDivergentBranch(BasicBlock* bb) {
+  const uint32_t id_bound = GetAnalyzedIdBound(bb->GetParent());
+  // Blocks and conditions created since the function was analyzed are
+  // unknown.
+  if (bb->id() >= id_bound) return true;
+  const Instruction* branch = bb->terminator();
+  if ((branch->opcode() == SpvOpBranchConditional ||
+       branch->opcode() == SpvOpSwitch) &&
+      branch->GetSingleWordInOperand(kBranchConditionInIdx) >= id_bound) {
+    return true;
+  }
+  return divergent_branches_.count(bb->id()) != 0;
+}
+
+uint32_t DivergenceAnalysis::GetAnalyzedIdBound(Function* f) {
+  auto it = analyzed_functions_.find(f->result_id());
+  if (it == analyzed_functions_.end()) {
+    it = analyzed_functions_
+             .emplace(f->result_id(), context_->module()->IdBound())
+             .first;
+    Analyze(f);
+  }
+  return it->second;
+}
+
+void DivergenceAnalysis::Analyze(Function* f) {
+  std::vector<Instruction*> worklist;
+  f->ForEachParam(
+      [this, &worklist](Instruction* param) {
+        MarkDivergent(param, &worklist);
+      },
+      false);
+  for (BasicBlock& bb : *f) {
+    for (Instruction& inst : bb) {
+      if (IsDivergenceSource(&inst)) MarkDivergent(&inst, &worklist);
+    }
+  }
+
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  while (!worklist.empty()) {
+    Instruction* inst = worklist.back();
+    worklist.pop_back();
+    std::vector<Instruction*> users;
+    def_use_mgr->ForEachUser(
+        inst, [&users](Instruction* user) { users.push_back(user); });
+    for (Instruction* user : users) {
+      MarkOperandDivergent(f, user, inst->result_id(), &worklist);
+    }
+  }
+}
+
+void DivergenceAnalysis::MarkDivergent(Instruction* inst,
+                                       std::vector<Instruction*>* worklist) {
+  if (!inst->HasResultId()) return;
+  if (HasDecoration(inst->result_id(), SpvDecorationUniform)) return;
+  if (divergent_ids_.insert(inst->result_id()).second) {
+    worklist->push_back(inst);
+  }
+}
+
+void DivergenceAnalysis::MarkOperandDivergent(
+    Function* f, Instruction* user, uint32_t id,
+    std::vector<Instruction*>* worklist) {
+  BasicBlock* bb = context_->get_instr_block(user);
+  // Names and decorations are not in a function.
+  if (bb == nullptr || bb->GetParent() != f) return;
+
+  if (user->opcode() == SpvOpBranchConditional ||
+      user->opcode() == SpvOpSwitch) {
+    if (user->GetSingleWordInOperand(kBranchConditionInIdx) == id) {
+      MarkDivergentBranch(f, bb, worklist);
+    }
+    return;
+  }
+  if (HasUniformResult(user)) return;
+  MarkDivergent(user, worklist);
+}
+
+void DivergenceAnalysis::MarkDivergentBranch(
+    Function* f, BasicBlock* bb, std::vector<Instruction*>* worklist) {
+  if (!divergent_branches_.insert(bb->id()).second) return;
+
+  CFG* cfg = context_->cfg();
+  LoopDescriptor* loops = context_->GetLoopDescriptor(f);
+  BasicBlock* join =
+      context_->GetPostDominatorAnalysis(f)->ImmediateDominator(bb);
+  if (join != nullptr && cfg->IsPseudoExitBlock(join)) join = nullptr;
+
+  // The paths from the successors of |bb| are followed until the join point
+  // of the branch, and until the headers of the loops containing |bb|, since
+  // the next iteration is reached by the invocations still in the loop
+  // together.
+  std::unordered_set<uint32_t> stops;
+  if (join != nullptr) stops.insert(join->id());
+  for (Loop* loop = (*loops)[bb]; loop != nullptr; loop = loop->GetParent()) {
+    stops.insert(loop->GetHeaderBlock()->id());
+  }
+
+  std::vector<uint32_t> successors;
+  bb->ForEachSuccessorLabel([&successors](const uint32_t id) {
+    if (std::find(successors.begin(), successors.end(), id) ==
+        successors.end()) {
+      successors.push_back(id);
+    }
+  });
+
+  // A block reached from two successors is a join point of the branch.
+  std::unordered_map<uint32_t, size_t> reached_from;
+  std::unordered_set<uint32_t> joins;
+  std::unordered_set<uint32_t> region = {bb->id()};
+  for (size_t i = 0; i < successors.size(); ++i) {
+    std::vector<uint32_t> stack = {successors[i]};
+    std::unordered_set<uint32_t> visited;
+    while (!stack.empty()) {
+      uint32_t id = stack.back();
+      stack.pop_back();
+      if (!visited.insert(id).second) continue;
+      auto inserted = reached_from.insert({id, i});
+      if (!inserted.second && inserted.first->second != i) joins.insert(id);
+      if (stops.count(id)) continue;
+      region.insert(id);
+      cfg->block(id)->ForEachSuccessorLabel(
+          [&stack](const uint32_t succ) { stack.push_back(succ); });
+    }
+  }
+  if (join != nullptr) joins.insert(join->id());
+
+  for (uint32_t id : joins) {
+    cfg->block(id)->ForEachPhiInst([this, worklist](Instruction* phi) {
+      MarkDivergent(phi, worklist);
+    });
+  }
+
+  // Invocations leaving a loop through the region do so in different
+  // iterations.
+  std::vector<Loop*> exited_loops;
+  for (uint32_t id : region) {
+    cfg->block(id)->ForEachSuccessorLabel(
+        [&loops, &exited_loops, id](const uint32_t succ) {
+          for (Loop* loop = (*loops)[id];
+               loop != nullptr && !loop->IsInsideLoop(succ);
+               loop = loop->GetParent()) {
+            exited_loops.push_back(loop);
+          }
+        });
+  }
+  for (Loop* loop : exited_loops) {
+    if (divergent_loops_.insert(loop).second) {
+      MarkLoopLiveOuts(f, loop, worklist);
+    }
+  }
+}
+
+void DivergenceAnalysis::MarkLoopLiveOuts(
+    Function* f, Loop* loop, std::vector<Instruction*>* worklist) {
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  CFG* cfg = context_->cfg();
+  for (uint32_t bb_id : loop->GetBlocks()) {
+    for (Instruction& inst : *cfg->block(bb_id)) {
+      if (!inst.HasResultId() || inst.opcode() == SpvOpLabel) continue;
+      std::vector<Instruction*> users;
+      def_use_mgr->ForEachUser(&inst, [this, loop, &users](Instruction* user) {
+        BasicBlock* user_bb = context_->get_instr_block(user);
+        if (user_bb != nullptr && !loop->IsInsideLoop(user_bb)) {
+          users.push_back(user);
+        }
+      });
+      for (Instruction* user : users) {
+        MarkOperandDivergent(f, user, inst.result_id(), worklist);
+      }
+    }
+  }
+}
+
+bool DivergenceAnalysis::IsDivergenceSource(Instruction* inst) {
+  if (!inst->HasResultId()) return false;
+  if (HasDecoration(inst->result_id(), SpvDecorationNonUniformEXT)) {
+    return true;
+  }
+  if (IsGroupArithmetic(inst->opcode())) {
+    return inst->GetSingleWordInOperand(kGroupOperationInIdx) !=
+           SpvGroupOperationReduce;
+  }
+  switch (inst->opcode()) {
+    case SpvOpLoad:
+      return !IsUniformLoad(inst);
+    case SpvOpFunctionCall:
+    case SpvOpGroupNonUniformElect:
+    case SpvOpGroupNonUniformInverseBallot:
+      return true;
+    default:
+      return inst->IsAtomicOp();
+  }
+}
+
+bool DivergenceAnalysis::HasUniformResult(Instruction* inst) {
+  if (IsGroupArithmetic(inst->opcode())) {
+    return inst->GetSingleWordInOperand(kGroupOperationInIdx) ==
+           SpvGroupOperationReduce;
+  }
+  switch (inst->opcode()) {
+    case SpvOpGroupNonUniformAll:
+    case SpvOpGroupNonUniformAny:
+    case SpvOpGroupNonUniformAllEqual:
+    case SpvOpGroupNonUniformBroadcast:
+    case SpvOpGroupNonUniformBroadcastFirst:
+    case SpvOpGroupNonUniformBallot:
+    case SpvOpSubgroupBallotKHR:
+    case SpvOpSubgroupFirstInvocationKHR:
+    case SpvOpSubgroupAllKHR:
+    case SpvOpSubgroupAnyKHR:
+    case SpvOpSubgroupAllEqualKHR:
+    case SpvOpSubgroupReadInvocationKHR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool DivergenceAnalysis::IsUniformLoad(Instruction* inst) {
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  uint32_t pointer_id = inst->GetSingleWordInOperand(kLoadPointerInIdx);
+  Instruction* pointer_type =
+      def_use_mgr->GetDef(def_use_mgr->GetDef(pointer_id)->type_id());
+  Instruction* root =
+      context_->GetAliasAnalysis()->GetAccessPath(pointer_id, nullptr);
+
+  switch (pointer_type->GetSingleWordInOperand(kTypePointerStorageClassInIdx)) {
+    case SpvStorageClassUniformConstant:
+    case SpvStorageClassPushConstant:
+      return true;
+    case SpvStorageClassUniform: {
+      // Storage buffers declared in the Uniform storage class can be written
+      // by other invocations.
+      if (root->opcode() != SpvOpVariable) return false;
+      Instruction* type = def_use_mgr->GetDef(
+          def_use_mgr->GetDef(root->type_id())
+              ->GetSingleWordInOperand(kTypePointerTypeInIdx));
+      while (type->opcode() == SpvOpTypeArray ||
+             type->opcode() == SpvOpTypeRuntimeArray) {
+        type = def_use_mgr->GetDef(type->GetSingleWordInOperand(0));
+      }
+      return !HasDecoration(type->result_id(), SpvDecorationBufferBlock);
+    }
+    case SpvStorageClassInput: {
+      if (root->opcode() != SpvOpVariable) return false;
+      bool uniform = false;
+      context_->get_decoration_mgr()->WhileEachDecoration(
+          root->result_id(), SpvDecorationBuiltIn,
+          [&uniform](const Instruction& decoration) {
+            uniform = IsUniformBuiltIn(
+                decoration.GetSingleWordInOperand(kDecorationValueInIdx));
+            return false;
+          });
+      return uniform;
+    }
+    default:
+      return false;
+  }
+}
+
+bool DivergenceAnalysis::HasDecoration(uint32_t id, uint32_t decoration) {
+  return !context_->get_decoration_mgr()->WhileEachDecoration(
+      id, decoration, [](const Instruction&) { return false; });
+}
+
+}  // namespace opt
+}  // namespace spvtools
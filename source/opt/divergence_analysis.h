@@ -0,0 +1,115 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_DIVERGENCE_ANALYSIS_H_
+#define SOURCE_OPT_DIVERGENCE_ANALYSIS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/instruction.h"
+
+namespace spvtools {
+namespace opt {
+
+class IRContext;
+class Loop;
+
+// Finds the values and branches that may differ between the invocations of a
+// subgroup that execute them together.
+//
+// Divergence starts at loads of per-invocation memory, such as inputs other
+// than the builtins that are uniform by definition, at atomics, function
+// calls and function parameters, at subgroup operations whose result depends
+// on the invocation, and at values decorated NonUniformEXT.  It flows from
+// operands to results, except for subgroup operations that return the same
+// value to all invocations.  A divergent branch makes the phis where its
+// paths join divergent, and makes divergent the values that leave a loop it
+// exits.  Values decorated Uniform are never divergent.
+//
+// Functions are analyzed the first time one of their instructions is queried.
+// Values and branches created after that are conservatively divergent.
+class DivergenceAnalysis {
+ public:
+  explicit DivergenceAnalysis(IRContext* context) : context_(context) {}
+
+  DivergenceAnalysis(const DivergenceAnalysis&) = delete;
+  DivergenceAnalysis& operator=(const DivergenceAnalysis&) = delete;
+
+  // Returns true if the result of |inst| may differ between invocations.
+  // Instructions outside of functions, such as constants and global
+  // variables, are uniform.
+  bool IsDivergent(Instruction* inst);
+  bool IsUniform(Instruction* inst) { return !IsDivergent(inst); }
+
+  // Returns true if the invocations that reach the end of |bb| may branch to
+  // different successors.
+  bool IsDivergentBranch(BasicBlock* bb);
+
+ private:
+  // Analyzes |f| if it has not been analyzed yet, and returns the id bound of
+  // the module when it was.  Larger ids were created after the analysis.
+  uint32_t GetAnalyzedIdBound(Function* f);
+
+  // Computes the divergent values and branches of |f|.
+  void Analyze(Function* f);
+
+  // Records that |inst| is divergent, and adds it to |worklist| if it was not
+  // known to be.
+  void MarkDivergent(Instruction* inst, std::vector<Instruction*>* worklist);
+
+  // Records that the operand |id| of |user| in |f| is divergent, and updates
+  // the divergence of |user|.
+  void MarkOperandDivergent(Function* f, Instruction* user, uint32_t id,
+                            std::vector<Instruction*>* worklist);
+
+  // Records that the branch ending |bb| in |f| is divergent, and marks the
+  // phis at its join points and the values leaving the loops it exits.
+  void MarkDivergentBranch(Function* f, BasicBlock* bb,
+                           std::vector<Instruction*>* worklist);
+
+  // Marks as divergent the users outside of |loop| of the values it defines.
+  void MarkLoopLiveOuts(Function* f, Loop* loop,
+                        std::vector<Instruction*>* worklist);
+
+  // Returns true if |inst| is divergent whatever its operands.
+  bool IsDivergenceSource(Instruction* inst);
+
+  // Returns true if |inst| returns the same value to all invocations whatever
+  // its operands.
+  bool HasUniformResult(Instruction* inst);
+
+  // Returns true if the load |inst| reads memory that holds the same value
+  // for all invocations.
+  bool IsUniformLoad(Instruction* inst);
+
+  // Returns true if |id| is decorated with |decoration|.
+  bool HasDecoration(uint32_t id, uint32_t decoration);
+
+  IRContext* context_;
+  // Maps the analyzed functions to the id bound when they were analyzed.
+  std::unordered_map<uint32_t, uint32_t> analyzed_functions_;
+  std::unordered_set<uint32_t> divergent_ids_;
+  std::unordered_set<uint32_t> divergent_branches_;
+  std::unordered_set<const Loop*> divergent_loops_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_DIVERGENCE_ANALYSIS_H_
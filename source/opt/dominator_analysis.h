@@ -33,6 +33,13 @@ class DominatorAnalysisBase {
     tree_.InitializeTree(cfg, f);
   }
 
+  // Builds the dominator tree for function |f| from the immediate dominators
+  // recorded in |indexed|.
+  inline void InitializeTree(const CFG& cfg, const Function* f,
+                             const ModuleIndex::Function& indexed) {
+    tree_.InitializeTree(cfg, f, indexed);
+  }
+
   // Returns true if BasicBlock |a| dominates BasicBlock |b|.
   inline bool Dominates(const BasicBlock* a, const BasicBlock* b) const {
     if (!a || !b) return false;
@@ -15,6 +15,7 @@
 #include <iostream>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 #include "source/cfa.h"
 #include "source/opt/dominator_tree.h"
@@ -353,6 +354,57 @@ void DominatorTree::InitializeTree(const CFG& cfg, const Function* f) {
   ResetDFNumbering();
 }
 
+void DominatorTree::InitializeTree(const CFG& cfg, const Function* f,
+                                   const ModuleIndex::Function& indexed) {
+  assert(!postdominator_ && "The index only records immediate dominators.");
+  ClearTree();
+
+  // Skip over empty functions.
+  if (f->cbegin() == f->cend()) {
+    return;
+  }
+
+  // CFA::CalculateDominators sorts the edges by the postorder index of the
+  // block, so the children of each node of the computed tree are in that
+  // order.  Number the blocks the same way to build the same tree.
+  const BasicBlock* dummy_start_node = cfg.pseudo_entry_block();
+  std::unordered_map<const BasicBlock*, size_t> postorder_index;
+  auto postorder_function = [&postorder_index](const BasicBlock* b) {
+    const size_t index = postorder_index.size();
+    postorder_index[b] = index;
+  };
+  BasicBlockSuccessorHelper<BasicBlock> helper{*const_cast<Function*>(f),
+                                               dummy_start_node, false};
+  DepthFirstSearchPostOrder(dummy_start_node, helper.GetSuccessorFunctor(),
+                            postorder_function);
+
+  // As in the tree computed from the CFG, the entry block hangs from the
+  // pseudo entry block, and unreachable blocks are not part of the tree.
+  DominatorTreeNode* root =
+      GetOrInsertNode(const_cast<BasicBlock*>(dummy_start_node));
+  roots_.push_back(root);
+  for (const ModuleIndex::Block& block : indexed.blocks) {
+    if (block.immediate_dominator == 0) continue;
+    DominatorTreeNode* node = GetOrInsertNode(cfg.block(block.label_id));
+    DominatorTreeNode* parent =
+        block.immediate_dominator == block.label_id
+            ? root
+            : GetOrInsertNode(cfg.block(block.immediate_dominator));
+    node->parent_ = parent;
+    parent->children_.push_back(node);
+  }
+  for (auto& id_and_node : nodes_) {
+    std::vector<DominatorTreeNode*>& children = id_and_node.second.children_;
+    std::sort(children.begin(), children.end(),
+              [&postorder_index](const DominatorTreeNode* lhs,
+                                 const DominatorTreeNode* rhs) {
+                return postorder_index.at(lhs->bb_) <
+                       postorder_index.at(rhs->bb_);
+              });
+  }
+  ResetDFNumbering();
+}
+
 void DominatorTree::ResetDFNumbering() {
   int index = 0;
   auto preFunc = [&index](const DominatorTreeNode* node) {
@@ -21,6 +21,7 @@
 #include <utility>
 #include <vector>
 
+#include "source/module_index.h"
 #include "source/opt/cfg.h"
 #include "source/opt/tree_iterator.h"
 
@@ -160,6 +161,12 @@ class DominatorTree {
   // existing data in the dominator tree will be overwritten
   void InitializeTree(const CFG& cfg, const Function* f);
 
+  // Build the dominator tree of the function |f| from the immediate
+  // dominators recorded for it in a module index.  |indexed| must describe
+  // |f|.  This cannot be used for a post dominator tree.
+  void InitializeTree(const CFG& cfg, const Function* f,
+                      const ModuleIndex::Function& indexed);
+
   // Check if the basic block |a| dominates the basic block |b|.
   bool Dominates(const BasicBlock* a, const BasicBlock* b) const;
 
@@ -14,6 +14,7 @@
 
 #include "source/opt/if_conversion.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -21,6 +22,13 @@
 
 namespace spvtools {
 namespace opt {
+namespace {
+
+// A side of a branch taken by fewer than one invocation in this many is
+// skipped by most waves of 32 or 64 invocations, so it is not speculated.
+const uint64_t kBiasedBranchRatio = 64;
+
+}  // anonymous namespace
 
 Pass::Status IfConversion::Process() {
   if (!context()->get_feature_mgr()->HasCapability(SpvCapabilityShader)) {
@@ -28,6 +36,7 @@ Pass::Status IfConversion::Process() {
   }
 
   const ValueNumberTable& vn_table = *context()->GetValueNumberTable();
+  DivergenceAnalysis* divergence = context()->GetDivergenceAnalysis();
   bool modified = false;
   std::vector<Instruction*> to_kill;
   for (auto& func : *get_module()) {
@@ -48,7 +57,8 @@ Pass::Status IfConversion::Process() {
           context(), &*iter,
           IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
       block.ForEachPhiInst([this, &builder, &modified, &common, &to_kill,
-                            dominators, &block, &vn_table](Instruction* phi) {
+                            dominators, divergence, &block,
+                            &vn_table](Instruction* phi) {
         // This phi is not compatible, but subsequent phis might be.
         if (!CheckType(phi->type_id())) return;
 
@@ -111,14 +121,27 @@ Pass::Status IfConversion::Process() {
         }
 
         // If either incoming value is defined in a block that does not dominate
-        // this phi, then we cannot eliminate the phi with a select.
-        // TODO(alan-baker): Perform code motion where it makes sense to enable
-        // the transform in this case.
-        if (true_def_block && !dominators->Dominates(true_def_block, &block))
-          return;
-
-        if (false_def_block && !dominators->Dominates(false_def_block, &block))
-          return;
+        // this phi, then it must be computed before the branch to eliminate the
+        // phi with a select.  This is only worth it if the branch is divergent,
+        // since the invocations then execute both sides of the branch anyway.
+        bool true_dominates =
+            !true_def_block || dominators->Dominates(true_def_block, &block);
+        bool false_dominates =
+            !false_def_block || dominators->Dominates(false_def_block, &block);
+        if (!true_dominates || !false_dominates) {
+          if (!divergence->IsDivergentBranch(common)) return;
+          if (IsBiasedBranch(common, &block)) return;
+          if (!true_dominates &&
+              !CanSpeculateInstruction(true_value, common, dominators))
+            return;
+          if (!false_dominates &&
+              !CanSpeculateInstruction(false_value, common, dominators))
+            return;
+          if (!true_dominates)
+            HoistInstruction(true_value, common, dominators);
+          if (!false_dominates)
+            HoistInstruction(false_value, common, dominators);
+        }
 
         analysis::Type* data_ty =
             context()->get_type_mgr()->GetType(true_value->type_id());
@@ -281,5 +304,60 @@ bool IfConversion::CanHoistInstruction(Instruction* inst,
       });
 }
 
+bool IfConversion::CanSpeculateInstruction(Instruction* inst,
+                                           BasicBlock* target_block,
+                                           DominatorAnalysis* dominators) {
+  BasicBlock* inst_block = context()->get_instr_block(inst);
+  if (!inst_block || dominators->Dominates(inst_block, target_block)) {
+    return true;
+  }
+
+  // The instruction will also be executed by invocations that did not execute
+  // it before.  Loads could access memory out of bounds, and integer division
+  // by zero is undefined.
+  switch (inst->opcode()) {
+    case SpvOpLoad:
+    case SpvOpUDiv:
+    case SpvOpSDiv:
+    case SpvOpUMod:
+    case SpvOpSRem:
+    case SpvOpSMod:
+      return false;
+    default:
+      break;
+  }
+  if (!inst->IsOpcodeCodeMotionSafe()) {
+    return false;
+  }
+
+  analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
+  return inst->WhileEachInId(
+      [this, target_block, def_use_mgr, dominators](uint32_t* id) {
+        Instruction* operand_inst = def_use_mgr->GetDef(*id);
+        return CanSpeculateInstruction(operand_inst, target_block, dominators);
+      });
+}
+
+bool IfConversion::IsBiasedBranch(BasicBlock* common, BasicBlock* merge) {
+  if (!common->HasProfileCount() || common->profile_count() == 0) return false;
+
+  // The count of a side is the count of its first block, unless the side
+  // branches straight to |merge|, whose count includes the other side.
+  const uint64_t total = common->profile_count();
+  const Instruction* branch = common->terminator();
+  uint64_t side_count = 0;
+  bool found_side = false;
+  for (uint32_t i = 1; i < 3 && !found_side; ++i) {
+    BasicBlock* side = GetBlock(branch->GetSingleWordInOperand(i));
+    if (side == merge || !side->HasProfileCount()) continue;
+    side_count = std::min(side->profile_count(), total);
+    found_side = true;
+  }
+  if (!found_side) return false;
+  const uint64_t other_count = total - side_count;
+  return std::min(side_count, other_count) * kBiasedBranchRatio <
+         std::max(side_count, other_count);
+}
+
 }  // namespace opt
 }  // namespace spvtools
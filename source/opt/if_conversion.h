@@ -80,6 +80,17 @@ class IfConversion : public Pass {
   // on to |target_block| if they do not already dominate |target_block|.
   bool CanHoistInstruction(Instruction* inst, BasicBlock* target_block,
                            DominatorAnalysis* dominators);
+
+  // Returns true if |inst| and the instructions it depends on can be moved to
+  // |target_block| even though some invocations executing |target_block| did
+  // not execute them.
+  bool CanSpeculateInstruction(Instruction* inst, BasicBlock* target_block,
+                               DominatorAnalysis* dominators);
+
+  // Returns true if the profile shows that the conditional branch ending
+  // |common| almost always goes the same way.  |merge| is the block where its
+  // two sides meet.
+  bool IsBiasedBranch(BasicBlock* common, BasicBlock* merge);
 };
 
 }  //  namespace opt
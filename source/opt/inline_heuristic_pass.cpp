@@ -0,0 +1,241 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/inline_heuristic_pass.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+const uint32_t kFunctionCallFunctionIdInIdx = 0;
+
+// The largest callee, in instructions, inlined at a call site outside of any
+// loop and without constant arguments.
+const uint32_t kInlineThreshold = 24;
+
+// The number of instructions added to the threshold for each constant
+// argument, which is likely to fold once the callee is inlined.
+const uint32_t kConstantArgumentBonus = 4;
+
+// Loops deeper than this do not raise the threshold any further.
+const uint32_t kMaxLoopDepthBonus = 3;
+
+}  // anonymous namespace
+
+bool InlineHeuristicPass::HasPointerArgsOrReturn(
+    const Instruction* call_inst) {
+  auto is_pointer = [this](uint32_t type_id) {
+    const Instruction* type_inst = get_def_use_mgr()->GetDef(type_id);
+    return type_inst->opcode() == SpvOpTypePointer;
+  };
+  if (is_pointer(call_inst->type_id())) return true;
+  for (uint32_t i = kFunctionCallFunctionIdInIdx + 1;
+       i < call_inst->NumInOperands(); ++i) {
+    const Instruction* arg_inst =
+        get_def_use_mgr()->GetDef(call_inst->GetSingleWordInOperand(i));
+    if (is_pointer(arg_inst->type_id())) return true;
+  }
+  return false;
+}
+
+bool InlineHeuristicPass::IsForcedInline(const Instruction* call_inst) {
+  return HasOpaqueArgsOrReturn(call_inst) || HasPointerArgsOrReturn(call_inst);
+}
+
+uint32_t InlineHeuristicPass::CountConstantArgs(
+    const Instruction* call_inst) const {
+  uint32_t count = 0;
+  for (uint32_t i = kFunctionCallFunctionIdInIdx + 1;
+       i < call_inst->NumInOperands(); ++i) {
+    const Instruction* arg_inst =
+        get_def_use_mgr()->GetDef(call_inst->GetSingleWordInOperand(i));
+    if (arg_inst->IsConstant()) ++count;
+  }
+  return count;
+}
+
+uint32_t InlineHeuristicPass::GetFunctionSize(const Function* func) const {
+  uint32_t size = 0;
+  for (const auto& bb : *func) {
+    for (auto ii = bb.cbegin(); ii != bb.cend(); ++ii) ++size;
+  }
+  return size;
+}
+
+void InlineHeuristicPass::AddCallsFrom(const Function* func) {
+  for (const auto& bb : *func) {
+    for (const auto& inst : bb) {
+      if (inst.opcode() == SpvOpFunctionCall)
+        ++call_counts_[inst.GetSingleWordInOperand(
+            kFunctionCallFunctionIdInIdx)];
+    }
+  }
+}
+
+bool InlineHeuristicPass::ShouldInline(const Instruction* call_inst,
+                                       uint32_t loop_depth, bool is_cold) {
+  if (IsForcedInline(call_inst)) return true;
+
+  const uint32_t callee_id =
+      call_inst->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+  const uint32_t size = GetFunctionSize(id2function_[callee_id]);
+
+  // The only call to a function that is not visible outside of the module
+  // does not grow the module once the function is removed, whatever its size.
+  const bool is_single_call = call_counts_[callee_id] == 1 &&
+                              externally_visible_.count(callee_id) == 0;
+  if (is_single_call) return true;
+
+  // Code that never ran in the profile is not worth growing the module for.
+  if (is_cold) return false;
+
+  // A call in a loop is executed many times, so removing its overhead and
+  // exposing the callee to the optimizations of the loop is worth more code.
+  uint32_t threshold =
+      kInlineThreshold + kConstantArgumentBonus * CountConstantArgs(call_inst);
+  threshold *= 1 + std::min(loop_depth, kMaxLoopDepthBonus);
+  if (size > threshold || size > size_budget_) return false;
+
+  size_budget_ -= size;
+  return true;
+}
+
+bool InlineHeuristicPass::InlineHeuristic(Function* func) {
+  // The loop nest of |func| is computed before it is modified.  The blocks
+  // inlined at a call site are given the depth of the block of the call.
+  // They are also cold if the block of the call is, since they only run when
+  // the call does.
+  std::unordered_map<uint32_t, uint32_t> loop_depths;
+  std::unordered_set<uint32_t> cold_blocks;
+  LoopDescriptor* loop_descriptor = context()->GetLoopDescriptor(func);
+  for (auto& bb : *func) {
+    Loop* loop = (*loop_descriptor)[bb.id()];
+    loop_depths[bb.id()] =
+        loop ? static_cast<uint32_t>(loop->GetDepth()) : 0;
+    if (bb.HasProfileCount() && bb.profile_count() == 0)
+      cold_blocks.insert(bb.id());
+  }
+
+  bool modified = false;
+  // Using block iterators here because of block erasures and insertions.
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    const uint32_t loop_depth = loop_depths[bi->id()];
+    const bool is_cold = cold_blocks.count(bi->id()) != 0;
+    for (auto ii = bi->begin(); ii != bi->end();) {
+      if (IsInlinableFunctionCall(&*ii) &&
+          ShouldInline(&*ii, loop_depth, is_cold)) {
+        // The calls made by the callee are now made from |func| as well.
+        const uint32_t callee_id =
+            ii->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+        --call_counts_[callee_id];
+        AddCallsFrom(id2function_[callee_id]);
+
+        // Inline call.
+        std::vector<std::unique_ptr<BasicBlock>> newBlocks;
+        std::vector<std::unique_ptr<Instruction>> newVars;
+        GenInlineCode(&newBlocks, &newVars, ii, bi);
+        // If call block is replaced with more than one block, point
+        // succeeding phis at new last block.
+        if (newBlocks.size() > 1) UpdateSucceedingPhis(newBlocks);
+        for (auto& bb : newBlocks) {
+          loop_depths[bb->id()] = loop_depth;
+          if (is_cold) cold_blocks.insert(bb->id());
+        }
+
+        // Kill the name and decorations of the call, which will be deleted.
+        context()->KillNamesAndDecorates(&*ii);
+
+        bi = bi.Erase();
+
+        for (auto& bb : newBlocks) {
+          bb->SetParent(func);
+        }
+        bi = bi.InsertBefore(&newBlocks);
+        // Insert new function variables.
+        if (newVars.size() > 0)
+          func->begin()->begin().InsertBefore(std::move(newVars));
+        // Restart inlining at beginning of calling block.
+        ii = bi->begin();
+        modified = true;
+      } else {
+        ++ii;
+      }
+    }
+  }
+  return modified;
+}
+
+void InlineHeuristicPass::AddCallTreePostOrder(
+    uint32_t func_id, std::unordered_set<uint32_t>* visited,
+    std::vector<Function*>* order) {
+  if (!visited->insert(func_id).second) return;
+  Function* func = id2function_[func_id];
+  if (func == nullptr) return;
+  for (const auto& bb : *func) {
+    for (const auto& inst : bb) {
+      if (inst.opcode() == SpvOpFunctionCall)
+        AddCallTreePostOrder(
+            inst.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx),
+            visited, order);
+    }
+  }
+  order->push_back(func);
+}
+
+void InlineHeuristicPass::Initialize() {
+  InitializeInline();
+  call_counts_.clear();
+  externally_visible_.clear();
+
+  for (auto& func : *get_module()) AddCallsFrom(&func);
+
+  for (auto& e : get_module()->entry_points())
+    externally_visible_.insert(
+        e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+  for (auto& a : get_module()->annotations()) {
+    if (a.opcode() == SpvOpDecorate &&
+        a.GetSingleWordOperand(1) == SpvDecorationLinkageAttributes &&
+        a.GetSingleWordOperand(a.NumOperands() - 1) ==
+            SpvLinkageTypeExport) {
+      externally_visible_.insert(a.GetSingleWordOperand(0));
+    }
+  }
+}
+
+Pass::Status InlineHeuristicPass::Process() {
+  Initialize();
+
+  // Callees are processed before their callers, so that the size of a callee
+  // includes the calls that were inlined into it.  The loop descriptor of
+  // each function is built before the function is modified.
+  std::unordered_set<uint32_t> visited;
+  std::vector<Function*> order;
+  for (auto& e : get_module()->entry_points())
+    AddCallTreePostOrder(e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx),
+                         &visited, &order);
+
+  bool modified = false;
+  for (Function* func : order) modified |= InlineHeuristic(func);
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,91 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INLINE_HEURISTIC_PASS_H_
+#define SOURCE_OPT_INLINE_HEURISTIC_PASS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/function.h"
+#include "source/opt/inline_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class InlineHeuristicPass : public InlinePass {
+ public:
+  explicit InlineHeuristicPass(uint32_t size_budget)
+      : size_budget_(size_budget) {}
+  Status Process() override;
+
+  const char* name() const override { return "inline-heuristic"; }
+
+ private:
+  // Inlines the calls in |func| chosen by ShouldInline, as well as the calls
+  // chosen in the code that is inlined into |func|.  Returns true if |func|
+  // is modified.
+  bool InlineHeuristic(Function* func);
+
+  // Returns true if the call |call_inst|, in a block nested in |loop_depth|
+  // loops, should be inlined.  |is_cold| is true if the profile shows that
+  // the block never ran.  Updates the remaining budget if it is.
+  bool ShouldInline(const Instruction* call_inst, uint32_t loop_depth,
+                    bool is_cold);
+
+  // Returns true if |call_inst| must be inlined for the module to be legal,
+  // because it passes or returns an opaque type or a pointer.
+  bool IsForcedInline(const Instruction* call_inst);
+
+  // Returns true if function call |call_inst| has a pointer argument or
+  // return type.
+  bool HasPointerArgsOrReturn(const Instruction* call_inst);
+
+  // Returns the number of arguments of |call_inst| that are constants.
+  uint32_t CountConstantArgs(const Instruction* call_inst) const;
+
+  // Returns the number of instructions in the body of |func|.
+  uint32_t GetFunctionSize(const Function* func) const;
+
+  // Records in |call_counts_| the calls made by |func|, as if it was called
+  // once more.
+  void AddCallsFrom(const Function* func);
+
+  // Appends to |order| the functions reachable from |func_id| that are not in
+  // |visited|, callees before callers.
+  void AddCallTreePostOrder(uint32_t func_id,
+                            std::unordered_set<uint32_t>* visited,
+                            std::vector<Function*>* order);
+
+  // Initializes the state of the pass.
+  void Initialize();
+
+  // The number of instructions by which the module may still grow because of
+  // calls that are not forced.
+  uint32_t size_budget_;
+
+  // The number of calls to each function.
+  std::unordered_map<uint32_t, uint32_t> call_counts_;
+
+  // The ids of the functions that can be called from outside the module.
+  std::unordered_set<uint32_t> externally_visible_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INLINE_HEURISTIC_PASS_H_
@@ -20,49 +20,6 @@
 
 namespace spvtools {
 namespace opt {
-namespace {
-
-const uint32_t kTypePointerTypeIdInIdx = 1;
-
-}  // anonymous namespace
-
-bool InlineOpaquePass::IsOpaqueType(uint32_t typeId) {
-  const Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
-  switch (typeInst->opcode()) {
-    case SpvOpTypeSampler:
-    case SpvOpTypeImage:
-    case SpvOpTypeSampledImage:
-      return true;
-    case SpvOpTypePointer:
-      return IsOpaqueType(
-          typeInst->GetSingleWordInOperand(kTypePointerTypeIdInIdx));
-    default:
-      break;
-  }
-  // TODO(greg-lunarg): Handle arrays containing opaque type
-  if (typeInst->opcode() != SpvOpTypeStruct) return false;
-  // Return true if any member is opaque
-  return !typeInst->WhileEachInId([this](const uint32_t* tid) {
-    if (IsOpaqueType(*tid)) return false;
-    return true;
-  });
-}
-
-bool InlineOpaquePass::HasOpaqueArgsOrReturn(const Instruction* callInst) {
-  // Check return type
-  if (IsOpaqueType(callInst->type_id())) return true;
-  // Check args
-  int icnt = 0;
-  return !callInst->WhileEachInId([&icnt, this](const uint32_t* iid) {
-    if (icnt > 0) {
-      const Instruction* argInst = get_def_use_mgr()->GetDef(*iid);
-      if (IsOpaqueType(argInst->type_id())) return false;
-    }
-    ++icnt;
-    return true;
-  });
-}
-
 bool InlineOpaquePass::InlineOpaque(Function* func) {
   bool modified = false;
   // Using block iterators here because of block erasures and insertions.
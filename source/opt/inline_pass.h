@@ -119,6 +119,12 @@ class InlinePass : public Pass {
   // Return true if |inst| is a function call that can be inlined.
   bool IsInlinableFunctionCall(const Instruction* inst);
 
+  // Return true if |typeId| is or contains opaque type
+  bool IsOpaqueType(uint32_t typeId);
+
+  // Return true if function call |callInst| has opaque argument or return type
+  bool HasOpaqueArgsOrReturn(const Instruction* callInst);
+
   // Return true if |func| does not have a return that is
   // nested in a structured if, switch or loop.
   bool HasNoReturnInStructuredConstruct(Function* func);
@@ -136,20 +136,35 @@ void InstBindlessCheckPass::GenBindlessCheckCode(
   // Generate full runtime bounds test code with true branch
   // being full reference and false branch being debug output and zero
   // for the referenced value.
+  if (ref_block_itr->GetParent() != func_)
+    InitializeFunction(ref_block_itr->GetParent());
+  uint32_t orig_blk_id = GetOriginalBlockId(ref_block_itr->id());
   MovePreludeCode(ref_inst_itr, ref_block_itr, &new_blk_ptr);
   InstructionBuilder builder(
       context(), &*new_blk_ptr,
       IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
   uint32_t error_id = builder.GetUintConstantId(kInstErrorBindlessBounds);
-  Instruction* ult_inst =
-      builder.AddBinaryOp(GetBoolId(), SpvOpULessThan, index_id, length_id);
+  // Reuse a dominating or hoisted test of the same index if possible.
+  bool reports_error = false;
+  uint32_t in_bounds_id =
+      FindDominatingCheck(index_id, length_id, orig_blk_id, &reports_error);
+  if (in_bounds_id == 0)
+    in_bounds_id = GenHoistedCheck(index_id, length_id, orig_blk_id);
+  if (in_bounds_id == 0)
+    in_bounds_id =
+        builder.AddBinaryOp(GetBoolId(), SpvOpULessThan, index_id, length_id)
+            ->result_id();
+  bool write_error = !reports_error;
+  if (write_error)
+    checks_[std::make_pair(index_id, length_id)].push_back(
+        {orig_blk_id, in_bounds_id, true});
   uint32_t merge_blk_id = TakeNextId();
   uint32_t valid_blk_id = TakeNextId();
   uint32_t invalid_blk_id = TakeNextId();
   std::unique_ptr<Instruction> merge_label(NewLabel(merge_blk_id));
   std::unique_ptr<Instruction> valid_label(NewLabel(valid_blk_id));
   std::unique_ptr<Instruction> invalid_label(NewLabel(invalid_blk_id));
-  (void)builder.AddConditionalBranch(ult_inst->result_id(), valid_blk_id,
+  (void)builder.AddConditionalBranch(in_bounds_id, valid_blk_id,
                                      invalid_blk_id, merge_blk_id,
                                      SpvSelectionControlMaskNone);
   // Close selection block and gen valid reference block
@@ -196,9 +211,11 @@ void InstBindlessCheckPass::GenBindlessCheckCode(
   new_blocks->push_back(std::move(new_blk_ptr));
   new_blk_ptr.reset(new BasicBlock(std::move(invalid_label)));
   builder.SetInsertPoint(&*new_blk_ptr);
-  uint32_t u_index_id = GenUintCastCode(index_id, &builder);
-  GenDebugStreamWrite(instruction_idx, stage_idx,
-                      {error_id, u_index_id, length_id}, &builder);
+  if (write_error) {
+    uint32_t u_index_id = GenUintCastCode(index_id, &builder);
+    GenDebugStreamWrite(instruction_idx, stage_idx,
+                        {error_id, u_index_id, length_id}, &builder);
+  }
   // Remember last invalid block id
   uint32_t last_invalid_blk_id = new_blk_ptr->GetLabelInst()->result_id();
   // Gen zero for invalid  reference
@@ -219,13 +236,102 @@ void InstBindlessCheckPass::GenBindlessCheckCode(
   }
   context()->KillInst(&*ref_inst_itr);
   MovePostludeCode(ref_block_itr, &new_blk_ptr);
+  // Remember which original block the new blocks come from
+  for (auto& blk : *new_blocks) original_block_ids_[blk->id()] = orig_blk_id;
+  original_block_ids_[merge_blk_id] = orig_blk_id;
+  tail_blocks_[orig_blk_id] = &*new_blk_ptr;
   // Add remainder/merge block to new blocks
   new_blocks->push_back(std::move(new_blk_ptr));
 }
 
+void InstBindlessCheckPass::InitializeFunction(Function* func) {
+  func_ = func;
+  dom_analysis_ = context()->GetDominatorAnalysis(func);
+  loop_descriptor_ = context()->GetLoopDescriptor(func);
+  preheader_ids_.clear();
+  for (auto& loop : *loop_descriptor_) {
+    BasicBlock* preheader = loop.GetPreHeaderBlock();
+    preheader_ids_[&loop] = preheader ? preheader->id() : 0;
+  }
+  // Parameters are invariant in every loop, as if defined in no block.
+  def_block_ids_.clear();
+  func->ForEachParam(
+      [this](Instruction* param) { def_block_ids_[param->result_id()] = 0; });
+  for (auto& blk : *func) {
+    for (auto& inst : blk) {
+      if (inst.result_id() != 0) def_block_ids_[inst.result_id()] = blk.id();
+    }
+  }
+  original_block_ids_.clear();
+  tail_blocks_.clear();
+  checks_.clear();
+}
+
+uint32_t InstBindlessCheckPass::GetOriginalBlockId(uint32_t block_id) const {
+  auto it = original_block_ids_.find(block_id);
+  return it == original_block_ids_.end() ? block_id : it->second;
+}
+
+uint32_t InstBindlessCheckPass::FindDominatingCheck(uint32_t index_id,
+                                                    uint32_t length_id,
+                                                    uint32_t block_id,
+                                                    bool* reports_error) const {
+  // A test in the same block precedes the reference, since blocks are
+  // instrumented in order. Since the index dominates the test, and the test
+  // dominates the reference, the test was executed after the last definition
+  // of the index on every path to the reference.
+  auto it = checks_.find(std::make_pair(index_id, length_id));
+  if (it == checks_.end()) return 0;
+  uint32_t found_id = 0;
+  for (const auto& check : it->second) {
+    if (!dom_analysis_->Dominates(check.block_id, block_id)) continue;
+    if (check.reports_error) {
+      *reports_error = true;
+      return check.in_bounds_id;
+    }
+    found_id = check.in_bounds_id;
+  }
+  return found_id;
+}
+
+uint32_t InstBindlessCheckPass::GenHoistedCheck(uint32_t index_id,
+                                                uint32_t length_id,
+                                                uint32_t block_id) {
+  // Find the outermost loop with a preheader in which the index is invariant.
+  const Loop* hoist_loop = nullptr;
+  auto def_it = def_block_ids_.find(index_id);
+  for (const Loop* loop = (*loop_descriptor_)[block_id]; loop != nullptr;
+       loop = loop->GetParent()) {
+    if (def_it != def_block_ids_.end() && loop->IsInsideLoop(def_it->second))
+      break;
+    if (def_it == def_block_ids_.end() &&
+        !get_def_use_mgr()->GetDef(index_id)->IsConstant())
+      break;
+    if (preheader_ids_.at(loop) == 0) break;
+    hoist_loop = loop;
+  }
+  if (hoist_loop == nullptr) return 0;
+  // Insert the test before the terminator of the preheader.
+  uint32_t preheader_id = preheader_ids_.at(hoist_loop);
+  auto tail_it = tail_blocks_.find(preheader_id);
+  BasicBlock* preheader = tail_it == tail_blocks_.end()
+                              ? id2block_.at(preheader_id)
+                              : tail_it->second;
+  InstructionBuilder builder(
+      context(), preheader->terminator(),
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  uint32_t in_bounds_id =
+      builder.AddBinaryOp(GetBoolId(), SpvOpULessThan, index_id, length_id)
+          ->result_id();
+  checks_[std::make_pair(index_id, length_id)].push_back(
+      {preheader_id, in_bounds_id, false});
+  return in_bounds_id;
+}
+
 void InstBindlessCheckPass::InitializeInstBindlessCheck() {
   // Initialize base class
   InitializeInstrument();
+  func_ = nullptr;
   // Look for related extensions
   ext_descriptor_indexing_defined_ = false;
   for (auto& ei : get_module()->extensions()) {
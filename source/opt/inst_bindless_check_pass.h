@@ -17,7 +17,14 @@
 #ifndef LIBSPIRV_OPT_INST_BINDLESS_CHECK_PASS_H_
 #define LIBSPIRV_OPT_INST_BINDLESS_CHECK_PASS_H_
 
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "instrument_pass.h"
+#include "source/opt/dominator_analysis.h"
+#include "source/opt/loop_descriptor.h"
 
 namespace spvtools {
 namespace opt {
@@ -63,6 +70,12 @@ class InstBindlessCheckPass : public InstrumentPass {
   // comprise all instructions following |ref_inst_itr|,
   // preceded by a phi instruction.
   //
+  // The bounds test is shared with an earlier check of the same index and
+  // array size that dominates the reference, in which case no error record
+  // is written since the earlier check already wrote it. The bounds test of
+  // an index which is invariant in the loops containing the reference is
+  // hoisted to the preheader of the outermost such loop.
+  //
   // This instrumentation pass utilizes GenDebugStreamWrite() to write its
   // error records. The validation-specific part of the error record will
   // have the format:
@@ -81,10 +94,70 @@ class InstBindlessCheckPass : public InstrumentPass {
       UptrVectorIterator<BasicBlock> ref_block_itr, uint32_t instruction_idx,
       uint32_t stage_idx, std::vector<std::unique_ptr<BasicBlock>>* new_blocks);
 
+  // A bounds test already generated in the current function.
+  struct BoundsCheck {
+    // The original block of the function whose end the test dominates.
+    uint32_t block_id;
+    // The id of the result of the test.
+    uint32_t in_bounds_id;
+    // True if the test is followed by the writing of an error record when it
+    // fails.
+    bool reports_error;
+  };
+
+  // Initialize the state of the current function |func|, which must not have
+  // been instrumented yet.
+  void InitializeFunction(Function* func);
+
+  // Return the id of the block of the current function, before any
+  // instrumentation, containing the block |block_id|.
+  uint32_t GetOriginalBlockId(uint32_t block_id) const;
+
+  // Return the id of the result of a bounds test of |index_id| against
+  // |length_id| that dominates the end of the original block |block_id| and
+  // whose result is still the same there, or 0 if there is none. Set
+  // |reports_error| to true if that test writes the error record itself.
+  uint32_t FindDominatingCheck(uint32_t index_id, uint32_t length_id,
+                               uint32_t block_id, bool* reports_error) const;
+
+  // If |index_id| is invariant in the loop containing the original block
+  // |block_id|, generate the bounds test of |index_id| against |length_id| at
+  // the end of the preheader of the outermost loop in which it is invariant,
+  // and return its id. Otherwise return 0.
+  uint32_t GenHoistedCheck(uint32_t index_id, uint32_t length_id,
+                           uint32_t block_id);
+
   Pass::Status ProcessImpl();
 
   // True if VK_EXT_descriptor_indexing is defined
   bool ext_descriptor_indexing_defined_;
+
+  // Function currently being instrumented
+  Function* func_;
+
+  // Dominator analysis and loops of the current function before
+  // instrumentation.
+  DominatorAnalysis* dom_analysis_;
+  LoopDescriptor* loop_descriptor_;
+
+  // Map from the loops of the current function to the id of their preheader,
+  // or 0 if they have none.
+  std::unordered_map<const Loop*, uint32_t> preheader_ids_;
+
+  // Map from the ids defined in the current function before instrumentation
+  // to the id of their block.
+  std::unordered_map<uint32_t, uint32_t> def_block_ids_;
+
+  // Map from the blocks created by instrumentation to the original block
+  // they were split from.
+  std::unordered_map<uint32_t, uint32_t> original_block_ids_;
+
+  // Map from the original blocks which were split to the block now holding
+  // their terminator.
+  std::unordered_map<uint32_t, BasicBlock*> tail_blocks_;
+
+  // The bounds tests generated in the current function, by index and length.
+  std::map<std::pair<uint32_t, uint32_t>, std::vector<BoundsCheck>> checks_;
 };
 
 }  // namespace opt
@@ -0,0 +1,322 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/inst_profile_pass.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+
+#include "source/opt/loop_descriptor.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// Returns the representative of the set of |idx| in the union-find
+// |parents|.
+uint32_t FindRoot(std::vector<uint32_t>* parents, uint32_t idx) {
+  while ((*parents)[idx] != idx) {
+    (*parents)[idx] = (*parents)[(*parents)[idx]];
+    idx = (*parents)[idx];
+  }
+  return idx;
+}
+
+}  // anonymous namespace
+
+ProfileCounterLayout::ProfileCounterLayout(IRContext* context,
+                                           bool count_edges)
+    : count_edges_(count_edges), counter_count_(0) {
+  // The counter buffer is a storage buffer, which only shaders have.
+  if (!context->get_feature_mgr()->HasCapability(SpvCapabilityShader)) return;
+  for (auto& func : *context->module()) {
+    // Function declarations have no block to count.
+    if (func.begin() == func.end()) continue;
+    FunctionLayout layout;
+    layout.function_id = func.result_id();
+    layout.first_counter = counter_count_;
+    for (auto& bb : func) layout.block_ids.push_back(bb.id());
+    if (!count_edges_ || !AddEdges(context, &func, &layout))
+      counter_count_ += static_cast<uint32_t>(layout.block_ids.size());
+    functions_.push_back(std::move(layout));
+  }
+}
+
+bool ProfileCounterLayout::AddEdges(IRContext* context, Function* func,
+                                    FunctionLayout* layout) {
+  const uint32_t entry_id = func->begin()->id();
+  std::vector<Edge>& edges = layout->edges;
+  std::unordered_map<uint32_t, uint32_t> succ_counts;
+  std::unordered_map<uint32_t, uint32_t> pred_counts;
+  std::unordered_set<uint32_t> switch_blocks;
+  for (const auto& bb : *func) {
+    const uint32_t bb_id = bb.id();
+    if (bb.terminator()->opcode() == SpvOpSwitch) switch_blocks.insert(bb_id);
+    std::unordered_set<uint32_t> succs;
+    bb.ForEachSuccessorLabel([&edges, &succs, bb_id](const uint32_t succ) {
+      if (succs.insert(succ).second) edges.push_back({bb_id, succ, kNoCounter});
+    });
+    for (uint32_t succ : succs) ++pred_counts[succ];
+    succ_counts[bb_id] = static_cast<uint32_t>(succs.size());
+    if (succs.empty()) edges.push_back({bb_id, entry_id, kNoCounter});
+  }
+
+  // Returns true if |edge| could only be counted by splitting it, and
+  // splitting it would break the structured control flow: a critical back
+  // edge would no longer come from the back-edge block of its loop, and a
+  // critical switch edge would no longer lead to a case construct.
+  LoopDescriptor* loop_descriptor = context->GetLoopDescriptor(func);
+  auto is_unsplittable = [loop_descriptor, &switch_blocks](const Edge& edge) {
+    if (switch_blocks.count(edge.from)) return true;
+    const Loop* loop = (*loop_descriptor)[edge.to];
+    return loop != nullptr && loop->GetHeaderBlock()->id() == edge.to &&
+           loop->IsInsideLoop(edge.from);
+  };
+  auto is_critical = [entry_id, &succ_counts, &pred_counts](const Edge& edge) {
+    return edge.to != entry_id && succ_counts[edge.from] > 1 &&
+           pred_counts[edge.to] > 1;
+  };
+
+  // Order the edges by decreasing preference for the spanning tree.
+  auto get_rank = [entry_id, loop_descriptor, &is_critical,
+                   &is_unsplittable](const Edge& edge) {
+    const bool is_virtual = edge.to == entry_id;
+    const bool critical = is_critical(edge);
+    const bool unsplittable = critical && is_unsplittable(edge);
+    const Loop* loop = (*loop_descriptor)[edge.from];
+    const size_t depth = loop ? loop->GetDepth() : 0;
+    return std::make_tuple(unsplittable, critical, depth, !is_virtual);
+  };
+  std::vector<size_t> order(edges.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&edges, &get_rank](size_t a, size_t b) {
+                     return get_rank(edges[a]) > get_rank(edges[b]);
+                   });
+
+  // Build the spanning tree, and count the edges which would close a cycle
+  // in it.
+  std::unordered_map<uint32_t, uint32_t> block_idx;
+  for (uint32_t id : layout->block_ids)
+    block_idx[id] = static_cast<uint32_t>(block_idx.size());
+  std::vector<uint32_t> parents(block_idx.size());
+  std::iota(parents.begin(), parents.end(), 0);
+  std::vector<bool> is_counted(edges.size(), false);
+  for (size_t i : order) {
+    const uint32_t from_root = FindRoot(&parents, block_idx[edges[i].from]);
+    const uint32_t to_root = FindRoot(&parents, block_idx[edges[i].to]);
+    if (from_root != to_root) {
+      parents[from_root] = to_root;
+      continue;
+    }
+    // The edges which cannot be split go from a block to one of its
+    // dominators or from a dominator, so they do not form cycles in
+    // structured control flow.  Count the blocks otherwise.
+    if (is_critical(edges[i]) && is_unsplittable(edges[i])) {
+      edges.clear();
+      return false;
+    }
+    is_counted[i] = true;
+  }
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (is_counted[i]) edges[i].counter = counter_count_++;
+  }
+  return true;
+}
+
+std::vector<uint64_t> ProfileCounterLayout::GetBlockCounts(
+    const FunctionLayout& func, const uint32_t* counters) const {
+  const size_t block_cnt = func.block_ids.size();
+  std::vector<uint64_t> counts(block_cnt, 0);
+  if (func.edges.empty()) {
+    for (size_t i = 0; i < block_cnt; ++i)
+      counts[i] = counters[func.first_counter + i];
+    return counts;
+  }
+
+  std::unordered_map<uint32_t, size_t> block_idx;
+  for (size_t i = 0; i < block_cnt; ++i) block_idx[func.block_ids[i]] = i;
+  const size_t edge_cnt = func.edges.size();
+  std::vector<int64_t> edge_counts(edge_cnt, 0);
+  std::vector<bool> is_known(edge_cnt, false);
+  std::vector<std::vector<size_t>> in_edges(block_cnt);
+  std::vector<std::vector<size_t>> out_edges(block_cnt);
+  for (size_t i = 0; i < edge_cnt; ++i) {
+    const Edge& edge = func.edges[i];
+    if (edge.counter != kNoCounter) {
+      edge_counts[i] = counters[edge.counter];
+      is_known[i] = true;
+    }
+    in_edges[block_idx[edge.to]].push_back(i);
+    out_edges[block_idx[edge.from]].push_back(i);
+  }
+
+  // The flow into each block is equal to the flow out of it, so the count of
+  // the only edge of a block which is not known yet follows from the others.
+  // Starting from the leaves of the spanning tree, this gives all of them.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t b = 0; b < block_cnt; ++b) {
+      int64_t flow = 0;
+      size_t unknown_cnt = 0;
+      size_t unknown = 0;
+      bool unknown_is_in = false;
+      for (size_t e : in_edges[b]) {
+        if (is_known[e]) {
+          flow += edge_counts[e];
+        } else {
+          ++unknown_cnt;
+          unknown = e;
+          unknown_is_in = true;
+        }
+      }
+      for (size_t e : out_edges[b]) {
+        if (is_known[e]) {
+          flow -= edge_counts[e];
+        } else {
+          ++unknown_cnt;
+          unknown = e;
+          unknown_is_in = false;
+        }
+      }
+      if (unknown_cnt != 1) continue;
+      edge_counts[unknown] = unknown_is_in ? -flow : flow;
+      is_known[unknown] = true;
+      changed = true;
+    }
+  }
+
+  // Counters which wrapped around can make the computed counts negative.
+  for (size_t b = 0; b < block_cnt; ++b) {
+    int64_t count = 0;
+    for (size_t e : in_edges[b]) count += edge_counts[e];
+    counts[b] = count > 0 ? static_cast<uint64_t>(count) : 0;
+  }
+  return counts;
+}
+
+void InstProfilePass::GenCounterIncrement(uint32_t counter,
+                                          Instruction* insert_before) {
+  InstructionBuilder builder(
+      context(), insert_before,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  Instruction* counter_ptr_inst = builder.AddTernaryOp(
+      GetOutputBufferUintPtrId(), SpvOpAccessChain, GetOutputBufferId(),
+      builder.GetUintConstantId(kDebugOutputDataOffset),
+      builder.GetUintConstantId(counter));
+  (void)builder.AddQuadOp(
+      GetUintId(), SpvOpAtomicIAdd, counter_ptr_inst->result_id(),
+      builder.GetUintConstantId(SpvScopeDevice),
+      builder.GetUintConstantId(SpvMemorySemanticsMaskNone),
+      builder.GetUintConstantId(1));
+}
+
+Instruction* InstProfilePass::GetStartInsertPoint(BasicBlock* bb) {
+  auto ii = bb->begin();
+  while (ii->opcode() == SpvOpPhi || ii->opcode() == SpvOpVariable) ++ii;
+  return &*ii;
+}
+
+Instruction* InstProfilePass::GetEndInsertPoint(BasicBlock* bb) {
+  Instruction* merge_inst = bb->GetMergeInst();
+  return merge_inst ? merge_inst : &*bb->tail();
+}
+
+void InstProfilePass::GenEdgeCounterIncrement(
+    Function* func, const ProfileCounterLayout::Edge& edge) {
+  BasicBlock* from_blk = id2block_.at(edge.from);
+  if (edge.to == func->begin()->id() || succ_counts_[edge.from] == 1) {
+    GenCounterIncrement(edge.counter, GetEndInsertPoint(from_blk));
+    return;
+  }
+  BasicBlock* to_blk = id2block_.at(edge.to);
+  if (pred_counts_[edge.to] == 1) {
+    GenCounterIncrement(edge.counter, GetStartInsertPoint(to_blk));
+    return;
+  }
+  assert(from_blk->tail()->opcode() != SpvOpSwitch &&
+         "Switch edges are never split");
+
+  // Split the edge with a block which only branches to its target.  It is
+  // placed after the source block, which dominates it.
+  const uint32_t split_blk_id = TakeNextId();
+  std::unique_ptr<BasicBlock> new_blk_ptr(
+      new BasicBlock(NewLabel(split_blk_id)));
+  context()->set_instr_block(new_blk_ptr->GetLabelInst(), &*new_blk_ptr);
+  InstructionBuilder builder(
+      context(), &*new_blk_ptr,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  (void)builder.AddBranch(edge.to);
+  new_blk_ptr->SetParent(func);
+  BasicBlock* split_blk =
+      func->InsertBasicBlockAfter(std::move(new_blk_ptr), from_blk);
+  id2block_[split_blk_id] = split_blk;
+  GenCounterIncrement(edge.counter, &*split_blk->tail());
+
+  from_blk->ForEachSuccessorLabel([&edge, split_blk_id](uint32_t* succ) {
+    if (*succ == edge.to) *succ = split_blk_id;
+  });
+  get_def_use_mgr()->AnalyzeInstUse(&*from_blk->tail());
+  to_blk->ForEachPhiInst([this, &edge, split_blk_id](Instruction* phi) {
+    for (uint32_t i = 1; i < phi->NumInOperands(); i += 2) {
+      if (phi->GetSingleWordInOperand(i) == edge.from)
+        phi->SetInOperand(i, {split_blk_id});
+    }
+    get_def_use_mgr()->AnalyzeInstUse(phi);
+  });
+}
+
+Pass::Status InstProfilePass::Process() {
+  InitializeInstrument();
+  // The layout is computed before any change to the module, as it is when
+  // the counters are read back.
+  ProfileCounterLayout layout(context(), count_edges_);
+  if (layout.counter_count() == 0) return Status::SuccessWithoutChange;
+
+  for (const auto& func_layout : layout.functions()) {
+    Function* func = id2function_.at(func_layout.function_id);
+    if (func_layout.edges.empty()) {
+      for (size_t i = 0; i < func_layout.block_ids.size(); ++i) {
+        GenCounterIncrement(
+            func_layout.first_counter + static_cast<uint32_t>(i),
+            GetStartInsertPoint(id2block_.at(func_layout.block_ids[i])));
+      }
+      continue;
+    }
+
+    // Splitting an edge does not change the number of successors of its
+    // source or of predecessors of its target, so they are computed once.
+    const uint32_t entry_id = func->begin()->id();
+    succ_counts_.clear();
+    pred_counts_.clear();
+    for (const auto& edge : func_layout.edges) {
+      if (edge.to == entry_id) continue;
+      ++succ_counts_[edge.from];
+      ++pred_counts_[edge.to];
+    }
+    for (const auto& edge : func_layout.edges) {
+      if (edge.counter != ProfileCounterLayout::kNoCounter)
+        GenEdgeCounterIncrement(func, edge);
+    }
+  }
+  return Status::SuccessWithChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,150 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INST_PROFILE_PASS_H_
+#define SOURCE_OPT_INST_PROFILE_PASS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/instrument_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// The profile counters of a module: the blocks or the edges of its functions
+// that are counted, and the index of their counter in the counter buffer.
+//
+// When edges are counted, only the edges which are not in a spanning tree of
+// the control flow graph of each function get a counter.  The graph includes
+// a virtual edge from each block leaving the function to its entry block, so
+// that the flow into each block is equal to the flow out of it.  This is
+// enough to compute the count of the other edges, and of every block.  The
+// tree prefers the edges which could only be counted by splitting them, then
+// the edges in the deepest loops, so that they are not counted.  The virtual
+// edges, which are taken once per call, come last.
+//
+// Splitting a back edge or an edge leaving a switch would break the rules of
+// structured control flow, so those edges always go first in the tree.  If
+// one of them still closes a cycle, the blocks of the function are counted
+// instead of its edges.
+//
+// The layout only depends on the module before it is instrumented, so it can
+// be computed again from that module to read back the counters.
+class ProfileCounterLayout {
+ public:
+  // The index of the counter of an edge which is not counted.
+  static const uint32_t kNoCounter = UINT32_MAX;
+
+  // An edge of the control flow graph.  The virtual edges go from a block
+  // leaving the function to the entry block, which no real edge can reach.
+  struct Edge {
+    uint32_t from;
+    uint32_t to;
+    // The index of the counter of the edge, or kNoCounter.
+    uint32_t counter;
+  };
+
+  // The counters of a function.
+  struct FunctionLayout {
+    uint32_t function_id;
+    // The ids of the blocks of the function, in order.  When blocks are
+    // counted, the counter of the n-th block is |first_counter| + n.
+    std::vector<uint32_t> block_ids;
+    uint32_t first_counter;
+    // The edges of the function, when edges are counted.  Empty if its
+    // blocks are counted instead.
+    std::vector<Edge> edges;
+  };
+
+  // Computes the counters of the functions of |context|, counting their
+  // edges if |count_edges| is true, or else their blocks.  Modules without
+  // the Shader capability have no counters.
+  ProfileCounterLayout(IRContext* context, bool count_edges);
+
+  bool count_edges() const { return count_edges_; }
+
+  const std::vector<FunctionLayout>& functions() const { return functions_; }
+
+  // Returns the number of counters of the module.
+  uint32_t counter_count() const { return counter_count_; }
+
+  // Returns the execution counts of the blocks of |func|, in the order of
+  // its |block_ids|, computed from the values of the |counters| of the
+  // module.
+  std::vector<uint64_t> GetBlockCounts(const FunctionLayout& func,
+                                       const uint32_t* counters) const;
+
+ private:
+  // Adds the edges of |func| to |layout| and gives a counter to the ones
+  // which are not in the spanning tree.  Returns false, and adds no edge, if
+  // an edge which cannot be split would need a counter.
+  bool AddEdges(IRContext* context, Function* func, FunctionLayout* layout);
+
+  bool count_edges_;
+  std::vector<FunctionLayout> functions_;
+  uint32_t counter_count_;
+};
+
+// See optimizer.hpp for documentation.
+class InstProfilePass : public InstrumentPass {
+ public:
+  // For test harness only
+  InstProfilePass() : InstProfilePass(7, false) {}
+  // For all other interfaces
+  InstProfilePass(uint32_t desc_set, bool count_edges)
+      : InstrumentPass(desc_set, 0, kInstValidationIdProfile),
+        count_edges_(count_edges) {}
+
+  ~InstProfilePass() override = default;
+
+  Status Process() override;
+
+  const char* name() const override { return "inst-profile-pass"; }
+
+ private:
+  // Generates before |insert_before| the atomic increment of the counter
+  // |counter|.
+  void GenCounterIncrement(uint32_t counter, Instruction* insert_before);
+
+  // Returns the instruction before which the instructions at the start of
+  // |bb| are inserted: the first one which is not an OpPhi or an OpVariable.
+  Instruction* GetStartInsertPoint(BasicBlock* bb);
+
+  // Returns the instruction before which the instructions at the end of |bb|
+  // are inserted: its merge instruction if any, or else its terminator.
+  Instruction* GetEndInsertPoint(BasicBlock* bb);
+
+  // Generates the increment of the counter of |edge| of |func|.  The increment
+  // is put at the end of the source block if it has a single successor, at the
+  // start of the target block if it has a single predecessor, or else in a
+  // new block splitting the edge.  Back edges and switch edges are never
+  // split, as the layout does not count them when they are critical.
+  void GenEdgeCounterIncrement(Function* func,
+                               const ProfileCounterLayout::Edge& edge);
+
+  // True if the edges are counted, false if the blocks are.
+  bool count_edges_;
+
+  // The number of distinct successors and predecessors of each block of the
+  // function being instrumented.
+  std::unordered_map<uint32_t, uint32_t> succ_counts_;
+  std::unordered_map<uint32_t, uint32_t> pred_counts_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INST_PROFILE_PASS_H_
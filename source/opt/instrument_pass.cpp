@@ -292,6 +292,8 @@ uint32_t InstrumentPass::GetOutputBufferBinding() {
   switch (validation_id_) {
     case kInstValidationIdBindless:
       return kDebugOutputBindingStream;
+    case kInstValidationIdProfile:
+      return kDebugOutputBindingProfile;
     default:
       assert(false && "unexpected validation id");
   }
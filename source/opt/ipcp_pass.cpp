@@ -0,0 +1,264 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/ipcp_pass.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "source/opcode.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+const uint32_t kFunctionCallFunctionIdInIdx = 0;
+
+// Returns true if |inst| defines a constant whose value is known at compile
+// time.
+bool IsKnownConstant(const Instruction* inst) {
+  return inst->IsConstant() && !spvOpcodeIsSpecConstant(inst->opcode());
+}
+
+}  // anonymous namespace
+
+void IPCPPass::Initialize() {
+  externally_visible_.clear();
+  for (auto& e : get_module()->entry_points())
+    externally_visible_.insert(
+        e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+  for (auto& a : get_module()->annotations()) {
+    if (a.opcode() == SpvOpDecorate &&
+        a.GetSingleWordOperand(1) == SpvDecorationLinkageAttributes &&
+        a.GetSingleWordOperand(a.NumOperands() - 1) ==
+            SpvLinkageTypeExport) {
+      externally_visible_.insert(a.GetSingleWordOperand(0));
+    }
+  }
+}
+
+void IPCPPass::AddCallTreePostOrder(Function* func,
+                                    std::unordered_set<uint32_t>* visited,
+                                    std::vector<Function*>* order) {
+  if (func == nullptr || !visited->insert(func->result_id()).second) return;
+  for (auto& bb : *func) {
+    for (auto& inst : bb) {
+      if (inst.opcode() == SpvOpFunctionCall)
+        AddCallTreePostOrder(
+            context()->GetFunction(
+                inst.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx)),
+            visited, order);
+    }
+  }
+  order->push_back(func);
+}
+
+std::vector<Function*> IPCPPass::GetCallTreeOrder() {
+  std::unordered_set<uint32_t> visited;
+  std::vector<Function*> order;
+  for (auto& e : get_module()->entry_points())
+    AddCallTreePostOrder(context()->GetFunction(e.GetSingleWordInOperand(
+                             kEntryPointFunctionIdInIdx)),
+                         &visited, &order);
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+std::vector<Instruction*> IPCPPass::GetCalls(const Function* func) {
+  std::vector<Instruction*> calls;
+  const uint32_t func_id = func->result_id();
+  get_def_use_mgr()->ForEachUser(func_id, [&calls, func_id](Instruction* use) {
+    if (use->opcode() == SpvOpFunctionCall &&
+        use->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx) == func_id)
+      calls.push_back(use);
+  });
+  return calls;
+}
+
+IPCPPass::ConstantArgs IPCPPass::GetConstantArgs(const Function* func,
+                                                 const Instruction* call) {
+  ConstantArgs args;
+  uint32_t in_idx = kFunctionCallFunctionIdInIdx + 1;
+  func->ForEachParam([this, call, &args, &in_idx](const Instruction* param) {
+    const uint32_t arg_id = call->GetSingleWordInOperand(in_idx++);
+    const bool is_used = !get_def_use_mgr()->WhileEachUser(
+        param, [](Instruction* use) {
+          return use->IsDecoration() || spvOpcodeIsDebug(use->opcode());
+        });
+    if (is_used && IsKnownConstant(get_def_use_mgr()->GetDef(arg_id)))
+      args.push_back(arg_id);
+    else
+      args.push_back(0);
+  });
+  return args;
+}
+
+uint32_t IPCPPass::GetFunctionSize(const Function* func) const {
+  uint32_t size = 0;
+  for (const auto& bb : *func) {
+    for (auto ii = bb.cbegin(); ii != bb.cend(); ++ii) ++size;
+  }
+  return size;
+}
+
+bool IPCPPass::PropagateArgs(Function* func) {
+  if (IsExternallyVisible(func)) return false;
+  std::vector<Instruction*> calls = GetCalls(func);
+  if (calls.empty()) return false;
+
+  // Keep the arguments that are the same constant in every call.
+  ConstantArgs args = GetConstantArgs(func, calls[0]);
+  for (size_t i = 1; i < calls.size(); ++i) {
+    ConstantArgs call_args = GetConstantArgs(func, calls[i]);
+    for (size_t j = 0; j < args.size(); ++j) {
+      if (args[j] != call_args[j]) args[j] = 0;
+    }
+  }
+
+  // Replace the uses of the parameters in the body of |func|.  The names and
+  // decorations of the parameters are left alone.
+  bool modified = false;
+  size_t param_idx = 0;
+  func->ForEachParam([this, &args, &param_idx, &modified](Instruction* param) {
+    const uint32_t const_id = args[param_idx++];
+    if (const_id == 0) return;
+    std::vector<std::pair<Instruction*, uint32_t>> uses;
+    get_def_use_mgr()->ForEachUse(
+        param, [&uses](Instruction* use, uint32_t operand_index) {
+          if (!use->IsDecoration() && !spvOpcodeIsDebug(use->opcode()))
+            uses.emplace_back(use, operand_index);
+        });
+    for (auto& use : uses) {
+      use.first->SetOperand(use.second, {const_id});
+      get_def_use_mgr()->AnalyzeInstUse(use.first);
+    }
+    modified = true;
+  });
+  return modified;
+}
+
+Function* IPCPPass::CloneWithArgs(const Function* func,
+                                  const ConstantArgs& args) {
+  std::unique_ptr<Function> clone(func->Clone(context()));
+
+  // Give fresh ids to the results of the clone, and replace the uses of the
+  // parameters whose argument is a constant by that constant.
+  std::unordered_map<uint32_t, uint32_t> new_ids;
+  std::unordered_map<uint32_t, uint32_t> replacements;
+  size_t param_idx = 0;
+  clone->ForEachParam([&args, &param_idx, &replacements](Instruction* param) {
+    const uint32_t const_id = args[param_idx++];
+    if (const_id != 0) replacements[param->result_id()] = const_id;
+  });
+  clone->ForEachInst([this, &new_ids](Instruction* inst) {
+    const uint32_t old_id = inst->result_id();
+    if (old_id == 0) return;
+    const uint32_t new_id = TakeNextId();
+    new_ids[old_id] = new_id;
+    inst->SetResultId(new_id);
+    // The linkage attributes of the function itself are not copied, since the
+    // clone is not visible outside of the module.
+    if (inst->opcode() != SpvOpFunction)
+      get_decoration_mgr()->CloneDecorations(old_id, new_id);
+  });
+  for (const auto& id : new_ids) replacements.insert(id);
+  clone->ForEachInst([&replacements](Instruction* inst) {
+    inst->ForEachInId([&replacements](uint32_t* id) {
+      const auto it = replacements.find(*id);
+      if (it != replacements.end()) *id = it->second;
+    });
+  });
+
+  Function* clone_ptr = clone.get();
+  context()->AddFunction(std::move(clone));
+  clone_ptr->ForEachInst(
+      [this](Instruction* inst) { context()->AnalyzeDefUse(inst); });
+  for (auto& bb : *clone_ptr) {
+    bb.ForEachInst([this, &bb](Instruction* inst) {
+      context()->set_instr_block(inst, &bb);
+    });
+  }
+  return clone_ptr;
+}
+
+bool IPCPPass::SpecializeCalls(Function* func) {
+  const uint32_t size = GetFunctionSize(func);
+  if (size > size_budget_) return false;
+
+  // Group the calls by their constant arguments, in the order of the calls.
+  std::vector<Instruction*> calls = GetCalls(func);
+  using Group = std::pair<ConstantArgs, std::vector<Instruction*>>;
+  std::map<ConstantArgs, size_t> group_index;
+  std::vector<Group> groups;
+  for (Instruction* call : calls) {
+    ConstantArgs args = GetConstantArgs(func, call);
+    if (std::all_of(args.begin(), args.end(),
+                    [](uint32_t id) { return id == 0; }))
+      continue;
+    auto it = group_index.find(args);
+    if (it == group_index.end()) {
+      it = group_index.emplace(args, groups.size()).first;
+      groups.emplace_back(args, std::vector<Instruction*>());
+    }
+    groups[it->second].second.push_back(call);
+  }
+  if (groups.empty()) return false;
+
+  // When all the calls pass the same constants to a function that is not
+  // visible outside of the module, the parameters were already propagated.
+  if (!IsExternallyVisible(func) && groups.size() == 1 &&
+      groups[0].second.size() == calls.size())
+    return false;
+
+  std::stable_sort(groups.begin(), groups.end(),
+                   [](const Group& a, const Group& b) {
+                     return a.second.size() > b.second.size();
+                   });
+
+  bool modified = false;
+  for (const auto& group : groups) {
+    if (size > size_budget_) break;
+    size_budget_ -= size;
+    Function* clone = CloneWithArgs(func, group.first);
+    for (Instruction* call : group.second) {
+      call->SetInOperand(kFunctionCallFunctionIdInIdx, {clone->result_id()});
+      get_def_use_mgr()->AnalyzeInstUse(call);
+    }
+    modified = true;
+  }
+  return modified;
+}
+
+Pass::Status IPCPPass::Process() {
+  Initialize();
+
+  // Constants flow from callers to callees, so a single walk of the call
+  // trees, callers first, propagates them as far as they go.
+  std::vector<Function*> order = GetCallTreeOrder();
+  bool modified = false;
+  for (Function* func : order) modified |= PropagateArgs(func);
+
+  // The calls in the clones of a function are seen when its callees are
+  // specialized, since they come later in the walk.
+  for (Function* func : order) modified |= SpecializeCalls(func);
+
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
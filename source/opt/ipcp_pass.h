@@ -0,0 +1,94 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_IPCP_PASS_H_
+#define SOURCE_OPT_IPCP_PASS_H_
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class IPCPPass : public Pass {
+ public:
+  explicit IPCPPass(uint32_t size_budget) : size_budget_(size_budget) {}
+
+  const char* name() const override { return "ipcp"; }
+  Status Process() override;
+
+ private:
+  // The arguments of a call that are constants, in the order of the
+  // parameters.  The id of an argument that is not a constant, or whose
+  // parameter is not used, is 0.
+  using ConstantArgs = std::vector<uint32_t>;
+
+  // Initializes the pass.
+  void Initialize();
+
+  // Returns the functions of the entry point call trees, callers before
+  // callees.
+  std::vector<Function*> GetCallTreeOrder();
+
+  // Appends to |order| the functions reachable from |func| that are not in
+  // |visited|, callees before callers.
+  void AddCallTreePostOrder(Function* func,
+                            std::unordered_set<uint32_t>* visited,
+                            std::vector<Function*>* order);
+
+  // Returns the calls to |func|.
+  std::vector<Instruction*> GetCalls(const Function* func);
+
+  // Returns the constant arguments of |call| to |func|.
+  ConstantArgs GetConstantArgs(const Function* func, const Instruction* call);
+
+  // Replaces the uses of the parameters of |func| with the constant passed by
+  // every one of its calls, if any.  Returns true if |func| is modified.
+  bool PropagateArgs(Function* func);
+
+  // Clones |func| for the combinations of constant arguments shared by the
+  // most calls, as long as the budget allows it, and redirects those calls to
+  // the clones.  Returns true if the module is modified.
+  bool SpecializeCalls(Function* func);
+
+  // Adds to the module a copy of |func| with fresh result ids in which the
+  // parameters are replaced by the non-zero entries of |args|.  Returns the
+  // copy.
+  Function* CloneWithArgs(const Function* func, const ConstantArgs& args);
+
+  // Returns the number of instructions in the body of |func|.
+  uint32_t GetFunctionSize(const Function* func) const;
+
+  // Returns true if |func| can be called from outside the module.
+  bool IsExternallyVisible(const Function* func) const {
+    return externally_visible_.count(func->result_id()) != 0;
+  }
+
+  // The number of instructions the clones may still add to the module.
+  uint32_t size_budget_;
+
+  // The ids of the functions that can be called from outside the module.
+  std::unordered_set<uint32_t> externally_visible_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_IPCP_PASS_H_
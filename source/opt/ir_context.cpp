@@ -74,6 +74,15 @@ void IRContext::BuildInvalidAnalyses(IRContext::Analysis set) {
   if (set & kAnalysisIdToFuncMapping) {
     BuildIdToFuncMapping();
   }
+  if (set & kAnalysisMemorySSA) {
+    BuildMemorySSAAnalysis();
+  }
+  if (set & kAnalysisAliasAnalysis) {
+    BuildAliasAnalysis();
+  }
+  if (set & kAnalysisDivergence) {
+    BuildDivergenceAnalysis();
+  }
 }
 
 void IRContext::InvalidateAnalysesExceptFor(
@@ -117,6 +126,15 @@ void IRContext::InvalidateAnalyses(IRContext::Analysis analyses_to_invalidate) {
   if (analyses_to_invalidate & kAnalysisIdToFuncMapping) {
     id_to_func_.clear();
   }
+  if (analyses_to_invalidate & kAnalysisMemorySSA) {
+    memory_ssa_.reset(nullptr);
+  }
+  if (analyses_to_invalidate & kAnalysisAliasAnalysis) {
+    alias_analysis_.reset(nullptr);
+  }
+  if (analyses_to_invalidate & kAnalysisDivergence) {
+    divergence_analysis_.reset(nullptr);
+  }
 
   valid_analyses_ = Analysis(valid_analyses_ & ~analyses_to_invalidate);
 }
@@ -753,6 +771,55 @@ bool IRContext::ProcessCallTreeFromRoots(ProcessFunction& pfn,
   return modified;
 }
 
+bool IRContext::BuildAnalysesFromModuleIndex(const ModuleIndex& index) {
+  // Map the ordinals of |index| to the instructions of the module.  Both list
+  // the instructions in module order, so checking the opcode and result id of
+  // each instruction is enough to find out if they describe the same module.
+  std::vector<Instruction*> insts;
+  insts.reserve(index.num_instructions());
+  bool matches = true;
+  module()->ForEachInst(
+      [&index, &insts, &matches](Instruction* inst) {
+        const uint32_t ordinal = static_cast<uint32_t>(insts.size());
+        if (!matches || ordinal >= index.num_instructions() ||
+            index.opcode(ordinal) != inst->opcode() ||
+            index.result_id(ordinal) != inst->result_id()) {
+          matches = false;
+          return;
+        }
+        insts.push_back(inst);
+      },
+      true);
+  // Debug line instructions at the end of the module are dropped when it is
+  // loaded.
+  for (size_t i = insts.size(); matches && i < index.num_instructions(); ++i) {
+    matches = IsDebugLineInst(index.opcode(static_cast<uint32_t>(i)));
+  }
+  if (!matches) return false;
+
+  std::vector<std::pair<const Function*, const ModuleIndex::Function*>>
+      functions;
+  auto indexed = index.functions().begin();
+  for (auto& fn : *module()) {
+    if (indexed == index.functions().end() || indexed->id != fn.result_id()) {
+      return false;
+    }
+    functions.emplace_back(&fn, &*indexed);
+    ++indexed;
+  }
+  if (indexed != index.functions().end()) return false;
+
+  def_use_mgr_ = MakeUnique<analysis::DefUseManager>(index, insts);
+  valid_analyses_ = valid_analyses_ | kAnalysisDefUse;
+
+  ResetDominatorAnalysis();
+  for (const auto& entry : functions) {
+    dominator_trees_[entry.first].InitializeTree(*cfg(), entry.first,
+                                                 *entry.second);
+  }
+  return true;
+}
+
 // Gets the dominator analysis for function |f|.
 DominatorAnalysis* IRContext::GetDominatorAnalysis(const Function* f) {
   if (!AreAnalysesValid(kAnalysisDominatorAnalysis)) {
@@ -27,14 +27,17 @@
 #include <vector>
 
 #include "source/assembly_grammar.h"
+#include "source/opt/alias_analysis.h"
 #include "source/opt/cfg.h"
 #include "source/opt/constants.h"
 #include "source/opt/decoration_manager.h"
 #include "source/opt/def_use_manager.h"
+#include "source/opt/divergence_analysis.h"
 #include "source/opt/dominator_analysis.h"
 #include "source/opt/feature_manager.h"
 #include "source/opt/fold.h"
 #include "source/opt/loop_descriptor.h"
+#include "source/opt/memory_ssa.h"
 #include "source/opt/module.h"
 #include "source/opt/register_pressure.h"
 #include "source/opt/scalar_analysis.h"
@@ -76,7 +79,10 @@ class IRContext {
     kAnalysisStructuredCFG = 1 << 11,
     kAnalysisBuiltinVarId = 1 << 12,
     kAnalysisIdToFuncMapping = 1 << 13,
-    kAnalysisEnd = 1 << 14
+    kAnalysisMemorySSA = 1 << 14,
+    kAnalysisAliasAnalysis = 1 << 15,
+    kAnalysisDivergence = 1 << 16,
+    kAnalysisEnd = 1 << 17
   };
 
   using ProcessFunction = std::function<bool(Function*)>;
@@ -252,6 +258,33 @@ class IRContext {
     return reg_pressure_.get();
   }
 
+  // Returns a pointer to a memory SSA analysis.  If the analysis is invalid,
+  // it is rebuilt first.
+  MemorySSAAnalysis* GetMemorySSAAnalysis() {
+    if (!AreAnalysesValid(kAnalysisMemorySSA)) {
+      BuildMemorySSAAnalysis();
+    }
+    return memory_ssa_.get();
+  }
+
+  // Returns a pointer to the alias analysis.  If the analysis is invalid, it
+  // is rebuilt first.
+  AliasAnalysis* GetAliasAnalysis() {
+    if (!AreAnalysesValid(kAnalysisAliasAnalysis)) {
+      BuildAliasAnalysis();
+    }
+    return alias_analysis_.get();
+  }
+
+  // Returns a pointer to the divergence analysis.  If the analysis is invalid,
+  // it is rebuilt first.
+  DivergenceAnalysis* GetDivergenceAnalysis() {
+    if (!AreAnalysesValid(kAnalysisDivergence)) {
+      BuildDivergenceAnalysis();
+    }
+    return divergence_analysis_.get();
+  }
+
   // Returns the basic block for instruction |instr|. Re-builds the instruction
   // block map, if needed.
   BasicBlock* get_instr_block(Instruction* instr) {
@@ -334,6 +367,12 @@ class IRContext {
   // Rebuilds the analyses in |set| that are invalid.
   void BuildInvalidAnalyses(Analysis set);
 
+  // Builds the def-use manager and the dominator analysis of every function
+  // from |index| instead of analyzing the module.  |index| must describe the
+  // module as it was loaded.  Returns false, and builds nothing, if the module
+  // does not match |index|.
+  bool BuildAnalysesFromModuleIndex(const ModuleIndex& index);
+
   // Invalidates all of the analyses except for those in |preserved_analyses|.
   void InvalidateAnalysesExceptFor(Analysis preserved_analyses);
 
@@ -584,6 +623,24 @@ class IRContext {
     valid_analyses_ = valid_analyses_ | kAnalysisStructuredCFG;
   }
 
+  // Builds the memory SSA analysis from scratch, even if it was already valid.
+  void BuildMemorySSAAnalysis() {
+    memory_ssa_ = MakeUnique<MemorySSAAnalysis>(this);
+    valid_analyses_ = valid_analyses_ | kAnalysisMemorySSA;
+  }
+
+  // Builds the alias analysis from scratch, even if it was already valid.
+  void BuildAliasAnalysis() {
+    alias_analysis_ = MakeUnique<AliasAnalysis>(this);
+    valid_analyses_ = valid_analyses_ | kAnalysisAliasAnalysis;
+  }
+
+  // Builds the divergence analysis from scratch, even if it was already valid.
+  void BuildDivergenceAnalysis() {
+    divergence_analysis_ = MakeUnique<DivergenceAnalysis>(this);
+    valid_analyses_ = valid_analyses_ | kAnalysisDivergence;
+  }
+
   // Removes all computed dominator and post-dominator trees. This will force
   // the context to rebuild the trees on demand.
   void ResetDominatorAnalysis() {
@@ -721,6 +778,15 @@ class IRContext {
 
   std::unique_ptr<StructuredCFGAnalysis> struct_cfg_analysis_;
 
+  // The memory SSA form of the functions of |module_|.
+  std::unique_ptr<MemorySSAAnalysis> memory_ssa_;
+
+  // The alias analysis for the module.
+  std::unique_ptr<AliasAnalysis> alias_analysis_;
+
+  // The divergence analysis for the module.
+  std::unique_ptr<DivergenceAnalysis> divergence_analysis_;
+
   // The maximum legal value for the id bound.
   uint32_t max_id_bound_;
 };
@@ -0,0 +1,588 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/jump_threading_pass.h"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kBranchCondConditionalIdInIdx = 0;
+const uint32_t kBranchCondTrueLabIdInIdx = 1;
+const uint32_t kBranchCondFalseLabIdInIdx = 2;
+const uint32_t kSelectionMergeMergeBlockIdInIdx = 0;
+
+// The largest number of instructions, besides its label and phis, of a block
+// that is copied for its predecessors.
+const uint32_t kMaxCopiedBlockSize = 8;
+
+// Returns true if a copy of |inst| in a copy of its block, or in a
+// predecessor of its block, computes the same thing as |inst|.  Instructions
+// that need the invocations to be converged, like barriers and derivatives,
+// are excluded.
+bool IsDuplicable(const Instruction& inst) {
+  switch (inst.opcode()) {
+    case SpvOpStore:
+    case SpvOpBranch:
+    case SpvOpReturn:
+    case SpvOpReturnValue:
+      return true;
+    default:
+      return inst.IsOpcodeCodeMotionSafe();
+  }
+}
+
+}  // anonymous namespace
+
+BasicBlock* JumpThreadingPass::GetSelectionHeader(BasicBlock* bb) {
+  BasicBlock* header = nullptr;
+  const bool is_merge_of_selection_only = get_def_use_mgr()->WhileEachUse(
+      bb->GetLabelInst(),
+      [this, &header](Instruction* user, uint32_t index) {
+        switch (user->opcode()) {
+          case SpvOpSelectionMerge:
+            if (index != kSelectionMergeMergeBlockIdInIdx) return false;
+            header = context()->get_instr_block(user);
+            return true;
+          case SpvOpBranch:
+          case SpvOpBranchConditional:
+          case SpvOpPhi:
+          case SpvOpName:
+            return true;
+          default:
+            return false;
+        }
+      });
+  return is_merge_of_selection_only ? header : nullptr;
+}
+
+uint32_t JumpThreadingPass::GetDecidedTarget(BasicBlock* bb,
+                                             uint32_t pred_id) {
+  Instruction* branch = bb->terminator();
+  Instruction* condition = get_def_use_mgr()->GetDef(
+      branch->GetSingleWordInOperand(kBranchCondConditionalIdInIdx));
+  bool negated = false;
+  if (condition->opcode() == SpvOpLogicalNot &&
+      context()->get_instr_block(condition) == bb) {
+    condition = get_def_use_mgr()->GetDef(condition->GetSingleWordInOperand(0));
+    negated = true;
+  }
+  if (condition->opcode() != SpvOpPhi ||
+      context()->get_instr_block(condition) != bb) {
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < condition->NumInOperands(); i += 2) {
+    if (condition->GetSingleWordInOperand(i + 1) != pred_id) continue;
+    const analysis::Constant* value =
+        context()->get_constant_mgr()->FindDeclaredConstant(
+            condition->GetSingleWordInOperand(i));
+    if (value == nullptr || value->AsBoolConstant() == nullptr) return 0;
+    const bool taken = value->AsBoolConstant()->value() != negated;
+    return branch->GetSingleWordInOperand(taken ? kBranchCondTrueLabIdInIdx
+                                                : kBranchCondFalseLabIdInIdx);
+  }
+  return 0;
+}
+
+uint32_t JumpThreadingPass::GetValueFrom(BasicBlock* bb, uint32_t id,
+                                         uint32_t pred_id) {
+  Instruction* def = get_def_use_mgr()->GetDef(id);
+  if (def->opcode() != SpvOpPhi || context()->get_instr_block(def) != bb)
+    return id;
+  for (uint32_t i = 0; i < def->NumInOperands(); i += 2) {
+    if (def->GetSingleWordInOperand(i + 1) == pred_id)
+      return def->GetSingleWordInOperand(i);
+  }
+  return id;
+}
+
+bool JumpThreadingPass::CanBypass(
+    BasicBlock* bb,
+    const std::function<bool(Instruction*, uint32_t)>& is_phi_use_allowed) {
+  Instruction* branch = bb->terminator();
+  Instruction* merge_inst = bb->GetMergeInst();
+  for (auto& inst : *bb) {
+    if (&inst == branch || &inst == merge_inst) continue;
+    const bool is_phi = inst.opcode() == SpvOpPhi;
+    if (!is_phi && inst.opcode() != SpvOpLogicalNot) return false;
+    const bool is_local = get_def_use_mgr()->WhileEachUse(
+        &inst, [this, bb, is_phi, &is_phi_use_allowed](Instruction* user,
+                                                      uint32_t index) {
+          // Names and decorations have no block.
+          BasicBlock* user_block = context()->get_instr_block(user);
+          if (user_block == nullptr || user_block == bb) return true;
+          return is_phi && is_phi_use_allowed(user, index);
+        });
+    if (!is_local) return false;
+  }
+  return true;
+}
+
+bool JumpThreadingPass::ThreadBlock(Function* func, BasicBlock* bb) {
+  Instruction* branch = bb->terminator();
+  Instruction* merge_inst = bb->GetMergeInst();
+  if (branch->opcode() != SpvOpBranchConditional || merge_inst == nullptr ||
+      merge_inst->opcode() != SpvOpSelectionMerge) {
+    return false;
+  }
+  const uint32_t true_id =
+      branch->GetSingleWordInOperand(kBranchCondTrueLabIdInIdx);
+  const uint32_t false_id =
+      branch->GetSingleWordInOperand(kBranchCondFalseLabIdInIdx);
+  if (true_id == false_id) return false;
+  BasicBlock* header = GetSelectionHeader(bb);
+  if (header == nullptr) return false;
+
+  // Find the target of each predecessor, or 0 if it does not decide the
+  // branch.  A predecessor already branching to its target would enter it
+  // twice.
+  std::vector<std::pair<uint32_t, uint32_t>> target_of_pred;
+  bool all_decided = true;
+  bool reaches_true = false;
+  bool reaches_false = false;
+  for (uint32_t pred_id : cfg()->preds(bb->id())) {
+    BasicBlock* pred = cfg()->block(pred_id);
+    if (pred != header && pred->GetMergeInst() != nullptr) return false;
+    uint32_t target_id = GetDecidedTarget(bb, pred_id);
+    const bool enters_target_once = pred->terminator()->WhileEachInId(
+        [target_id](const uint32_t* id) { return *id != target_id; });
+    if (!enters_target_once) target_id = 0;
+    target_of_pred.emplace_back(pred_id, target_id);
+    all_decided &= target_id != 0;
+    reaches_true |= target_id == true_id;
+    reaches_false |= target_id == false_id;
+  }
+
+  // Unless every predecessor decides the branch, and both targets stay
+  // reachable so that no block is left behind without a predecessor, |bb|
+  // stays for the other predecessors.
+  if (!all_decided || !reaches_true || !reaches_false) {
+    return CopyDecidedTargets(func, bb, header, target_of_pred);
+  }
+
+  // The instructions of |bb| go away with it, so they may only be used in
+  // |bb|, or by the phis of its successors, which are given the value coming
+  // from each predecessor instead.
+  if (!CanBypass(bb, [bb](Instruction* user, uint32_t index) {
+        return user->opcode() == SpvOpPhi &&
+               user->GetSingleWordOperand(index + 1) == bb->id();
+      })) {
+    return false;
+  }
+
+  // The phis of the targets get an incoming value for each predecessor of
+  // |bb| that now branches to them.
+  for (uint32_t target_id : {true_id, false_id}) {
+    cfg()->block(target_id)->ForEachPhiInst(
+        [this, bb, target_id, &target_of_pred](Instruction* phi) {
+          Instruction::OperandList operands;
+          for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+            const uint32_t value_id = phi->GetSingleWordInOperand(i);
+            const uint32_t block_id = phi->GetSingleWordInOperand(i + 1);
+            if (block_id != bb->id()) {
+              operands.push_back({SPV_OPERAND_TYPE_ID, {value_id}});
+              operands.push_back({SPV_OPERAND_TYPE_ID, {block_id}});
+              continue;
+            }
+            for (const auto& pred_and_target : target_of_pred) {
+              if (pred_and_target.second != target_id) continue;
+              operands.push_back(
+                  {SPV_OPERAND_TYPE_ID,
+                   {GetValueFrom(bb, value_id, pred_and_target.first)}});
+              operands.push_back(
+                  {SPV_OPERAND_TYPE_ID, {pred_and_target.first}});
+            }
+          }
+          phi->SetInOperands(std::move(operands));
+          get_def_use_mgr()->AnalyzeInstUse(phi);
+        });
+  }
+
+  // Branch the predecessors to their targets, and end the construct of
+  // |header| where the construct of |bb| ended.
+  for (const auto& pred_and_target : target_of_pred) {
+    Instruction* pred_branch =
+        cfg()->block(pred_and_target.first)->terminator();
+    const uint32_t target_id = pred_and_target.second;
+    pred_branch->ForEachInId([bb, target_id](uint32_t* id) {
+      if (*id == bb->id()) *id = target_id;
+    });
+    get_def_use_mgr()->AnalyzeInstUse(pred_branch);
+  }
+  Instruction* header_merge = header->GetMergeInst();
+  header_merge->SetInOperand(
+      kSelectionMergeMergeBlockIdInIdx,
+      {merge_inst->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx)});
+  get_def_use_mgr()->AnalyzeInstUse(header_merge);
+
+  RemoveBlock(func, bb);
+  return true;
+}
+
+bool JumpThreadingPass::CopyDecidedTargets(
+    Function* func, BasicBlock* bb, BasicBlock* header,
+    const std::vector<std::pair<uint32_t, uint32_t>>& target_of_pred) {
+  bool has_decided = false;
+  bool has_undecided = false;
+  for (const auto& pred_and_target : target_of_pred) {
+    has_decided |= pred_and_target.second != 0;
+    has_undecided |= pred_and_target.second == 0;
+  }
+  if (!has_decided || !has_undecided) return false;
+
+  Instruction* branch = bb->terminator();
+  Instruction* merge_inst = bb->GetMergeInst();
+  const uint32_t merge_id =
+      merge_inst->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx);
+  BasicBlock* merge = cfg()->block(merge_id);
+  if (GetSelectionHeader(merge) != bb) return false;
+
+  // Each target is the merge block, or a block of straight-line code entered
+  // only from |bb| and branching to the merge block, so that a copy of it can
+  // take its place on a decided edge.  The size of each such target is its
+  // number of instructions besides its label.
+  std::unordered_map<uint32_t, uint32_t> target_sizes;
+  for (uint32_t index :
+       {kBranchCondTrueLabIdInIdx, kBranchCondFalseLabIdInIdx}) {
+    const uint32_t target_id = branch->GetSingleWordInOperand(index);
+    if (target_id == merge_id) continue;
+    BasicBlock* target = cfg()->block(target_id);
+    Instruction* target_branch = target->terminator();
+    if (cfg()->preds(target_id).size() != 1 ||
+        target->GetMergeInst() != nullptr ||
+        target_branch->opcode() != SpvOpBranch ||
+        target_branch->GetSingleWordInOperand(0) != merge_id) {
+      return false;
+    }
+    uint32_t size = 0;
+    for (auto& inst : *target) {
+      if (inst.opcode() == SpvOpPhi || !IsDuplicable(inst)) return false;
+      ++size;
+    }
+    if (size > kMaxCopiedBlockSize) return false;
+    target_sizes[target_id] = size;
+  }
+  for (uint32_t pred_id : cfg()->preds(merge_id)) {
+    if (pred_id != bb->id() && target_sizes.count(pred_id) == 0) return false;
+  }
+
+  // |bb| no longer dominates the merge block, so its phis may only be used in
+  // the targets, which are copied with the value of each decided edge, and by
+  // the phis of the merge block for the edge from |bb|.
+  if (!CanBypass(bb, [this, bb, merge, &target_sizes](Instruction* user,
+                                                      uint32_t index) {
+        BasicBlock* user_block = context()->get_instr_block(user);
+        if (target_sizes.count(user_block->id())) return true;
+        return user_block == merge && user->opcode() == SpvOpPhi &&
+               user->GetSingleWordOperand(index + 1) == bb->id();
+      })) {
+    return false;
+  }
+
+  // The new merge block of |bb| has a copy of each phi of the merge block,
+  // and a branch to it.  Each decided edge adds a copy of its target.
+  uint32_t cost = 2;
+  merge->ForEachPhiInst([&cost](Instruction*) { ++cost; });
+  for (const auto& pred_and_target : target_of_pred) {
+    auto it = target_sizes.find(pred_and_target.second);
+    if (it != target_sizes.end()) cost += it->second + 1;
+  }
+  if (cost > budget_left_) return false;
+  budget_left_ -= cost;
+
+  // New blocks are laid out just before the merge block.
+  auto add_block = [this, func, merge](uint32_t label_id) {
+    std::unique_ptr<BasicBlock> block(
+        new BasicBlock(std::unique_ptr<Instruction>(
+            new Instruction(context(), SpvOpLabel, 0, label_id, {}))));
+    BasicBlock* added = block.get();
+    get_def_use_mgr()->AnalyzeInstDefUse(added->GetLabelInst());
+    context()->set_instr_block(added->GetLabelInst(), added);
+    auto merge_it = func->begin();
+    while (&*merge_it != merge) ++merge_it;
+    func->AddBasicBlock(std::move(block), merge_it);
+    return added;
+  };
+  auto add_inst = [this](BasicBlock* block, std::unique_ptr<Instruction> inst) {
+    block->AddInstruction(std::move(inst));
+    Instruction* added = &*block->tail();
+    get_def_use_mgr()->AnalyzeInstDefUse(added);
+    context()->set_instr_block(added, block);
+  };
+
+  // The new merge block of |bb| collects the values of the edges that still
+  // go through |bb|.  The phis of the old merge block take them from there,
+  // and the values of the decided edges from their copies.
+  BasicBlock* new_merge = add_block(TakeNextId());
+  std::vector<Instruction*> merge_phis;
+  std::vector<Instruction::OperandList> merge_phi_operands;
+  merge->ForEachPhiInst([this, new_merge, &add_inst, &merge_phis,
+                         &merge_phi_operands](Instruction* phi) {
+    std::unique_ptr<Instruction> copy(phi->Clone(context()));
+    const uint32_t copy_id = TakeNextId();
+    copy->SetResultId(copy_id);
+    get_decoration_mgr()->CloneDecorations(phi->result_id(), copy_id);
+    add_inst(new_merge, std::move(copy));
+    merge_phis.push_back(phi);
+    merge_phi_operands.push_back({{SPV_OPERAND_TYPE_ID, {copy_id}},
+                                  {SPV_OPERAND_TYPE_ID, {new_merge->id()}}});
+  });
+  add_inst(new_merge,
+           std::unique_ptr<Instruction>(new Instruction(
+               context(), SpvOpBranch, 0, 0,
+               {{SPV_OPERAND_TYPE_ID, {merge_id}}})));
+
+  for (const auto& pred_and_target : target_of_pred) {
+    const uint32_t pred_id = pred_and_target.first;
+    const uint32_t target_id = pred_and_target.second;
+    if (target_id == 0) continue;
+
+    // The values of |bb| are those coming from |pred_id|, and the values of
+    // the target those of its copy.
+    std::unordered_map<uint32_t, uint32_t> new_ids;
+    auto get_new_id = [this, bb, pred_id, &new_ids](uint32_t id) {
+      auto it = new_ids.find(id);
+      return it != new_ids.end() ? it->second : GetValueFrom(bb, id, pred_id);
+    };
+    uint32_t new_target_id = merge_id;
+    uint32_t from_id = pred_id;
+    if (target_id != merge_id) {
+      BasicBlock* copy_block = add_block(TakeNextId());
+      new_target_id = from_id = copy_block->id();
+      for (auto& inst : *cfg()->block(target_id)) {
+        std::unique_ptr<Instruction> copy(inst.Clone(context()));
+        if (inst.result_id() != 0) {
+          const uint32_t new_id = TakeNextId();
+          new_ids[inst.result_id()] = new_id;
+          copy->SetResultId(new_id);
+          get_decoration_mgr()->CloneDecorations(inst.result_id(), new_id);
+        }
+        copy->ForEachInId(
+            [&get_new_id](uint32_t* id) { *id = get_new_id(*id); });
+        add_inst(copy_block, std::move(copy));
+      }
+    }
+    for (size_t i = 0; i < merge_phis.size(); ++i) {
+      Instruction* phi = merge_phis[i];
+      for (uint32_t j = 0; j < phi->NumInOperands(); j += 2) {
+        if (phi->GetSingleWordInOperand(j + 1) != target_id &&
+            (target_id != merge_id ||
+             phi->GetSingleWordInOperand(j + 1) != bb->id())) {
+          continue;
+        }
+        merge_phi_operands[i].push_back(
+            {SPV_OPERAND_TYPE_ID,
+             {get_new_id(phi->GetSingleWordInOperand(j))}});
+        merge_phi_operands[i].push_back({SPV_OPERAND_TYPE_ID, {from_id}});
+      }
+    }
+
+    Instruction* pred_branch = cfg()->block(pred_id)->terminator();
+    pred_branch->ForEachInId([bb, new_target_id](uint32_t* id) {
+      if (*id == bb->id()) *id = new_target_id;
+    });
+    get_def_use_mgr()->AnalyzeInstUse(pred_branch);
+  }
+
+  // The edges that still go through |bb| end at its new merge block, and the
+  // decided ones no longer enter |bb|.  The construct of |header| now ends at
+  // the old merge block, around the construct of |bb|.
+  for (size_t i = 0; i < merge_phis.size(); ++i) {
+    merge_phis[i]->SetInOperands(std::move(merge_phi_operands[i]));
+    get_def_use_mgr()->AnalyzeInstUse(merge_phis[i]);
+  }
+  std::vector<Instruction*> merge_users = {merge_inst, branch};
+  for (const auto& target_and_size : target_sizes) {
+    merge_users.push_back(cfg()->block(target_and_size.first)->terminator());
+  }
+  for (Instruction* user : merge_users) {
+    user->ForEachInId([merge_id, new_merge](uint32_t* id) {
+      if (*id == merge_id) *id = new_merge->id();
+    });
+    get_def_use_mgr()->AnalyzeInstUse(user);
+  }
+  bb->ForEachPhiInst([this, &target_of_pred](Instruction* phi) {
+    Instruction::OperandList operands;
+    for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+      const uint32_t block_id = phi->GetSingleWordInOperand(i + 1);
+      bool is_decided = false;
+      for (const auto& pred_and_target : target_of_pred) {
+        is_decided |= pred_and_target.first == block_id &&
+                      pred_and_target.second != 0;
+      }
+      if (is_decided) continue;
+      operands.push_back(phi->GetInOperand(i));
+      operands.push_back(phi->GetInOperand(i + 1));
+    }
+    phi->SetInOperands(std::move(operands));
+    get_def_use_mgr()->AnalyzeInstUse(phi);
+  });
+  Instruction* header_merge = header->GetMergeInst();
+  header_merge->SetInOperand(kSelectionMergeMergeBlockIdInIdx, {merge_id});
+  get_def_use_mgr()->AnalyzeInstUse(header_merge);
+  return true;
+}
+
+bool JumpThreadingPass::DuplicateReturnBlock(Function* func, BasicBlock* bb) {
+  const SpvOp return_op = bb->terminator()->opcode();
+  if ((return_op != SpvOpReturn && return_op != SpvOpReturnValue) ||
+      bb == &*func->begin()) {
+    return false;
+  }
+  uint32_t size = 0;
+  for (auto& inst : *bb) {
+    if (inst.opcode() == SpvOpPhi) continue;
+    if (!IsDuplicable(inst)) return false;
+    ++size;
+  }
+  if (size > kMaxCopiedBlockSize) return false;
+
+  // Each copy replaces the branch of a predecessor which is not a header, and
+  // so has no merge instruction that must be followed by a branch.
+  std::vector<BasicBlock*> preds;
+  for (uint32_t pred_id : cfg()->preds(bb->id())) {
+    BasicBlock* pred = cfg()->block(pred_id);
+    if (pred->terminator()->opcode() == SpvOpBranch &&
+        pred->GetMergeInst() == nullptr) {
+      preds.push_back(pred);
+    }
+  }
+  if (preds.size() < 2) return false;
+
+  bool modified = false;
+  for (BasicBlock* pred : preds) {
+    if (size - 1 > budget_left_) break;
+    budget_left_ -= size - 1;
+
+    // The phis of |bb| take their value from |pred| in the copy.
+    std::unordered_map<uint32_t, uint32_t> new_ids;
+    bb->ForEachPhiInst([pred, &new_ids](Instruction* phi) {
+      for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+        if (phi->GetSingleWordInOperand(i + 1) == pred->id())
+          new_ids[phi->result_id()] = phi->GetSingleWordInOperand(i);
+      }
+    });
+    context()->KillInst(pred->terminator());
+    for (auto& inst : *bb) {
+      if (inst.opcode() == SpvOpPhi) continue;
+      std::unique_ptr<Instruction> copy(inst.Clone(context()));
+      if (inst.result_id() != 0) {
+        const uint32_t new_id = TakeNextId();
+        new_ids[inst.result_id()] = new_id;
+        copy->SetResultId(new_id);
+        get_decoration_mgr()->CloneDecorations(inst.result_id(), new_id);
+      }
+      copy->ForEachInId([&new_ids](uint32_t* id) {
+        auto it = new_ids.find(*id);
+        if (it != new_ids.end()) *id = it->second;
+      });
+      pred->AddInstruction(std::move(copy));
+      Instruction* added = &*pred->tail();
+      get_def_use_mgr()->AnalyzeInstDefUse(added);
+      context()->set_instr_block(added, pred);
+    }
+
+    // |pred| no longer enters |bb|.
+    bb->ForEachPhiInst([this, pred](Instruction* phi) {
+      Instruction::OperandList operands;
+      for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+        if (phi->GetSingleWordInOperand(i + 1) == pred->id()) continue;
+        operands.push_back(phi->GetInOperand(i));
+        operands.push_back(phi->GetInOperand(i + 1));
+      }
+      phi->SetInOperands(std::move(operands));
+      get_def_use_mgr()->AnalyzeInstUse(phi);
+    });
+    modified = true;
+  }
+  if (!modified) return false;
+
+  // A block left without predecessors is removed, unless it is still the
+  // merge block of a construct, which then becomes unreachable.
+  if (get_def_use_mgr()->WhileEachUser(
+          bb->GetLabelInst(), [](Instruction* user) {
+            return user->opcode() == SpvOpName;
+          })) {
+    RemoveBlock(func, bb);
+  } else if (get_def_use_mgr()->WhileEachUser(
+                 bb->GetLabelInst(), [](Instruction* user) {
+                   return user->opcode() != SpvOpBranch &&
+                          user->opcode() != SpvOpBranchConditional &&
+                          user->opcode() != SpvOpSwitch;
+                 })) {
+    bb->KillAllInsts(false);
+    std::unique_ptr<Instruction> unreachable(
+        new Instruction(context(), SpvOpUnreachable, 0, 0, {}));
+    bb->AddInstruction(std::move(unreachable));
+    Instruction* added = &*bb->tail();
+    get_def_use_mgr()->AnalyzeInstDefUse(added);
+    context()->set_instr_block(added, bb);
+  }
+  return true;
+}
+
+void JumpThreadingPass::RemoveBlock(Function* func, BasicBlock* bb) {
+  bb->KillAllInsts(true);
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    if (&*bi == bb) {
+      bi.Erase();
+      break;
+    }
+  }
+}
+
+bool JumpThreadingPass::ThreadJumps(Function* func) {
+  budget_left_ = size_budget_;
+  bool modified = false;
+  std::vector<BasicBlock*> blocks;
+  for (auto& bb : *func) blocks.push_back(&bb);
+  for (BasicBlock* bb : blocks) {
+    if (ThreadBlock(func, bb)) {
+      context()->InvalidateAnalyses(IRContext::kAnalysisCFG |
+                                    IRContext::kAnalysisDominatorAnalysis);
+      modified = true;
+    }
+  }
+
+  blocks.clear();
+  for (auto& bb : *func) blocks.push_back(&bb);
+  for (BasicBlock* bb : blocks) {
+    if (DuplicateReturnBlock(func, bb)) {
+      context()->InvalidateAnalyses(IRContext::kAnalysisCFG |
+                                    IRContext::kAnalysisDominatorAnalysis);
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+Pass::Status JumpThreadingPass::Process() {
+  ProcessFunction pfn = [this](Function* fp) {
+    return ThreadJumps(fp);
+  };
+  bool modified = context()->ProcessEntryPointCallTree(pfn);
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
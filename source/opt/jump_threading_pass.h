@@ -0,0 +1,110 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_JUMP_THREADING_PASS_H_
+#define SOURCE_OPT_JUMP_THREADING_PASS_H_
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class JumpThreadingPass : public Pass {
+ public:
+  explicit JumpThreadingPass(uint32_t size_budget = 64)
+      : size_budget_(size_budget) {}
+
+  const char* name() const override { return "jump-thread"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // Threads the jumps and duplicates the return blocks of |func|.  Returns
+  // true if |func| was modified.
+  bool ThreadJumps(Function* func);
+
+  // Returns the header of the selection construct whose merge block is |bb|.
+  // Returns nullptr if there is none, or if |bb| is referenced by another
+  // structured control flow instruction or by an OpSwitch.
+  BasicBlock* GetSelectionHeader(BasicBlock* bb);
+
+  // Returns the target taken by the conditional branch of |bb| when it is
+  // entered from |pred_id|, or 0 if it is not known.  The branch is known
+  // when its condition is a phi of |bb|, or the negation of one, whose
+  // incoming value from |pred_id| is a constant.
+  uint32_t GetDecidedTarget(BasicBlock* bb, uint32_t pred_id);
+
+  // Returns the value of |id| when |bb| is entered from |pred_id|: the
+  // incoming value of |id| if it is a phi of |bb|, and |id| otherwise.
+  uint32_t GetValueFrom(BasicBlock* bb, uint32_t id, uint32_t pred_id);
+
+  // Returns true if the instructions of |bb|, besides its branch and merge
+  // instruction, are phis or negations that are only used in |bb|, by names
+  // and decorations, or, for the phis, where |is_phi_use_allowed| returns
+  // true for the user and the operand index.
+  bool CanBypass(
+      BasicBlock* bb,
+      const std::function<bool(Instruction*, uint32_t)>& is_phi_use_allowed);
+
+  // Branches the predecessors of the selection merge block |bb| directly to
+  // the targets of its conditional branch, and removes |bb|, if the target is
+  // known on every incoming edge.  The construct ending at |bb| then ends at
+  // the merge block of |bb|.  Otherwise calls CopyDecidedTargets.  Returns
+  // true if |func| was modified.
+  bool ThreadBlock(Function* func, BasicBlock* bb);
+
+  // Branches the predecessors of |bb| whose target is known in
+  // |target_of_pred| to a copy of their target, while the others still go
+  // through |bb|.  The target is 0 for those.  |header| is the header of the
+  // selection construct ending at |bb|, which then ends at the merge block of
+  // |bb|, and |bb| is given a new merge block in front of it.  The targets
+  // must be straight-line code branching to the merge block of |bb|, or that
+  // block itself, and the copies must fit in the size budget.  Returns true
+  // if |func| was modified.
+  bool CopyDecidedTargets(
+      Function* func, BasicBlock* bb, BasicBlock* header,
+      const std::vector<std::pair<uint32_t, uint32_t>>& target_of_pred);
+
+  // Replaces the branches to the small return block |bb| by copies of it,
+  // while the size budget allows.  Returns true if a copy was made.
+  bool DuplicateReturnBlock(Function* func, BasicBlock* bb);
+
+  // Removes |bb| from |func| and kills its instructions.
+  void RemoveBlock(Function* func, BasicBlock* bb);
+
+  // The number of instructions the copies of blocks can add to each function,
+  // and what is left of it in the function being processed.
+  uint32_t size_budget_;
+  uint32_t budget_left_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_JUMP_THREADING_PASS_H_
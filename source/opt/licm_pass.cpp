@@ -84,8 +84,10 @@ Pass::Status LICMPass::AnalyseAndHoistFromBB(
     std::vector<BasicBlock*>* loop_bbs) {
   bool modified = false;
   std::function<bool(Instruction*)> hoist_inst =
-      [this, &loop, &modified](Instruction* inst) {
-        if (loop->ShouldHoistInstruction(this->context(), inst)) {
+      [this, &loop, f, &modified](Instruction* inst) {
+        if (loop->ShouldHoistInstruction(this->context(), inst) &&
+            (inst->opcode() != SpvOpLoad ||
+             IsLoopInvariantLoad(loop, f, inst))) {
           if (!HoistInstruction(loop, inst)) {
             return false;
           }
@@ -118,6 +120,29 @@ bool LICMPass::IsImmediatelyContainedInLoop(Loop* loop, Function* f,
   return loop == (*loop_descriptor)[bb->id()];
 }
 
+bool LICMPass::IsLoopInvariantLoad(Loop* loop, Function* f,
+                                   Instruction* inst) {
+  MemorySSA* memory_ssa = context()->GetMemorySSAAnalysis()->Get(f);
+  MemoryAccess* use = memory_ssa->GetUse(inst);
+  // Volatile and coherent loads have no plain use of memory.
+  if (use == nullptr) return false;
+  if (inst->IsReadOnlyLoad()) return true;
+
+  AliasAnalysis* alias_analysis = context()->GetAliasAnalysis();
+  for (uint32_t bb_id : loop->GetBlocks()) {
+    for (Instruction& loop_inst : *cfg()->block(bb_id)) {
+      for (MemoryAccess* def : memory_ssa->GetDefs(&loop_inst)) {
+        if (def->partition() != use->partition()) continue;
+        if (def->pointer_id() == 0 ||
+            alias_analysis->MayAlias(def->pointer_id(), use->pointer_id())) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
 bool LICMPass::HoistInstruction(Loop* loop, Instruction* inst) {
   // TODO(1841): Handle failure to create pre-header.
   BasicBlock* pre_header_bb = loop->GetOrCreatePreHeaderBlock();
@@ -61,6 +61,10 @@ class LICMPass : public Pass {
   // Returns true if |bb| is immediately contained in |loop|
   bool IsImmediatelyContainedInLoop(Loop* loop, Function* f, BasicBlock* bb);
 
+  // Returns true if the memory read by the load |inst| is not written by any
+  // instruction in |loop|, so the load can be moved out of it.
+  bool IsLoopInvariantLoad(Loop* loop, Function* f, Instruction* inst);
+
   // Move the instruction to the given BasicBlock
   // This method will update the instruction to block mapping for the context
   bool HoistInstruction(Loop* loop, Instruction* inst);
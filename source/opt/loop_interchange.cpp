@@ -0,0 +1,500 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/loop_interchange.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "source/opt/ir_builder.h"
+#include "source/opt/loop_dependence.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kBranchCondTrueLabIdInIdx = 1;
+const uint32_t kBranchCondFalseLabIdInIdx = 2;
+const uint32_t kLoopMergeMergeBlockIdInIdx = 0;
+
+// The cost of a memory access along the innermost loop, by stride.
+const int64_t kInvariantCost = 0;
+const int64_t kUnitStrideCost = 1;
+const int64_t kStridedCost = 4;
+
+// Returns the sign of the dependence distance of |entry|: 0 if the
+// dependence is not carried by its loop, 1 or -1 if it is carried in one
+// direction, and 2 if it is not known.
+int DependenceSign(const DistanceEntry& entry) {
+  switch (entry.dependence_information) {
+    case DistanceEntry::DependenceInformation::DISTANCE:
+      return entry.distance > 0 ? 1 : (entry.distance < 0 ? -1 : 0);
+    case DistanceEntry::DependenceInformation::DIRECTION:
+      if (entry.direction == DistanceEntry::Directions::EQ) return 0;
+      if (entry.direction == DistanceEntry::Directions::LT) return 1;
+      if (entry.direction == DistanceEntry::Directions::GT) return -1;
+      return 2;
+    default:
+      return 2;
+  }
+}
+
+// Returns the variable accessed by the load or store |mem_op|.
+Instruction* GetAccessedVariable(IRContext* context, Instruction* mem_op) {
+  Instruction* ptr =
+      context->get_def_use_mgr()->GetDef(mem_op->GetSingleWordInOperand(0));
+  while (ptr->opcode() == SpvOpAccessChain ||
+         ptr->opcode() == SpvOpInBoundsAccessChain) {
+    ptr = context->get_def_use_mgr()->GetDef(ptr->GetSingleWordInOperand(0));
+  }
+  return ptr;
+}
+
+// Swaps the opcodes and the second in-operands of |a| and |b|.
+void SwapOperation(Instruction* a, Instruction* b) {
+  const SpvOp opcode = a->opcode();
+  const uint32_t operand = a->GetSingleWordInOperand(1);
+  a->SetOpcode(b->opcode());
+  a->SetInOperand(1, {b->GetSingleWordInOperand(1)});
+  b->SetOpcode(opcode);
+  b->SetInOperand(1, {operand});
+}
+
+}  // anonymous namespace
+
+bool LoopInterchangePass::GetInduction(Loop* loop, Induction* iv) const {
+  BasicBlock* header = loop->GetHeaderBlock();
+  if (loop->FindConditionBlock() != header) return false;
+  Instruction* branch = &*header->tail();
+  if (branch->opcode() != SpvOpBranchConditional ||
+      !loop->IsInsideLoop(
+          branch->GetSingleWordInOperand(kBranchCondTrueLabIdInIdx)) ||
+      branch->GetSingleWordInOperand(kBranchCondFalseLabIdInIdx) !=
+          loop->GetMergeBlock()->id()) {
+    return false;
+  }
+
+  // The induction variable must be the only value carried by the loop.
+  uint32_t phi_count = 0;
+  header->ForEachPhiInst([&phi_count](Instruction*) { ++phi_count; });
+  Instruction* phi = loop->FindConditionVariable(header);
+  if (phi_count != 1 || phi == nullptr ||
+      context()->get_instr_block(phi) != header) {
+    return false;
+  }
+  Instruction* step = loop->GetInductionStepOperation(phi);
+  if (step == nullptr || step->GetSingleWordInOperand(0) != phi->result_id())
+    return false;
+  if (!loop->FindNumberOfIterations(phi, branch, &iv->trip_count,
+                                    &iv->step_value)) {
+    return false;
+  }
+
+  // The condition and the step must only control the loop, so that they can
+  // be changed.
+  Instruction* condition =
+      get_def_use_mgr()->GetDef(branch->GetSingleWordInOperand(0));
+  if (get_def_use_mgr()->NumUsers(condition) != 1 ||
+      get_def_use_mgr()->NumUsers(step) != 1) {
+    return false;
+  }
+
+  iv->phi = phi;
+  iv->condition = condition;
+  iv->step = step;
+  iv->init_idx = loop->IsInsideLoop(phi->GetSingleWordInOperand(1)) ? 2 : 0;
+  return true;
+}
+
+bool LoopInterchangePass::IsPerfectNest(Loop* outer, Loop* inner,
+                                        Induction* outer_iv,
+                                        Induction* inner_iv) const {
+  if (outer->NumImmediateChildren() != 1 || *outer->begin() != inner)
+    return false;
+  if (!GetInduction(outer, outer_iv) || !GetInduction(inner, inner_iv))
+    return false;
+  if (outer_iv->phi->type_id() != inner_iv->phi->type_id()) return false;
+
+  // The blocks of the outer loop around the inner loop only hold the control
+  // of the outer loop.
+  for (uint32_t bb_id : outer->GetBlocks()) {
+    if (inner->IsInsideLoop(bb_id)) continue;
+    BasicBlock* bb = cfg()->block(bb_id);
+    const bool is_header = bb == outer->GetHeaderBlock();
+    for (auto& inst : *bb) {
+      if (&inst == outer_iv->phi || &inst == outer_iv->condition ||
+          &inst == outer_iv->step || inst.opcode() == SpvOpBranch) {
+        continue;
+      }
+      if (is_header && (inst.opcode() == SpvOpLoopMerge ||
+                        inst.opcode() == SpvOpBranchConditional)) {
+        continue;
+      }
+      return false;
+    }
+  }
+
+  // The induction variables must not be used after their loop, where the
+  // interchange changes their value.
+  auto is_used_only_in = [this](Instruction* inst, Loop* loop) {
+    return get_def_use_mgr()->WhileEachUser(
+        inst, [this, loop](Instruction* user) {
+          BasicBlock* bb = context()->get_instr_block(user);
+          return bb == nullptr || loop->IsInsideLoop(bb);
+        });
+  };
+  return is_used_only_in(outer_iv->phi, outer) &&
+         is_used_only_in(inner_iv->phi, inner);
+}
+
+bool LoopInterchangePass::GetMemoryAccesses(
+    Loop* loop, std::vector<Instruction*>* loads,
+    std::vector<Instruction*>* stores) const {
+  for (uint32_t bb_id : loop->GetBlocks()) {
+    for (auto& inst : *cfg()->block(bb_id)) {
+      switch (inst.opcode()) {
+        case SpvOpLoad:
+          loads->push_back(&inst);
+          break;
+        case SpvOpStore:
+          stores->push_back(&inst);
+          break;
+        case SpvOpPhi:
+        case SpvOpAccessChain:
+        case SpvOpInBoundsAccessChain:
+        case SpvOpSelectionMerge:
+        case SpvOpLoopMerge:
+        case SpvOpBranch:
+        case SpvOpBranchConditional:
+        case SpvOpSwitch:
+          break;
+        default:
+          if (!inst.IsOpcodeCodeMotionSafe()) return false;
+          break;
+      }
+    }
+  }
+  return true;
+}
+
+bool LoopInterchangePass::IsInterchangeLegal(Loop* outer, Loop* inner) const {
+  std::vector<Instruction*> loads;
+  std::vector<Instruction*> stores;
+  if (!GetMemoryAccesses(inner, &loads, &stores)) return false;
+  if (stores.empty()) return true;
+
+  // The dependence vectors have an entry for each loop of the nest, from the
+  // outermost one.
+  std::vector<const Loop*> loops;
+  for (Loop* loop = outer; loop != nullptr; loop = loop->GetParent())
+    loops.push_back(loop);
+  std::reverse(loops.begin(), loops.end());
+  const size_t outer_pos = loops.size() - 1;
+  loops.push_back(inner);
+  const size_t inner_pos = loops.size() - 1;
+  LoopDependenceAnalysis analysis(context(), loops);
+
+  // A dependence carried by a single loop, or by both loops in the same
+  // direction, is kept by the interchange.
+  auto is_kept = [&analysis, &loops, outer_pos, inner_pos](
+                     Instruction* source, Instruction* destination) {
+    DistanceVector distances(loops.size());
+    if (analysis.GetDependence(source, destination, &distances)) return true;
+    const int outer_sign = DependenceSign(distances.GetEntry(outer_pos));
+    const int inner_sign = DependenceSign(distances.GetEntry(inner_pos));
+    return outer_sign == 0 || inner_sign == 0 ||
+           (outer_sign == inner_sign && outer_sign != 2);
+  };
+
+  // Each store depends on the loads and the stores of the same variable,
+  // including itself.
+  std::map<Instruction*, std::vector<Instruction*>> accesses;
+  for (Instruction* load : loads)
+    accesses[GetAccessedVariable(context(), load)].push_back(load);
+  for (Instruction* store : stores) {
+    std::vector<Instruction*>& others =
+        accesses[GetAccessedVariable(context(), store)];
+    others.push_back(store);
+    for (Instruction* other : others) {
+      if (!is_kept(other, store)) return false;
+    }
+  }
+  return true;
+}
+
+LoopInterchangePass::Stride LoopInterchangePass::GetStride(
+    Instruction* mem_op, const Loop* loop,
+    ScalarEvolutionAnalysis* scev) const {
+  Instruction* ptr =
+      get_def_use_mgr()->GetDef(mem_op->GetSingleWordInOperand(0));
+  if (ptr->opcode() != SpvOpAccessChain &&
+      ptr->opcode() != SpvOpInBoundsAccessChain) {
+    return kInvariant;
+  }
+
+  // Only the last index selects consecutive elements.
+  const uint32_t last_idx = ptr->NumInOperands() - 1;
+  Stride stride = kInvariant;
+  for (uint32_t i = 1; i <= last_idx; ++i) {
+    SENode* index = scev->SimplifyExpression(scev->AnalyzeInstruction(
+        get_def_use_mgr()->GetDef(ptr->GetSingleWordInOperand(i))));
+    if (index->IsCantCompute()) return kStrided;
+    for (SERecurrentNode* rec : index->CollectRecurrentNodes()) {
+      if (rec->GetLoop() != loop) continue;
+      SEConstantNode* coefficient = rec->GetCoefficient()->AsSEConstantNode();
+      if (i != last_idx || coefficient == nullptr ||
+          std::abs(coefficient->FoldToSingleValue()) != 1) {
+        return kStrided;
+      }
+      stride = kUnit;
+    }
+  }
+  return stride;
+}
+
+void LoopInterchangePass::Interchange(Loop* inner, const Induction& outer_iv,
+                                      const Induction& inner_iv) {
+  const uint32_t outer_init =
+      outer_iv.phi->GetSingleWordInOperand(outer_iv.init_idx);
+  outer_iv.phi->SetInOperand(
+      outer_iv.init_idx,
+      {inner_iv.phi->GetSingleWordInOperand(inner_iv.init_idx)});
+  inner_iv.phi->SetInOperand(inner_iv.init_idx, {outer_init});
+  SwapOperation(outer_iv.condition, inner_iv.condition);
+  SwapOperation(outer_iv.step, inner_iv.step);
+  for (Instruction* inst :
+       {outer_iv.phi, outer_iv.condition, outer_iv.step, inner_iv.phi,
+        inner_iv.condition, inner_iv.step}) {
+    get_def_use_mgr()->AnalyzeInstUse(inst);
+  }
+
+  // The outer induction variable now takes the values of the inner one, and
+  // conversely, so the body uses them the other way around.
+  const uint32_t outer_id = outer_iv.phi->result_id();
+  const uint32_t inner_id = inner_iv.phi->result_id();
+  for (uint32_t bb_id : inner->GetBlocks()) {
+    for (auto& inst : *cfg()->block(bb_id)) {
+      if (&inst == inner_iv.phi || &inst == inner_iv.condition ||
+          &inst == inner_iv.step) {
+        continue;
+      }
+      bool changed = false;
+      inst.ForEachInId([outer_id, inner_id, &changed](uint32_t* id) {
+        if (*id == outer_id) {
+          *id = inner_id;
+          changed = true;
+        } else if (*id == inner_id) {
+          *id = outer_id;
+          changed = true;
+        }
+      });
+      if (changed) get_def_use_mgr()->AnalyzeInstUse(&inst);
+    }
+  }
+}
+
+uint32_t LoopInterchangePass::StripMine(Function* func, Loop* loop,
+                                        const Induction& iv) {
+  analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  const uint32_t type_id = iv.phi->type_id();
+  const analysis::Constant* tile_step = const_mgr->GetConstant(
+      context()->get_type_mgr()->GetType(type_id),
+      {static_cast<uint32_t>(iv.step_value * tile_size_)});
+  const uint32_t tile_step_id =
+      const_mgr->GetDefiningInstruction(tile_step, type_id)->result_id();
+  const uint32_t entry_id = iv.phi->GetSingleWordInOperand(iv.init_idx + 1);
+  BasicBlock* header = loop->GetHeaderBlock();
+  BasicBlock* merge = loop->GetMergeBlock();
+
+  const uint32_t tile_header_id = TakeNextId();
+  const uint32_t tile_body_id = TakeNextId();
+  const uint32_t inner_merge_id = TakeNextId();
+  const uint32_t tile_continue_id = TakeNextId();
+  const uint32_t tile_phi_id = TakeNextId();
+  const uint32_t tile_next_id = TakeNextId();
+  auto new_block = [this, func](uint32_t id) {
+    std::unique_ptr<BasicBlock> bb(new BasicBlock(std::unique_ptr<Instruction>(
+        new Instruction(context(), SpvOpLabel, 0, id, {}))));
+    bb->SetParent(func);
+    get_def_use_mgr()->AnalyzeInstDef(bb->GetLabelInst());
+    context()->set_instr_block(bb->GetLabelInst(), bb.get());
+    return bb;
+  };
+  const IRContext::Analysis kPreserved =
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping;
+
+  // The loop over the tiles, which starts where |loop| started, and steps
+  // over |tile_size_| iterations of it.
+  std::unique_ptr<BasicBlock> tile_header = new_block(tile_header_id);
+  InstructionBuilder header_builder(context(), tile_header.get(), kPreserved);
+  header_builder.AddPhi(type_id,
+                        {iv.phi->GetSingleWordInOperand(iv.init_idx), entry_id,
+                         tile_next_id, tile_continue_id},
+                        tile_phi_id);
+  Instruction* tile_condition = header_builder.AddBinaryOp(
+      iv.condition->type_id(), iv.condition->opcode(), tile_phi_id,
+      iv.condition->GetSingleWordInOperand(1));
+  header_builder.AddLoopMerge(merge->id(), tile_continue_id);
+  header_builder.AddConditionalBranch(tile_condition->result_id(),
+                                      tile_body_id, merge->id());
+
+  // The end of the tile, where |loop| now stops.
+  std::unique_ptr<BasicBlock> tile_body = new_block(tile_body_id);
+  InstructionBuilder body_builder(context(), tile_body.get(), kPreserved);
+  Instruction* tile_end = body_builder.AddBinaryOp(
+      type_id, iv.step->opcode(), tile_phi_id, tile_step_id);
+  body_builder.AddBranch(header->id());
+
+  std::unique_ptr<BasicBlock> inner_merge = new_block(inner_merge_id);
+  InstructionBuilder merge_builder(context(), inner_merge.get(), kPreserved);
+  merge_builder.AddBranch(tile_continue_id);
+
+  std::unique_ptr<BasicBlock> tile_continue = new_block(tile_continue_id);
+  InstructionBuilder continue_builder(context(), tile_continue.get(),
+                                      kPreserved);
+  std::unique_ptr<Instruction> tile_next(
+      new Instruction(context(), iv.step->opcode(), type_id, tile_next_id,
+                      {{SPV_OPERAND_TYPE_ID, {tile_phi_id}},
+                       {SPV_OPERAND_TYPE_ID, {tile_step_id}}}));
+  continue_builder.AddInstruction(std::move(tile_next));
+  continue_builder.AddBranch(tile_header_id);
+
+  // Enter the tile loop instead of |loop|, and run |loop| over one tile.
+  BasicBlock* entry = cfg()->block(entry_id);
+  entry->ForEachSuccessorLabel([header, tile_header_id](uint32_t* succ) {
+    if (*succ == header->id()) *succ = tile_header_id;
+  });
+  def_use_mgr->AnalyzeInstUse(&*entry->tail());
+  iv.phi->SetInOperand(iv.init_idx, {tile_phi_id});
+  iv.phi->SetInOperand(iv.init_idx + 1, {tile_body_id});
+  def_use_mgr->AnalyzeInstUse(iv.phi);
+  iv.condition->SetInOperand(1, {tile_end->result_id()});
+  def_use_mgr->AnalyzeInstUse(iv.condition);
+  Instruction* loop_merge = header->GetLoopMergeInst();
+  loop_merge->SetInOperand(kLoopMergeMergeBlockIdInIdx, {inner_merge_id});
+  def_use_mgr->AnalyzeInstUse(loop_merge);
+  Instruction* branch = &*header->tail();
+  branch->SetInOperand(kBranchCondFalseLabIdInIdx, {inner_merge_id});
+  def_use_mgr->AnalyzeInstUse(branch);
+
+  // The tile loop is placed before |loop|, and the new merge block of |loop|
+  // and the continue block of the tile loop after it.
+  BasicBlock* tile_header_ptr =
+      func->InsertBasicBlockAfter(std::move(tile_header), entry);
+  func->InsertBasicBlockAfter(std::move(tile_body), tile_header_ptr);
+  BasicBlock* before_merge = nullptr;
+  for (auto& bb : *func) {
+    if (&bb == merge) break;
+    before_merge = &bb;
+  }
+  BasicBlock* inner_merge_ptr =
+      func->InsertBasicBlockAfter(std::move(inner_merge), before_merge);
+  func->InsertBasicBlockAfter(std::move(tile_continue), inner_merge_ptr);
+  return tile_header_id;
+}
+
+bool LoopInterchangePass::ProcessNest(Function* func, uint32_t outer_id,
+                                      uint32_t inner_id) {
+  LoopDescriptor& ld = *context()->GetLoopDescriptor(func);
+  Loop* outer = ld[outer_id];
+  Loop* inner = ld[inner_id];
+  Induction outer_iv;
+  Induction inner_iv;
+  if (!IsPerfectNest(outer, inner, &outer_iv, &inner_iv)) return false;
+
+  // Sum the costs of the memory accesses when each loop is the innermost.
+  std::vector<Instruction*> accesses;
+  if (!GetMemoryAccesses(inner, &accesses, &accesses)) return false;
+  ScalarEvolutionAnalysis scev(context());
+  const int64_t kCosts[] = {kInvariantCost, kUnitStrideCost, kStridedCost};
+  int64_t outer_cost = 0;
+  int64_t inner_cost = 0;
+  bool has_inner_unit_stride = false;
+  bool has_outer_unit_stride = false;
+  for (Instruction* access : accesses) {
+    const Stride outer_stride = GetStride(access, outer, &scev);
+    const Stride inner_stride = GetStride(access, inner, &scev);
+    outer_cost += kCosts[outer_stride];
+    inner_cost += kCosts[inner_stride];
+    if (inner_stride == kUnit) has_inner_unit_stride = true;
+    if (outer_stride == kUnit && inner_stride == kStrided)
+      has_outer_unit_stride = true;
+  }
+
+  if (tile_size_ == 0) {
+    if (outer_cost >= inner_cost || !IsInterchangeLegal(outer, inner))
+      return false;
+    Interchange(inner, outer_iv, inner_iv);
+    return true;
+  }
+
+  // Tile the inner loop into whole tiles of increasing induction values.
+  if (!has_inner_unit_stride || !has_outer_unit_stride) return false;
+  if ((inner_iv.condition->opcode() != SpvOpSLessThan &&
+       inner_iv.condition->opcode() != SpvOpULessThan) ||
+      inner_iv.step->opcode() != SpvOpIAdd || inner_iv.step_value <= 0 ||
+      inner_iv.step_value * tile_size_ > std::numeric_limits<int32_t>::max() ||
+      inner_iv.trip_count <= tile_size_ ||
+      inner_iv.trip_count % tile_size_ != 0) {
+    return false;
+  }
+  if (cfg()->preds(inner->GetMergeBlock()->id()).size() != 1 ||
+      !IsInterchangeLegal(outer, inner)) {
+    return false;
+  }
+  const uint32_t tile_id = StripMine(func, inner, inner_iv);
+
+  // Move the loop over the tiles out of |outer|.
+  context()->InvalidateAnalysesExceptFor(
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  LoopDescriptor& new_ld = *context()->GetLoopDescriptor(func);
+  Loop* tile_loop = new_ld[tile_id];
+  Induction tile_iv;
+  if (IsPerfectNest(new_ld[outer_id], tile_loop, &outer_iv, &tile_iv))
+    Interchange(tile_loop, outer_iv, tile_iv);
+  return true;
+}
+
+bool LoopInterchangePass::ProcessFunction(Function* func) {
+  // The nests are found first, since tiling rebuilds the loop descriptor.
+  std::vector<std::pair<uint32_t, uint32_t>> nests;
+  for (Loop& loop : *context()->GetLoopDescriptor(func)) {
+    Loop* parent = loop.GetParent();
+    if (loop.HasNestedLoops() || parent == nullptr) continue;
+    nests.emplace_back(parent->GetHeaderBlock()->id(),
+                       loop.GetHeaderBlock()->id());
+  }
+
+  bool modified = false;
+  for (const auto& nest : nests) {
+    if (ProcessNest(func, nest.first, nest.second)) modified = true;
+  }
+  return modified;
+}
+
+Pass::Status LoopInterchangePass::Process() {
+  bool modified = false;
+  for (auto& func : *get_module()) {
+    if (ProcessFunction(&func)) modified = true;
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,126 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_LOOP_INTERCHANGE_H_
+#define SOURCE_OPT_LOOP_INTERCHANGE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
+#include "source/opt/pass.h"
+#include "source/opt/scalar_analysis.h"
+
+namespace spvtools {
+namespace opt {
+
+// Implements the interchange and the tiling of perfect nests of two loops.
+//
+// A nest is perfect when the outer loop only contains the inner loop and its
+// own control, and both loops iterate a known number of times with a single
+// induction variable, tested in their header.  The loops can then be
+// interchanged by swapping the initial value, the bound and the step of their
+// induction variables, and swapping the induction variables in the body.
+//
+// The interchange is legal when the dependence distance vectors computed by
+// LoopDependenceAnalysis show that no dependence is carried by the two loops
+// in opposite directions.  It is done when the memory accesses of the body
+// have a smaller stride along the outer loop than along the inner loop.
+//
+// Tiling strip-mines the inner loop into tiles of |tile_size| iterations, and
+// moves the loop over the tiles out of the outer loop.  It is done when some
+// accesses have a unit stride along the inner loop, and others have a unit
+// stride along the outer loop only, so that no order of the two loops suits
+// all of them.
+class LoopInterchangePass : public Pass {
+ public:
+  // Interchanges loops if |tile_size| is 0, or else tiles them.
+  explicit LoopInterchangePass(uint32_t tile_size = 0)
+      : tile_size_(tile_size) {}
+
+  const char* name() const override {
+    return tile_size_ ? "loop-tile" : "loop-interchange";
+  }
+
+  Status Process() override;
+
+ private:
+  // The induction variable controlling a loop.
+  struct Induction {
+    Instruction* phi;
+    // The comparison of |phi| with the bound in the header.
+    Instruction* condition;
+    // The increment of |phi| by a constant.
+    Instruction* step;
+    // The index of the in-operand of |phi| with its initial value.
+    uint32_t init_idx;
+    size_t trip_count;
+    int64_t step_value;
+  };
+
+  // How the address of a memory access changes from one iteration of a loop
+  // to the next.
+  enum Stride { kInvariant, kUnit, kStrided };
+
+  // Interchanges or tiles the perfect nests of |func|.  Returns true if
+  // |func| was modified.
+  bool ProcessFunction(Function* func);
+
+  // Returns true if the loop nest with headers |outer_id| and |inner_id| is
+  // interchanged or tiled.
+  bool ProcessNest(Function* func, uint32_t outer_id, uint32_t inner_id);
+
+  // Finds the induction variable controlling |loop|.  Returns false if the
+  // loop is not controlled by a single induction variable tested in its
+  // header, with a known number of iterations.
+  bool GetInduction(Loop* loop, Induction* iv) const;
+
+  // Returns true if |inner| is the only content of |outer| besides its
+  // control, and fills the induction variables of both loops.
+  bool IsPerfectNest(Loop* outer, Loop* inner, Induction* outer_iv,
+                     Induction* inner_iv) const;
+
+  // Returns true if the iterations of |outer| and |inner| can be executed in
+  // the interchanged order.
+  bool IsInterchangeLegal(Loop* outer, Loop* inner) const;
+
+  // Returns the loads and stores of |loop|.  Returns false if it has other
+  // instructions with side effects.
+  bool GetMemoryAccesses(Loop* loop, std::vector<Instruction*>* loads,
+                         std::vector<Instruction*>* stores) const;
+
+  // Returns the stride of the memory access |mem_op| along |loop|.
+  Stride GetStride(Instruction* mem_op, const Loop* loop,
+                   ScalarEvolutionAnalysis* scev) const;
+
+  // Interchanges the loops of the perfect nest |outer| and |inner|, with
+  // induction variables |outer_iv| and |inner_iv|.
+  void Interchange(Loop* inner, const Induction& outer_iv,
+                   const Induction& inner_iv);
+
+  // Strip-mines |loop|, with induction variable |iv|, into a loop over tiles
+  // of |tile_size_| iterations around it.  Returns the id of the header of
+  // the new loop.
+  uint32_t StripMine(Function* func, Loop* loop, const Induction& iv);
+
+  // The number of iterations of a tile, or 0 if loops are interchanged.
+  uint32_t tile_size_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_LOOP_INTERCHANGE_H_
@@ -14,6 +14,7 @@
 
 #include "source/opt/loop_unroller.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <memory>
@@ -23,6 +24,7 @@
 
 #include "source/opt/ir_builder.h"
 #include "source/opt/loop_utils.h"
+#include "source/opt/register_pressure.h"
 
 // Implements loop util unrolling functionality for fully and partially
 // unrolling loops. Given a factor it will duplicate the loop that many times,
@@ -937,6 +939,48 @@ void LoopUnrollerUtilsImpl::PartiallyUnroll(Loop* loop, size_t factor) {
  * End LoopUtilsImpl.
  */
 
+// Limits of the cost model of the automatic unrolling.  A loop is fully
+// unrolled if that gives at most |kMaxFullyUnrolledSize| instructions, or
+// else partially unrolled by at most |kMaxUnrollFactor| if the unrolled body
+// has at most |kMaxUnrolledBodySize| instructions.  Neither is done if the
+// estimated register pressure of the unrolled loop is above
+// |kMaxUnrolledRegisterPressure|.
+const size_t kMaxFullyUnrolledSize = 256;
+const size_t kMaxUnrolledBodySize = 128;
+const size_t kMaxUnrollFactor = 8;
+const size_t kMaxUnrolledRegisterPressure = 64;
+
+// Returns true if |loop| has the DontUnroll flag.
+bool HasDontUnrollLoopControl(const Loop& loop) {
+  const Instruction* merge = loop.GetHeaderBlock()->GetLoopMergeInst();
+  return merge && (merge->GetSingleWordOperand(kLoopControlIndex) &
+                   kLoopControlDontUnrollIndex);
+}
+
+// Returns the number of instructions of |loop| that are duplicated for each
+// copy of its body.  The labels, phis, merges and unconditional branches are
+// not counted, as they mostly disappear once the copies are merged.
+size_t GetLoopBodySize(IRContext* context, const Loop& loop) {
+  size_t size = 0;
+  for (uint32_t label_id : loop.GetBlocks()) {
+    for (const Instruction& inst : *context->cfg()->block(label_id)) {
+      switch (inst.opcode()) {
+        case SpvOpPhi:
+        case SpvOpLoopMerge:
+        case SpvOpSelectionMerge:
+        case SpvOpBranch:
+        case SpvOpLine:
+        case SpvOpNoLine:
+          break;
+        default:
+          ++size;
+          break;
+      }
+    }
+  }
+  return std::max<size_t>(size, 1);
+}
+
 }  // namespace
 
 /*
@@ -1069,6 +1113,12 @@ Pass::Status LoopUnroller::Process() {
   bool changed = false;
   for (Function& f : *context()->module()) {
     LoopDescriptor* LD = context()->GetLoopDescriptor(&f);
+    if (auto_unroll_) {
+      if (AutoUnrollLoops(&f)) changed = true;
+      LD->PostModificationCleanup();
+      continue;
+    }
+
     for (Loop& loop : *LD) {
       LoopUtils loop_utils{context(), &loop};
       if (!loop.HasUnrollLoopControl() || !loop_utils.CanPerformUnroll()) {
@@ -1088,5 +1138,118 @@ Pass::Status LoopUnroller::Process() {
   return changed ? Status::SuccessWithChange : Status::SuccessWithoutChange;
 }
 
+bool LoopUnroller::AutoUnrollLoops(Function* f) {
+  // The decisions are taken before changing |f|, as the register liveness is
+  // not kept up to date by the unroller.  Only inner loops can be unrolled,
+  // so unrolling a loop does not change the others.
+  LoopDescriptor* LD = context()->GetLoopDescriptor(f);
+  RegisterLiveness liveness(context(), f);
+  struct UnrollDecision {
+    Loop* loop;
+    size_t factor;
+    bool fully_unroll;
+  };
+  std::vector<UnrollDecision> decisions;
+  size_t remaining_budget = size_budget_;
+  for (Loop& loop : *LD) {
+    LoopUtils loop_utils{context(), &loop};
+    if (HasDontUnrollLoopControl(loop) || !loop_utils.CanPerformUnroll()) {
+      continue;
+    }
+
+    // A loop that never ran in the profile is not worth growing the function
+    // for, unless it asks to be unrolled.
+    const BasicBlock* header = loop.GetHeaderBlock();
+    if (header->HasProfileCount() && header->profile_count() == 0 &&
+        !loop.HasUnrollLoopControl()) {
+      continue;
+    }
+
+    bool fully_unroll = false;
+    size_t growth = 0;
+    size_t factor = ChooseUnrollFactor(loop, liveness, remaining_budget,
+                                       &fully_unroll, &growth);
+    if (factor == 0) continue;
+    remaining_budget -= growth;
+    decisions.push_back({&loop, factor, fully_unroll});
+  }
+
+  bool changed = false;
+  for (const UnrollDecision& decision : decisions) {
+    LoopUtils loop_utils{context(), decision.loop};
+    if (decision.fully_unroll) {
+      if (loop_utils.FullyUnroll()) changed = true;
+    } else {
+      if (loop_utils.PartiallyUnroll(decision.factor)) changed = true;
+    }
+  }
+  return changed;
+}
+
+size_t LoopUnroller::ChooseUnrollFactor(const Loop& loop,
+                                        const RegisterLiveness& liveness,
+                                        size_t size_budget, bool* fully_unroll,
+                                        size_t* growth) const {
+  // LoopUtils::CanPerformUnroll has checked that the trip count is known.
+  const BasicBlock* condition = loop.FindConditionBlock();
+  const Instruction* induction = loop.FindConditionVariable(condition);
+  size_t trip_count = 0;
+  if (!loop.FindNumberOfIterations(induction, &*condition->ctail(),
+                                   &trip_count) ||
+      trip_count == 0) {
+    return 0;
+  }
+
+  const size_t body_size = GetLoopBodySize(context(), loop);
+  RegisterLiveness::RegionRegisterLiveness sim_result;
+
+  // Fully unrolling removes the loop overhead and lets the induction variable
+  // be folded into constants, so it is preferred when the code stays small.
+  // The Unroll flag lifts the size limit, but not the budget.
+  const size_t max_fully_unrolled_size = loop.HasUnrollLoopControl()
+                                             ? size_budget + body_size
+                                             : kMaxFullyUnrolledSize;
+  if (trip_count <= max_fully_unrolled_size / body_size &&
+      body_size * (trip_count - 1) <= size_budget) {
+    liveness.SimulateUnroll(loop, std::min(trip_count, kMaxUnrollFactor),
+                            &sim_result);
+    if (sim_result.used_registers_ <= kMaxUnrolledRegisterPressure) {
+      *fully_unroll = true;
+      *growth = body_size * (trip_count - 1);
+      return trip_count;
+    }
+  }
+
+  // Otherwise pick the largest factor that fits the limits, preferring the
+  // factors dividing the trip count: the others need a copy of the loop to
+  // run the remaining iterations.
+  size_t best_factor = 0;
+  size_t best_growth = 0;
+  for (size_t factor = std::min(kMaxUnrollFactor, trip_count - 1);
+       factor >= 2; --factor) {
+    if (body_size * factor > kMaxUnrolledBodySize) continue;
+    const bool has_residual = trip_count % factor != 0;
+    const size_t factor_growth =
+        body_size * (factor - 1) + (has_residual ? body_size : 0);
+    if (factor_growth > size_budget) continue;
+    liveness.SimulateUnroll(loop, factor, &sim_result);
+    if (sim_result.used_registers_ > kMaxUnrolledRegisterPressure) continue;
+
+    if (!has_residual) {
+      best_factor = factor;
+      best_growth = factor_growth;
+      break;
+    }
+    if (best_factor == 0) {
+      best_factor = factor;
+      best_growth = factor_growth;
+    }
+  }
+
+  *fully_unroll = false;
+  *growth = best_growth;
+  return best_factor;
+}
+
 }  // namespace opt
 }  // namespace spvtools
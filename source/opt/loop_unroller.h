@@ -15,16 +15,40 @@
 #ifndef SOURCE_OPT_LOOP_UNROLLER_H_
 #define SOURCE_OPT_LOOP_UNROLLER_H_
 
+#include <cstddef>
+
+#include "source/opt/loop_descriptor.h"
 #include "source/opt/pass.h"
+#include "source/opt/register_pressure.h"
 
 namespace spvtools {
 namespace opt {
 
 class LoopUnroller : public Pass {
  public:
-  LoopUnroller() : Pass(), fully_unroll_(true), unroll_factor_(0) {}
+  LoopUnroller()
+      : Pass(),
+        fully_unroll_(true),
+        unroll_factor_(0),
+        auto_unroll_(false),
+        size_budget_(0) {}
   LoopUnroller(bool fully_unroll, int unroll_factor)
-      : Pass(), fully_unroll_(fully_unroll), unroll_factor_(unroll_factor) {}
+      : Pass(),
+        fully_unroll_(fully_unroll),
+        unroll_factor_(unroll_factor),
+        auto_unroll_(false),
+        size_budget_(0) {}
+
+  // Creates an unroller that decides how to unroll each loop it can unroll,
+  // whether or not it has the Unroll flag, from its trip count, its size and
+  // the register pressure.  The loops of a function are unrolled as long as
+  // the function grows by at most |size_budget| instructions.
+  explicit LoopUnroller(size_t size_budget)
+      : Pass(),
+        fully_unroll_(false),
+        unroll_factor_(0),
+        auto_unroll_(true),
+        size_budget_(size_budget) {}
 
   const char* name() const override { return "loop-unroll"; }
 
@@ -38,8 +62,22 @@ class LoopUnroller : public Pass {
   }
 
  private:
+  // Unrolls the loops of |f| chosen by the cost model.  Returns true if |f|
+  // was modified.
+  bool AutoUnrollLoops(Function* f);
+
+  // Returns the number of times the body of |loop| should be replicated, or 0
+  // if it should not be unrolled.  |fully_unroll| is set to true if |loop|
+  // should be fully unrolled.  The number of instructions the unrolling adds
+  // is returned in |growth|, and must be at most |size_budget|.
+  size_t ChooseUnrollFactor(const Loop& loop, const RegisterLiveness& liveness,
+                            size_t size_budget, bool* fully_unroll,
+                            size_t* growth) const;
+
   bool fully_unroll_;
   int unroll_factor_;
+  bool auto_unroll_;
+  size_t size_budget_;
 };
 
 }  // namespace opt
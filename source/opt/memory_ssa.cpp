@@ -0,0 +1,493 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/memory_ssa.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+const uint32_t kLoadPointerInIdx = 0;
+const uint32_t kLoadMemoryAccessInIdx = 1;
+const uint32_t kStorePointerInIdx = 0;
+const uint32_t kStoreMemoryAccessInIdx = 2;
+const uint32_t kCopyMemoryTargetInIdx = 0;
+const uint32_t kCopyMemorySourceInIdx = 1;
+const uint32_t kAtomicPointerInIdx = 0;
+const uint32_t kAtomicSemanticsInIdx = 2;
+const uint32_t kAtomicUnequalSemanticsInIdx = 3;
+const uint32_t kControlBarrierSemanticsInIdx = 2;
+const uint32_t kMemoryBarrierSemanticsInIdx = 1;
+const uint32_t kTypePointerTypeInIdx = 1;
+
+const uint32_t kOrderingSemanticsMask =
+    SpvMemorySemanticsAcquireMask | SpvMemorySemanticsReleaseMask |
+    SpvMemorySemanticsAcquireReleaseMask |
+    SpvMemorySemanticsSequentiallyConsistentMask;
+
+// Returns true if the memory semantics |semantics| order memory accesses.
+bool IsRelaxed(uint32_t semantics) {
+  return (semantics & kOrderingSemanticsMask) == 0;
+}
+
+// Returns the value of |inst| if it is a scalar integer OpConstant of at most
+// 64 bits.  Returns false otherwise.
+bool GetConstantValue(const Instruction* inst, uint64_t* value) {
+  if (inst == nullptr || inst->opcode() != SpvOpConstant) return false;
+  const Operand& operand = inst->GetInOperand(0);
+  if (operand.words.size() == 1) {
+    *value = operand.words[0];
+    return true;
+  }
+  if (operand.words.size() == 2) {
+    *value = static_cast<uint64_t>(operand.words[1]) << 32 | operand.words[0];
+    return true;
+  }
+  return false;
+}
+}  // namespace
+
+MemorySSA::MemorySSA(IRContext* context, Function* f) : context_(context) {
+  CollectPartitions(f);
+  Build(f);
+}
+
+MemoryAccess* MemorySSA::GetUse(const Instruction* inst) const {
+  if (inst->opcode() != SpvOpLoad) return nullptr;
+  for (MemoryAccess* access : GetAccesses(inst)) {
+    if (access->IsUse() && access->pointer_id() != 0) return access;
+  }
+  return nullptr;
+}
+
+std::vector<MemoryAccess*> MemorySSA::GetDefs(const Instruction* inst) const {
+  std::vector<MemoryAccess*> defs;
+  for (MemoryAccess* access : GetAccesses(inst)) {
+    if (access->IsDef()) defs.push_back(access);
+  }
+  return defs;
+}
+
+const std::vector<MemoryAccess*>& MemorySSA::GetAccesses(
+    const Instruction* inst) const {
+  static const std::vector<MemoryAccess*> kNoAccesses;
+  auto it = inst_accesses_.find(inst);
+  return it != inst_accesses_.end() ? it->second : kNoAccesses;
+}
+
+MemoryAccess* MemorySSA::GetPhi(const BasicBlock* bb,
+                                uint32_t partition) const {
+  auto it = phis_.find({bb->id(), partition});
+  return it != phis_.end() ? it->second : nullptr;
+}
+
+MemoryAccess* MemorySSA::GetLiveOnEntry(uint32_t partition) const {
+  auto it = live_on_entry_.find(partition);
+  return it != live_on_entry_.end() ? it->second : nullptr;
+}
+
+MemoryAccess* MemorySSA::GetClobberingAccess(
+    const MemoryAccess* access) const {
+  MemoryAccess* current = access->defining_access();
+  if (access->pointer_id() == 0) return current;
+  AliasAnalysis* alias_analysis = context_->GetAliasAnalysis();
+  while (current != nullptr && current->IsDef() &&
+         current->pointer_id() != 0 &&
+         !alias_analysis->MayAlias(current->pointer_id(),
+                                   access->pointer_id())) {
+    current = current->defining_access();
+  }
+  return current;
+}
+
+uint32_t MemorySSA::GetPartition(uint32_t pointer_id) const {
+  return context_->GetAliasAnalysis()->GetStorageClass(pointer_id);
+}
+
+MemoryAccess* MemorySSA::NewAccess(MemoryAccess::Kind kind, uint32_t partition,
+                                   Instruction* inst, BasicBlock* block,
+                                   uint32_t pointer_id) {
+  accesses_.emplace_back(
+      new MemoryAccess(kind, partition, inst, block, pointer_id));
+  return accesses_.back().get();
+}
+
+void MemorySSA::CollectPartitions(Function* f) {
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  std::unordered_set<uint32_t> partitions;
+  f->ForEachInst([this, def_use_mgr, &partitions](Instruction* inst) {
+    if (inst->opcode() == SpvOpImageWrite) {
+      partitions.insert(SpvStorageClassImage);
+    }
+    inst->ForEachInId([this, def_use_mgr, &partitions](const uint32_t* id) {
+      Instruction* def = def_use_mgr->GetDef(*id);
+      if (def->type_id() == 0) return;
+      Instruction* type = def_use_mgr->GetDef(def->type_id());
+      if (type->opcode() == SpvOpTypePointer) {
+        partitions.insert(GetPartition(*id));
+      }
+    });
+  });
+  partitions_.assign(partitions.begin(), partitions.end());
+  std::sort(partitions_.begin(), partitions_.end());
+}
+
+void MemorySSA::GetBarrierPartitions(uint32_t semantics_id,
+                                     std::vector<uint32_t>* partitions) const {
+  uint64_t semantics = 0;
+  if (GetConstantValue(context_->get_def_use_mgr()->GetDef(semantics_id),
+                       &semantics)) {
+    const std::pair<uint32_t, uint32_t> kSemanticsToStorageClass[] = {
+        {SpvMemorySemanticsUniformMemoryMask, SpvStorageClassUniform},
+        {SpvMemorySemanticsUniformMemoryMask, SpvStorageClassStorageBuffer},
+        {SpvMemorySemanticsWorkgroupMemoryMask, SpvStorageClassWorkgroup},
+        {SpvMemorySemanticsCrossWorkgroupMemoryMask,
+         SpvStorageClassCrossWorkgroup},
+        {SpvMemorySemanticsAtomicCounterMemoryMask,
+         SpvStorageClassAtomicCounter},
+        {SpvMemorySemanticsImageMemoryMask, SpvStorageClassImage},
+    };
+    size_t size = partitions->size();
+    for (const auto& entry : kSemanticsToStorageClass) {
+      if (semantics & entry.first) partitions->push_back(entry.second);
+    }
+    if (partitions->size() != size) return;
+  }
+
+  // The memory synchronized is unknown, so assume it is any memory visible to
+  // other invocations.
+  for (uint32_t partition : partitions_) {
+    if (partition != SpvStorageClassFunction) partitions->push_back(partition);
+  }
+}
+
+bool MemorySSA::IsSynchronizedAccess(uint32_t pointer_id, uint32_t mask) const {
+  if (mask & ~(SpvMemoryAccessAlignedMask | SpvMemoryAccessNontemporalMask)) {
+    return true;
+  }
+
+  Instruction* root =
+      context_->GetAliasAnalysis()->GetAccessPath(pointer_id, nullptr);
+  if (root->opcode() != SpvOpVariable) {
+    return GetPartition(pointer_id) != SpvStorageClassFunction;
+  }
+
+  // Look for Volatile and Coherent on the variable, and on the members of its
+  // type.
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  analysis::DecorationManager* decoration_mgr = context_->get_decoration_mgr();
+  std::vector<uint32_t> worklist = {root->result_id()};
+  Instruction* pointer_type = def_use_mgr->GetDef(root->type_id());
+  worklist.push_back(
+      pointer_type->GetSingleWordInOperand(kTypePointerTypeInIdx));
+  std::unordered_set<uint32_t> seen;
+  while (!worklist.empty()) {
+    uint32_t id = worklist.back();
+    worklist.pop_back();
+    if (!seen.insert(id).second) continue;
+    for (uint32_t decoration :
+         {SpvDecorationVolatile, SpvDecorationCoherent}) {
+      if (!decoration_mgr->WhileEachDecoration(
+              id, decoration, [](const Instruction&) { return false; })) {
+        return true;
+      }
+    }
+    Instruction* type = def_use_mgr->GetDef(id);
+    switch (type->opcode()) {
+      case SpvOpTypeStruct:
+        for (uint32_t i = 0; i < type->NumInOperands(); ++i) {
+          worklist.push_back(type->GetSingleWordInOperand(i));
+        }
+        break;
+      case SpvOpTypeArray:
+      case SpvOpTypeRuntimeArray:
+        worklist.push_back(type->GetSingleWordInOperand(0));
+        break;
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+void MemorySSA::AddAccesses(Instruction* inst, BasicBlock* bb,
+                            std::map<uint32_t, MemoryAccess*>* current) {
+  auto add_use = [this, inst, bb, current](uint32_t partition,
+                                          uint32_t pointer_id) {
+    auto it = current->find(partition);
+    if (it == current->end()) return;
+    MemoryAccess* use =
+        NewAccess(MemoryAccess::Kind::kUse, partition, inst, bb, pointer_id);
+    use->defining_access_ = it->second;
+    inst_accesses_[inst].push_back(use);
+  };
+  auto add_def = [this, inst, bb, current](uint32_t partition,
+                                          uint32_t pointer_id) {
+    auto it = current->find(partition);
+    if (it == current->end()) return;
+    MemoryAccess* def =
+        NewAccess(MemoryAccess::Kind::kDef, partition, inst, bb, pointer_id);
+    def->defining_access_ = it->second;
+    it->second = def;
+    inst_accesses_[inst].push_back(def);
+  };
+
+  std::vector<uint32_t> partitions;
+  switch (inst->opcode()) {
+    case SpvOpLoad: {
+      uint32_t pointer_id = inst->GetSingleWordInOperand(kLoadPointerInIdx);
+      uint32_t mask = inst->NumInOperands() > kLoadMemoryAccessInIdx
+                          ? inst->GetSingleWordInOperand(kLoadMemoryAccessInIdx)
+                          : 0;
+      if (IsSynchronizedAccess(pointer_id, mask)) {
+        add_def(GetPartition(pointer_id), 0);
+      } else {
+        add_use(GetPartition(pointer_id), pointer_id);
+      }
+      return;
+    }
+    case SpvOpStore: {
+      uint32_t pointer_id = inst->GetSingleWordInOperand(kStorePointerInIdx);
+      uint32_t mask =
+          inst->NumInOperands() > kStoreMemoryAccessInIdx
+              ? inst->GetSingleWordInOperand(kStoreMemoryAccessInIdx)
+              : 0;
+      add_def(GetPartition(pointer_id),
+              IsSynchronizedAccess(pointer_id, mask) ? 0 : pointer_id);
+      return;
+    }
+    case SpvOpCopyMemory:
+    case SpvOpCopyMemorySized:
+      add_use(
+          GetPartition(inst->GetSingleWordInOperand(kCopyMemorySourceInIdx)),
+          0);
+      add_def(
+          GetPartition(inst->GetSingleWordInOperand(kCopyMemoryTargetInIdx)),
+          0);
+      return;
+    case SpvOpImageWrite:
+      add_def(SpvStorageClassImage, 0);
+      return;
+    case SpvOpControlBarrier:
+      GetBarrierPartitions(
+          inst->GetSingleWordInOperand(kControlBarrierSemanticsInIdx),
+          &partitions);
+      break;
+    case SpvOpMemoryBarrier:
+      GetBarrierPartitions(
+          inst->GetSingleWordInOperand(kMemoryBarrierSemanticsInIdx),
+          &partitions);
+      break;
+    case SpvOpFunctionCall:
+    case SpvOpEmitVertex:
+    case SpvOpEndPrimitive:
+    case SpvOpEmitStreamVertex:
+    case SpvOpEndStreamPrimitive:
+      partitions = partitions_;
+      break;
+    case SpvOpReturn:
+    case SpvOpReturnValue:
+    case SpvOpKill:
+    case SpvOpUnreachable:
+      for (uint32_t partition : partitions_) add_use(partition, 0);
+      return;
+    case SpvOpExtInst: {
+      // Extended instructions taking pointers may read or write through them.
+      analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+      bool takes_pointer = !inst->WhileEachInId([def_use_mgr](
+                                                    const uint32_t* id) {
+        Instruction* def = def_use_mgr->GetDef(*id);
+        if (def->type_id() == 0) return true;
+        return def_use_mgr->GetDef(def->type_id())->opcode() !=
+               SpvOpTypePointer;
+      });
+      if (takes_pointer) partitions = partitions_;
+      break;
+    }
+    default:
+      if (inst->IsAtomicOp()) {
+        partitions.push_back(GetPartition(
+            inst->GetSingleWordInOperand(kAtomicPointerInIdx)));
+        std::vector<uint32_t> semantics_ids = {
+            inst->GetSingleWordInOperand(kAtomicSemanticsInIdx)};
+        if (inst->opcode() == SpvOpAtomicCompareExchange ||
+            inst->opcode() == SpvOpAtomicCompareExchangeWeak) {
+          semantics_ids.push_back(
+              inst->GetSingleWordInOperand(kAtomicUnequalSemanticsInIdx));
+        }
+        for (uint32_t semantics_id : semantics_ids) {
+          uint64_t semantics = 0;
+          if (!GetConstantValue(
+                  context_->get_def_use_mgr()->GetDef(semantics_id),
+                  &semantics) ||
+              !IsRelaxed(static_cast<uint32_t>(semantics))) {
+            GetBarrierPartitions(semantics_id, &partitions);
+          }
+        }
+      }
+      break;
+  }
+
+  std::sort(partitions.begin(), partitions.end());
+  partitions.erase(std::unique(partitions.begin(), partitions.end()),
+                   partitions.end());
+  for (uint32_t partition : partitions) add_def(partition, 0);
+}
+
+void MemorySSA::Build(Function* f) {
+  if (f->begin() == f->end() || partitions_.empty()) return;
+
+  CFG* cfg = context_->cfg();
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(f);
+
+  std::map<uint32_t, MemoryAccess*> entry_state;
+  for (uint32_t partition : partitions_) {
+    MemoryAccess* live_on_entry = NewAccess(MemoryAccess::Kind::kLiveOnEntry,
+                                            partition, nullptr, nullptr, 0);
+    live_on_entry_[partition] = live_on_entry;
+    entry_state[partition] = live_on_entry;
+  }
+
+  // Visit the blocks in dominator tree order.  A block with a single
+  // predecessor is immediately dominated by it, so the versions on exit of the
+  // predecessor are known when the block is visited.  Other blocks start with
+  // a phi per partition.
+  std::unordered_map<uint32_t, std::map<uint32_t, MemoryAccess*>> exit_states;
+  std::vector<BasicBlock*> join_blocks;
+  for (DominatorTreeNode& node : dom->GetDomTree()) {
+    BasicBlock* bb = node.bb_;
+    const std::vector<uint32_t>& preds = cfg->preds(bb->id());
+    std::map<uint32_t, MemoryAccess*> current;
+    if (bb == &*f->begin()) {
+      current = entry_state;
+    } else if (preds.size() == 1) {
+      current = exit_states[preds[0]];
+    } else {
+      for (uint32_t partition : partitions_) {
+        MemoryAccess* phi =
+            NewAccess(MemoryAccess::Kind::kPhi, partition, nullptr, bb, 0);
+        phis_[{bb->id(), partition}] = phi;
+        current[partition] = phi;
+      }
+      join_blocks.push_back(bb);
+    }
+    bb->ForEachInst(
+        [this, bb, &current](Instruction* inst) {
+          AddAccesses(inst, bb, &current);
+        },
+        false);
+    exit_states[bb->id()] = std::move(current);
+  }
+
+  for (BasicBlock* bb : join_blocks) {
+    for (uint32_t pred : cfg->preds(bb->id())) {
+      auto exit_state = exit_states.find(pred);
+      if (exit_state == exit_states.end()) continue;
+      for (uint32_t partition : partitions_) {
+        phis_[{bb->id(), partition}]->incoming_.push_back(
+            exit_state->second[partition]);
+      }
+    }
+  }
+
+  RemoveTrivialPhis();
+
+  for (auto& access : accesses_) {
+    if (access->defining_access_ != nullptr) {
+      access->defining_access_->users_.push_back(access.get());
+    }
+    for (MemoryAccess* incoming : access->incoming_) {
+      auto& users = incoming->users_;
+      if (std::find(users.begin(), users.end(), access.get()) == users.end()) {
+        users.push_back(access.get());
+      }
+    }
+  }
+}
+
+void MemorySSA::RemoveTrivialPhis() {
+  // Record the phis using each access, so that replacing a phi can revisit the
+  // phis that merged it.
+  std::unordered_map<MemoryAccess*, std::vector<MemoryAccess*>> phi_users;
+  for (const auto& entry : phis_) {
+    for (MemoryAccess* incoming : entry.second->incoming_) {
+      phi_users[incoming].push_back(entry.second);
+    }
+  }
+
+  std::unordered_map<MemoryAccess*, MemoryAccess*> replacements;
+  std::vector<MemoryAccess*> worklist;
+  for (const auto& entry : phis_) worklist.push_back(entry.second);
+  while (!worklist.empty()) {
+    MemoryAccess* phi = worklist.back();
+    worklist.pop_back();
+    if (replacements.count(phi)) continue;
+
+    // A phi is trivial if it merges a single version other than itself.
+    MemoryAccess* same = nullptr;
+    bool trivial = true;
+    for (MemoryAccess* incoming : phi->incoming_) {
+      if (incoming == phi || incoming == same) continue;
+      if (same != nullptr) {
+        trivial = false;
+        break;
+      }
+      same = incoming;
+    }
+    if (!trivial || same == nullptr) continue;
+
+    replacements[phi] = same;
+    const std::vector<MemoryAccess*> users = phi_users[phi];
+    for (MemoryAccess* user : users) {
+      if (user == phi || replacements.count(user)) continue;
+      std::replace(user->incoming_.begin(), user->incoming_.end(), phi, same);
+      phi_users[same].push_back(user);
+      worklist.push_back(user);
+    }
+    phis_.erase({phi->block()->id(), phi->partition()});
+  }
+  if (replacements.empty()) return;
+
+  // Follow chains of replaced phis to the version that replaces them all.
+  auto resolve = [&replacements](MemoryAccess* access) {
+    auto it = replacements.find(access);
+    while (it != replacements.end()) {
+      access = it->second;
+      it = replacements.find(access);
+    }
+    return access;
+  };
+  for (auto& access : accesses_) {
+    if (access->defining_access_ != nullptr) {
+      access->defining_access_ = resolve(access->defining_access_);
+    }
+    for (MemoryAccess*& incoming : access->incoming_) {
+      incoming = resolve(incoming);
+    }
+  }
+  accesses_.erase(
+      std::remove_if(accesses_.begin(), accesses_.end(),
+                     [&replacements](const std::unique_ptr<MemoryAccess>& a) {
+                       return replacements.count(a.get()) != 0;
+                     }),
+      accesses_.end());
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,212 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_MEMORY_SSA_H_
+#define SOURCE_OPT_MEMORY_SSA_H_
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/instruction.h"
+
+namespace spvtools {
+namespace opt {
+
+class IRContext;
+
+// A node of the memory SSA form of a function.
+//
+// The memory of a function is split in partitions, one per storage class.
+// Every instruction that may write the memory of a partition defines a new
+// version of that partition, and every instruction that reads it uses the
+// version reaching it.  Versions merging at a block are joined by a phi.
+class MemoryAccess {
+ public:
+  enum class Kind {
+    kLiveOnEntry,  // The memory on entry to the function.
+    kDef,          // An instruction that may write memory.
+    kUse,          // An instruction that reads memory, or a function exit.
+    kPhi,          // The merge of the versions reaching a block.
+  };
+
+  MemoryAccess(Kind kind, uint32_t partition, Instruction* inst,
+               BasicBlock* block, uint32_t pointer_id)
+      : kind_(kind),
+        partition_(partition),
+        inst_(inst),
+        block_(block),
+        pointer_id_(pointer_id),
+        defining_access_(nullptr) {}
+
+  Kind kind() const { return kind_; }
+  bool IsLiveOnEntry() const { return kind_ == Kind::kLiveOnEntry; }
+  bool IsDef() const { return kind_ == Kind::kDef; }
+  bool IsUse() const { return kind_ == Kind::kUse; }
+  bool IsPhi() const { return kind_ == Kind::kPhi; }
+
+  // Returns the storage class of the memory accessed.
+  uint32_t partition() const { return partition_; }
+
+  // Returns the instruction accessing memory.  It is nullptr for phis and for
+  // the live on entry access.
+  Instruction* instruction() const { return inst_; }
+
+  // Returns the block of the access.  It is nullptr for the live on entry
+  // access.
+  BasicBlock* block() const { return block_; }
+
+  // Returns the id of the pointer to the memory read or written by a plain
+  // load or store.  It is 0 when the access may touch any memory of the
+  // partition, such as for function calls, barriers, atomics, volatile
+  // accesses and function exits.
+  uint32_t pointer_id() const { return pointer_id_; }
+
+  // Returns the version of the memory that reaches this access.  It is nullptr
+  // for phis and for the live on entry access.
+  MemoryAccess* defining_access() const { return defining_access_; }
+
+  // Returns the versions merged by a phi, in the order of the predecessors of
+  // its block that are reachable from the entry block.
+  const std::vector<MemoryAccess*>& incoming() const { return incoming_; }
+
+  // Returns the accesses whose defining access, or one of whose incoming
+  // versions, is this access.
+  const std::vector<MemoryAccess*>& users() const { return users_; }
+
+ private:
+  friend class MemorySSA;
+
+  Kind kind_;
+  uint32_t partition_;
+  Instruction* inst_;
+  BasicBlock* block_;
+  uint32_t pointer_id_;
+  MemoryAccess* defining_access_;
+  std::vector<MemoryAccess*> incoming_;
+  std::vector<MemoryAccess*> users_;
+};
+
+// The memory SSA form of a function.
+//
+// Loads and stores are matched to the storage class of their pointer, and
+// the pointers of stores are compared using the alias analysis.
+// Barriers write the storage classes named by their memory semantics, or all
+// of the storage classes other than Function if the semantics name none.
+// Atomics write the memory they point to, and act as barriers unless their
+// semantics are relaxed.  Function calls write all memory.  Loads and stores
+// that are volatile, that make memory available or visible, or that access a
+// variable decorated Volatile or Coherent are treated as writing all of the
+// memory of their storage class.  Function exits read all memory.
+class MemorySSA {
+ public:
+  MemorySSA(IRContext* context, Function* f);
+
+  MemorySSA(const MemorySSA&) = delete;
+  MemorySSA& operator=(const MemorySSA&) = delete;
+
+  // Returns the use of memory by the load |inst|, or nullptr if |inst| is not
+  // a plain load.
+  MemoryAccess* GetUse(const Instruction* inst) const;
+
+  // Returns the versions of memory defined by |inst|, one per partition it
+  // writes.
+  std::vector<MemoryAccess*> GetDefs(const Instruction* inst) const;
+
+  // Returns all of the accesses of |inst|.
+  const std::vector<MemoryAccess*>& GetAccesses(const Instruction* inst) const;
+
+  // Returns the phi of |partition| at the start of |bb|, or nullptr if there
+  // is none.
+  MemoryAccess* GetPhi(const BasicBlock* bb, uint32_t partition) const;
+
+  // Returns the version of |partition| on entry to the function, or nullptr if
+  // the function does not access |partition|.
+  MemoryAccess* GetLiveOnEntry(uint32_t partition) const;
+
+  // Returns the nearest version reaching |access| that may have written the
+  // memory it reads.  Stores that are known not to alias the pointer of
+  // |access| are skipped.  The walk stops at phis.
+  MemoryAccess* GetClobberingAccess(const MemoryAccess* access) const;
+
+ private:
+  // Creates a new access owned by this object.
+  MemoryAccess* NewAccess(MemoryAccess::Kind kind, uint32_t partition,
+                          Instruction* inst, BasicBlock* block,
+                          uint32_t pointer_id);
+
+  // Adds to |partitions_| the storage classes accessed by |f|.
+  void CollectPartitions(Function* f);
+
+  // Creates the accesses of |inst| in |bb|, and updates |current| with the
+  // versions it defines.
+  void AddAccesses(Instruction* inst, BasicBlock* bb,
+                   std::map<uint32_t, MemoryAccess*>* current);
+
+  // Adds to |partitions| the storage classes ordered by the memory semantics
+  // |semantics_id|.
+  void GetBarrierPartitions(uint32_t semantics_id,
+                            std::vector<uint32_t>* partitions) const;
+
+  // Returns true if the access to |pointer_id| with the memory access mask
+  // |mask| cannot be treated as a plain read or write.
+  bool IsSynchronizedAccess(uint32_t pointer_id, uint32_t mask) const;
+
+  // Builds the SSA form of the memory accesses of |f|.
+  void Build(Function* f);
+
+  // Replaces the phis that merge a single version by that version.
+  void RemoveTrivialPhis();
+
+  // Returns the partition of the memory pointed to by |pointer_id|.
+  uint32_t GetPartition(uint32_t pointer_id) const;
+
+  IRContext* context_;
+  std::vector<uint32_t> partitions_;
+  std::vector<std::unique_ptr<MemoryAccess>> accesses_;
+  std::unordered_map<const Instruction*, std::vector<MemoryAccess*>>
+      inst_accesses_;
+  std::map<std::pair<uint32_t, uint32_t>, MemoryAccess*> phis_;
+  std::map<uint32_t, MemoryAccess*> live_on_entry_;
+};
+
+// Computes the memory SSA form of the functions of a module on demand, and
+// caches the result.
+class MemorySSAAnalysis {
+  using MemorySSAMap =
+      std::unordered_map<const Function*, std::unique_ptr<MemorySSA>>;
+
+ public:
+  MemorySSAAnalysis(IRContext* context) : context_(context) {}
+
+  // Returns the memory SSA form of |f|, computing it if needed.
+  MemorySSA* Get(Function* f) {
+    std::unique_ptr<MemorySSA>& memory_ssa = analysis_cache_[f];
+    if (!memory_ssa) memory_ssa.reset(new MemorySSA(context_, f));
+    return memory_ssa.get();
+  }
+
+ private:
+  IRContext* context_;
+  MemorySSAMap analysis_cache_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_MEMORY_SSA_H_
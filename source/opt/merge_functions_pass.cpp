@@ -0,0 +1,184 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/merge_functions_pass.h"
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+#include "source/operand.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+
+// Tags written before each id of a signature, telling whether the id is
+// defined in the function or at module scope.
+const uint32_t kGlobalIdTag = 0;
+const uint32_t kLocalIdTag = 1;
+
+// Returns a hash of |words|.
+size_t HashWords(const std::vector<uint32_t>& words) {
+  size_t hash = words.size();
+  for (uint32_t word : words) {
+    hash ^= std::hash<uint32_t>()(word) + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+  }
+  return hash;
+}
+
+}  // anonymous namespace
+
+void MergeFunctionsPass::Initialize() {
+  externally_visible_.clear();
+  for (auto& e : get_module()->entry_points())
+    externally_visible_.insert(
+        e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+  for (auto& a : get_module()->annotations()) {
+    if (a.opcode() == SpvOpDecorate &&
+        a.GetSingleWordOperand(1) == SpvDecorationLinkageAttributes &&
+        a.GetSingleWordOperand(a.NumOperands() - 1) ==
+            SpvLinkageTypeExport) {
+      externally_visible_.insert(a.GetSingleWordOperand(0));
+    }
+  }
+}
+
+MergeFunctionsPass::Signature MergeFunctionsPass::GetSignature(
+    const Function* func) const {
+  Signature sig;
+
+  // Number the ids defined in the function first, since an OpPhi may use an
+  // id defined later.
+  std::unordered_map<uint32_t, uint32_t> local_numbers;
+  func->ForEachInst([&sig, &local_numbers](const Instruction* inst) {
+    if (inst->result_id() == 0) return;
+    local_numbers[inst->result_id()] =
+        static_cast<uint32_t>(sig.local_ids.size());
+    sig.local_ids.push_back(inst->result_id());
+  });
+
+  func->ForEachInst([&sig, &local_numbers](const Instruction* inst) {
+    sig.words.push_back(inst->opcode());
+    sig.words.push_back(inst->NumOperands());
+    for (uint32_t i = 0; i < inst->NumOperands(); ++i) {
+      const Operand& operand = inst->GetOperand(i);
+      if (!spvIsIdType(operand.type)) {
+        sig.words.push_back(static_cast<uint32_t>(operand.words.size()));
+        sig.words.insert(sig.words.end(), operand.words.begin(),
+                         operand.words.end());
+        continue;
+      }
+      const uint32_t id = operand.words[0];
+      const auto it = local_numbers.find(id);
+      if (it != local_numbers.end()) {
+        sig.words.push_back(kLocalIdTag);
+        sig.words.push_back(it->second);
+      } else {
+        sig.words.push_back(kGlobalIdTag);
+        sig.words.push_back(id);
+      }
+    }
+  });
+  return sig;
+}
+
+bool MergeFunctionsPass::AreFunctionsEqual(const Signature& sig1,
+                                           const Signature& sig2) const {
+  if (sig1.words != sig2.words) return false;
+  // The first local id is the function itself.  Its only decorations are
+  // the linkage attributes, which do not change what the function computes,
+  // so it is skipped.
+  for (size_t i = 1; i < sig1.local_ids.size(); ++i) {
+    if (!context()->get_decoration_mgr()->HaveTheSameDecorations(
+            sig1.local_ids[i], sig2.local_ids[i]))
+      return false;
+  }
+  return true;
+}
+
+void MergeFunctionsPass::ReplaceFunction(Function* func,
+                                         Function* replacement) {
+  const uint32_t func_id = func->result_id();
+  context()->KillNamesAndDecorates(func_id);
+  context()->ReplaceAllUsesWith(func_id, replacement->result_id());
+  func->ForEachInst([this](Instruction* inst) { context()->KillInst(inst); },
+                    true);
+  for (auto it = get_module()->begin(); it != get_module()->end(); ++it) {
+    if (&*it == func) {
+      it.Erase();
+      break;
+    }
+  }
+}
+
+bool MergeFunctionsPass::MergeIdenticalFunctions() {
+  // The functions that are kept, with their signatures, by hash.
+  using Candidate = std::pair<Function*, Signature>;
+  std::unordered_map<size_t, std::vector<Candidate>> kept;
+  // The functions to remove, with the function that replaces them.
+  std::vector<std::pair<Function*, Function*>> replacements;
+
+  for (auto& func : *get_module()) {
+    // Function declarations have no body to compare.
+    if (func.begin() == func.end()) continue;
+    Signature sig = GetSignature(&func);
+    std::vector<Candidate>& bucket = kept[HashWords(sig.words)];
+
+    bool merged = false;
+    for (Candidate& candidate : bucket) {
+      if (!AreFunctionsEqual(candidate.second, sig)) continue;
+      // A function that is visible outside of the module cannot be removed,
+      // but it can replace the copies that are not.
+      if (!IsExternallyVisible(&func)) {
+        replacements.emplace_back(&func, candidate.first);
+        merged = true;
+      } else if (!IsExternallyVisible(candidate.first)) {
+        replacements.emplace_back(candidate.first, &func);
+        candidate = Candidate(&func, std::move(sig));
+        merged = true;
+      }
+      break;
+    }
+    if (!merged) bucket.emplace_back(&func, std::move(sig));
+  }
+
+  // Resolve the chains of replacements, where a function replaced earlier
+  // was itself replaced by a visible copy found later.
+  std::unordered_map<Function*, Function*> replaced_by;
+  for (const auto& r : replacements) replaced_by[r.first] = r.second;
+  for (const auto& r : replacements) {
+    Function* replacement = r.second;
+    while (replaced_by.count(replacement))
+      replacement = replaced_by[replacement];
+    ReplaceFunction(r.first, replacement);
+  }
+  return !replacements.empty();
+}
+
+Pass::Status MergeFunctionsPass::Process() {
+  Initialize();
+
+  // Merging callees can make their callers identical, so repeat until no
+  // more functions are merged.
+  bool modified = false;
+  while (MergeIdenticalFunctions()) modified = true;
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,78 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_MERGE_FUNCTIONS_PASS_H_
+#define SOURCE_OPT_MERGE_FUNCTIONS_PASS_H_
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class MergeFunctionsPass : public Pass {
+ public:
+  MergeFunctionsPass() = default;
+
+  const char* name() const override { return "merge-functions"; }
+  Status Process() override;
+
+ private:
+  // The instructions of a function, with the ids it defines replaced by their
+  // position in the function, so that functions that differ only by their
+  // ids have the same signature.
+  struct Signature {
+    // The words of the instructions.
+    std::vector<uint32_t> words;
+    // The ids defined by the function, in the order of their definition.
+    std::vector<uint32_t> local_ids;
+  };
+
+  // Initializes the pass.
+  void Initialize();
+
+  // Merges the functions of the module that are identical.  Returns true if
+  // any function was removed.
+  bool MergeIdenticalFunctions();
+
+  // Returns the signature of |func|.
+  Signature GetSignature(const Function* func) const;
+
+  // Returns true if the functions with signatures |sig1| and |sig2| are
+  // identical: same instructions and same decorations on the ids they define.
+  bool AreFunctionsEqual(const Signature& sig1, const Signature& sig2) const;
+
+  // Replaces the calls to |func| by calls to |replacement|, and removes
+  // |func| from the module.
+  void ReplaceFunction(Function* func, Function* replacement);
+
+  // Returns true if |func| can be called from outside the module.
+  bool IsExternallyVisible(const Function* func) const {
+    return externally_visible_.count(func->result_id()) != 0;
+  }
+
+  // The ids of the functions that can be called from outside the module.
+  std::unordered_set<uint32_t> externally_visible_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_MERGE_FUNCTIONS_PASS_H_
@@ -15,20 +15,76 @@
 #include "spirv-tools/optimizer.hpp"
 
 #include <memory>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <source/spirv_optimizer_options.h>
+#include "source/module_index.h"
 #include "source/opt/build_module.h"
 #include "source/opt/log.h"
 #include "source/opt/pass_manager.h"
 #include "source/opt/passes.h"
+#include "source/table.h"
 #include "source/util/make_unique.h"
 #include "source/util/string_utils.h"
+#include "source/val/validate.h"
+#include "source/val/validation_state.h"
 
 namespace spvtools {
+namespace {
+
+// Validates the module in |binary| using |options|.  Returns an index of the
+// module if it is valid, and otherwise reports the error to |consumer| and
+// returns nullptr.
+std::unique_ptr<ModuleIndex> ValidateAndIndexModule(
+    spv_target_env env, const MessageConsumer& consumer,
+    const uint32_t* binary, size_t size, spv_const_validator_options options) {
+  spv_context context = spvContextCreate(env);
+  SetContextMessageConsumer(context, consumer);
+
+  spv_diagnostic diagnostic = nullptr;
+  std::unique_ptr<val::ValidationState_t> vstate;
+  std::unique_ptr<ModuleIndex> index;
+  if (val::ValidateBinaryAndKeepValidationState(context, options, binary, size,
+                                                &diagnostic, &vstate) ==
+      SPV_SUCCESS) {
+    index = MakeUnique<ModuleIndex>(*vstate);
+  } else if (consumer && diagnostic) {
+    consumer(SPV_MSG_ERROR, nullptr, diagnostic->position, diagnostic->error);
+  } else if (consumer) {
+    consumer(SPV_MSG_ERROR, nullptr, {}, "Module failed validation.");
+  }
+
+  spvDiagnosticDestroy(diagnostic);
+  spvContextDestroy(context);
+  return index;
+}
+
+// Gives the counts of |profile| to the blocks of the module of |context|.
+void ApplyProfile(const std::vector<ProfileBlockCount>& profile,
+                  opt::IRContext* context) {
+  std::unordered_map<uint32_t,
+                     std::unordered_map<uint32_t, opt::BasicBlock*>>
+      blocks;
+  for (auto& func : *context->module()) {
+    auto& func_blocks = blocks[func.result_id()];
+    for (auto& bb : func) func_blocks[bb.id()] = &bb;
+  }
+  for (const auto& entry : profile) {
+    const auto func_it = blocks.find(entry.function_id);
+    if (func_it == blocks.end()) continue;
+    const auto bb_it = func_it->second.find(entry.block_id);
+    if (bb_it == func_it->second.end()) continue;
+    opt::BasicBlock* bb = bb_it->second;
+    const uint64_t count = bb->HasProfileCount() ? bb->profile_count() : 0;
+    bb->SetProfileCount(count + entry.count);
+  }
+}
+
+}  // namespace
 
 struct Optimizer::PassToken::Impl {
   Impl(std::unique_ptr<opt::Pass> p) : pass(std::move(p)) {}
@@ -58,6 +114,9 @@ struct Optimizer::Impl {
 
   spv_target_env target_env;        // Target environment.
   opt::PassManager pass_manager;    // Internal implementation pass manager.
+
+  // Execution profile of the modules to optimize.
+  std::vector<ProfileBlockCount> profile;
 };
 
 Optimizer::Optimizer(spv_target_env env) : impl_(new Impl(env)) {}
@@ -165,6 +224,7 @@ Optimizer& Optimizer::RegisterPerformancePasses() {
       .RegisterPass(CreateLocalMultiStoreElimPass())
       .RegisterPass(CreateAggressiveDCEPass())
       .RegisterPass(CreateCCPPass())
+      .RegisterPass(CreateSwitchToTablePass())
       .RegisterPass(CreateAggressiveDCEPass())
       .RegisterPass(CreateRedundancyEliminationPass())
       .RegisterPass(CreateCombineAccessChainsPass())
@@ -181,6 +241,7 @@ Optimizer& Optimizer::RegisterPerformancePasses() {
       .RegisterPass(CreateRedundancyEliminationPass())
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateBlockMergePass())
+      .RegisterPass(CreateCodeSinkingPass())
       .RegisterPass(CreateSimplificationPass());
   // Currently exposing driver bugs resulting in crashes (#946)
   // .RegisterPass(CreateCommonUniformElimPass())
@@ -290,6 +351,16 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateInlineExhaustivePass());
   } else if (pass_name == "inline-entry-points-opaque") {
     RegisterPass(CreateInlineOpaquePass());
+  } else if (pass_name == "inline-heuristic") {
+    int size_budget = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 1024;
+    if (size_budget >= 0) {
+      RegisterPass(
+          CreateInlineHeuristicPass(static_cast<uint32_t>(size_budget)));
+    } else {
+      Error(consumer(), nullptr, {},
+            "--inline-heuristic must have a non-negative integer argument");
+      return false;
+    }
   } else if (pass_name == "combine-access-chains") {
     RegisterPass(CreateCombineAccessChainsPass());
   } else if (pass_name == "convert-local-access-chains") {
@@ -308,6 +379,8 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateLocalSingleStoreElimPass());
   } else if (pass_name == "merge-blocks") {
     RegisterPass(CreateBlockMergePass());
+  } else if (pass_name == "merge-functions") {
+    RegisterPass(CreateMergeFunctionsPass());
   } else if (pass_name == "merge-return") {
     RegisterPass(CreateMergeReturnPass());
   } else if (pass_name == "eliminate-dead-branches") {
@@ -348,6 +421,18 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     }
   } else if (pass_name == "strength-reduction") {
     RegisterPass(CreateStrengthReductionPass());
+  } else if (pass_name == "switch-to-table") {
+    RegisterPass(CreateSwitchToTablePass());
+  } else if (pass_name == "gvn-pre") {
+    int max_registers = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 64;
+    if (max_registers > 0) {
+      RegisterPass(CreatePartialRedundancyEliminationPass(
+          static_cast<size_t>(max_registers)));
+    } else {
+      Error(consumer(), nullptr, {},
+            "--gvn-pre must have a positive integer argument");
+      return false;
+    }
   } else if (pass_name == "unify-const") {
     RegisterPass(CreateUnifyConstantPass());
   } else if (pass_name == "flatten-decorations") {
@@ -356,10 +441,18 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateCompactIdsPass());
   } else if (pass_name == "cfg-cleanup") {
     RegisterPass(CreateCFGCleanupPass());
+  } else if (pass_name == "code-sink") {
+    RegisterPass(CreateCodeSinkingPass());
+  } else if (pass_name == "eliminate-redundant-loads") {
+    RegisterPass(CreateRedundantLoadElimPass());
+  } else if (pass_name == "eliminate-dead-stores") {
+    RegisterPass(CreateDeadStoreElimPass());
   } else if (pass_name == "local-redundancy-elimination") {
     RegisterPass(CreateLocalRedundancyEliminationPass());
   } else if (pass_name == "loop-invariant-code-motion") {
     RegisterPass(CreateLoopInvariantCodeMotionPass());
+  } else if (pass_name == "range-fold") {
+    RegisterPass(CreateRangeFoldPass());
   } else if (pass_name == "reduce-load-size") {
     RegisterPass(CreateReduceLoadSizePass());
   } else if (pass_name == "redundancy-elimination") {
@@ -378,8 +471,22 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateDeadBranchElimPass());
     RegisterPass(CreateBlockMergePass());
     RegisterPass(CreateAggressiveDCEPass());
+  } else if (pass_name == "inst-profile") {
+    if (pass_args.empty() || pass_args == "blocks") {
+      RegisterPass(CreateInstProfilePass(7, false));
+    } else if (pass_args == "edges") {
+      RegisterPass(CreateInstProfilePass(7, true));
+    } else {
+      Error(consumer(), nullptr, {},
+            "--inst-profile must have the argument blocks or edges");
+      return false;
+    }
   } else if (pass_name == "simplify-instructions") {
     RegisterPass(CreateSimplificationPass());
+  } else if (pass_name == "slp-vectorize") {
+    RegisterPass(CreateSLPVectorizerPass())
+        .RegisterPass(CreateVectorDCEPass())
+        .RegisterPass(CreateSimplificationPass());
   } else if (pass_name == "ssa-rewrite") {
     RegisterPass(CreateSSARewritePass());
   } else if (pass_name == "copy-propagate-arrays") {
@@ -412,6 +519,16 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateUpgradeMemoryModelPass());
   } else if (pass_name == "vector-dce") {
     RegisterPass(CreateVectorDCEPass());
+  } else if (pass_name == "loop-unroll-auto") {
+    int size_budget = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 1024;
+    if (size_budget > 0) {
+      RegisterPass(
+          CreateLoopUnrollAutoPass(static_cast<uint32_t>(size_budget)));
+    } else {
+      Error(consumer(), nullptr, {},
+            "--loop-unroll-auto must have a positive integer argument");
+      return false;
+    }
   } else if (pass_name == "loop-unroll-partial") {
     int factor = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 0;
     if (factor > 0) {
@@ -421,6 +538,17 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
             "--loop-unroll-partial must have a positive integer argument");
       return false;
     }
+  } else if (pass_name == "loop-interchange") {
+    RegisterPass(CreateLoopInterchangePass());
+  } else if (pass_name == "loop-tile") {
+    int tile_size = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : -1;
+    if (tile_size > 0) {
+      RegisterPass(CreateLoopTilePass(static_cast<uint32_t>(tile_size)));
+    } else {
+      Error(consumer(), nullptr, {},
+            "--loop-tile must have a positive integer argument");
+      return false;
+    }
   } else if (pass_name == "loop-peeling") {
     RegisterPass(CreateLoopPeelingPass());
   } else if (pass_name == "loop-peeling-threshold") {
@@ -434,6 +562,27 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     }
   } else if (pass_name == "ccp") {
     RegisterPass(CreateCCPPass());
+  } else if (pass_name == "ipcp") {
+    int size_budget = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 1024;
+    if (size_budget >= 0) {
+      RegisterPass(CreateIPCPPass(static_cast<uint32_t>(size_budget)))
+          .RegisterPass(CreateCCPPass())
+          .RegisterPass(CreateDeadBranchElimPass())
+          .RegisterPass(CreateEliminateDeadFunctionsPass());
+    } else {
+      Error(consumer(), nullptr, {},
+            "--ipcp must have a non-negative integer argument");
+      return false;
+    }
+  } else if (pass_name == "jump-thread") {
+    int size_budget = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 64;
+    if (size_budget >= 0) {
+      RegisterPass(CreateJumpThreadingPass(static_cast<uint32_t>(size_budget)));
+    } else {
+      Error(consumer(), nullptr, {},
+            "--jump-thread must have a non-negative integer argument");
+      return false;
+    }
   } else if (pass_name == "O") {
     RegisterPerformancePasses();
   } else if (pass_name == "Os") {
@@ -477,19 +626,23 @@ bool Optimizer::Run(const uint32_t* original_binary,
                     const size_t original_binary_size,
                     std::vector<uint32_t>* optimized_binary,
                     const spv_optimizer_options opt_options) const {
-  spvtools::SpirvTools tools(impl_->target_env);
-  tools.SetMessageConsumer(impl_->pass_manager.consumer());
-  if (opt_options->run_validator_ &&
-      !tools.Validate(original_binary, original_binary_size,
-                      &opt_options->val_options_)) {
-    return false;
+  std::unique_ptr<ModuleIndex> index;
+  if (opt_options->run_validator_) {
+    index = ValidateAndIndexModule(impl_->target_env, consumer(),
+                                   original_binary, original_binary_size,
+                                   &opt_options->val_options_);
+    if (index == nullptr) return false;
   }
 
   std::unique_ptr<opt::IRContext> context = BuildModule(
       impl_->target_env, consumer(), original_binary, original_binary_size);
   if (context == nullptr) return false;
 
+  // Reuse the def-use chains and dominators computed by the validator.
+  if (index != nullptr) context->BuildAnalysesFromModuleIndex(*index);
+
   context->set_max_id_bound(opt_options->max_id_bound_);
+  ApplyProfile(impl_->profile, context.get());
 
   auto status = impl_->pass_manager.Run(context.get());
   if (status == opt::Pass::Status::SuccessWithChange ||
@@ -513,6 +666,12 @@ Optimizer& Optimizer::SetTimeReport(std::ostream* out) {
   return *this;
 }
 
+Optimizer& Optimizer::SetProfile(
+    const std::vector<ProfileBlockCount>& profile) {
+  impl_->profile = profile;
+  return *this;
+}
+
 Optimizer::PassToken CreateNullPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::NullPass>());
 }
@@ -785,4 +944,141 @@ Optimizer::PassToken CreateInstBindlessCheckPass(uint32_t desc_set,
       MakeUnique<opt::InstBindlessCheckPass>(desc_set, shader_id));
 }
 
+Optimizer::PassToken CreateCodeSinkingPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::CodeSinkingPass>());
+}
+
+Optimizer::PassToken CreateRedundantLoadElimPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::RedundantLoadElimPass>());
+}
+
+Optimizer::PassToken CreateDeadStoreElimPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::DeadStoreElimPass>());
+}
+
+Optimizer::PassToken CreateRangeFoldPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::RangeFoldPass>());
+}
+
+Optimizer::PassToken CreateLoopUnrollAutoPass(uint32_t size_budget) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::LoopUnroller>(static_cast<size_t>(size_budget)));
+}
+
+Optimizer::PassToken CreateInlineHeuristicPass(uint32_t size_budget) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InlineHeuristicPass>(size_budget));
+}
+
+Optimizer::PassToken CreateIPCPPass(uint32_t size_budget) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::IPCPPass>(size_budget));
+}
+
+Optimizer::PassToken CreateMergeFunctionsPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::MergeFunctionsPass>());
+}
+
+Optimizer::PassToken CreateInstProfilePass(uint32_t desc_set,
+                                           bool count_edges) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InstProfilePass>(desc_set, count_edges));
+}
+
+uint32_t GetProfileCounterCount(spv_target_env env,
+                                const std::vector<uint32_t>& binary,
+                                bool count_edges) {
+  std::unique_ptr<opt::IRContext> context =
+      BuildModule(env, [](spv_message_level_t, const char*,
+                          const spv_position_t&, const char*) {},
+                  binary.data(), binary.size());
+  if (!context) return 0;
+  return opt::ProfileCounterLayout(context.get(), count_edges)
+      .counter_count();
+}
+
+bool GetProfileBlockCounts(spv_target_env env,
+                           const std::vector<uint32_t>& binary,
+                           bool count_edges, const uint32_t* counters,
+                           size_t counter_count,
+                           std::vector<ProfileBlockCount>* counts) {
+  std::unique_ptr<opt::IRContext> context =
+      BuildModule(env, [](spv_message_level_t, const char*,
+                          const spv_position_t&, const char*) {},
+                  binary.data(), binary.size());
+  if (!context) return false;
+  opt::ProfileCounterLayout layout(context.get(), count_edges);
+  if (layout.counter_count() != counter_count) return false;
+  counts->clear();
+  for (const auto& func : layout.functions()) {
+    std::vector<uint64_t> block_counts = layout.GetBlockCounts(func, counters);
+    for (size_t i = 0; i < block_counts.size(); ++i)
+      counts->push_back({func.function_id, func.block_ids[i], block_counts[i]});
+  }
+  return true;
+}
+
+std::string ProfileToText(const std::vector<ProfileBlockCount>& profile) {
+  std::ostringstream text;
+  for (const auto& entry : profile) {
+    text << entry.function_id << " " << entry.block_id << " " << entry.count
+         << "\n";
+  }
+  return text.str();
+}
+
+bool ParseProfileText(const std::string& text,
+                      std::vector<ProfileBlockCount>* profile) {
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    const size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') continue;
+    std::istringstream fields(line);
+    ProfileBlockCount entry;
+    std::string extra;
+    if (!(fields >> entry.function_id >> entry.block_id >> entry.count) ||
+        (fields >> extra))
+      return false;
+    profile->push_back(entry);
+  }
+  return true;
+}
+
+Optimizer::PassToken CreateSLPVectorizerPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::SLPVectorizerPass>());
+}
+
+Optimizer::PassToken CreateLoopInterchangePass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::LoopInterchangePass>());
+}
+
+Optimizer::PassToken CreateLoopTilePass(uint32_t tile_size) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::LoopInterchangePass>(tile_size));
+}
+
+Optimizer::PassToken CreateJumpThreadingPass(uint32_t size_budget) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::JumpThreadingPass>(size_budget));
+}
+
+Optimizer::PassToken CreateSwitchToTablePass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::SwitchToTablePass>());
+}
+
+Optimizer::PassToken CreatePartialRedundancyEliminationPass(
+    size_t max_registers) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::PartialRedundancyEliminationPass>(max_registers));
+}
+
 }  // namespace spvtools
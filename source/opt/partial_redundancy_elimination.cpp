@@ -0,0 +1,221 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/partial_redundancy_elimination.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// Returns true if the result of |opcode| depends on the control flow that
+// reaches it, through implicit derivatives, or if it reads an image.
+bool DependsOnPosition(SpvOp opcode) {
+  return (opcode >= SpvOpSampledImage && opcode <= SpvOpImageQuerySamples) ||
+         (opcode >= SpvOpDPdx && opcode <= SpvOpFwidthCoarse) ||
+         (opcode >= SpvOpImageSparseSampleImplicitLod &&
+          opcode <= SpvOpImageSparseRead);
+}
+
+}  // anonymous namespace
+
+Pass::Status PartialRedundancyEliminationPass::Process() {
+  bool modified = false;
+  ValueNumberTable vn_table(context());
+  for (auto& func : *get_module()) {
+    modified |= EliminateRedundancies(&func, vn_table);
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+bool PartialRedundancyEliminationPass::IsCandidate(Instruction* inst) {
+  if (inst->result_id() == 0 || inst->type_id() == 0) return false;
+  switch (inst->opcode()) {
+    case SpvOpPhi:
+    case SpvOpLoad:
+    case SpvOpVariable:
+    case SpvOpUndef:
+    case SpvOpExtInst:
+      return false;
+    default:
+      break;
+  }
+  if (DependsOnPosition(inst->opcode()) ||
+      !context()->IsCombinatorInstruction(inst)) {
+    return false;
+  }
+  // Pointers cannot be selected by a phi in logical addressing.
+  return !context()->get_type_mgr()->GetType(inst->type_id())->AsPointer();
+}
+
+Instruction* PartialRedundancyEliminationPass::FindDominatingValue(
+    uint32_t value, Instruction* inst) {
+  for (Instruction* other : computations_[value]) {
+    if (other != inst && dom_->Dominates(other, inst)) return other;
+  }
+  return nullptr;
+}
+
+Instruction* PartialRedundancyEliminationPass::FindAvailableValue(
+    uint32_t value, BasicBlock* bb) {
+  for (Instruction* other : computations_[value]) {
+    if (dom_->Dominates(context()->get_instr_block(other), bb)) return other;
+  }
+  return nullptr;
+}
+
+bool PartialRedundancyEliminationPass::CanInsertAtEnd(BasicBlock* pred,
+                                                      BasicBlock* bb) {
+  // Every path from |pred| must reach |bb|, and |pred| must not be executed
+  // more often than |bb|, as it would be if it were in a loop that |bb| is
+  // not in.
+  return post_dom_->Dominates(bb, pred) &&
+         (*loop_desc_)[pred] == (*loop_desc_)[bb] &&
+         pred->GetLoopMergeInst() == nullptr;
+}
+
+bool PartialRedundancyEliminationPass::HasRegisterFor(BasicBlock* bb,
+                                                      Instruction* value) {
+  const RegisterLiveness::RegionRegisterLiveness* bb_liveness =
+      liveness_->Get(bb);
+  if (bb_liveness == nullptr) return false;
+  if (value != nullptr && bb_liveness->live_out_.count(value)) return true;
+  return bb_liveness->used_registers_ + added_live_out_[bb->id()] <
+         max_registers_;
+}
+
+Instruction* PartialRedundancyEliminationPass::InsertCopyAtEnd(
+    Instruction* inst, BasicBlock* bb) {
+  std::unique_ptr<Instruction> copy(inst->Clone(context()));
+  copy->SetResultId(TakeNextId());
+  Instruction* merge_inst = bb->GetMergeInst();
+  Instruction* insert_before =
+      merge_inst != nullptr ? merge_inst : bb->terminator();
+  Instruction* added = insert_before->InsertBefore(std::move(copy));
+  get_def_use_mgr()->AnalyzeInstDefUse(added);
+  context()->set_instr_block(added, bb);
+  return added;
+}
+
+bool PartialRedundancyEliminationPass::EliminatePartialRedundancy(
+    Instruction* inst, uint32_t value, BasicBlock* bb) {
+  // A phi in a loop header would select a value computed in the previous
+  // iteration.
+  const std::vector<uint32_t>& preds = cfg()->preds(bb->id());
+  if (preds.size() < 2 || bb->GetLoopMergeInst() != nullptr) return false;
+
+  // The operands must be available at the end of every predecessor.  Operands
+  // defined in |bb| would have to be translated through its phis.
+  bool operands_available = inst->WhileEachInId([this, bb](uint32_t* id) {
+    return context()->get_instr_block(*id) != bb;
+  });
+  if (!operands_available) return false;
+
+  // Find where the value is already computed, and check that it can be
+  // computed where it is not.
+  std::vector<Instruction*> incoming;
+  bool partially_available = false;
+  for (uint32_t pred_id : preds) {
+    BasicBlock* pred = cfg()->block(pred_id);
+    Instruction* available = FindAvailableValue(value, pred);
+    if (available != nullptr) {
+      if (!HasRegisterFor(pred, available)) return false;
+      partially_available = true;
+    } else if (!CanInsertAtEnd(pred, bb) || !HasRegisterFor(pred, nullptr)) {
+      return false;
+    }
+    incoming.push_back(available);
+  }
+  if (!partially_available) return false;
+
+  // A copy inserted in a predecessor may dominate another predecessor, which
+  // then needs no copy of its own.
+  std::vector<Operand> phi_operands;
+  for (size_t i = 0; i < preds.size(); ++i) {
+    BasicBlock* pred = cfg()->block(preds[i]);
+    Instruction* available = incoming[i];
+    if (available == nullptr) available = FindAvailableValue(value, pred);
+    if (available == nullptr) {
+      available = InsertCopyAtEnd(inst, pred);
+      computations_[value].push_back(available);
+    }
+    ++added_live_out_[preds[i]];
+    phi_operands.push_back({SPV_OPERAND_TYPE_ID, {available->result_id()}});
+    phi_operands.push_back({SPV_OPERAND_TYPE_ID, {preds[i]}});
+  }
+
+  std::unique_ptr<Instruction> phi(new Instruction(
+      context(), SpvOpPhi, inst->type_id(), TakeNextId(), phi_operands));
+  Instruction* added = bb->begin()->InsertBefore(std::move(phi));
+  get_def_use_mgr()->AnalyzeInstDefUse(added);
+  context()->set_instr_block(added, bb);
+  computations_[value].push_back(added);
+
+  context()->KillNamesAndDecorates(inst);
+  context()->ReplaceAllUsesWith(inst->result_id(), added->result_id());
+  return true;
+}
+
+bool PartialRedundancyEliminationPass::EliminateRedundancies(
+    Function* func, const ValueNumberTable& vn_table) {
+  if (func->begin() == func->end()) return false;
+
+  dom_ = context()->GetDominatorAnalysis(func);
+  post_dom_ = context()->GetPostDominatorAnalysis(func);
+  loop_desc_ = context()->GetLoopDescriptor(func);
+  liveness_ = context()->GetLivenessAnalysis()->Get(func);
+  computations_.clear();
+  added_live_out_.clear();
+
+  for (auto& bb : *func) {
+    for (auto& inst : bb) {
+      if (!IsCandidate(&inst)) continue;
+      uint32_t value = vn_table.GetValueNumber(&inst);
+      if (value != 0) computations_[value].push_back(&inst);
+    }
+  }
+
+  // Blocks are visited in dominator tree order, so that a value replaced by a
+  // phi can make the computations in the blocks it dominates fully redundant.
+  bool modified = false;
+  for (DominatorTreeNode& node : dom_->GetDomTree()) {
+    std::vector<Instruction*> insts;
+    for (auto& inst : *node.bb_) {
+      if (IsCandidate(&inst)) insts.push_back(&inst);
+    }
+    for (Instruction* inst : insts) {
+      uint32_t value = vn_table.GetValueNumber(inst);
+      if (value == 0) continue;
+
+      Instruction* leader = FindDominatingValue(value, inst);
+      if (leader != nullptr) {
+        context()->KillNamesAndDecorates(inst);
+        context()->ReplaceAllUsesWith(inst->result_id(), leader->result_id());
+      } else if (!EliminatePartialRedundancy(inst, value, node.bb_)) {
+        continue;
+      }
+      std::vector<Instruction*>& insts_of_value = computations_[value];
+      insts_of_value.erase(
+          std::find(insts_of_value.begin(), insts_of_value.end(), inst));
+      context()->KillInst(inst);
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+}  // namespace opt
+}  // namespace spvtools
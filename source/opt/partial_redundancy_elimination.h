@@ -0,0 +1,108 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_PARTIAL_REDUNDANCY_ELIMINATION_H_
+#define SOURCE_OPT_PARTIAL_REDUNDANCY_ELIMINATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/dominator_analysis.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
+#include "source/opt/pass.h"
+#include "source/opt/register_pressure.h"
+#include "source/opt/value_number_table.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class PartialRedundancyEliminationPass : public Pass {
+ public:
+  explicit PartialRedundancyEliminationPass(size_t max_registers = 64)
+      : max_registers_(max_registers) {}
+
+  const char* name() const override { return "gvn-pre"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // Removes the full and partial redundancies of |func|, whose instructions
+  // all have a value number in |vn_table|.  Returns true if |func| was
+  // modified.
+  bool EliminateRedundancies(Function* func, const ValueNumberTable& vn_table);
+
+  // Returns true if |inst| computes a value that only depends on its operands,
+  // and that can be computed on another path without side effects.
+  bool IsCandidate(Instruction* inst);
+
+  // Returns an instruction other than |inst| computing |value| that dominates
+  // |inst|, or nullptr if there is none.
+  Instruction* FindDominatingValue(uint32_t value, Instruction* inst);
+
+  // Returns an instruction computing |value| that is available at the end of
+  // |bb|, or nullptr if there is none.
+  Instruction* FindAvailableValue(uint32_t value, BasicBlock* bb);
+
+  // Replaces |inst|, which computes |value| in |bb|, by a phi of the values
+  // computed on each incoming edge, if it is already computed on at least one
+  // of them.  It is computed at the end of the predecessors where it is
+  // missing.  Returns true if |inst| was replaced.
+  bool EliminatePartialRedundancy(Instruction* inst, uint32_t value,
+                                  BasicBlock* bb);
+
+  // Returns true if a copy of an instruction of |bb| can be computed at the
+  // end of its predecessor |pred|, without computing it on a path that does
+  // not reach |bb|, or more often than |bb| is executed.
+  bool CanInsertAtEnd(BasicBlock* pred, BasicBlock* bb);
+
+  // Returns true if |value| is already live out of |bb|, or if making one more
+  // value live out of |bb| keeps the register pressure in |bb| under
+  // |max_registers_|.  |value| may be null for a value not computed yet.
+  bool HasRegisterFor(BasicBlock* bb, Instruction* value);
+
+  // Inserts a copy of |inst| at the end of |bb|, before its merge instruction
+  // if it has one, and returns it.
+  Instruction* InsertCopyAtEnd(Instruction* inst, BasicBlock* bb);
+
+  // The most registers a block may need after values are made live out of it.
+  size_t max_registers_;
+
+  // The analyses of the function being processed.
+  DominatorAnalysis* dom_;
+  PostDominatorAnalysis* post_dom_;
+  LoopDescriptor* loop_desc_;
+  const RegisterLiveness* liveness_;
+
+  // The instructions computing each value number in the function being
+  // processed, and the number of values made live out of each block.
+  std::unordered_map<uint32_t, std::vector<Instruction*>> computations_;
+  std::unordered_map<uint32_t, size_t> added_live_out_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_PARTIAL_REDUNDANCY_ELIMINATION_H_
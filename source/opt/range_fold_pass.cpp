@@ -0,0 +1,717 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/range_fold_pass.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "source/latest_version_glsl_std_450_header.h"
+#include "source/opcode.h"
+#include "source/opt/loop_descriptor.h"
+#include "source/opt/scalar_analysis.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+using Range = RangeFoldPass::Range;
+
+const int64_t kMinInt = std::numeric_limits<int32_t>::min();
+const int64_t kMaxInt = std::numeric_limits<int32_t>::max();
+const int64_t kTwoToThe32 = int64_t(1) << 32;
+const uint32_t kExtInstSetIdInIdx = 0;
+const uint32_t kExtInstInstructionInIdx = 1;
+const uint32_t kExtInstFirstOperandInIdx = 2;
+
+const Range kFullIntRange = {kMinInt, kMaxInt};
+const Range kUnknownBool = {0, 1};
+
+// Returns [lo, hi], or the full range if a value in it does not fit in 32
+// bits and the operation producing it would wrap.
+Range Checked(int64_t lo, int64_t hi) {
+  if (lo < kMinInt || hi > kMaxInt) return kFullIntRange;
+  return {lo, hi};
+}
+
+// Returns the range of the values of |r| interpreted as unsigned.
+Range ToUnsigned(const Range& r) {
+  if (r.lo >= 0) return r;
+  if (r.hi < 0) return {r.lo + kTwoToThe32, r.hi + kTwoToThe32};
+  return {0, kTwoToThe32 - 1};
+}
+
+// Returns the signed range of the unsigned values in |r|.
+Range FromUnsigned(const Range& r) {
+  if (r.hi <= kMaxInt) return r;
+  if (r.lo > kMaxInt) return {r.lo - kTwoToThe32, r.hi - kTwoToThe32};
+  return kFullIntRange;
+}
+
+Range Union(const Range& a, const Range& b) {
+  return {std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+}
+
+Range Min(const Range& a, const Range& b) {
+  return {std::min(a.lo, b.lo), std::min(a.hi, b.hi)};
+}
+
+Range Max(const Range& a, const Range& b) {
+  return {std::max(a.lo, b.lo), std::max(a.hi, b.hi)};
+}
+
+Range Not(const Range& r) { return {1 - r.hi, 1 - r.lo}; }
+
+// Returns the boolean range of |a| < |b|.
+Range LessThan(const Range& a, const Range& b) {
+  if (a.hi < b.lo) return {1, 1};
+  if (a.lo >= b.hi) return {0, 0};
+  return kUnknownBool;
+}
+
+// Returns the boolean range of |a| == |b|.
+Range Equal(const Range& a, const Range& b) {
+  if (a.IsSingleValue() && a == b) return {1, 1};
+  if (a.hi < b.lo || b.hi < a.lo) return {0, 0};
+  return kUnknownBool;
+}
+
+Range Multiply(const Range& a, const Range& b) {
+  int64_t products[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+  return Checked(*std::min_element(std::begin(products), std::end(products)),
+                 *std::max_element(std::begin(products), std::end(products)));
+}
+
+bool IsIntegerComparison(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpIEqual:
+    case SpvOpINotEqual:
+    case SpvOpSLessThan:
+    case SpvOpSGreaterThan:
+    case SpvOpSLessThanEqual:
+    case SpvOpSGreaterThanEqual:
+    case SpvOpULessThan:
+    case SpvOpUGreaterThan:
+    case SpvOpULessThanEqual:
+    case SpvOpUGreaterThanEqual:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if |opcode| is a GLSL.std.450 integer abs, min, max or clamp.
+bool IsIntegerMinMax(uint32_t opcode) {
+  switch (opcode) {
+    case GLSLstd450SAbs:
+    case GLSLstd450SMin:
+    case GLSLstd450SMax:
+    case GLSLstd450SClamp:
+    case GLSLstd450UMin:
+    case GLSLstd450UMax:
+    case GLSLstd450UClamp:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Range Abs(const Range& r) {
+  if (r.lo >= 0) return r;
+  if (r.hi <= 0) return Checked(-r.hi, -r.lo);
+  return Checked(0, std::max(-r.lo, r.hi));
+}
+
+}  // namespace
+
+bool RangeFoldPass::IsSupportedType(uint32_t type_id) const {
+  const analysis::Type* type = context()->get_type_mgr()->GetType(type_id);
+  if (type == nullptr) return false;
+  if (type->AsBool()) return true;
+  const analysis::Integer* int_type = type->AsInteger();
+  return int_type != nullptr && int_type->width() == 32;
+}
+
+Range RangeFoldPass::GetFullRange(uint32_t type_id) const {
+  if (context()->get_type_mgr()->GetType(type_id)->AsBool()) {
+    return kUnknownBool;
+  }
+  return kFullIntRange;
+}
+
+bool RangeFoldPass::GetRange(uint32_t id, Range* range, bool* is_final) const {
+  auto it = ranges_.find(id);
+  if (it == ranges_.end()) return false;
+  *range = it->second;
+
+  // Values outside of the function being processed never change.
+  Instruction* def = get_def_use_mgr()->GetDef(id);
+  if (context()->get_instr_block(def) != nullptr &&
+      (!propagator_->HasStatus(def) ||
+       propagator_->Status(def) != SSAPropagator::kVarying)) {
+    *is_final = false;
+  }
+  return true;
+}
+
+SSAPropagator::PropStatus RangeFoldPass::SetRange(Instruction* instr,
+                                                  const Range& range,
+                                                  bool is_final) {
+  auto it = ranges_.find(instr->result_id());
+  if (is_final) {
+    ranges_[instr->result_id()] = range;
+    return SSAPropagator::kVarying;
+  }
+  if (it == ranges_.end()) {
+    ranges_[instr->result_id()] = range;
+    return SSAPropagator::kInteresting;
+  }
+  if (it->second == range) return SSAPropagator::kInteresting;
+  it->second = GetFullRange(instr->type_id());
+  return SSAPropagator::kVarying;
+}
+
+bool RangeFoldPass::GetInductionRange(Instruction* phi, Range* range) {
+  BasicBlock* bb = context()->get_instr_block(phi);
+  Loop* loop = (*context()->GetLoopDescriptor(bb->GetParent()))[bb];
+  if (loop == nullptr || loop->GetHeaderBlock() != bb) return false;
+
+  // The exit condition must be tested in the header, so that the induction
+  // variables take one more value than the number of iterations.
+  BasicBlock* condition = loop->FindConditionBlock();
+  if (condition != bb) return false;
+  Instruction* induction = loop->FindConditionVariable(condition);
+  if (induction == nullptr) return false;
+  size_t iterations = 0;
+  if (!loop->FindNumberOfIterations(induction, &*condition->ctail(),
+                                    &iterations)) {
+    return false;
+  }
+  if (iterations > (size_t(1) << 30)) return false;
+
+  ScalarEvolutionAnalysis* scev = context()->GetScalarEvolutionAnalysis();
+  SENode* node = scev->SimplifyExpression(scev->AnalyzeInstruction(phi));
+  SERecurrentNode* recurrent = node->AsSERecurrentNode();
+  if (recurrent == nullptr || recurrent->GetLoop() != loop) return false;
+  SEConstantNode* offset = recurrent->GetOffset()->AsSEConstantNode();
+  SEConstantNode* coefficient =
+      recurrent->GetCoefficient()->AsSEConstantNode();
+  if (offset == nullptr || coefficient == nullptr) return false;
+
+  int64_t first = offset->FoldToSingleValue();
+  int64_t step = coefficient->FoldToSingleValue();
+  if (first < kMinInt || first >= kTwoToThe32 || step <= -kTwoToThe32 ||
+      step >= kTwoToThe32) {
+    return false;
+  }
+  int64_t last = first + step * static_cast<int64_t>(iterations);
+  *range = Checked(std::min(first, last), std::max(first, last));
+  return true;
+}
+
+bool RangeFoldPass::ComputeExtInstRange(Instruction* instr, Range* range,
+                                        bool* is_final) {
+  uint32_t opcode = instr->GetSingleWordInOperand(kExtInstInstructionInIdx);
+  if (glsl_std_450_id_ == 0 ||
+      instr->GetSingleWordInOperand(kExtInstSetIdInIdx) != glsl_std_450_id_ ||
+      !IsIntegerMinMax(opcode)) {
+    *range = GetFullRange(instr->type_id());
+    return true;
+  }
+
+  std::vector<Range> args;
+  for (uint32_t i = kExtInstFirstOperandInIdx; i < instr->NumInOperands();
+       ++i) {
+    Range arg;
+    if (!GetRange(instr->GetSingleWordInOperand(i), &arg, is_final)) {
+      return false;
+    }
+    args.push_back(arg);
+  }
+
+  switch (opcode) {
+    case GLSLstd450SAbs:
+      *range = Abs(args[0]);
+      break;
+    case GLSLstd450SMin:
+      *range = Min(args[0], args[1]);
+      break;
+    case GLSLstd450SMax:
+      *range = Max(args[0], args[1]);
+      break;
+    case GLSLstd450SClamp:
+      *range = Min(Max(args[0], args[1]), args[2]);
+      break;
+    case GLSLstd450UMin:
+      *range = FromUnsigned(Min(ToUnsigned(args[0]), ToUnsigned(args[1])));
+      break;
+    case GLSLstd450UMax:
+      *range = FromUnsigned(Max(ToUnsigned(args[0]), ToUnsigned(args[1])));
+      break;
+    case GLSLstd450UClamp:
+      *range = FromUnsigned(
+          Min(Max(ToUnsigned(args[0]), ToUnsigned(args[1])),
+              ToUnsigned(args[2])));
+      break;
+    default:
+      *range = GetFullRange(instr->type_id());
+      break;
+  }
+  return true;
+}
+
+bool RangeFoldPass::ComputeRange(Instruction* instr, Range* range,
+                                 bool* is_final) {
+  // Integer comparisons may have operands of a type that is not tracked.
+  if (IsIntegerComparison(instr->opcode()) &&
+      !IsSupportedType(get_def_use_mgr()
+                           ->GetDef(instr->GetSingleWordInOperand(0))
+                           ->type_id())) {
+    *range = GetFullRange(instr->type_id());
+    return true;
+  }
+
+  Range a = {0, 0};
+  Range b = {0, 0};
+  auto get_operands = [this, instr, is_final, &a, &b](uint32_t count) {
+    return GetRange(instr->GetSingleWordInOperand(0), &a, is_final) &&
+           (count < 2 ||
+            GetRange(instr->GetSingleWordInOperand(1), &b, is_final));
+  };
+
+  switch (instr->opcode()) {
+    case SpvOpCopyObject:
+      if (!get_operands(1)) return false;
+      *range = a;
+      return true;
+    case SpvOpBitcast:
+      if (!IsSupportedType(get_def_use_mgr()
+                               ->GetDef(instr->GetSingleWordInOperand(0))
+                               ->type_id())) {
+        break;
+      }
+      if (!get_operands(1)) return false;
+      *range = a;
+      return true;
+    case SpvOpIAdd:
+      if (!get_operands(2)) return false;
+      *range = Checked(a.lo + b.lo, a.hi + b.hi);
+      return true;
+    case SpvOpISub:
+      if (!get_operands(2)) return false;
+      *range = Checked(a.lo - b.hi, a.hi - b.lo);
+      return true;
+    case SpvOpIMul:
+      if (!get_operands(2)) return false;
+      *range = Multiply(a, b);
+      return true;
+    case SpvOpSNegate:
+      if (!get_operands(1)) return false;
+      *range = Checked(-a.hi, -a.lo);
+      return true;
+    case SpvOpUDiv: {
+      if (!get_operands(2)) return false;
+      Range ua = ToUnsigned(a);
+      Range ub = ToUnsigned(b);
+      if (ub.lo == 0) break;
+      *range = FromUnsigned({ua.lo / ub.hi, ua.hi / ub.lo});
+      return true;
+    }
+    case SpvOpUMod: {
+      if (!get_operands(2)) return false;
+      Range ua = ToUnsigned(a);
+      Range ub = ToUnsigned(b);
+      if (ub.lo == 0) break;
+      if (ua.hi < ub.lo) {
+        *range = a;
+      } else {
+        *range = FromUnsigned({0, std::min(ua.hi, ub.hi - 1)});
+      }
+      return true;
+    }
+    case SpvOpBitwiseAnd:
+      if (!get_operands(2)) return false;
+      *range = FromUnsigned(
+          {0, std::min(ToUnsigned(a).hi, ToUnsigned(b).hi)});
+      return true;
+    case SpvOpShiftRightLogical:
+    case SpvOpShiftRightArithmetic: {
+      if (!IsSupportedType(get_def_use_mgr()
+                               ->GetDef(instr->GetSingleWordInOperand(1))
+                               ->type_id())) {
+        break;
+      }
+      if (!get_operands(2)) return false;
+      Range shift = ToUnsigned(b);
+      if (!shift.IsSingleValue() || shift.lo >= 32) break;
+      if (instr->opcode() == SpvOpShiftRightLogical) {
+        Range ua = ToUnsigned(a);
+        *range = FromUnsigned({ua.lo >> shift.lo, ua.hi >> shift.lo});
+      } else {
+        *range = {a.lo >> shift.lo, a.hi >> shift.lo};
+      }
+      return true;
+    }
+    case SpvOpSelect: {
+      Range condition;
+      if (!GetRange(instr->GetSingleWordInOperand(0), &condition, is_final) ||
+          !GetRange(instr->GetSingleWordInOperand(1), &a, is_final) ||
+          !GetRange(instr->GetSingleWordInOperand(2), &b, is_final)) {
+        return false;
+      }
+      if (condition.IsSingleValue()) {
+        *range = condition.lo ? a : b;
+      } else {
+        *range = Union(a, b);
+      }
+      return true;
+    }
+    case SpvOpExtInst:
+      return ComputeExtInstRange(instr, range, is_final);
+    case SpvOpIEqual:
+      if (!get_operands(2)) return false;
+      *range = Equal(a, b);
+      return true;
+    case SpvOpINotEqual:
+      if (!get_operands(2)) return false;
+      *range = Not(Equal(a, b));
+      return true;
+    case SpvOpSLessThan:
+      if (!get_operands(2)) return false;
+      *range = LessThan(a, b);
+      return true;
+    case SpvOpSGreaterThan:
+      if (!get_operands(2)) return false;
+      *range = LessThan(b, a);
+      return true;
+    case SpvOpSLessThanEqual:
+      if (!get_operands(2)) return false;
+      *range = Not(LessThan(b, a));
+      return true;
+    case SpvOpSGreaterThanEqual:
+      if (!get_operands(2)) return false;
+      *range = Not(LessThan(a, b));
+      return true;
+    case SpvOpULessThan:
+      if (!get_operands(2)) return false;
+      *range = LessThan(ToUnsigned(a), ToUnsigned(b));
+      return true;
+    case SpvOpUGreaterThan:
+      if (!get_operands(2)) return false;
+      *range = LessThan(ToUnsigned(b), ToUnsigned(a));
+      return true;
+    case SpvOpULessThanEqual:
+      if (!get_operands(2)) return false;
+      *range = Not(LessThan(ToUnsigned(b), ToUnsigned(a)));
+      return true;
+    case SpvOpUGreaterThanEqual:
+      if (!get_operands(2)) return false;
+      *range = Not(LessThan(ToUnsigned(a), ToUnsigned(b)));
+      return true;
+    case SpvOpLogicalNot:
+      if (!get_operands(1)) return false;
+      *range = Not(a);
+      return true;
+    case SpvOpLogicalAnd:
+      if (!get_operands(2)) return false;
+      *range = Min(a, b);
+      return true;
+    case SpvOpLogicalOr:
+      if (!get_operands(2)) return false;
+      *range = Max(a, b);
+      return true;
+    case SpvOpLogicalEqual:
+      if (!get_operands(2)) return false;
+      *range = Equal(a, b);
+      return true;
+    case SpvOpLogicalNotEqual:
+      if (!get_operands(2)) return false;
+      *range = Not(Equal(a, b));
+      return true;
+    default:
+      break;
+  }
+  *range = GetFullRange(instr->type_id());
+  return true;
+}
+
+SSAPropagator::PropStatus RangeFoldPass::VisitPhi(Instruction* phi) {
+  if (!IsSupportedType(phi->type_id())) return SSAPropagator::kVarying;
+
+  Range range = {0, 0};
+  if (GetInductionRange(phi, &range)) return SetRange(phi, range, true);
+
+  bool has_range = false;
+  bool is_final = true;
+  for (uint32_t i = 2; i < phi->NumOperands(); i += 2) {
+    // Arguments on edges that are not executable yet may widen the range
+    // later.
+    Range arg;
+    if (!propagator_->IsPhiArgExecutable(phi, i) ||
+        !GetRange(phi->GetSingleWordOperand(i), &arg, &is_final)) {
+      is_final = false;
+      continue;
+    }
+    range = has_range ? Union(range, arg) : arg;
+    has_range = true;
+  }
+
+  if (!has_range) return SSAPropagator::kNotInteresting;
+  return SetRange(phi, range, is_final);
+}
+
+SSAPropagator::PropStatus RangeFoldPass::VisitAssignment(Instruction* instr) {
+  if (!IsSupportedType(instr->type_id())) return SSAPropagator::kVarying;
+
+  Range range;
+  bool is_final = true;
+  if (!ComputeRange(instr, &range, &is_final)) {
+    return SSAPropagator::kNotInteresting;
+  }
+  return SetRange(instr, range, is_final);
+}
+
+SSAPropagator::PropStatus RangeFoldPass::VisitBranch(
+    Instruction* instr, BasicBlock** dest_bb) const {
+  assert(instr->IsBranch() && "Expected a branch instruction.");
+
+  *dest_bb = nullptr;
+  uint32_t dest_label = 0;
+  bool is_final = true;
+  Range range;
+  if (instr->opcode() == SpvOpBranch) {
+    dest_label = instr->GetSingleWordInOperand(0);
+  } else if (instr->opcode() == SpvOpBranchConditional) {
+    if (!GetRange(instr->GetSingleWordInOperand(0), &range, &is_final) ||
+        !range.IsSingleValue()) {
+      return SSAPropagator::kVarying;
+    }
+    dest_label = instr->GetSingleWordInOperand(range.lo ? 1 : 2);
+  } else {
+    assert(instr->opcode() == SpvOpSwitch);
+    uint32_t selector_id = instr->GetSingleWordInOperand(0);
+    if (!IsSupportedType(get_def_use_mgr()->GetDef(selector_id)->type_id()) ||
+        !GetRange(selector_id, &range, &is_final) || !range.IsSingleValue()) {
+      return SSAPropagator::kVarying;
+    }
+
+    // Start assuming that the selector will take the default value.
+    dest_label = instr->GetSingleWordInOperand(1);
+    for (uint32_t i = 2; i < instr->NumInOperands(); i += 2) {
+      if (static_cast<uint32_t>(range.lo) ==
+          instr->GetSingleWordInOperand(i)) {
+        dest_label = instr->GetSingleWordInOperand(i + 1);
+        break;
+      }
+    }
+  }
+
+  *dest_bb = context()->cfg()->block(dest_label);
+  return SSAPropagator::kInteresting;
+}
+
+SSAPropagator::PropStatus RangeFoldPass::VisitInstruction(
+    Instruction* instr, BasicBlock** dest_bb) {
+  *dest_bb = nullptr;
+  if (instr->opcode() == SpvOpPhi) {
+    return VisitPhi(instr);
+  } else if (instr->IsBranch()) {
+    return VisitBranch(instr, dest_bb);
+  } else if (instr->result_id() && instr->type_id()) {
+    return VisitAssignment(instr);
+  }
+  return SSAPropagator::kVarying;
+}
+
+uint32_t RangeFoldPass::GetConstantId(uint32_t type_id, int64_t value) {
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  const analysis::Constant* constant =
+      const_mgr->GetConstant(context()->get_type_mgr()->GetType(type_id),
+                             {static_cast<uint32_t>(value)});
+  if (constant == nullptr) return 0;
+  Instruction* def = const_mgr->GetDefiningInstruction(constant, type_id);
+  if (def == nullptr) return 0;
+
+  // The instructions folded later may use the new constant.
+  ranges_[def->result_id()] = {value, value};
+  return def->result_id();
+}
+
+uint32_t RangeFoldPass::GetRedundantOperand(Instruction* inst) {
+  if (inst->opcode() == SpvOpSelect) {
+    Range condition;
+    bool is_final = true;
+    if (!GetRange(inst->GetSingleWordInOperand(0), &condition, &is_final) ||
+        !condition.IsSingleValue()) {
+      return 0;
+    }
+    return inst->GetSingleWordInOperand(condition.lo ? 1 : 2);
+  }
+  if (inst->opcode() == SpvOpExtInst &&
+      (inst->GetSingleWordInOperand(kExtInstSetIdInIdx) != glsl_std_450_id_ ||
+       !IsIntegerMinMax(
+           inst->GetSingleWordInOperand(kExtInstInstructionInIdx)))) {
+    return 0;
+  }
+  if (inst->opcode() != SpvOpUMod && inst->opcode() != SpvOpBitwiseAnd &&
+      inst->opcode() != SpvOpExtInst) {
+    return 0;
+  }
+
+  std::vector<Range> args;
+  uint32_t first = inst->opcode() == SpvOpExtInst ? kExtInstFirstOperandInIdx
+                                                   : 0;
+  for (uint32_t i = first; i < inst->NumInOperands(); ++i) {
+    Range arg;
+    bool is_final = true;
+    if (!GetRange(inst->GetSingleWordInOperand(i), &arg, &is_final)) {
+      return 0;
+    }
+    args.push_back(arg);
+  }
+  auto operand = [inst, first](uint32_t i) {
+    return inst->GetSingleWordInOperand(first + i);
+  };
+
+  switch (inst->opcode()) {
+    case SpvOpUMod:
+      return ToUnsigned(args[0]).hi < ToUnsigned(args[1]).lo ? operand(0) : 0;
+    case SpvOpBitwiseAnd:
+      // Masking with the low bits that are the only ones that can be set.
+      for (uint32_t i = 0; i < 2; ++i) {
+        const Range& mask = args[1 - i];
+        if (mask.IsSingleValue() && mask.lo >= 0 &&
+            ((mask.lo + 1) & mask.lo) == 0 &&
+            ToUnsigned(args[i]).hi <= mask.lo) {
+          return operand(i);
+        }
+      }
+      return 0;
+    case SpvOpExtInst:
+      break;
+    default:
+      return 0;
+  }
+
+  uint32_t opcode = inst->GetSingleWordInOperand(kExtInstInstructionInIdx);
+  bool is_unsigned = opcode == GLSLstd450UMin || opcode == GLSLstd450UMax ||
+                     opcode == GLSLstd450UClamp;
+  if (is_unsigned) {
+    for (Range& arg : args) arg = ToUnsigned(arg);
+  }
+  switch (opcode) {
+    case GLSLstd450SAbs:
+      return args[0].lo >= 0 ? operand(0) : 0;
+    case GLSLstd450SMin:
+    case GLSLstd450UMin:
+      if (args[0].hi <= args[1].lo) return operand(0);
+      if (args[1].hi <= args[0].lo) return operand(1);
+      return 0;
+    case GLSLstd450SMax:
+    case GLSLstd450UMax:
+      if (args[0].lo >= args[1].hi) return operand(0);
+      if (args[1].lo >= args[0].hi) return operand(1);
+      return 0;
+    case GLSLstd450SClamp:
+    case GLSLstd450UClamp:
+      if (args[0].lo >= args[1].hi && args[0].hi <= args[2].lo) {
+        return operand(0);
+      }
+      return 0;
+    default:
+      return 0;
+  }
+}
+
+uint32_t RangeFoldPass::GetReplacement(Instruction* inst) {
+  auto it = ranges_.find(inst->result_id());
+  if (it != ranges_.end() && it->second.IsSingleValue()) {
+    return GetConstantId(inst->type_id(), it->second.lo);
+  }
+  if (inst->opcode() == SpvOpSelect || IsSupportedType(inst->type_id())) {
+    return GetRedundantOperand(inst);
+  }
+  return 0;
+}
+
+bool RangeFoldPass::FoldRanges(Function* fp) {
+  // Function parameters can take any value.
+  fp->ForEachParam([this](const Instruction* inst) {
+    if (IsSupportedType(inst->type_id())) {
+      ranges_[inst->result_id()] = GetFullRange(inst->type_id());
+    }
+  });
+
+  const auto visit_fn = [this](Instruction* instr, BasicBlock** dest_bb) {
+    return VisitInstruction(instr, dest_bb);
+  };
+  propagator_ =
+      std::unique_ptr<SSAPropagator>(new SSAPropagator(context(), visit_fn));
+  propagator_->Run(fp);
+
+  bool modified = false;
+  for (BasicBlock& bb : *fp) {
+    for (Instruction& inst : bb) {
+      if (inst.result_id() == 0 || inst.type_id() == 0) continue;
+      uint32_t replacement = GetReplacement(&inst);
+      if (replacement != 0 && replacement != inst.result_id()) {
+        modified |= context()->ReplaceAllUsesWith(inst.result_id(),
+                                                  replacement);
+      }
+    }
+  }
+  return modified;
+}
+
+void RangeFoldPass::Initialize() {
+  glsl_std_450_id_ =
+      context()->get_feature_mgr()->GetExtInstImportId_GLSLstd450();
+
+  // Constants have a single value, and the other global values can take any
+  // value.
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  for (Instruction& inst : get_module()->types_values()) {
+    if (inst.result_id() == 0 || !IsSupportedType(inst.type_id())) continue;
+    Range range = GetFullRange(inst.type_id());
+    const analysis::Constant* constant =
+        inst.IsConstant() && !spvOpcodeIsSpecConstant(inst.opcode())
+            ? const_mgr->GetConstantFromInst(&inst)
+            : nullptr;
+    if (constant != nullptr) {
+      int64_t value = 0;
+      if (const analysis::BoolConstant* bool_constant =
+              constant->AsBoolConstant()) {
+        value = bool_constant->value() ? 1 : 0;
+      } else if (const analysis::IntConstant* int_constant =
+                     constant->AsIntConstant()) {
+        value = int_constant->GetS32BitValue();
+      }
+      range = {value, value};
+    }
+    ranges_[inst.result_id()] = range;
+  }
+}
+
+Pass::Status RangeFoldPass::Process() {
+  Initialize();
+
+  ProcessFunction pfn = [this](Function* fp) { return FoldRanges(fp); };
+  bool modified = context()->ProcessReachableCallTree(pfn);
+  return modified ? Pass::Status::SuccessWithChange
+                  : Pass::Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
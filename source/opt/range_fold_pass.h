@@ -0,0 +1,147 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_RANGE_FOLD_PASS_H_
+#define SOURCE_OPT_RANGE_FOLD_PASS_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+#include "source/opt/propagator.h"
+
+namespace spvtools {
+namespace opt {
+
+// Computes the range of values of the 32-bit integer and boolean scalars of
+// each function, and uses them to fold the comparisons whose result is known,
+// and the min, max, clamp, mask and select instructions that always return
+// one of their operands.
+//
+// The ranges are propagated with the SSA propagator, starting from constants
+// and from the induction variables of loops with a known trip count.  Branches
+// whose condition becomes constant are left to dead branch elimination.
+class RangeFoldPass : public Pass {
+ public:
+  // The closed interval [lo, hi] of the values of a 32-bit integer
+  // interpreted as signed, or of a boolean with false as 0 and true as 1.
+  struct Range {
+    int64_t lo;
+    int64_t hi;
+
+    bool IsSingleValue() const { return lo == hi; }
+    bool operator==(const Range& other) const {
+      return lo == other.lo && hi == other.hi;
+    }
+    bool operator!=(const Range& other) const { return !(*this == other); }
+  };
+
+  RangeFoldPass() = default;
+
+  const char* name() const override { return "range-fold"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // Initializes the pass.
+  void Initialize();
+
+  // Computes the ranges in |fp| and folds the instructions they make
+  // redundant.  Returns true if the IR was modified.
+  bool FoldRanges(Function* fp);
+
+  // Visits |instr| for the propagator.  If it is a conditional branch whose
+  // condition is known, sets |dest_bb| to the block it jumps to.
+  SSAPropagator::PropStatus VisitInstruction(Instruction* instr,
+                                             BasicBlock** dest_bb);
+
+  // Visits the OpPhi |phi|, whose range is the union of the ranges of its
+  // arguments on executable edges, or the range of the induction variable it
+  // defines.
+  SSAPropagator::PropStatus VisitPhi(Instruction* phi);
+
+  // Visits an instruction |instr| producing a value.
+  SSAPropagator::PropStatus VisitAssignment(Instruction* instr);
+
+  // Visits the branch |instr|, setting |dest_bb| as the CCP pass does.
+  SSAPropagator::PropStatus VisitBranch(Instruction* instr,
+                                        BasicBlock** dest_bb) const;
+
+  // Records |range| for the result of |instr|.  |is_final| is true if the
+  // range cannot change anymore.  A range that is not final is only ever
+  // replaced by a final one, since the propagator only revisits the users of
+  // an instruction whose status changes; if the new range is not final, the
+  // full range is recorded instead.
+  SSAPropagator::PropStatus SetRange(Instruction* instr, const Range& range,
+                                     bool is_final);
+
+  // Returns the range of values taken by the induction variable |phi| in the
+  // header of a loop with a known trip count, in |range|.  Returns false if
+  // |phi| is not such an induction variable.
+  bool GetInductionRange(Instruction* phi, Range* range);
+
+  // Computes in |range| the range of the result of |instr| from the ranges of
+  // its operands.  Returns false if the range of an operand is not known yet.
+  // |is_final| is set to false if the range of an operand may still change.
+  bool ComputeRange(Instruction* instr, Range* range, bool* is_final);
+
+  // Computes the range of the GLSL.std.450 extended instruction |instr|.
+  bool ComputeExtInstRange(Instruction* instr, Range* range, bool* is_final);
+
+  // Returns the range of |id| in |range|.  Returns false if it is not known
+  // yet.  |is_final| is set to false if it may still change.
+  bool GetRange(uint32_t id, Range* range, bool* is_final) const;
+
+  // Returns the range of all the values of the integer or boolean type
+  // |type_id|.
+  Range GetFullRange(uint32_t type_id) const;
+
+  // Returns true if ranges are tracked for values of type |type_id|.
+  bool IsSupportedType(uint32_t type_id) const;
+
+  // Returns the id that the result of |inst| can be replaced with, or 0.
+  uint32_t GetReplacement(Instruction* inst);
+
+  // Returns the operand of the min, max, clamp, mask or select |inst| that is
+  // always its result, or 0.
+  uint32_t GetRedundantOperand(Instruction* inst);
+
+  // Returns the id of the constant of type |type_id| with value |value|, or 0
+  // if it cannot be created.
+  uint32_t GetConstantId(uint32_t type_id, int64_t value);
+
+  // The id of the GLSL.std.450 import, or 0 if there is none.
+  uint32_t glsl_std_450_id_;
+
+  // The range of every value known so far.
+  std::unordered_map<uint32_t, Range> ranges_;
+
+  // Propagator engine used.
+  std::unique_ptr<SSAPropagator> propagator_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_RANGE_FOLD_PASS_H_
@@ -0,0 +1,89 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/redundant_load_elim_pass.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+const uint32_t kStoreValIdInIdx = 1;
+}  // namespace
+
+Pass::Status RedundantLoadElimPass::Process() {
+  bool modified = false;
+  for (Function& function : *get_module()) {
+    modified |= EliminateRedundantLoads(&function);
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+bool RedundantLoadElimPass::EliminateRedundantLoads(Function* function) {
+  if (function->begin() == function->end()) return false;
+
+  MemorySSA* memory_ssa = context()->GetMemorySSAAnalysis()->Get(function);
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(function);
+  ValueNumberTable* vn_table = context()->GetValueNumberTable();
+
+  // The loads that were kept, keyed by the version of memory they read and by
+  // the value number of their pointer.  Blocks are visited in dominator tree
+  // order, so a load that dominates another one is always seen first.
+  std::map<std::pair<const MemoryAccess*, uint32_t>, std::vector<Instruction*>>
+      available_loads;
+  std::vector<Instruction*> to_kill;
+  for (DominatorTreeNode& node : dom->GetDomTree()) {
+    for (Instruction& inst : *node.bb_) {
+      MemoryAccess* use = memory_ssa->GetUse(&inst);
+      if (use == nullptr) continue;
+
+      uint32_t replacement = 0;
+      MemoryAccess* clobber = memory_ssa->GetClobberingAccess(use);
+      uint32_t pointer_value = vn_table->GetValueNumber(use->pointer_id());
+      if (clobber->IsDef() && clobber->pointer_id() != 0 &&
+          context()->GetAliasAnalysis()->MustAlias(clobber->pointer_id(),
+                                                   use->pointer_id())) {
+        replacement =
+            clobber->instruction()->GetSingleWordInOperand(kStoreValIdInIdx);
+      } else if (pointer_value != 0) {
+        std::vector<Instruction*>& loads =
+            available_loads[{clobber, pointer_value}];
+        for (Instruction* load : loads) {
+          if (load->type_id() == inst.type_id() &&
+              dom->Dominates(load, &inst)) {
+            replacement = load->result_id();
+            break;
+          }
+        }
+        if (replacement == 0) loads.push_back(&inst);
+      }
+
+      if (replacement != 0) {
+        context()->ReplaceAllUsesWith(inst.result_id(), replacement);
+        to_kill.push_back(&inst);
+      }
+    }
+  }
+
+  for (Instruction* inst : to_kill) {
+    context()->KillInst(inst);
+  }
+  return !to_kill.empty();
+}
+
+}  // namespace opt
+}  // namespace spvtools
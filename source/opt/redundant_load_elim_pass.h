@@ -0,0 +1,53 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_REDUNDANT_LOAD_ELIM_PASS_H_
+#define SOURCE_OPT_REDUNDANT_LOAD_ELIM_PASS_H_
+
+#include "source/opt/ir_context.h"
+#include "source/opt/memory_ssa.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// This pass removes loads whose value is already known, in any storage class.
+// It uses the memory SSA form of each function to find, for each load, the
+// nearest instruction that may have written the memory it reads.  If that is a
+// store to the same address, the load is replaced by the stored value.
+// Otherwise, if a load of the same address reading the same version of memory
+// dominates it, the load is replaced by that load.
+class RedundantLoadElimPass : public Pass {
+ public:
+  const char* name() const override { return "eliminate-redundant-loads"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // Removes the redundant loads of |function|.  Returns true if the function
+  // was modified.
+  bool EliminateRedundantLoads(Function* function);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_REDUNDANT_LOAD_ELIM_PASS_H_
@@ -261,14 +261,9 @@ void RegisterLiveness::RegionRegisterLiveness::AddRegisterClass(
   analysis::Type* type =
       insn->context()->get_type_mgr()->GetType(insn->type_id());
 
-  RegisterLiveness::RegisterClass reg_class{type, false};
-
-  insn->context()->get_decoration_mgr()->WhileEachDecoration(
-      insn->result_id(), SpvDecorationUniform,
-      [&reg_class](const Instruction&) {
-        reg_class.is_uniform_ = true;
-        return false;
-      });
+  // Uniform values can be held in scalar registers.
+  RegisterLiveness::RegisterClass reg_class{
+      type, insn->context()->GetDivergenceAnalysis()->IsUniform(insn)};
 
   AddRegisterClass(reg_class);
 }
@@ -572,5 +567,26 @@ void RegisterLiveness::SimulateFission(
   }
 }
 
+void RegisterLiveness::SimulateUnroll(
+    const Loop& loop, size_t factor,
+    RegionRegisterLiveness* sim_result) const {
+  ComputeLoopRegisterPressure(loop, sim_result);
+
+  // The values live when entering the header and defined outside of the loop
+  // are only needed once, whatever the number of copies.
+  size_t shared_registers = 0;
+  for (Instruction* insn : sim_result->live_in_) {
+    BasicBlock* bb = context_->get_instr_block(insn);
+    if (bb == nullptr || !loop.IsInsideLoop(bb)) {
+      ++shared_registers;
+    }
+  }
+  shared_registers = std::min(shared_registers, sim_result->used_registers_);
+
+  sim_result->used_registers_ =
+      shared_registers +
+      factor * (sim_result->used_registers_ - shared_registers);
+}
+
 }  // namespace opt
 }  // namespace spvtools
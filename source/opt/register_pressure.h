@@ -153,6 +153,15 @@ class RegisterLiveness {
       RegionRegisterLiveness* loop1_sim_result,
       RegionRegisterLiveness* loop2_sim_result) const;
 
+  // Estimate the register pressure of |loop| after its body has been
+  // replicated |factor| times, assuming the copies of the body can be
+  // interleaved.  The values defined outside of |loop| are shared by all the
+  // copies while the values defined inside of |loop| are needed by each copy.
+  // The result is stored into |sim_result|, of which only the number of used
+  // registers is scaled.
+  void SimulateUnroll(const Loop& loop, size_t factor,
+                      RegionRegisterLiveness* sim_result) const;
+
  private:
   using RegionRegisterLivenessMap =
       std::unordered_map<uint32_t, RegionRegisterLiveness>;
@@ -0,0 +1,355 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/slp_vectorizer_pass.h"
+
+#include <memory>
+#include <utility>
+
+#include "source/opt/ir_builder.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kExtractCompositeIdInIdx = 0;
+const uint32_t kExtractFirstIndexInIdx = 1;
+
+// The maximum depth of the trees that are vectorized.
+const uint32_t kMaxTreeDepth = 8;
+
+// Returns true if |opcode| computes each component of a vector result from
+// the same component of its operands, with the result and the operands all
+// of the same type.
+bool IsVectorizableOpcode(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpFNegate:
+    case SpvOpSNegate:
+    case SpvOpNot:
+    case SpvOpFAdd:
+    case SpvOpFSub:
+    case SpvOpFMul:
+    case SpvOpFDiv:
+    case SpvOpFRem:
+    case SpvOpFMod:
+    case SpvOpIAdd:
+    case SpvOpISub:
+    case SpvOpIMul:
+    case SpvOpSDiv:
+    case SpvOpUDiv:
+    case SpvOpSRem:
+    case SpvOpSMod:
+    case SpvOpUMod:
+    case SpvOpBitwiseAnd:
+    case SpvOpBitwiseOr:
+    case SpvOpBitwiseXor:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if |user| only names or decorates the id it uses.
+bool IsNameOrDecoration(const Instruction* user) {
+  return user->IsDecoration() || user->opcode() == SpvOpName;
+}
+
+}  // anonymous namespace
+
+size_t SLPVectorizerPass::BuildNode(const std::vector<uint32_t>& lanes,
+                                    uint32_t depth) {
+  auto it = node_for_lanes_.find(lanes);
+  if (it != node_for_lanes_.end()) return it->second;
+
+  Node node;
+  node.lanes = lanes;
+  node.opcode = SpvOpNop;
+  if (IsConstantNode(node)) {
+    node.kind = Node::kConstant;
+  } else if (!BuildOperationNode(&node, depth) && !BuildExtractNode(&node)) {
+    node.kind = Node::kGather;
+  }
+
+  // The operands of the node were added before it.
+  nodes_.push_back(std::move(node));
+  node_for_lanes_[lanes] = nodes_.size() - 1;
+  return nodes_.size() - 1;
+}
+
+bool SLPVectorizerPass::BuildOperationNode(Node* node, uint32_t depth) {
+  if (depth >= kMaxTreeDepth) return false;
+  analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
+  BasicBlock* bb = context()->get_instr_block(root_);
+  std::unordered_set<uint32_t> seen;
+  Instruction* first = def_use_mgr->GetDef(node->lanes[0]);
+  for (uint32_t lane : node->lanes) {
+    // An instruction cannot compute two lanes.
+    if (!seen.insert(lane).second) return false;
+    Instruction* inst = def_use_mgr->GetDef(lane);
+    if (inst->opcode() != first->opcode() ||
+        !IsVectorizableOpcode(inst->opcode()) ||
+        context()->get_instr_block(inst) != bb ||
+        inst->type_id() != component_type_id_) {
+      return false;
+    }
+    for (uint32_t i = 0; i < inst->NumInOperands(); ++i) {
+      if (def_use_mgr->GetDef(inst->GetSingleWordInOperand(i))->type_id() !=
+          component_type_id_) {
+        return false;
+      }
+    }
+    // The vector instruction gets the decorations of the first lane.
+    if (!context()->get_decoration_mgr()->HaveTheSameDecorations(
+            first->result_id(), lane)) {
+      return false;
+    }
+  }
+
+  node->kind = Node::kOperation;
+  node->opcode = first->opcode();
+  for (uint32_t i = 0; i < first->NumInOperands(); ++i) {
+    std::vector<uint32_t> operand_lanes;
+    for (uint32_t lane : node->lanes) {
+      operand_lanes.push_back(
+          def_use_mgr->GetDef(lane)->GetSingleWordInOperand(i));
+    }
+    node->operands.push_back(BuildNode(operand_lanes, depth + 1));
+  }
+  return true;
+}
+
+bool SLPVectorizerPass::BuildExtractNode(Node* node) {
+  analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  std::vector<uint32_t> sources;
+  std::vector<uint32_t> source_sizes;
+  std::vector<uint32_t> components;
+  for (uint32_t lane : node->lanes) {
+    Instruction* inst = def_use_mgr->GetDef(lane);
+    if (inst->opcode() != SpvOpCompositeExtract ||
+        inst->NumInOperands() != kExtractFirstIndexInIdx + 1) {
+      return false;
+    }
+    const uint32_t source =
+        inst->GetSingleWordInOperand(kExtractCompositeIdInIdx);
+    const uint32_t index =
+        inst->GetSingleWordInOperand(kExtractFirstIndexInIdx);
+    size_t s = 0;
+    while (s < sources.size() && sources[s] != source) ++s;
+    if (s == sources.size()) {
+      if (sources.size() == 2) return false;
+      const analysis::Vector* source_type =
+          type_mgr->GetType(def_use_mgr->GetDef(source)->type_id())
+              ->AsVector();
+      if (source_type == nullptr ||
+          type_mgr->GetId(source_type->element_type()) != component_type_id_)
+        return false;
+      sources.push_back(source);
+      source_sizes.push_back(source_type->element_count());
+    }
+    components.push_back(s == 0 ? index : source_sizes[0] + index);
+  }
+
+  bool is_identity =
+      sources.size() == 1 &&
+      def_use_mgr->GetDef(sources[0])->type_id() == vector_type_id_;
+  for (uint32_t i = 0; i < components.size(); ++i) {
+    if (components[i] != i) is_identity = false;
+  }
+  if (sources.size() == 1) sources.push_back(sources[0]);
+  node->kind = is_identity ? Node::kVector : Node::kShuffle;
+  node->sources = std::move(sources);
+  node->components = std::move(components);
+  return true;
+}
+
+bool SLPVectorizerPass::IsConstantNode(const Node& node) const {
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  for (uint32_t lane : node.lanes) {
+    if (const_mgr->FindDeclaredConstant(lane) == nullptr) return false;
+  }
+  return true;
+}
+
+std::unordered_set<uint32_t> SLPVectorizerPass::GetDeadInstructions() {
+  std::vector<uint32_t> tree_ids;
+  for (const Node& node : nodes_) {
+    if (node.kind == Node::kOperation || node.kind == Node::kVector ||
+        node.kind == Node::kShuffle) {
+      tree_ids.insert(tree_ids.end(), node.lanes.begin(), node.lanes.end());
+    }
+  }
+
+  std::unordered_set<uint32_t> dead = {root_->result_id()};
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t id : tree_ids) {
+      if (dead.count(id)) continue;
+      if (get_def_use_mgr()->WhileEachUser(id, [&dead](Instruction* user) {
+            return IsNameOrDecoration(user) ||
+                   dead.count(user->result_id()) != 0;
+          })) {
+        dead.insert(id);
+        changed = true;
+      }
+    }
+  }
+  return dead;
+}
+
+int64_t SLPVectorizerPass::GetBenefit(uint32_t lane_count) {
+  // The root construct is part of the dead instructions.
+  int64_t benefit =
+      static_cast<int64_t>(GetDeadInstructions().size()) - 1 + lane_count;
+  for (const Node& node : nodes_) {
+    switch (node.kind) {
+      case Node::kOperation:
+      case Node::kShuffle:
+        --benefit;
+        break;
+      case Node::kGather: {
+        const std::unordered_set<uint32_t> distinct(node.lanes.begin(),
+                                                    node.lanes.end());
+        benefit -= distinct.size() == 1 ? 1 : lane_count;
+        break;
+      }
+      case Node::kVector:
+      case Node::kConstant:
+        break;
+    }
+  }
+  return benefit;
+}
+
+uint32_t SLPVectorizerPass::GenNode(size_t node_idx,
+                                    Instruction* insert_before) {
+  if (node_results_[node_idx] != 0) return node_results_[node_idx];
+  const Node& node = nodes_[node_idx];
+  InstructionBuilder builder(
+      context(), insert_before,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  uint32_t result = 0;
+  switch (node.kind) {
+    case Node::kOperation: {
+      std::vector<uint32_t> operands;
+      for (size_t operand : node.operands)
+        operands.push_back(GenNode(operand, insert_before));
+      Instruction* inst =
+          operands.size() == 1
+              ? builder.AddUnaryOp(vector_type_id_, node.opcode, operands[0])
+              : builder.AddBinaryOp(vector_type_id_, node.opcode,
+                                    operands[0], operands[1]);
+      result = inst->result_id();
+      context()->get_decoration_mgr()->CloneDecorations(node.lanes[0],
+                                                        result);
+      break;
+    }
+    case Node::kVector:
+      result = node.sources[0];
+      break;
+    case Node::kShuffle: {
+      std::vector<Operand> operands = {
+          {SPV_OPERAND_TYPE_ID, {node.sources[0]}},
+          {SPV_OPERAND_TYPE_ID, {node.sources[1]}}};
+      for (uint32_t component : node.components)
+        operands.push_back({SPV_OPERAND_TYPE_LITERAL_INTEGER, {component}});
+      std::unique_ptr<Instruction> shuffle(
+          new Instruction(context(), SpvOpVectorShuffle, vector_type_id_,
+                          TakeNextId(), operands));
+      result = builder.AddInstruction(std::move(shuffle))->result_id();
+      break;
+    }
+    case Node::kConstant: {
+      analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+      const analysis::Constant* constant = const_mgr->GetConstant(
+          context()->get_type_mgr()->GetType(vector_type_id_), node.lanes);
+      result = const_mgr->GetDefiningInstruction(constant, vector_type_id_)
+                   ->result_id();
+      break;
+    }
+    case Node::kGather:
+      result = builder.AddCompositeConstruct(vector_type_id_, node.lanes)
+                   ->result_id();
+      break;
+  }
+  node_results_[node_idx] = result;
+  return result;
+}
+
+bool SLPVectorizerPass::VectorizeTree(Instruction* root) {
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  const analysis::Vector* vector_type =
+      type_mgr->GetType(root->type_id())->AsVector();
+  if (vector_type == nullptr ||
+      root->NumInOperands() != vector_type->element_count()) {
+    return false;
+  }
+  vector_type_id_ = root->type_id();
+  component_type_id_ = type_mgr->GetId(vector_type->element_type());
+  root_ = root;
+
+  // Constructs that concatenate vectors are not trees of scalars.
+  std::vector<uint32_t> lanes;
+  for (uint32_t i = 0; i < root->NumInOperands(); ++i) {
+    const uint32_t lane = root->GetSingleWordInOperand(i);
+    if (get_def_use_mgr()->GetDef(lane)->type_id() != component_type_id_)
+      return false;
+    lanes.push_back(lane);
+  }
+
+  nodes_.clear();
+  node_for_lanes_.clear();
+  const size_t top = BuildNode(lanes, 0);
+  if (nodes_[top].kind == Node::kGather || nodes_[top].kind == Node::kConstant)
+    return false;
+  if (GetBenefit(vector_type->element_count()) <= 0) return false;
+
+  const std::unordered_set<uint32_t> dead = GetDeadInstructions();
+  node_results_.assign(nodes_.size(), 0);
+  const uint32_t result = GenNode(top, root);
+  context()->ReplaceAllUsesWith(root->result_id(), result);
+  for (uint32_t id : dead) context()->KillInst(get_def_use_mgr()->GetDef(id));
+  return true;
+}
+
+bool SLPVectorizerPass::VectorizeBlock(BasicBlock* bb) {
+  // The vectorized trees are rooted at the constructs of vectors from
+  // scalars.  Vectorizing a tree does not remove any other construct.
+  std::vector<uint32_t> roots;
+  for (auto& inst : *bb) {
+    if (inst.opcode() == SpvOpCompositeConstruct)
+      roots.push_back(inst.result_id());
+  }
+
+  bool modified = false;
+  for (uint32_t root_id : roots) {
+    Instruction* root = get_def_use_mgr()->GetDef(root_id);
+    if (root != nullptr && VectorizeTree(root)) modified = true;
+  }
+  return modified;
+}
+
+Pass::Status SLPVectorizerPass::Process() {
+  bool modified = false;
+  for (auto& func : *get_module()) {
+    for (auto& bb : func) {
+      if (VectorizeBlock(&bb)) modified = true;
+    }
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
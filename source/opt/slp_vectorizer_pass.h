@@ -0,0 +1,132 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_SLP_VECTORIZER_PASS_H_
+#define SOURCE_OPT_SLP_VECTORIZER_PASS_H_
+
+#include <cstdint>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class SLPVectorizerPass : public Pass {
+ public:
+  SLPVectorizerPass() = default;
+
+  const char* name() const override { return "slp-vectorize"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // A node of the tree of a vector built from scalars: the vector whose
+  // components are the scalar |lanes|, and how it is computed.
+  struct Node {
+    enum Kind {
+      // The same operation applied to the components of the |operands|.
+      kOperation,
+      // The lanes are the components of an existing vector, in order.
+      kVector,
+      // The lanes are components of at most two existing vectors.
+      kShuffle,
+      // The lanes are constants.
+      kConstant,
+      // The lanes are collected with an OpCompositeConstruct.
+      kGather
+    };
+
+    Kind kind;
+    std::vector<uint32_t> lanes;
+    // The opcode of a kOperation node.
+    SpvOp opcode;
+    // The operand nodes of a kOperation node.
+    std::vector<size_t> operands;
+    // The vectors the lanes of a kVector or kShuffle node are taken from,
+    // and, for a kShuffle node, the shuffle component of each lane.
+    std::vector<uint32_t> sources;
+    std::vector<uint32_t> components;
+  };
+
+  // Vectorizes the trees of isomorphic scalar instructions in |bb|.  Returns
+  // true if |bb| was modified.
+  bool VectorizeBlock(BasicBlock* bb);
+
+  // Builds the tree of the OpCompositeConstruct |root|, and replaces it by
+  // vector instructions if that is cheaper.  Returns true if |root| was
+  // replaced.
+  bool VectorizeTree(Instruction* root);
+
+  // Returns the index of the node computing a vector whose components are
+  // |lanes|, creating it and the nodes of its operands if needed.  |depth| is
+  // the depth of the node in the tree.
+  size_t BuildNode(const std::vector<uint32_t>& lanes, uint32_t depth);
+
+  // Sets |node| to an kOperation node if the instructions defining its lanes
+  // are the same vectorizable operation in the block of the tree.  Returns
+  // false if they are not.
+  bool BuildOperationNode(Node* node, uint32_t depth);
+
+  // Sets |node| to a kVector or kShuffle node if its lanes are extracted from
+  // at most two vectors.  Returns false if they are not.
+  bool BuildExtractNode(Node* node);
+
+  // Returns true if all the lanes of |node| are constants.
+  bool IsConstantNode(const Node& node) const;
+
+  // Returns the number of scalar instructions that the vector instructions
+  // replace, minus the number of instructions they add.  A construct or an
+  // extract counts once per component, so the root of the tree, and the
+  // gathers and shuffles it needs, are included.
+  int64_t GetBenefit(uint32_t lane_count);
+
+  // Returns the ids of the instructions of the tree which are dead once its
+  // root is replaced: their users are all dead instructions of the tree.
+  std::unordered_set<uint32_t> GetDeadInstructions();
+
+  // Generates before |insert_before| the vector instructions computing
+  // |node| and returns the id of the result.
+  uint32_t GenNode(size_t node, Instruction* insert_before);
+
+  // The id of the vector type and of the component type of the tree being
+  // built, and its root instruction.
+  uint32_t vector_type_id_;
+  uint32_t component_type_id_;
+  Instruction* root_;
+
+  // The nodes of the tree, and the node built for each list of lanes.
+  std::vector<Node> nodes_;
+  std::map<std::vector<uint32_t>, size_t> node_for_lanes_;
+
+  // The result of the code generated for each node.
+  std::vector<uint32_t> node_results_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_SLP_VECTORIZER_PASS_H_
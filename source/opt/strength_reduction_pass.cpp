@@ -16,7 +16,6 @@
 
 #include <algorithm>
 #include <cstdio>
-#include <cstring>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -31,7 +30,7 @@
 namespace {
 // Count the number of trailing zeros in the binary representation of
 // |constVal|.
-uint32_t CountTrailingZeros(uint32_t constVal) {
+uint32_t CountTrailingZeros(uint64_t constVal) {
   // Faster if we use the hardware count trailing zeros instruction.
   // If not available, we could create a table.
   uint32_t shiftAmount = 0;
@@ -43,7 +42,7 @@ uint32_t CountTrailingZeros(uint32_t constVal) {
 }
 
 // Return true if |val| is a power of 2.
-bool IsPowerOf2(uint32_t val) {
+bool IsPowerOf2(uint64_t val) {
   // The idea is that the & will clear out the least
   // significant 1 bit.  If it is a power of 2, then
   // there is exactly 1 bit set, and the value becomes 0.
@@ -51,19 +50,117 @@ bool IsPowerOf2(uint32_t val) {
   return ((val - 1) & val) == 0;
 }
 
+// Returns a mask of the low |width| bits.
+uint64_t LowBitsMask(uint32_t width) {
+  return width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+// Returns true if the |width|-bit value |val| is negative when interpreted as
+// a two's complement integer.
+bool IsNegative(uint64_t val, uint32_t width) {
+  return ((val >> (width - 1)) & 1) != 0;
+}
+
 }  // namespace
 
 namespace spvtools {
 namespace opt {
 
+DivisionMagic ComputeUnsignedDivisionMagic(uint64_t divisor, uint32_t width) {
+  assert(divisor > 1 && "Division by 0 or 1 does not need a multiplier.");
+  const uint64_t mask = LowBitsMask(width);
+  const uint64_t d = divisor & mask;
+  const uint64_t signed_min = uint64_t(1) << (width - 1);
+  const uint64_t signed_max = signed_min - 1;
+  DivisionMagic magic = {0, 0, false};
+
+  // Find the smallest power of 2, 2^p, for which the multiplier
+  // ceil(2^p / d) gives the exact quotient of all the |width|-bit dividends.
+  // The computation is done modulo 2^|width|, with q1 and r1 the quotient and
+  // remainder of 2^p by the largest dividend nc with nc % d == d - 1, and q2
+  // and r2 those of 2^p - 1 by d.  See Hacker's Delight, section 10-10.
+  const uint64_t nc = mask - (mask - d) % d;
+  uint32_t p = width - 1;
+  uint64_t q1 = signed_min / nc;
+  uint64_t r1 = signed_min - q1 * nc;
+  uint64_t q2 = signed_max / d;
+  uint64_t r2 = signed_max - q2 * d;
+  uint64_t delta = 0;
+  do {
+    ++p;
+    if (r1 >= nc - r1) {
+      q1 = (2 * q1 + 1) & mask;
+      r1 = (2 * r1 - nc) & mask;
+    } else {
+      q1 = (2 * q1) & mask;
+      r1 = (2 * r1) & mask;
+    }
+    if (r2 + 1 >= d - r2) {
+      if (q2 >= signed_max) magic.add = true;
+      q2 = (2 * q2 + 1) & mask;
+      r2 = (2 * r2 + 1 - d) & mask;
+    } else {
+      if (q2 >= signed_min) magic.add = true;
+      q2 = (2 * q2) & mask;
+      r2 = (2 * r2 + 1) & mask;
+    }
+    delta = d - 1 - r2;
+  } while (p < 2 * width && (q1 < delta || (q1 == delta && r1 == 0)));
+
+  magic.multiplier = (q2 + 1) & mask;
+  magic.shift = p - width;
+  return magic;
+}
+
+DivisionMagic ComputeSignedDivisionMagic(uint64_t divisor, uint32_t width) {
+  const uint64_t mask = LowBitsMask(width);
+  const uint64_t d = divisor & mask;
+  const uint64_t signed_min = uint64_t(1) << (width - 1);
+  const bool negative = IsNegative(d, width);
+  const uint64_t ad = negative ? (0 - d) & mask : d;
+  assert(ad > 1 && "Division by -1, 0 or 1 does not need a multiplier.");
+  DivisionMagic magic = {0, 0, false};
+
+  // Same as above with the absolute values of the divisor and of the largest
+  // dividend anc with anc % ad == ad - 1.  See Hacker's Delight, section 10-1.
+  const uint64_t t = signed_min + (negative ? 1 : 0);
+  const uint64_t anc = t - 1 - t % ad;
+  uint32_t p = width - 1;
+  uint64_t q1 = signed_min / anc;
+  uint64_t r1 = signed_min - q1 * anc;
+  uint64_t q2 = signed_min / ad;
+  uint64_t r2 = signed_min - q2 * ad;
+  uint64_t delta = 0;
+  do {
+    ++p;
+    q1 = (2 * q1) & mask;
+    r1 = (2 * r1) & mask;
+    if (r1 >= anc) {
+      ++q1;
+      r1 -= anc;
+    }
+    q2 = (2 * q2) & mask;
+    r2 = (2 * r2) & mask;
+    if (r2 >= ad) {
+      ++q2;
+      r2 -= ad;
+    }
+    delta = ad - r2;
+  } while (q1 < delta || (q1 == delta && r1 == 0));
+
+  magic.multiplier = (q2 + 1) & mask;
+  if (negative) magic.multiplier = (0 - magic.multiplier) & mask;
+  magic.shift = p - width;
+  return magic;
+}
+
 Pass::Status StrengthReductionPass::Process() {
   // Initialize the member variables on a per module basis.
   bool modified = false;
   int32_type_id_ = 0;
   uint32_type_id_ = 0;
-  std::memset(constant_ids_, 0, sizeof(constant_ids_));
 
-  FindIntTypesAndConstants();
+  FindIntTypes();
   modified = ScanFunctions();
   return (modified ? Status::SuccessWithChange : Status::SuccessWithoutChange);
 }
@@ -125,54 +222,238 @@ bool StrengthReductionPass::ReplaceMultiplyByPowerOf2(
   return modified;
 }
 
-void StrengthReductionPass::FindIntTypesAndConstants() {
-  analysis::Integer int32(32, true);
-  int32_type_id_ = context()->get_type_mgr()->GetId(&int32);
-  analysis::Integer uint32(32, false);
-  uint32_type_id_ = context()->get_type_mgr()->GetId(&uint32);
-  for (auto iter = get_module()->types_values_begin();
-       iter != get_module()->types_values_end(); ++iter) {
-    switch (iter->opcode()) {
-      case SpvOp::SpvOpConstant:
-        if (iter->type_id() == uint32_type_id_) {
-          uint32_t value = iter->GetSingleWordOperand(2);
-          if (value <= 32) constant_ids_[value] = iter->result_id();
-        }
-        break;
-      default:
-        break;
+bool StrengthReductionPass::ReplaceDivisionByConstant(
+    BasicBlock::iterator* inst) {
+  Instruction* div = &**inst;
+  const SpvOp opcode = div->opcode();
+  const uint32_t type_id = div->type_id();
+
+  // Only scalar 32-bit and 64-bit integers are handled.  A 64-bit type can
+  // only be present if the module declares the Int64 capability.
+  const analysis::Integer* int_type =
+      context()->get_type_mgr()->GetType(type_id)->AsInteger();
+  if (int_type == nullptr) return false;
+  const uint32_t width = int_type->width();
+  if (width != 32 && width != 64) return false;
+
+  const uint32_t dividend = div->GetSingleWordInOperand(0);
+  if (get_def_use_mgr()->GetDef(dividend)->type_id() != type_id) return false;
+  const analysis::Constant* divisor_const =
+      context()->get_constant_mgr()->FindDeclaredConstant(
+          div->GetSingleWordInOperand(1));
+  if (divisor_const == nullptr || divisor_const->AsIntConstant() == nullptr ||
+      divisor_const->type()->AsInteger()->width() != width) {
+    return false;
+  }
+  const uint64_t divisor =
+      width == 64 ? divisor_const->GetU64() : divisor_const->GetU32();
+
+  // The division by 0 is undefined, and the division by 1 or -1 is left to
+  // the folding rules.
+  const uint64_t mask = LowBitsMask(width);
+  const bool is_signed = opcode != SpvOpUDiv && opcode != SpvOpUMod;
+  if (divisor == 0 || divisor == 1 || (is_signed && divisor == mask)) {
+    return false;
+  }
+  const bool negative = is_signed && IsNegative(divisor, width);
+  const bool power_of_2 = IsPowerOf2(negative ? (0 - divisor) & mask : divisor);
+
+  // OpUMulExtended needs an unsigned result type.
+  if (!is_signed && !power_of_2 && int_type->IsSigned()) return false;
+
+  InstructionBuilder builder(
+      context(), div,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  uint32_t result = 0;
+  if (opcode == SpvOpUDiv && power_of_2) {
+    result = builder
+                 .AddBinaryOp(type_id, SpvOpShiftRightLogical, dividend,
+                              GetIntConstantId(type_id,
+                                               CountTrailingZeros(divisor)))
+                 ->result_id();
+  } else if (opcode == SpvOpUMod && power_of_2) {
+    result = builder
+                 .AddBinaryOp(type_id, SpvOpBitwiseAnd, dividend,
+                              GetIntConstantId(type_id, divisor - 1))
+                 ->result_id();
+  } else {
+    const uint32_t quotient =
+        is_signed ? BuildSignedDivision(&builder, type_id, width, dividend,
+                                        divisor)
+                  : BuildUnsignedDivision(&builder, type_id, width, dividend,
+                                          divisor);
+    result = quotient;
+    if (opcode != SpvOpUDiv && opcode != SpvOpSDiv) {
+      // The remainder is the dividend minus the product of the quotient and
+      // the divisor.
+      const uint32_t divisor_id = GetIntConstantId(type_id, divisor);
+      const uint32_t product =
+          builder.AddBinaryOp(type_id, SpvOpIMul, quotient, divisor_id)
+              ->result_id();
+      result = builder.AddBinaryOp(type_id, SpvOpISub, dividend, product)
+                   ->result_id();
+
+      if (opcode == SpvOpSMod) {
+        // The result of OpSMod has the sign of the divisor: add the divisor
+        // to a remainder of the other sign.
+        analysis::Bool bool_type;
+        const uint32_t bool_id =
+            context()->get_type_mgr()->GetTypeInstruction(&bool_type);
+        const uint32_t zero = GetIntConstantId(type_id, 0);
+        const uint32_t wrong_sign =
+            builder
+                .AddBinaryOp(bool_id,
+                             negative ? SpvOpSGreaterThan : SpvOpSLessThan,
+                             result, zero)
+                ->result_id();
+        const uint32_t adjusted =
+            builder.AddIAdd(type_id, result, divisor_id)->result_id();
+        result =
+            builder.AddSelect(type_id, wrong_sign, adjusted, result)
+                ->result_id();
+      }
     }
   }
+
+  // The last new instruction is just before |div|.
+  context()->ReplaceAllUsesWith(div->result_id(), result);
+  --(*inst);
+  context()->KillInst(div);
+  return true;
 }
 
-uint32_t StrengthReductionPass::GetConstantId(uint32_t val) {
-  assert(val <= 32 &&
-         "This function does not handle constants larger than 32.");
+uint32_t StrengthReductionPass::BuildUnsignedDivision(
+    InstructionBuilder* builder, uint32_t type_id, uint32_t width,
+    uint32_t dividend, uint64_t divisor) {
+  const DivisionMagic magic = ComputeUnsignedDivisionMagic(divisor, width);
+  const uint32_t high = BuildMultiplyHigh(
+      builder, SpvOpUMulExtended, type_id, dividend,
+      GetIntConstantId(type_id, magic.multiplier));
+  if (!magic.add) {
+    if (magic.shift == 0) return high;
+    return builder
+        ->AddBinaryOp(type_id, SpvOpShiftRightLogical, high,
+                      GetIntConstantId(type_id, magic.shift))
+        ->result_id();
+  }
 
-  if (constant_ids_[val] == 0) {
-    if (uint32_type_id_ == 0) {
-      analysis::Integer uint(32, false);
-      uint32_type_id_ = context()->get_type_mgr()->GetTypeInstruction(&uint);
+  // The multiplier has one more bit than the type, so the dividend has to be
+  // added to the high half of the product.  The sum is computed as
+  // ((dividend - high) / 2 + high) to avoid overflowing.
+  assert(magic.shift > 0);
+  uint32_t sum =
+      builder->AddBinaryOp(type_id, SpvOpISub, dividend, high)->result_id();
+  sum = builder
+            ->AddBinaryOp(type_id, SpvOpShiftRightLogical, sum,
+                          GetIntConstantId(type_id, 1))
+            ->result_id();
+  sum = builder->AddIAdd(type_id, sum, high)->result_id();
+  if (magic.shift == 1) return sum;
+  return builder
+      ->AddBinaryOp(type_id, SpvOpShiftRightLogical, sum,
+                    GetIntConstantId(type_id, magic.shift - 1))
+      ->result_id();
+}
+
+uint32_t StrengthReductionPass::BuildSignedDivision(
+    InstructionBuilder* builder, uint32_t type_id, uint32_t width,
+    uint32_t dividend, uint64_t divisor) {
+  const uint64_t mask = LowBitsMask(width);
+  const bool negative = IsNegative(divisor, width);
+  const uint64_t abs_divisor = negative ? (0 - divisor) & mask : divisor;
+
+  if (IsPowerOf2(abs_divisor)) {
+    // Add 2^k - 1 to a negative dividend before shifting it, so that the
+    // quotient is rounded toward 0.
+    const uint32_t k = CountTrailingZeros(abs_divisor);
+    uint32_t bias = dividend;
+    if (k > 1) {
+      bias = builder
+                 ->AddBinaryOp(type_id, SpvOpShiftRightArithmetic, dividend,
+                               GetIntConstantId(type_id, k - 1))
+                 ->result_id();
     }
+    bias = builder
+               ->AddBinaryOp(type_id, SpvOpShiftRightLogical, bias,
+                             GetIntConstantId(type_id, width - k))
+               ->result_id();
+    const uint32_t sum = builder->AddIAdd(type_id, dividend, bias)->result_id();
+    const uint32_t quotient =
+        builder
+            ->AddBinaryOp(type_id, SpvOpShiftRightArithmetic, sum,
+                          GetIntConstantId(type_id, k))
+            ->result_id();
+    if (!negative) return quotient;
+    return builder->AddUnaryOp(type_id, SpvOpSNegate, quotient)->result_id();
+  }
+
+  const DivisionMagic magic = ComputeSignedDivisionMagic(divisor, width);
+  uint32_t quotient = BuildMultiplyHigh(
+      builder, SpvOpSMulExtended, type_id, dividend,
+      GetIntConstantId(type_id, magic.multiplier));
+
+  // Correct the product when the multiplier overflowed into the sign bit.
+  const bool negative_multiplier = IsNegative(magic.multiplier, width);
+  if (!negative && negative_multiplier) {
+    quotient = builder->AddIAdd(type_id, quotient, dividend)->result_id();
+  } else if (negative && !negative_multiplier) {
+    quotient = builder->AddBinaryOp(type_id, SpvOpISub, quotient, dividend)
+                   ->result_id();
+  }
+  if (magic.shift > 0) {
+    quotient = builder
+                   ->AddBinaryOp(type_id, SpvOpShiftRightArithmetic, quotient,
+                                 GetIntConstantId(type_id, magic.shift))
+                   ->result_id();
+  }
+
+  // Add 1 to a negative quotient so that it is rounded toward 0.
+  const uint32_t sign =
+      builder
+          ->AddBinaryOp(type_id, SpvOpShiftRightLogical, quotient,
+                        GetIntConstantId(type_id, width - 1))
+          ->result_id();
+  return builder->AddIAdd(type_id, quotient, sign)->result_id();
+}
+
+uint32_t StrengthReductionPass::BuildMultiplyHigh(InstructionBuilder* builder,
+                                                  SpvOp opcode,
+                                                  uint32_t type_id, uint32_t a,
+                                                  uint32_t b) {
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  const analysis::Type* type = type_mgr->GetType(type_id);
+  analysis::Struct pair_type({type, type});
+  const uint32_t pair_type_id = type_mgr->GetTypeInstruction(&pair_type);
+  const uint32_t product =
+      builder->AddBinaryOp(pair_type_id, opcode, a, b)->result_id();
+  return builder->AddCompositeExtract(type_id, product, {1})->result_id();
+}
+
+void StrengthReductionPass::FindIntTypes() {
+  analysis::Integer int32(32, true);
+  int32_type_id_ = context()->get_type_mgr()->GetId(&int32);
+  analysis::Integer uint32(32, false);
+  uint32_type_id_ = context()->get_type_mgr()->GetId(&uint32);
+}
 
-    // Construct the constant.
-    uint32_t resultId = TakeNextId();
-    Operand constant(spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER,
-                     {val});
-    std::unique_ptr<Instruction> newConstant(
-        new Instruction(context(), SpvOp::SpvOpConstant, uint32_type_id_,
-                        resultId, {constant}));
-    get_module()->AddGlobalValue(std::move(newConstant));
-
-    // Notify the DefUseManager about this constant.
-    auto constantIter = --get_module()->types_values_end();
-    get_def_use_mgr()->AnalyzeInstDef(&*constantIter);
-
-    // Store the result id for next time.
-    constant_ids_[val] = resultId;
+uint32_t StrengthReductionPass::GetConstantId(uint32_t val) {
+  if (uint32_type_id_ == 0) {
+    analysis::Integer uint(32, false);
+    uint32_type_id_ = context()->get_type_mgr()->GetTypeInstruction(&uint);
   }
+  return GetIntConstantId(uint32_type_id_, val);
+}
 
-  return constant_ids_[val];
+uint32_t StrengthReductionPass::GetIntConstantId(uint32_t type_id,
+                                                 uint64_t value) {
+  // The constant manager reuses the constants already in the module.
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  const analysis::Integer* type =
+      context()->get_type_mgr()->GetType(type_id)->AsInteger();
+  std::vector<uint32_t> words = {static_cast<uint32_t>(value)};
+  if (type->width() == 64) words.push_back(static_cast<uint32_t>(value >> 32));
+  const analysis::Constant* constant = const_mgr->GetConstant(type, words);
+  return const_mgr->GetDefiningInstruction(constant, type_id)->result_id();
 }
 
 bool StrengthReductionPass::ScanFunctions() {
@@ -187,6 +468,13 @@ bool StrengthReductionPass::ScanFunctions() {
           case SpvOp::SpvOpIMul:
             if (ReplaceMultiplyByPowerOf2(&inst)) modified = true;
             break;
+          case SpvOp::SpvOpUDiv:
+          case SpvOp::SpvOpSDiv:
+          case SpvOp::SpvOpUMod:
+          case SpvOp::SpvOpSRem:
+          case SpvOp::SpvOpSMod:
+            if (ReplaceDivisionByConstant(&inst)) modified = true;
+            break;
           default:
             break;
         }
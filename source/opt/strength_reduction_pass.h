@@ -15,7 +15,10 @@
 #ifndef SOURCE_OPT_STRENGTH_REDUCTION_PASS_H_
 #define SOURCE_OPT_STRENGTH_REDUCTION_PASS_H_
 
+#include <cstdint>
+
 #include "source/opt/def_use_manager.h"
+#include "source/opt/ir_builder.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/module.h"
 #include "source/opt/pass.h"
@@ -23,6 +26,28 @@
 namespace spvtools {
 namespace opt {
 
+// The constants used to replace the division of |width|-bit integers by a
+// constant with a multiplication, as described in "Division by Invariant
+// Integers using Multiplication" by Granlund and Montgomery.
+struct DivisionMagic {
+  // The multiplier, as a |width|-bit value.
+  uint64_t multiplier;
+  // The amount the high half of the product is shifted right by.
+  uint32_t shift;
+  // For unsigned division, true if the multiplier needs |width| + 1 bits, in
+  // which case |multiplier| only holds its low |width| bits.
+  bool add;
+};
+
+// Returns the magic numbers for the unsigned division of |width|-bit integers
+// by |divisor|, which must be greater than 1.
+DivisionMagic ComputeUnsignedDivisionMagic(uint64_t divisor, uint32_t width);
+
+// Returns the magic numbers for the signed division of |width|-bit integers by
+// the |width|-bit two's complement value |divisor|, which must not be -1, 0 or
+// 1.
+DivisionMagic ComputeSignedDivisionMagic(uint64_t divisor, uint32_t width);
+
 // See optimizer.hpp for documentation.
 class StrengthReductionPass : public Pass {
  public:
@@ -34,17 +59,42 @@ class StrengthReductionPass : public Pass {
   // Returns true if something changed.
   bool ReplaceMultiplyByPowerOf2(BasicBlock::iterator*);
 
-  // Scan the types and constants in the module looking for the the integer
-  // types that we are
-  // interested in.  The shift operation needs a small unsigned integer.  We
-  // need to find
-  // them or create them.  We do not want duplicates.
-  void FindIntTypesAndConstants();
+  // Replaces a 32-bit or 64-bit integer division or remainder by a constant
+  // with shifts, or with a multiplication by the reciprocal of the constant.
+  // Returns true if something changed.
+  bool ReplaceDivisionByConstant(BasicBlock::iterator*);
+
+  // Adds with |builder| the instructions computing the unsigned quotient of
+  // |dividend| by |divisor|, which is not a power of 2.  Returns the id of the
+  // result.
+  uint32_t BuildUnsignedDivision(InstructionBuilder* builder, uint32_t type_id,
+                                 uint32_t width, uint32_t dividend,
+                                 uint64_t divisor);
+
+  // Adds with |builder| the instructions computing the signed quotient of
+  // |dividend| by |divisor|, rounded toward 0.  Returns the id of the result.
+  uint32_t BuildSignedDivision(InstructionBuilder* builder, uint32_t type_id,
+                               uint32_t width, uint32_t dividend,
+                               uint64_t divisor);
+
+  // Adds with |builder| an OpUMulExtended or OpSMulExtended |opcode|
+  // multiplying |a| and |b|, and returns the id of the high half of the
+  // product.
+  uint32_t BuildMultiplyHigh(InstructionBuilder* builder, SpvOp opcode,
+                             uint32_t type_id, uint32_t a, uint32_t b);
 
-  // Get the id for the given constant.  If it does not exist, it will be
-  // created.  The parameter must be between 0 and 32 inclusive.
+  // Finds the ids of the 32-bit signed and unsigned integer types, or 0 if the
+  // module does not declare them.
+  void FindIntTypes();
+
+  // Get the id for the given 32-bit unsigned constant.  If it does not exist,
+  // it will be created.
   uint32_t GetConstantId(uint32_t);
 
+  // Returns the id of the constant of the integer type |type_id| whose bits
+  // are the low bits of |value|.  If it does not exist, it will be created.
+  uint32_t GetIntConstantId(uint32_t type_id, uint64_t value);
+
   // Replaces certain instructions in function bodies with presumably cheaper
   // ones. Returns true if something changed.
   bool ScanFunctions();
@@ -52,11 +102,6 @@ class StrengthReductionPass : public Pass {
   // Type ids for the types of interest, or 0 if they do not exist.
   uint32_t int32_type_id_;
   uint32_t uint32_type_id_;
-
-  // constant_ids[i] is the id for unsigned integer constant i.
-  // We set the limit at 32 because a bit shift of a 32-bit integer does not
-  // need a value larger than 32.
-  uint32_t constant_ids_[33];
 };
 
 }  // namespace opt
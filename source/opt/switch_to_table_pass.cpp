@@ -0,0 +1,343 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/switch_to_table_pass.h"
+
+#include <map>
+#include <memory>
+#include <set>
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kSwitchSelectorInIdx = 0;
+const uint32_t kSwitchDefaultInIdx = 1;
+const uint32_t kSwitchFirstCaseInIdx = 2;
+const uint32_t kSelectionMergeMergeBlockIdInIdx = 0;
+const uint32_t kStorePointerInIdx = 0;
+const uint32_t kStoreObjectInIdx = 1;
+
+// A switch needs at least this many cases to be converted, and a table has at
+// most |kMaxTableSize| entries, of which at least half are cases.
+const uint32_t kMinCaseCount = 2;
+const int64_t kMaxTableSize = 64;
+
+// Returns true if |inst| declares a constant whose value is known, and not a
+// specialization constant.
+bool IsKnownConstant(const Instruction* inst) {
+  switch (inst->opcode()) {
+    case SpvOpConstant:
+    case SpvOpConstantTrue:
+    case SpvOpConstantFalse:
+    case SpvOpConstantNull:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // anonymous namespace
+
+uint32_t SwitchToTablePass::GetSelectedConstant(uint32_t pred_id,
+                                                Instruction* phi) {
+  uint32_t value_id = 0;
+  if (phi == nullptr) {
+    Instruction* store = &*cfg()->block(pred_id)->begin();
+    value_id = store->GetSingleWordInOperand(kStoreObjectInIdx);
+  } else {
+    for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+      if (phi->GetSingleWordInOperand(i + 1) == pred_id)
+        value_id = phi->GetSingleWordInOperand(i);
+    }
+  }
+  if (value_id == 0 || !IsKnownConstant(get_def_use_mgr()->GetDef(value_id)) ||
+      context()->get_constant_mgr()->FindDeclaredConstant(value_id) ==
+          nullptr) {
+    return 0;
+  }
+  return value_id;
+}
+
+uint32_t SwitchToTablePass::CreateTable(uint32_t type_id,
+                                        const std::vector<uint32_t>& entries) {
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  analysis::Integer uint_ty(32, false);
+  const analysis::Constant* length = const_mgr->GetConstant(
+      type_mgr->GetRegisteredType(&uint_ty),
+      {static_cast<uint32_t>(entries.size())});
+  analysis::Array array_ty(
+      type_mgr->GetType(type_id),
+      const_mgr->GetDefiningInstruction(length)->result_id());
+  analysis::Type* reg_array_ty = type_mgr->GetRegisteredType(&array_ty);
+  const uint32_t array_type_id = type_mgr->GetTypeInstruction(reg_array_ty);
+  const analysis::Constant* table = const_mgr->GetConstant(reg_array_ty,
+                                                           entries);
+  const uint32_t table_id =
+      const_mgr->GetDefiningInstruction(table, array_type_id)->result_id();
+
+  const uint32_t var_id = TakeNextId();
+  std::unique_ptr<Instruction> var(new Instruction(
+      context(), SpvOpVariable,
+      type_mgr->FindPointerToType(array_type_id, SpvStorageClassPrivate),
+      var_id,
+      {{SPV_OPERAND_TYPE_STORAGE_CLASS, {SpvStorageClassPrivate}},
+       {SPV_OPERAND_TYPE_ID, {table_id}}}));
+  context()->AddGlobalValue(std::move(var));
+  return var_id;
+}
+
+uint32_t SwitchToTablePass::GenTableLoad(InstructionBuilder* builder,
+                                         uint32_t type_id,
+                                         const std::vector<uint32_t>& entries,
+                                         uint32_t default_id,
+                                         uint32_t in_range,
+                                         uint32_t safe_index) {
+  const uint32_t table_id = CreateTable(type_id, entries);
+  const uint32_t ptr_type_id = context()->get_type_mgr()->FindPointerToType(
+      type_id, SpvStorageClassPrivate);
+  Instruction* ptr =
+      builder->AddAccessChain(ptr_type_id, table_id, {safe_index});
+  Instruction* entry = builder->AddLoad(type_id, ptr->result_id());
+  return builder
+      ->AddSelect(type_id, in_range, entry->result_id(), default_id)
+      ->result_id();
+}
+
+bool SwitchToTablePass::ConvertSwitch(Function* func, BasicBlock* header) {
+  Instruction* switch_inst = header->terminator();
+  Instruction* merge_inst = header->GetMergeInst();
+  if (switch_inst->opcode() != SpvOpSwitch || merge_inst == nullptr ||
+      merge_inst->opcode() != SpvOpSelectionMerge) {
+    return false;
+  }
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  const uint32_t selector_id =
+      switch_inst->GetSingleWordInOperand(kSwitchSelectorInIdx);
+  const uint32_t selector_type_id =
+      get_def_use_mgr()->GetDef(selector_id)->type_id();
+  const analysis::Integer* selector_type =
+      type_mgr->GetType(selector_type_id)->AsInteger();
+  if (selector_type == nullptr || selector_type->width() != 32) return false;
+
+  // The targets of the switch, and of each case literal in the order of the
+  // values of the selector.
+  const uint32_t header_id = header->id();
+  const uint32_t merge_id =
+      merge_inst->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx);
+  const uint32_t default_id =
+      switch_inst->GetSingleWordInOperand(kSwitchDefaultInIdx);
+  std::map<int64_t, uint32_t> cases;
+  std::set<uint32_t> targets = {default_id};
+  for (uint32_t i = kSwitchFirstCaseInIdx; i < switch_inst->NumInOperands();
+       i += 2) {
+    const uint32_t word = switch_inst->GetSingleWordInOperand(i);
+    const int64_t literal =
+        selector_type->IsSigned()
+            ? static_cast<int64_t>(static_cast<int32_t>(word))
+            : static_cast<int64_t>(word);
+    const uint32_t target = switch_inst->GetSingleWordInOperand(i + 1);
+    cases[literal] = target;
+    targets.insert(target);
+  }
+  if (cases.size() < kMinCaseCount) return false;
+  const int64_t min_case = cases.begin()->first;
+  const int64_t table_size = cases.rbegin()->first - min_case + 1;
+  if (table_size > kMaxTableSize ||
+      table_size > 2 * static_cast<int64_t>(cases.size())) {
+    return false;
+  }
+
+  // Each target other than the merge block is only entered from the switch,
+  // and at most stores to a pointer before branching to the merge block.
+  // Either all of them store to the same pointer, or none of them does.
+  Instruction* store = nullptr;
+  bool all_store = true;
+  for (uint32_t target : targets) {
+    if (target == merge_id) {
+      all_store = false;
+      continue;
+    }
+    BasicBlock* bb = cfg()->block(target);
+    Instruction* branch = bb->terminator();
+    if (cfg()->preds(target).size() != 1 || branch->opcode() != SpvOpBranch ||
+        branch->GetSingleWordInOperand(0) != merge_id) {
+      return false;
+    }
+    Instruction* first = &*bb->begin();
+    if (first == branch) {
+      all_store = false;
+      continue;
+    }
+    if (first->opcode() != SpvOpStore || first->NextNode() != branch ||
+        (store != nullptr &&
+         first->GetSingleWordInOperand(kStorePointerInIdx) !=
+             store->GetSingleWordInOperand(kStorePointerInIdx))) {
+      return false;
+    }
+    store = first;
+  }
+  if (store != nullptr && !all_store) return false;
+
+  // Nothing else branches to the merge block, so its phis only depend on the
+  // switch.  They are all replaced, or there are none and the store is.
+  for (uint32_t pred_id : cfg()->preds(merge_id)) {
+    if (pred_id != header_id && targets.count(pred_id) == 0) return false;
+  }
+  std::vector<Instruction*> phis;
+  cfg()->block(merge_id)->ForEachPhiInst(
+      [&phis](Instruction* phi) { phis.push_back(phi); });
+  if (store != nullptr) {
+    if (!phis.empty()) return false;
+    phis.push_back(nullptr);
+  } else if (phis.empty()) {
+    return false;
+  }
+
+  // The entries of the table of each phi, or of the stored value, and the
+  // value selected by the default.  Selects on vectors need a vector
+  // condition, so only scalars are handled.
+  auto pred_of = [header_id, merge_id](uint32_t target) {
+    return target == merge_id ? header_id : target;
+  };
+  std::vector<std::vector<uint32_t>> tables;
+  std::vector<uint32_t> defaults;
+  std::vector<uint32_t> type_ids;
+  for (Instruction* phi : phis) {
+    const uint32_t default_value =
+        GetSelectedConstant(pred_of(default_id), phi);
+    if (default_value == 0) return false;
+    const uint32_t type_id =
+        get_def_use_mgr()->GetDef(default_value)->type_id();
+    const analysis::Type* type = type_mgr->GetType(type_id);
+    if (!type->AsInteger() && !type->AsFloat() && !type->AsBool()) {
+      return false;
+    }
+    std::vector<uint32_t> entries;
+    for (int64_t value = min_case; value < min_case + table_size; ++value) {
+      auto it = cases.find(value);
+      const uint32_t target = it == cases.end() ? default_id : it->second;
+      const uint32_t entry = GetSelectedConstant(pred_of(target), phi);
+      if (entry == 0) return false;
+      entries.push_back(entry);
+    }
+    tables.push_back(std::move(entries));
+    defaults.push_back(default_value);
+    type_ids.push_back(type_id);
+  }
+
+  // Compute the index into the tables, clamped so that the load stays in
+  // bounds when the selector has no case, and load the entries.
+  InstructionBuilder builder(
+      context(), merge_inst,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  uint32_t index_id = selector_id;
+  if (min_case != 0) {
+    const uint32_t min_id =
+        const_mgr
+            ->GetDefiningInstruction(const_mgr->GetConstant(
+                selector_type, {static_cast<uint32_t>(min_case)}))
+            ->result_id();
+    index_id =
+        builder.AddBinaryOp(selector_type_id, SpvOpISub, selector_id, min_id)
+            ->result_id();
+  }
+  const uint32_t size_id =
+      const_mgr
+          ->GetDefiningInstruction(const_mgr->GetConstant(
+              selector_type, {static_cast<uint32_t>(table_size)}))
+          ->result_id();
+  const uint32_t zero_id =
+      const_mgr
+          ->GetDefiningInstruction(
+              const_mgr->GetConstant(selector_type, {0u}))
+          ->result_id();
+  analysis::Bool bool_ty;
+  const uint32_t bool_type_id =
+      type_mgr->GetTypeInstruction(type_mgr->GetRegisteredType(&bool_ty));
+  const uint32_t in_range_id =
+      builder.AddBinaryOp(bool_type_id, SpvOpULessThan, index_id, size_id)
+          ->result_id();
+  const uint32_t safe_index_id =
+      builder.AddSelect(selector_type_id, in_range_id, index_id, zero_id)
+          ->result_id();
+  for (size_t i = 0; i < phis.size(); ++i) {
+    const uint32_t value_id =
+        GenTableLoad(&builder, type_ids[i], tables[i], defaults[i],
+                     in_range_id, safe_index_id);
+    if (phis[i] == nullptr) {
+      std::unique_ptr<Instruction> new_store(store->Clone(context()));
+      new_store->SetInOperand(kStoreObjectInIdx, {value_id});
+      builder.AddInstruction(std::move(new_store));
+    } else {
+      context()->ReplaceAllUsesWith(phis[i]->result_id(), value_id);
+      context()->KillInst(phis[i]);
+    }
+  }
+
+  // The header now branches straight to the merge block.
+  context()->KillInst(merge_inst);
+  context()->KillInst(switch_inst);
+  InstructionBuilder(context(), header,
+                     IRContext::kAnalysisDefUse |
+                         IRContext::kAnalysisInstrToBlockMapping)
+      .AddBranch(merge_id);
+  for (uint32_t target : targets) {
+    if (target != merge_id) RemoveBlock(func, cfg()->block(target));
+  }
+  return true;
+}
+
+void SwitchToTablePass::RemoveBlock(Function* func, BasicBlock* bb) {
+  bb->KillAllInsts(true);
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    if (&*bi == bb) {
+      bi.Erase();
+      break;
+    }
+  }
+}
+
+bool SwitchToTablePass::ConvertSwitches(Function* func) {
+  bool modified = false;
+  // The case blocks removed along the way never end in a switch.
+  std::vector<BasicBlock*> headers;
+  for (auto& bb : *func) {
+    if (bb.tail()->opcode() == SpvOpSwitch) headers.push_back(&bb);
+  }
+  for (BasicBlock* bb : headers) {
+    if (ConvertSwitch(func, bb)) {
+      context()->InvalidateAnalyses(IRContext::kAnalysisCFG |
+                                    IRContext::kAnalysisDominatorAnalysis);
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+Pass::Status SwitchToTablePass::Process() {
+  // The tables are Private variables, which only shaders have.
+  if (!context()->get_feature_mgr()->HasCapability(SpvCapabilityShader)) {
+    return Status::SuccessWithoutChange;
+  }
+
+  ProcessFunction pfn = [this](Function* fp) { return ConvertSwitches(fp); };
+  bool modified = context()->ProcessEntryPointCallTree(pfn);
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
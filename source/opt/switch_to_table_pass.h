@@ -0,0 +1,78 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_SWITCH_TO_TABLE_PASS_H_
+#define SOURCE_OPT_SWITCH_TO_TABLE_PASS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/ir_builder.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class SwitchToTablePass : public Pass {
+ public:
+  const char* name() const override { return "switch-to-table"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisNameMap;
+  }
+
+ private:
+  // Converts the switches of |func| whose cases only select constants.
+  // Returns true if |func| was modified.
+  bool ConvertSwitches(Function* func);
+
+  // Replaces the OpSwitch ending |header| by loads from constant tables, if
+  // each of its targets only selects constants for the phis of the merge
+  // block, or only stores a constant to the same pointer, and branches to the
+  // merge block.  Returns true if the switch was replaced.
+  bool ConvertSwitch(Function* func, BasicBlock* header);
+
+  // Returns the value of the phi |phi| of the merge block when it is entered
+  // from |pred_id|, or the value stored by |pred_id| if |phi| is null.
+  // Returns 0 if it is not a known constant.
+  uint32_t GetSelectedConstant(uint32_t pred_id, Instruction* phi);
+
+  // Returns the id of a new private variable initialized with an array of the
+  // constants |entries| of type |type_id|.
+  uint32_t CreateTable(uint32_t type_id, const std::vector<uint32_t>& entries);
+
+  // Generates with |builder| a load of the entry |safe_index| of a new table
+  // of |entries|, and returns the id of the loaded value, or of |default_id|
+  // if |in_range| is false.
+  uint32_t GenTableLoad(InstructionBuilder* builder, uint32_t type_id,
+                        const std::vector<uint32_t>& entries,
+                        uint32_t default_id, uint32_t in_range,
+                        uint32_t safe_index);
+
+  // Removes |bb| from |func| and kills its instructions.
+  void RemoveBlock(Function* func, BasicBlock* bb);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_SWITCH_TO_TABLE_PASS_H_
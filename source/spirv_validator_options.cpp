@@ -16,6 +16,7 @@
 #include <cstring>
 
 #include "source/spirv_validator_options.h"
+#include "spirv-tools/libspirv.hpp"
 
 bool spvParseUniversalLimitsOptions(const char* s, spv_validator_limit* type) {
   auto match = [s](const char* b) {
@@ -104,3 +105,13 @@ void spvValidatorOptionsSetSkipBlockLayout(spv_validator_options options,
                                            bool val) {
   options->skip_block_layout = val;
 }
+
+void spvValidatorOptionsSetRuleGroups(spv_validator_options options,
+                                      uint32_t groups) {
+  options->rule_groups = groups;
+}
+
+void spvValidatorOptionsSetTimeReport(spv_validator_options options,
+                                      std::ostream* out) {
+  options->time_report_stream = out;
+}
@@ -15,6 +15,8 @@
 #ifndef SOURCE_SPIRV_VALIDATOR_OPTIONS_H_
 #define SOURCE_SPIRV_VALIDATOR_OPTIONS_H_
 
+#include <iosfwd>
+
 #include "spirv-tools/libspirv.h"
 
 // Return true if the command line option for the validator limit is valid (Also
@@ -44,7 +46,9 @@ struct spv_validator_options_t {
         relax_logical_pointer(false),
         relax_block_layout(false),
         scalar_block_layout(false),
-        skip_block_layout(false) {}
+        skip_block_layout(false),
+        rule_groups(spv_validator_rule_group_all),
+        time_report_stream(nullptr) {}
 
   validator_universal_limits_t universal_limits_;
   bool relax_struct_store;
@@ -52,6 +56,11 @@ struct spv_validator_options_t {
   bool relax_block_layout;
   bool scalar_block_layout;
   bool skip_block_layout;
+  // Bitwise OR of the spv_validator_rule_group values to check.
+  uint32_t rule_groups;
+  // If not null, the validator reports the resource utilization of each
+  // validation pass to this stream.
+  std::ostream* time_report_stream;
 };
 
 #endif  // SOURCE_SPIRV_VALIDATOR_OPTIONS_H_
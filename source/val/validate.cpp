@@ -19,10 +19,13 @@
 
 #include <algorithm>
 #include <functional>
+#include <iomanip>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "source/binary.h"
@@ -36,6 +39,7 @@
 #include "source/spirv_endian.h"
 #include "source/spirv_target_env.h"
 #include "source/spirv_validator_options.h"
+#include "source/util/timer.h"
 #include "source/val/construct.h"
 #include "source/val/function.h"
 #include "source/val/instruction.h"
@@ -152,6 +156,87 @@ UNUSED(void PrintDotGraph(ValidationState_t& _, Function func)) {
   }
 }
 
+// Accumulates the resource utilization of the validation passes and parsing
+// phases, keyed by name, and prints it as a table to the time report stream
+// when destroyed. Passes that run once per instruction are aggregated across
+// all instructions. Does nothing unless a time report stream was given and
+// timers are enabled.
+class PassTimeReport {
+ public:
+  explicit PassTimeReport(std::ostream* out) : out_(out) {}
+  ~PassTimeReport() { Report(); }
+
+  // Runs |pass| with |args| and returns its result. The resource utilization
+  // of the call is accumulated under |name|.
+  template <typename PassFn, typename... Args>
+  spv_result_t Run(const char* name, PassFn pass, Args&&... args) {
+#if defined(SPIRV_TIMER_ENABLED)
+    if (out_) {
+      Entry& entry = GetEntry(name);
+      entry.timer->Start();
+      const spv_result_t result = pass(std::forward<Args>(args)...);
+      entry.timer->Stop();
+      ++entry.calls;
+      return result;
+    }
+#else
+    (void)name;
+#endif
+    return pass(std::forward<Args>(args)...);
+  }
+
+ private:
+  // Prints the accumulated resource utilization of each pass, in the order in
+  // which the passes first ran.
+  void Report() {
+#if defined(SPIRV_TIMER_ENABLED)
+    if (!out_ || entries_.empty()) return;
+    *out_ << std::setw(30) << "PASS name" << std::setw(12) << "Calls"
+          << std::setw(12) << "CPU time" << std::setw(12) << "WALL time"
+          << std::setw(12) << "USR time" << std::setw(12) << "SYS time"
+          << std::setw(12) << "RSS delta" << std::endl;
+    out_->precision(2);
+    for (const auto& name_and_entry : entries_) {
+      utils::CumulativeTimer& timer = *name_and_entry.second.timer;
+      *out_ << std::fixed << std::setw(30) << name_and_entry.first
+            << std::setw(12) << name_and_entry.second.calls << std::setw(12)
+            << timer.CPUTime() << std::setw(12) << timer.WallTime()
+            << std::setw(12) << timer.UserTime() << std::setw(12)
+            << timer.SystemTime() << std::setw(12) << timer.RSS()
+            << std::endl;
+    }
+#endif
+  }
+
+#if defined(SPIRV_TIMER_ENABLED)
+  struct Entry {
+    Entry(std::ostream* out)
+        : timer(new utils::CumulativeTimer(out, true)), calls(0) {}
+
+    std::unique_ptr<utils::CumulativeTimer> timer;
+    size_t calls;
+  };
+
+  // Returns the entry for |name|, creating it on first use.
+  Entry& GetEntry(const char* name) {
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+      it = index_.insert(std::make_pair(std::string(name), entries_.size()))
+               .first;
+      entries_.emplace_back(name, Entry(out_));
+    }
+    return entries_[it->second].second;
+  }
+
+  // The entries in the order in which they were created.
+  std::vector<std::pair<std::string, Entry>> entries_;
+  // Maps a pass name to its index in |entries_|.
+  std::map<std::string, size_t> index_;
+#endif
+
+  std::ostream* out_;
+};
+
 spv_result_t ValidateForwardDecls(ValidationState_t& _) {
   if (_.unresolved_forward_id_count() == 0) return SPV_SUCCESS;
 
@@ -249,6 +334,8 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
            << vstate->options()->universal_limits_.max_id_bound << ".";
   }
 
+  PassTimeReport report(vstate->options()->time_report_stream);
+
   // Look for OpExtension instructions and register extensions.
   // This parse should not produce any error messages. Hijack the context and
   // replace the message consumer so that we do not pollute any state in input
@@ -256,14 +343,16 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
   spv_context_t hijacked_context = context;
   hijacked_context.consumer = [](spv_message_level_t, const char*,
                                  const spv_position_t&, const char*) {};
-  spvBinaryParse(&hijacked_context, vstate, words, num_words,
-                 /* parsed_header = */ nullptr, ProcessExtensions,
-                 /* diagnostic = */ nullptr);
+  report.Run("Parse extensions", spvBinaryParse, &hijacked_context, vstate,
+             words, num_words, /* parsed_header = */ nullptr,
+             ProcessExtensions, /* diagnostic = */ nullptr);
 
   // Parse the module and perform inline validation checks. These checks do
   // not require the the knowledge of the whole module.
-  if (auto error = spvBinaryParse(&context, vstate, words, num_words, setHeader,
-                                  ProcessInstruction, pDiagnostic)) {
+  if (auto error =
+          report.Run("Parse instructions", spvBinaryParse, &context, vstate,
+                     words, num_words, setHeader, ProcessInstruction,
+                     pDiagnostic)) {
     return error;
   }
 
@@ -315,21 +404,33 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
         }
       }
 
-      if (auto error = IdPass(*vstate, inst)) return error;
+      if (auto error = report.Run("IdPass", IdPass, *vstate, inst))
+        return error;
     }
 
-    if (auto error = CapabilityPass(*vstate, &instruction)) return error;
-    if (auto error = DataRulesPass(*vstate, &instruction)) return error;
-    if (auto error = ModuleLayoutPass(*vstate, &instruction)) return error;
-    if (auto error = CfgPass(*vstate, &instruction)) return error;
-    if (auto error = InstructionPass(*vstate, &instruction)) return error;
+    if (auto error = report.Run("CapabilityPass", CapabilityPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("DataRulesPass", DataRulesPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("ModuleLayoutPass", ModuleLayoutPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("CfgPass", CfgPass, *vstate, &instruction))
+      return error;
+    if (auto error = report.Run("InstructionPass", InstructionPass, *vstate,
+                                &instruction))
+      return error;
 
     // Now that all of the checks are done, update the state.
     {
       Instruction* inst = const_cast<Instruction*>(&instruction);
       vstate->RegisterInstruction(inst);
     }
-    if (auto error = UpdateIdUse(*vstate, &instruction)) return error;
+    if (auto error = report.Run("UpdateIdUse", UpdateIdUse, *vstate,
+                                &instruction))
+      return error;
   }
 
   if (!vstate->has_memory_model_specified())
@@ -341,7 +442,21 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
            << "Missing OpFunctionEnd at end of module.";
 
   // Catch undefined forward references before performing further checks.
-  if (auto error = ValidateForwardDecls(*vstate)) return error;
+  if (auto error = report.Run("ValidateForwardDecls", ValidateForwardDecls,
+                              *vstate))
+    return error;
+
+  // Groups of rules that may be disabled by the validator options.
+  const bool check_decorations =
+      vstate->IsRuleGroupEnabled(spv_validator_rule_group_decorations);
+  const bool check_builtins =
+      vstate->IsRuleGroupEnabled(spv_validator_rule_group_builtins);
+  const bool check_image =
+      vstate->IsRuleGroupEnabled(spv_validator_rule_group_image);
+  const bool check_atomics =
+      vstate->IsRuleGroupEnabled(spv_validator_rule_group_atomics);
+  const bool check_extensions =
+      vstate->IsRuleGroupEnabled(spv_validator_rule_group_extensions);
 
   // Validate individual opcodes.
   for (size_t i = 0; i < vstate->ordered_instructions().size(); ++i) {
@@ -350,51 +465,116 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
     // Keep these passes in the order they appear in the SPIR-V specification
     // sections to maintain test consistency.
     // Miscellaneous
-    if (auto error = DebugPass(*vstate, &instruction)) return error;
-    if (auto error = AnnotationPass(*vstate, &instruction)) return error;
-    if (auto error = ExtensionPass(*vstate, &instruction)) return error;
-    if (auto error = ModeSettingPass(*vstate, &instruction)) return error;
-    if (auto error = TypePass(*vstate, &instruction)) return error;
-    if (auto error = ConstantPass(*vstate, &instruction)) return error;
-    if (auto error = MemoryPass(*vstate, &instruction)) return error;
-    if (auto error = FunctionPass(*vstate, &instruction)) return error;
-    if (auto error = ImagePass(*vstate, &instruction)) return error;
-    if (auto error = ConversionPass(*vstate, &instruction)) return error;
-    if (auto error = CompositesPass(*vstate, &instruction)) return error;
-    if (auto error = ArithmeticsPass(*vstate, &instruction)) return error;
-    if (auto error = BitwisePass(*vstate, &instruction)) return error;
-    if (auto error = LogicalsPass(*vstate, &instruction)) return error;
-    if (auto error = ControlFlowPass(*vstate, &instruction)) return error;
-    if (auto error = DerivativesPass(*vstate, &instruction)) return error;
-    if (auto error = AtomicsPass(*vstate, &instruction)) return error;
-    if (auto error = PrimitivesPass(*vstate, &instruction)) return error;
-    if (auto error = BarriersPass(*vstate, &instruction)) return error;
+    if (auto error = report.Run("DebugPass", DebugPass, *vstate, &instruction))
+      return error;
+    if (auto error = report.Run("AnnotationPass", AnnotationPass, *vstate,
+                                &instruction))
+      return error;
+    if (check_extensions) {
+      if (auto error = report.Run("ExtensionPass", ExtensionPass, *vstate,
+                                  &instruction))
+        return error;
+    }
+    if (auto error = report.Run("ModeSettingPass", ModeSettingPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("TypePass", TypePass, *vstate, &instruction))
+      return error;
+    if (auto error = report.Run("ConstantPass", ConstantPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("MemoryPass", MemoryPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("FunctionPass", FunctionPass, *vstate,
+                                &instruction))
+      return error;
+    if (check_image) {
+      if (auto error =
+              report.Run("ImagePass", ImagePass, *vstate, &instruction))
+        return error;
+    }
+    if (auto error = report.Run("ConversionPass", ConversionPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("CompositesPass", CompositesPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("ArithmeticsPass", ArithmeticsPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("BitwisePass", BitwisePass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("LogicalsPass", LogicalsPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("ControlFlowPass", ControlFlowPass, *vstate,
+                                &instruction))
+      return error;
+    if (auto error = report.Run("DerivativesPass", DerivativesPass, *vstate,
+                                &instruction))
+      return error;
+    if (check_atomics) {
+      if (auto error = report.Run("AtomicsPass", AtomicsPass, *vstate,
+                                  &instruction))
+        return error;
+    }
+    if (auto error = report.Run("PrimitivesPass", PrimitivesPass, *vstate,
+                                &instruction))
+      return error;
+    if (check_atomics) {
+      if (auto error = report.Run("BarriersPass", BarriersPass, *vstate,
+                                  &instruction))
+        return error;
+    }
     // Group
     // Device-Side Enqueue
     // Pipe
-    if (auto error = NonUniformPass(*vstate, &instruction)) return error;
+    if (auto error = report.Run("NonUniformPass", NonUniformPass, *vstate,
+                                &instruction))
+      return error;
 
-    if (auto error = LiteralsPass(*vstate, &instruction)) return error;
+    if (auto error = report.Run("LiteralsPass", LiteralsPass, *vstate,
+                                &instruction))
+      return error;
   }
 
   // Validate the preconditions involving adjacent instructions. e.g. SpvOpPhi
   // must only be preceeded by SpvOpLabel, SpvOpPhi, or SpvOpLine.
-  if (auto error = ValidateAdjacency(*vstate)) return error;
+  if (auto error = report.Run("ValidateAdjacency", ValidateAdjacency, *vstate))
+    return error;
 
-  if (auto error = ValidateEntryPoints(*vstate)) return error;
+  if (auto error = report.Run("ValidateEntryPoints", ValidateEntryPoints,
+                              *vstate))
+    return error;
   // CFG checks are performed after the binary has been parsed
   // and the CFGPass has collected information about the control flow
-  if (auto error = PerformCfgChecks(*vstate)) return error;
-  if (auto error = CheckIdDefinitionDominateUse(*vstate)) return error;
-  if (auto error = ValidateDecorations(*vstate)) return error;
-  if (auto error = ValidateInterfaces(*vstate)) return error;
+  if (auto error = report.Run("PerformCfgChecks", PerformCfgChecks, *vstate))
+    return error;
+  if (auto error = report.Run("CheckIdDefinitionDominateUse",
+                              CheckIdDefinitionDominateUse, *vstate))
+    return error;
+  if (check_decorations) {
+    if (auto error = report.Run("ValidateDecorations", ValidateDecorations,
+                                *vstate))
+      return error;
+    if (auto error = report.Run("ValidateInterfaces", ValidateInterfaces,
+                                *vstate))
+      return error;
+  }
   // TODO(dsinclair): Restructure ValidateBuiltins so we can move into the
   // for() above as it loops over all ordered_instructions internally.
-  if (auto error = ValidateBuiltIns(*vstate)) return error;
+  if (check_builtins) {
+    if (auto error = report.Run("ValidateBuiltIns", ValidateBuiltIns, *vstate))
+      return error;
+  }
   // These checks must be performed after individual opcode checks because
   // those checks register the limitation checked here.
   for (const auto inst : vstate->ordered_instructions()) {
-    if (auto error = ValidateExecutionLimitations(*vstate, &inst)) return error;
+    if (auto error = report.Run("ValidateExecutionLimitations",
+                                ValidateExecutionLimitations, *vstate, &inst))
+      return error;
   }
 
   return SPV_SUCCESS;
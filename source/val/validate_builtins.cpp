@@ -2574,9 +2574,9 @@ spv_result_t BuiltInsValidator::ValidateSingleBuiltInAtDefinition(
 }
 
 spv_result_t BuiltInsValidator::ValidateBuiltInsAtDefinition() {
-  for (const auto& kv : _.id_decorations()) {
-    const uint32_t id = kv.first;
-    const auto& decorations = kv.second;
+  const auto& id_decorations = _.id_decorations();
+  for (uint32_t id = 0; id < id_decorations.size(); ++id) {
+    const auto& decorations = id_decorations[id];
     if (decorations.empty()) {
       continue;
     }
@@ -2584,7 +2584,7 @@ spv_result_t BuiltInsValidator::ValidateBuiltInsAtDefinition() {
     const Instruction* inst = _.FindDef(id);
     assert(inst);
 
-    for (const auto& decoration : kv.second) {
+    for (const auto& decoration : decorations) {
       if (decoration.dec_type() != SpvDecorationBuiltIn) {
         continue;
       }
@@ -1059,8 +1059,8 @@ spv_result_t CheckVulkanMemoryModelDeprecatedDecorations(
 
   std::string msg;
   std::ostringstream str(msg);
-  for (const auto& def : vstate.all_definitions()) {
-    const auto inst = def.second;
+  for (const auto inst : vstate.all_definitions()) {
+    if (!inst) continue;
     const auto id = inst->id();
     for (const auto& dec : vstate.id_decorations(id)) {
       const auto member = dec.struct_member_index();
@@ -1184,9 +1184,9 @@ spv_result_t CheckDecorationsFromDecoration(ValidationState_t& vstate) {
   // Some rules are only checked for shaders.
   const bool is_shader = vstate.HasCapability(SpvCapabilityShader);
 
-  for (const auto& kv : vstate.id_decorations()) {
-    const uint32_t id = kv.first;
-    const auto& decorations = kv.second;
+  const auto& id_decorations = vstate.id_decorations();
+  for (uint32_t id = 0; id < id_decorations.size(); ++id) {
+    const auto& decorations = id_decorations[id];
     if (decorations.empty()) continue;
 
     const Instruction* inst = vstate.FindDef(id);
@@ -261,19 +261,17 @@ std::vector<uint32_t> ValidationState_t::UnresolvedForwardIds() const {
 }
 
 bool ValidationState_t::IsDefinedId(uint32_t id) const {
-  return all_definitions_.find(id) != std::end(all_definitions_);
+  return FindDef(id) != nullptr;
 }
 
 const Instruction* ValidationState_t::FindDef(uint32_t id) const {
-  auto it = all_definitions_.find(id);
-  if (it == all_definitions_.end()) return nullptr;
-  return it->second;
+  if (id >= all_definitions_.size()) return nullptr;
+  return all_definitions_[id];
 }
 
 Instruction* ValidationState_t::FindDef(uint32_t id) {
-  auto it = all_definitions_.find(id);
-  if (it == all_definitions_.end()) return nullptr;
-  return it->second;
+  if (id >= all_definitions_.size()) return nullptr;
+  return all_definitions_[id];
 }
 
 ModuleLayoutSection ValidationState_t::current_layout_section() const {
@@ -316,6 +314,10 @@ std::vector<Function>& ValidationState_t::functions() {
   return module_functions_;
 }
 
+const std::vector<Function>& ValidationState_t::functions() const {
+  return module_functions_;
+}
+
 Function& ValidationState_t::current_function() {
   assert(in_function_body());
   return module_functions_.back();
@@ -327,15 +329,13 @@ const Function& ValidationState_t::current_function() const {
 }
 
 const Function* ValidationState_t::function(uint32_t id) const {
-  const auto it = id_to_function_.find(id);
-  if (it == id_to_function_.end()) return nullptr;
-  return it->second;
+  if (id >= id_to_function_.size()) return nullptr;
+  return id_to_function_[id];
 }
 
 Function* ValidationState_t::function(uint32_t id) {
-  auto it = id_to_function_.find(id);
-  if (it == id_to_function_.end()) return nullptr;
-  return it->second;
+  if (id >= id_to_function_.size()) return nullptr;
+  return id_to_function_[id];
 }
 
 bool ValidationState_t::in_function_body() const { return in_function_; }
@@ -456,7 +456,9 @@ spv_result_t ValidationState_t::RegisterFunction(
   in_function_ = true;
   module_functions_.emplace_back(id, ret_type_id, function_control,
                                  function_type_id);
-  id_to_function_.emplace(id, &current_function());
+  if (id >= id_to_function_.size()) id_to_function_.resize(id + 1, nullptr);
+  // Keep the first registration if the id is (invalidly) reused.
+  if (!id_to_function_[id]) id_to_function_[id] = &current_function();
 
   // TODO(umar): validate function type and type_id
 
@@ -511,11 +513,16 @@ void ValidationState_t::RegisterDebugInstruction(const Instruction* inst) {
 }
 
 void ValidationState_t::RegisterInstruction(Instruction* inst) {
-  if (inst->id()) all_definitions_.insert(std::make_pair(inst->id(), inst));
+  if (const uint32_t id = inst->id()) {
+    if (id >= all_definitions_.size()) all_definitions_.resize(id + 1, nullptr);
+    // Keep the first definition if the id is (invalidly) redefined.
+    if (!all_definitions_[id]) all_definitions_[id] = inst;
+  }
 
   // If the instruction is using an OpTypeSampledImage as an operand, it should
   // be recorded. The validator will ensure that all usages of an
   // OpTypeSampledImage and its definition are in the same basic block.
+  if (!IsRuleGroupEnabled(spv_validator_rule_group_image)) return;
   for (uint16_t i = 0; i < inst->operands().size(); ++i) {
     const spv_parsed_operand_t& operand = inst->operand(i);
     if (SPV_OPERAND_TYPE_ID == operand.type) {
@@ -545,10 +552,15 @@ void ValidationState_t::RegisterSampledImageConsumer(uint32_t sampled_image_id,
 
 uint32_t ValidationState_t::getIdBound() const { return id_bound_; }
 
-void ValidationState_t::setIdBound(const uint32_t bound) { id_bound_ = bound; }
+void ValidationState_t::setIdBound(const uint32_t bound) {
+  // The per-id tables are not sized here: the bound comes from the module
+  // header and may be far larger than the number of ids actually defined.
+  // They grow as ids are registered instead.
+  id_bound_ = bound;
+}
 
 bool ValidationState_t::RegisterUniqueTypeDeclaration(const Instruction* inst) {
-  std::vector<uint32_t> key;
+  std::u32string key;
   key.push_back(static_cast<uint32_t>(inst->opcode()));
   for (size_t index = 0; index < inst->operands().size(); ++index) {
     const spv_parsed_operand_t& operand = inst->operand(index);
@@ -559,7 +571,7 @@ bool ValidationState_t::RegisterUniqueTypeDeclaration(const Instruction* inst) {
     const int words_end = words_begin + operand.num_words;
     assert(words_end <= static_cast<int>(inst->words().size()));
 
-    key.insert(key.end(), inst->words().begin() + words_begin,
+    key.append(inst->words().begin() + words_begin,
                inst->words().begin() + words_end);
   }
 
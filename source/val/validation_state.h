@@ -15,7 +15,6 @@
 #ifndef SOURCE_VAL_VALIDATION_STATE_H_
 #define SOURCE_VAL_VALIDATION_STATE_H_
 
-#include <map>
 #include <set>
 #include <string>
 #include <tuple>
@@ -117,6 +116,11 @@ class ValidationState_t {
   /// Returns the command line options
   spv_const_validator_options options() const { return options_; }
 
+  /// Returns true if the rules in |group| should be checked.
+  bool IsRuleGroupEnabled(spv_validator_rule_group group) const {
+    return (options_->rule_groups & group) != 0;
+  }
+
   /// Sets the ID of the generator for this module.
   void setGenerator(uint32_t gen) { generator_ = gen; }
 
@@ -189,6 +193,7 @@ class ValidationState_t {
 
   /// Returns the function states
   std::vector<Function>& functions();
+  const std::vector<Function>& functions() const;
 
   /// Returns the function states
   Function& current_function();
@@ -292,7 +297,7 @@ class ValidationState_t {
   }
 
   bool IsFunctionCallDefined(const uint32_t id) {
-    return (id_to_function_.find(id) != id_to_function_.end());
+    return id < id_to_function_.size() && id_to_function_[id] != nullptr;
   }
   /// Registers the capability and its dependent capabilities
   void RegisterCapability(SpvCapability cap);
@@ -359,13 +364,13 @@ class ValidationState_t {
 
   /// Registers the decoration for the given <id>
   void RegisterDecorationForId(uint32_t id, const Decoration& dec) {
-    id_decorations_[id].push_back(dec);
+    id_decorations(id).push_back(dec);
   }
 
   /// Registers the list of decorations for the given <id>
   template <class InputIt>
   void RegisterDecorationsForId(uint32_t id, InputIt begin, InputIt end) {
-    std::vector<Decoration>& cur_decs = id_decorations_[id];
+    std::vector<Decoration>& cur_decs = id_decorations(id);
     cur_decs.insert(cur_decs.end(), begin, end);
   }
 
@@ -376,25 +381,26 @@ class ValidationState_t {
                                           uint32_t member_index, InputIt begin,
                                           InputIt end) {
     RegisterDecorationsForId(struct_id, begin, end);
-    for (auto& decoration : id_decorations_[struct_id]) {
+    for (auto& decoration : id_decorations(struct_id)) {
       decoration.set_struct_member_index(member_index);
     }
   }
 
-  /// Returns all the decorations for the given <id>. If no decorations exist
-  /// for the <id>, it registers an empty vector for it in the map and
-  /// returns the empty vector.
+  /// Returns all the decorations for the given <id>. The storage is indexed
+  /// by <id>; if |id| is outside of the current storage, the storage is grown
+  /// to hold it and an empty vector is returned.
   std::vector<Decoration>& id_decorations(uint32_t id) {
+    if (id >= id_decorations_.size()) id_decorations_.resize(id + 1);
     return id_decorations_[id];
   }
   const std::vector<Decoration>& id_decorations(uint32_t id) const {
-    // TODO: This would throw or generate SIGABRT if id has no
-    // decorations. Remove/refactor this function.
-    return id_decorations_.at(id);
+    if (id >= id_decorations_.size()) return empty_decorations_;
+    return id_decorations_[id];
   }
 
-  // Returns const pointer to the internal decoration container.
-  const std::map<uint32_t, std::vector<Decoration>>& id_decorations() const {
+  // Returns const reference to the internal decoration container. It is
+  // indexed by <id>, ids without decorations have an empty vector.
+  const std::vector<std::vector<Decoration>>& id_decorations() const {
     return id_decorations_;
   }
 
@@ -411,8 +417,9 @@ class ValidationState_t {
     return ordered_instructions_;
   }
 
-  /// Returns a map of instructions mapped by their result id
-  const std::unordered_map<uint32_t, Instruction*>& all_definitions() const {
+  /// Returns the instructions that define ids, indexed by result id. Ids
+  /// that have no definition map to nullptr.
+  const std::vector<Instruction*>& all_definitions() const {
     return all_definitions_;
   }
 
@@ -450,11 +457,15 @@ class ValidationState_t {
 
   /// Sets the struct nesting depth for a given struct ID
   void set_struct_nesting_depth(uint32_t id, uint32_t depth) {
+    if (id >= struct_nesting_depth_.size()) {
+      struct_nesting_depth_.resize(id + 1, 0);
+    }
     struct_nesting_depth_[id] = depth;
   }
 
   /// Returns the nesting depth of a given structure ID
-  uint32_t struct_nesting_depth(uint32_t id) {
+  uint32_t struct_nesting_depth(uint32_t id) const {
+    if (id >= struct_nesting_depth_.size()) return 0;
     return struct_nesting_depth_[id];
   }
 
@@ -611,8 +622,9 @@ class ValidationState_t {
   /// List of all instructions in the order they appear in the binary
   std::vector<Instruction> ordered_instructions_;
 
-  /// Instructions that can be referenced by Ids
-  std::unordered_map<uint32_t, Instruction*> all_definitions_;
+  /// Instructions that can be referenced by Ids, indexed by id. Sized from
+  /// the id bound in the header.
+  std::vector<Instruction*> all_definitions_;
 
   /// IDs that are entry points, ie, arguments to OpEntryPoint.
   std::vector<uint32_t> entry_points_;
@@ -640,17 +652,18 @@ class ValidationState_t {
   /// Set of struct types that have members with a BuiltIn decoration.
   std::unordered_set<uint32_t> builtin_structs_;
 
-  /// Structure Nesting Depth
-  std::unordered_map<uint32_t, uint32_t> struct_nesting_depth_;
+  /// Structure Nesting Depth, indexed by struct id.
+  std::vector<uint32_t> struct_nesting_depth_;
+
+  /// Stores the list of decorations for a given <id>, indexed by <id>.
+  std::vector<std::vector<Decoration>> id_decorations_;
 
-  /// Stores the list of decorations for a given <id>
-  std::map<uint32_t, std::vector<Decoration>> id_decorations_;
+  /// Returned for ids that lie outside of |id_decorations_|.
+  const std::vector<Decoration> empty_decorations_;
 
   /// Stores type declarations which need to be unique (i.e. non-aggregates),
   /// in the form [opcode, operand words], result_id is not stored.
-  /// Using ordered set to avoid the need for a vector hash function.
-  /// The size of this container is expected not to exceed double-digits.
-  std::set<std::vector<uint32_t>> unique_type_declarations_;
+  std::unordered_set<std::u32string> unique_type_declarations_;
 
   AssemblyGrammar grammar_;
 
@@ -664,8 +677,8 @@ class ValidationState_t {
   /// declared by the module and the environment.
   Feature features_;
 
-  /// Maps function ids to function stat objects.
-  std::unordered_map<uint32_t, Function*> id_to_function_;
+  /// Maps function ids to function stat objects, indexed by function id.
+  std::vector<Function*> id_to_function_;
 
   /// Mapping entry point -> execution models. It is presumed that the same
   /// function could theoretically be used as 'main' by multiple OpEntryPoint
@@ -0,0 +1,122 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "spirv-tools/libspirv.hpp"
+#include "tools/gen/module_generator.h"
+
+namespace spvtools {
+namespace gen {
+namespace {
+
+using ::testing::HasSubstr;
+
+// Returns the number of times |pattern| occurs in |text|.
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+// Returns true if a module of shape |shape| assembles and validates, and
+// reports the diagnostics otherwise.
+bool IsValid(const ModuleShape& shape) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  tools.SetMessageConsumer([](spv_message_level_t, const char*,
+                              const spv_position_t&, const char* message) {
+    ADD_FAILURE() << message;
+  });
+  std::vector<uint32_t> binary;
+  return GenerateModule(SPV_ENV_UNIVERSAL_1_3, shape, &binary) &&
+         tools.Validate(binary);
+}
+
+using ModuleGeneratorTest = ::testing::TestWithParam<ModuleShape>;
+
+TEST_P(ModuleGeneratorTest, GeneratesValidModule) {
+  EXPECT_TRUE(IsValid(GetParam()));
+}
+
+// Returns the default shape changed by |change|.
+template <typename Change>
+ModuleShape MakeShape(Change change) {
+  ModuleShape shape;
+  change(&shape);
+  return shape;
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Shapes, ModuleGeneratorTest,
+    ::testing::Values(
+        ModuleShape(), MakeShape([](ModuleShape* s) { s->Scale(4); }),
+        MakeShape([](ModuleShape* s) {
+          s->functions = 0;
+          s->types = 0;
+          s->constants = 0;
+          s->decorations = 0;
+        }),
+        MakeShape([](ModuleShape* s) { s->nesting_depth = 0; }),
+        MakeShape([](ModuleShape* s) { s->nesting_depth = 7; }),
+        MakeShape([](ModuleShape* s) { s->switch_cases = 0; }),
+        MakeShape([](ModuleShape* s) { s->phi_chain_length = 0; }),
+        MakeShape([](ModuleShape* s) {
+          s->types = 3;
+          s->decorations = 10;
+        })));
+
+TEST(ModuleGeneratorShapeTest, FollowsShape) {
+  ModuleShape shape;
+  shape.functions = 3;
+  shape.nesting_depth = 4;
+  shape.switch_cases = 5;
+  shape.phi_chain_length = 6;
+  shape.types = 7;
+  shape.constants = 8;
+  shape.decorations = 9;
+  shape.entry_point_name = "other";
+  std::string text = GenerateModuleText(shape);
+
+  EXPECT_THAT(text, HasSubstr("OpEntryPoint Fragment %main \"other\""));
+  EXPECT_EQ(4u, CountOccurrences(text, "= OpFunction "));
+  EXPECT_EQ(3u, CountOccurrences(text, "= OpFunctionCall "));
+  // Two loops in each function.
+  EXPECT_EQ(6u, CountOccurrences(text, "OpLoopMerge"));
+  EXPECT_EQ(3u, CountOccurrences(text, "OpSwitch"));
+  EXPECT_EQ(7u, CountOccurrences(text, "OpTypeStruct"));
+  EXPECT_EQ(9u, CountOccurrences(text, "RelaxedPrecision"));
+  // The constants and those used by the code.
+  EXPECT_EQ(8u + 5u, CountOccurrences(text, "OpConstant "));
+}
+
+TEST(ModuleGeneratorShapeTest, ScaleGrowsModule) {
+  ModuleShape shape;
+  std::vector<uint32_t> small;
+  ASSERT_TRUE(GenerateModule(SPV_ENV_UNIVERSAL_1_3, shape, &small));
+  shape.Scale(4);
+  EXPECT_EQ(16u, shape.functions);
+  EXPECT_EQ(4u, shape.nesting_depth);
+  std::vector<uint32_t> large;
+  ASSERT_TRUE(GenerateModule(SPV_ENV_UNIVERSAL_1_3, shape, &large));
+  EXPECT_GT(large.size(), 3 * small.size());
+}
+
+}  // namespace
+}  // namespace gen
+}  // namespace spvtools
@@ -0,0 +1,146 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/module_index.h"
+#include "source/val/validate.h"
+#include "source/val/validation_state.h"
+#include "test/test_fixture.h"
+#include "test/unit_spirv.h"
+
+namespace spvtools {
+namespace {
+
+using spvtest::ScopedContext;
+using ::testing::ElementsAre;
+
+using ModuleIndexTest = spvtest::TextToBinaryTest;
+
+// The ids are numbered in the order they first appear, and the comments give
+// the ordinal of each instruction.
+const char kModule[] = R"(
+OpCapability Shader                  ; 0
+OpMemoryModel Logical GLSL450        ; 1
+OpEntryPoint GLCompute %1 "main"     ; 2
+OpExecutionMode %1 LocalSize 1 1 1   ; 3
+OpDecorate %2 RelaxedPrecision       ; 4
+%3 = OpTypeVoid                      ; 5
+%4 = OpTypeFunction %3               ; 6
+%5 = OpTypeBool                      ; 7
+%6 = OpConstantTrue %5               ; 8
+%7 = OpTypeFloat 32                  ; 9
+%8 = OpConstant %7 1                 ; 10
+%1 = OpFunction %3 None %4           ; 11
+%9 = OpLabel                         ; 12
+OpSelectionMerge %10 None            ; 13
+OpBranchConditional %6 %11 %10       ; 14
+%11 = OpLabel                        ; 15
+%2 = OpFAdd %7 %8 %8                 ; 16
+OpBranch %10                         ; 17
+%10 = OpLabel                        ; 18
+OpReturn                             ; 19
+%12 = OpLabel                        ; 20
+OpReturn                             ; 21
+OpFunctionEnd                        ; 22
+)";
+
+// Validates |words| and returns the index built from the validation state.
+std::unique_ptr<ModuleIndex> BuildIndex(const std::vector<uint32_t>& words) {
+  ScopedContext context;
+  spv_validator_options options = spvValidatorOptionsCreate();
+  std::unique_ptr<val::ValidationState_t> vstate;
+  spv_result_t result = val::ValidateBinaryAndKeepValidationState(
+      context.context, options, words.data(), words.size(), nullptr, &vstate);
+  spvValidatorOptionsDestroy(options);
+  if (result != SPV_SUCCESS) return nullptr;
+  return std::unique_ptr<ModuleIndex>(new ModuleIndex(*vstate));
+}
+
+std::vector<uint32_t> Users(const ModuleIndex& index, uint32_t id) {
+  std::vector<uint32_t> users;
+  for (const ModuleIndex::Use& use : index.uses(id)) {
+    users.push_back(use.user);
+    users.push_back(use.operand_index);
+  }
+  return users;
+}
+
+TEST_F(ModuleIndexTest, Instructions) {
+  auto index = BuildIndex(CompileSuccessfully(kModule));
+  ASSERT_NE(nullptr, index);
+
+  EXPECT_EQ(13u, index->id_bound());
+  EXPECT_EQ(23u, index->num_instructions());
+  EXPECT_EQ(SpvOpCapability, index->opcode(0));
+  EXPECT_EQ(0u, index->result_id(0));
+  EXPECT_EQ(SpvOpFAdd, index->opcode(16));
+  EXPECT_EQ(2u, index->result_id(16));
+  EXPECT_EQ(SpvOpFunctionEnd, index->opcode(22));
+}
+
+TEST_F(ModuleIndexTest, Definitions) {
+  auto index = BuildIndex(CompileSuccessfully(kModule));
+  ASSERT_NE(nullptr, index);
+
+  EXPECT_EQ(ModuleIndex::kNoOrdinal, index->def(0));
+  EXPECT_EQ(11u, index->def(1));
+  EXPECT_EQ(16u, index->def(2));
+  EXPECT_EQ(5u, index->def(3));
+  EXPECT_EQ(20u, index->def(12));
+  EXPECT_EQ(ModuleIndex::kNoOrdinal, index->def(13));
+}
+
+TEST_F(ModuleIndexTest, UseLists) {
+  auto index = BuildIndex(CompileSuccessfully(kModule));
+  ASSERT_NE(nullptr, index);
+
+  // Pairs of user ordinal and operand index.
+  EXPECT_THAT(Users(*index, 1), ElementsAre(2, 1, 3, 0));
+  EXPECT_THAT(Users(*index, 2), ElementsAre(4, 0));
+  EXPECT_THAT(Users(*index, 3), ElementsAre(6, 1, 11, 0));
+  EXPECT_THAT(Users(*index, 7), ElementsAre(10, 0, 16, 0));
+  EXPECT_THAT(Users(*index, 8), ElementsAre(16, 2, 16, 3));
+  EXPECT_THAT(Users(*index, 10), ElementsAre(13, 0, 14, 2, 17, 0));
+  EXPECT_TRUE(index->uses(12).empty());
+  EXPECT_TRUE(index->uses(100).empty());
+}
+
+TEST_F(ModuleIndexTest, FunctionsAndDominators) {
+  auto index = BuildIndex(CompileSuccessfully(kModule));
+  ASSERT_NE(nullptr, index);
+
+  ASSERT_EQ(1u, index->functions().size());
+  const ModuleIndex::Function& function = index->functions()[0];
+  EXPECT_EQ(1u, function.id);
+  ASSERT_EQ(4u, function.blocks.size());
+
+  EXPECT_EQ(9u, function.blocks[0].label_id);
+  EXPECT_EQ(9u, function.blocks[0].immediate_dominator);
+
+  EXPECT_EQ(11u, function.blocks[1].label_id);
+  EXPECT_EQ(9u, function.blocks[1].immediate_dominator);
+
+  EXPECT_EQ(10u, function.blocks[2].label_id);
+  EXPECT_EQ(9u, function.blocks[2].immediate_dominator);
+
+  // Unreachable blocks have no immediate dominator.
+  EXPECT_EQ(12u, function.blocks[3].label_id);
+  EXPECT_EQ(0u, function.blocks[3].immediate_dominator);
+}
+
+}  // namespace
+}  // namespace spvtools
@@ -0,0 +1,147 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/alias_analysis.h"
+#include "source/opt/build_module.h"
+#include "source/opt/ir_context.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using AliasAnalysisTest = PassTest<::testing::Test>;
+using AliasResult = AliasAnalysis::AliasResult;
+
+// %12, %13, %14 and %27 are buffers.  %12 and %14 share a binding, and %27
+// shares it too but is Restrict.  %15 to %19 are workgroup variables, of which
+// %15 and %16 are Aliased.  %31 is a function parameter.
+const std::string kText = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+OpDecorate %10 BufferBlock
+OpMemberDecorate %10 0 Offset 0
+OpMemberDecorate %10 1 Offset 4
+OpDecorate %12 DescriptorSet 0
+OpDecorate %12 Binding 0
+OpDecorate %13 DescriptorSet 0
+OpDecorate %13 Binding 1
+OpDecorate %14 DescriptorSet 0
+OpDecorate %14 Binding 0
+OpDecorate %27 DescriptorSet 0
+OpDecorate %27 Binding 0
+OpDecorate %27 Restrict
+OpDecorate %15 Aliased
+OpDecorate %16 Aliased
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpConstant %4 0
+%6 = OpConstant %4 1
+%7 = OpTypePointer Workgroup %4
+%8 = OpTypePointer Uniform %4
+%10 = OpTypeStruct %4 %4
+%11 = OpTypePointer Uniform %10
+%32 = OpTypeFunction %2 %7
+%12 = OpVariable %11 Uniform
+%13 = OpVariable %11 Uniform
+%14 = OpVariable %11 Uniform
+%27 = OpVariable %11 Uniform
+%15 = OpVariable %7 Workgroup
+%16 = OpVariable %7 Workgroup
+%18 = OpVariable %7 Workgroup
+%19 = OpVariable %7 Workgroup
+%1 = OpFunction %2 None %3
+%20 = OpLabel
+%21 = OpAccessChain %8 %12 %5
+%22 = OpAccessChain %8 %12 %6
+%23 = OpAccessChain %8 %12 %5
+%24 = OpLoad %4 %21
+%25 = OpAccessChain %8 %12 %24
+%26 = OpCopyObject %8 %21
+%33 = OpFunctionCall %2 %30 %18
+OpReturn
+OpFunctionEnd
+%30 = OpFunction %2 None %32
+%31 = OpFunctionParameter %7
+%34 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST_F(AliasAnalysisTest, StorageClasses) {
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kText,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  AliasAnalysis* alias_analysis = context->GetAliasAnalysis();
+
+  EXPECT_EQ(SpvStorageClassUniform, alias_analysis->GetStorageClass(21));
+  EXPECT_EQ(SpvStorageClassWorkgroup, alias_analysis->GetStorageClass(18));
+  EXPECT_EQ(AliasResult::kMustAlias, alias_analysis->Alias(18, 18));
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(18, 21));
+}
+
+TEST_F(AliasAnalysisTest, AccessChainsFromSameVariable) {
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kText,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  AliasAnalysis* alias_analysis = context->GetAliasAnalysis();
+
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(21, 22));
+  EXPECT_EQ(AliasResult::kMustAlias, alias_analysis->Alias(21, 23));
+  EXPECT_EQ(AliasResult::kMustAlias, alias_analysis->Alias(21, 26));
+  EXPECT_EQ(AliasResult::kMayAlias, alias_analysis->Alias(21, 25));
+  EXPECT_EQ(AliasResult::kMayAlias, alias_analysis->Alias(12, 21));
+
+  std::vector<uint32_t> indexes;
+  EXPECT_EQ(12u, alias_analysis->GetAccessPath(26, &indexes)->result_id());
+  EXPECT_THAT(indexes, ::testing::ElementsAre(5u));
+}
+
+TEST_F(AliasAnalysisTest, DistinctVariables) {
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kText,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  AliasAnalysis* alias_analysis = context->GetAliasAnalysis();
+
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(18, 19));
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(15, 18));
+  EXPECT_EQ(AliasResult::kMayAlias, alias_analysis->Alias(15, 16));
+
+  // Buffers bound to the same binding are the same memory.
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(12, 13));
+  EXPECT_EQ(AliasResult::kMayAlias, alias_analysis->Alias(12, 14));
+  EXPECT_EQ(AliasResult::kMayAlias, alias_analysis->Alias(21, 14));
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(12, 27));
+}
+
+TEST_F(AliasAnalysisTest, FunctionParameters) {
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kText,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  AliasAnalysis* alias_analysis = context->GetAliasAnalysis();
+
+  EXPECT_EQ(AliasResult::kMayAlias, alias_analysis->Alias(31, 18));
+  EXPECT_EQ(AliasResult::kNoAlias, alias_analysis->Alias(31, 21));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,227 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/opt/assembly_builder.h"
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using CodeSinkTest = PassTest<::testing::Test>;
+
+const std::string kHeader = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %sel %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %sel "sel"
+OpName %out "out"
+OpName %priv "priv"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Input_uint = OpTypePointer Input %uint
+%_ptr_Output_float = OpTypePointer Output %float
+%_ptr_Private_float = OpTypePointer Private %float
+%in = OpVariable %_ptr_Input_float Input
+%sel = OpVariable %_ptr_Input_uint Input
+%out = OpVariable %_ptr_Output_float Output
+%priv = OpVariable %_ptr_Private_float Private
+)";
+
+TEST_F(CodeSinkTest, SinkChainIntoUsingSuccessor) {
+  const std::string text = kHeader + R"(
+; CHECK: %main = OpFunction
+; CHECK-NEXT: OpLabel
+; CHECK-NOT: OpFMul
+; CHECK: OpBranchConditional {{%\w+}} [[then:%\w+]] [[merge:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK-NEXT: [[ld:%\w+]] = OpLoad %float %in
+; CHECK-NEXT: [[mul:%\w+]] = OpFMul %float [[ld]] [[ld]]
+; CHECK-NEXT: OpStore %out [[mul]]
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %float %in
+%mul = OpFMul %float %ld %ld
+%s = OpLoad %uint %sel
+%cond = OpIEqual %bool %s %uint_0
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %merge
+%then = OpLabel
+OpStore %out %mul
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<CodeSinkingPass>(text, true);
+}
+
+TEST_F(CodeSinkTest, SinkThroughNestedSelections) {
+  const std::string text = kHeader + R"(
+; CHECK: OpBranchConditional {{%\w+}} [[then:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK-NOT: OpLoad %float %in
+; CHECK: OpBranchConditional {{%\w+}} [[inner:%\w+]]
+; CHECK: [[inner]] = OpLabel
+; CHECK-NEXT: [[ld:%\w+]] = OpLoad %float %in
+; CHECK-NEXT: [[add:%\w+]] = OpFAdd %float [[ld]] [[ld]]
+; CHECK-NEXT: OpStore %out [[add]]
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %float %in
+%add = OpFAdd %float %ld %ld
+%s = OpLoad %uint %sel
+%cond = OpIEqual %bool %s %uint_0
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %merge
+%then = OpLabel
+OpSelectionMerge %then_merge None
+OpBranchConditional %cond %inner %then_merge
+%inner = OpLabel
+OpStore %out %add
+OpBranch %then_merge
+%then_merge = OpLabel
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<CodeSinkingPass>(text, true);
+}
+
+TEST_F(CodeSinkTest, DontSinkIntoBlockWithSeveralPredecessors) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %float %in
+%mul = OpFMul %float %ld %ld
+%s = OpLoad %uint %sel
+%cond = OpIEqual %bool %s %uint_0
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %merge
+%then = OpLabel
+OpBranch %merge
+%merge = OpLabel
+OpStore %out %mul
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<CodeSinkingPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(CodeSinkTest, DontSinkWhenOperandsBecomeLive) {
+  // Sinking %add would make both %a and %b live out of the entry block in
+  // place of %add.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%a = OpLoad %float %in
+%b = OpFMul %float %a %a
+%cond = OpFOrdLessThan %bool %a %b
+%add = OpFAdd %float %a %b
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %merge
+%then = OpLabel
+OpStore %out %add
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<CodeSinkingPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(CodeSinkTest, DontSinkWritableLoad) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %float %priv
+%s = OpLoad %uint %sel
+%cond = OpIEqual %bool %s %uint_0
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %merge
+%then = OpLabel
+OpStore %out %ld
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<CodeSinkingPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(CodeSinkTest, DontSinkDerivative) {
+  const std::string text = kHeader + R"(
+; CHECK: OpLoad %float %in
+; CHECK: OpDPdx
+; CHECK: OpBranchConditional {{%\w+}} [[then:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK-NEXT: OpStore %out
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %float %in
+%dx = OpDPdx %float %ld
+%s = OpLoad %uint %sel
+%cond = OpIEqual %bool %s %uint_0
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %merge
+%then = OpLabel
+OpStore %out %dx
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<CodeSinkingPass>(text, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,211 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/cost_analysis.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using ::testing::HasSubstr;
+
+// Returns a fragment shader %1 whose loop %30 squares the input %21 while
+// its induction variable %31 is less than |bound|.  The loop body is %40 and
+// its merge block is %50.
+std::string GetLoopShader(const std::string& bound) {
+  return R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %1 "main" %10 %12
+OpExecutionMode %1 OriginUpperLeft
+OpDecorate %10 Flat
+OpDecorate %10 Location 0
+OpDecorate %12 Location 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 1
+%5 = OpTypeBool
+%6 = OpConstant %4 0
+%7 = OpConstant %4 1
+%8 = OpConstant %4 10
+%9 = OpTypePointer Input %4
+%10 = OpVariable %9 Input
+%11 = OpTypePointer Output %4
+%12 = OpVariable %11 Output
+%1 = OpFunction %2 None %3
+%20 = OpLabel
+%21 = OpLoad %4 %10
+OpBranch %30
+%30 = OpLabel
+%31 = OpPhi %4 %6 %20 %41 %40
+%32 = OpPhi %4 %21 %20 %42 %40
+OpLoopMerge %50 %40 None
+%33 = OpSLessThan %5 %31 )" +
+         bound + R"(
+OpBranchConditional %33 %40 %50
+%40 = OpLabel
+%42 = OpIMul %4 %32 %32
+%41 = OpIAdd %4 %31 %7
+OpBranch %30
+%50 = OpLabel
+OpStore %12 %32
+OpReturn
+OpFunctionEnd
+)";
+}
+
+TEST(CostAnalysisTest, ParseCostTable) {
+  CostTable table;
+  std::string error;
+  EXPECT_TRUE(table.ParseText(R"(
+# Latency and issue cycles.
+OpLoad 2 1
+IAdd 3 2   # Without the Op prefix.
+
+default 5 1
+)",
+                              &error));
+  EXPECT_EQ(2, table.GetCost(SpvOpLoad).latency);
+  EXPECT_EQ(1, table.GetCost(SpvOpLoad).issue);
+  EXPECT_EQ(3, table.GetCost(SpvOpIAdd).latency);
+  EXPECT_EQ(2, table.GetCost(SpvOpIAdd).issue);
+  EXPECT_EQ(5, table.GetCost(SpvOpISub).latency);
+  // Opcodes with a built-in cost keep it.
+  EXPECT_EQ(0, table.GetCost(SpvOpLabel).issue);
+}
+
+TEST(CostAnalysisTest, RejectInvalidCostTable) {
+  std::string error;
+  EXPECT_FALSE(CostTable().ParseText("OpLoad 2 1\nOpFoo 1 1\n", &error));
+  EXPECT_THAT(error, HasSubstr("line 2: unknown opcode OpFoo"));
+  EXPECT_FALSE(CostTable().ParseText("OpLoad 2\n", &error));
+  EXPECT_THAT(error, HasSubstr("line 1"));
+  EXPECT_FALSE(CostTable().ParseText("OpLoad 2 1 3\n", &error));
+  EXPECT_FALSE(CostTable().ParseText("OpLoad -2 1\n", &error));
+}
+
+TEST(CostAnalysisTest, BlockCostIsCriticalPathOrIssue) {
+  auto context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, GetLoopShader("%8"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  CostTable table;
+  std::string error;
+  ASSERT_TRUE(table.ParseText("OpLoad 20 1\nOpIMul 4 1\nOpIAdd 4 1\n"
+                              "OpStore 1 1\nOpBranch 0 1\nOpReturn 0 1\n",
+                              &error));
+  CostAnalysis analysis(context.get(), table);
+
+  // The load is followed by the branch: 20 cycles of latency.
+  EXPECT_EQ(20, analysis.GetBlockCost(context->get_instr_block(20)));
+  // The multiplication and the addition are independent, so their 4 cycles of
+  // latency overlap.
+  EXPECT_EQ(4, analysis.GetBlockCost(context->get_instr_block(40)));
+
+  // With less latency, issuing the 3 instructions takes longer.
+  ASSERT_TRUE(table.ParseText("OpIMul 1 1\nOpIAdd 1 1\n", &error));
+  CostAnalysis fast_analysis(context.get(), table);
+  EXPECT_EQ(3, fast_analysis.GetBlockCost(context->get_instr_block(40)));
+}
+
+TEST(CostAnalysisTest, LoopTripCountScalesFrequencies) {
+  auto context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, GetLoopShader("%8"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  CostAnalysis analysis(context.get(), CostTable());
+  Function* func = context->GetFunction(1);
+
+  EXPECT_EQ(10u, analysis.GetTripCount(
+                     &context->GetLoopDescriptor(func)->GetLoopByIndex(0)));
+  std::unordered_map<uint32_t, double> frequencies =
+      analysis.GetBlockFrequencies(func);
+  EXPECT_DOUBLE_EQ(1, frequencies[20]);
+  EXPECT_DOUBLE_EQ(10, frequencies[30]);
+  EXPECT_DOUBLE_EQ(10, frequencies[40]);
+  EXPECT_DOUBLE_EQ(1, frequencies[50]);
+}
+
+TEST(CostAnalysisTest, UnknownTripCountUsesDefault) {
+  auto context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, GetLoopShader("%21"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  CostOptions options;
+  options.default_trip_count = 5;
+  CostAnalysis analysis(context.get(), CostTable(), options);
+
+  std::unordered_map<uint32_t, double> frequencies =
+      analysis.GetBlockFrequencies(context->GetFunction(1));
+  EXPECT_DOUBLE_EQ(5, frequencies[30]);
+  EXPECT_DOUBLE_EQ(5, frequencies[40]);
+  EXPECT_DOUBLE_EQ(1, frequencies[50]);
+}
+
+TEST(CostAnalysisTest, ProfileGivesFrequencies) {
+  auto context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, GetLoopShader("%21"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  CostAnalysis analysis(context.get(), CostTable());
+  analysis.SetProfile({{1, 20, 2}, {1, 30, 30}, {1, 40, 28}, {1, 50, 2}});
+
+  std::unordered_map<uint32_t, double> frequencies =
+      analysis.GetBlockFrequencies(context->GetFunction(1));
+  EXPECT_DOUBLE_EQ(1, frequencies[20]);
+  EXPECT_DOUBLE_EQ(15, frequencies[30]);
+  EXPECT_DOUBLE_EQ(14, frequencies[40]);
+  EXPECT_DOUBLE_EQ(1, frequencies[50]);
+}
+
+TEST(CostAnalysisTest, EstimateEntryPoints) {
+  auto context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, GetLoopShader("%8"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  CostAnalysis analysis(context.get(), CostTable());
+
+  std::vector<EntryPointCost> costs = analysis.EstimateEntryPoints();
+  ASSERT_EQ(1u, costs.size());
+  EXPECT_EQ("main", costs[0].name);
+  EXPECT_EQ(SpvExecutionModelFragment, costs[0].execution_model);
+  EXPECT_EQ(1u, costs[0].function_id);
+  EXPECT_GT(costs[0].max_registers, 0u);
+
+  double expected = 0;
+  for (uint32_t id : {20, 50}) {
+    expected += analysis.GetBlockCost(context->get_instr_block(id));
+  }
+  for (uint32_t id : {30, 40}) {
+    expected += 10 * analysis.GetBlockCost(context->get_instr_block(id));
+  }
+  EXPECT_DOUBLE_EQ(expected, costs[0].cycles);
+
+  // Spilling the values above the budget makes the shader slower.
+  CostOptions options;
+  options.register_budget = 1;
+  CostAnalysis spilling_analysis(context.get(), CostTable(), options);
+  EXPECT_GT(spilling_analysis.EstimateEntryPoints()[0].cycles, expected);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,168 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/opt/assembly_builder.h"
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using DeadStoreElimTest = PassTest<::testing::Test>;
+
+const std::string kHeader = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%uint = OpTypeInt 32 0
+%uint_1 = OpConstant %uint 1
+%uint_2 = OpConstant %uint 2
+%uint_3 = OpConstant %uint 3
+%uint_264 = OpConstant %uint 264
+%_ptr_Workgroup_uint = OpTypePointer Workgroup %uint
+%_ptr_Function_uint = OpTypePointer Function %uint
+%a = OpVariable %_ptr_Workgroup_uint Workgroup
+%b = OpVariable %_ptr_Workgroup_uint Workgroup
+)";
+
+TEST_F(DeadStoreElimTest, RemoveOverwrittenStore) {
+  const std::string text = kHeader + R"(
+; CHECK-NOT: OpStore %a %uint_1
+; CHECK: OpLoad %uint %b
+; CHECK: OpStore %a
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpStore %a %uint_1
+OpBranch %next
+%next = OpLabel
+%x = OpLoad %uint %b
+OpStore %a %x
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<DeadStoreElimPass>(text, true);
+}
+
+TEST_F(DeadStoreElimTest, RemoveStoreOverwrittenOnAllPaths) {
+  const std::string text = kHeader + R"(
+; CHECK-NOT: OpStore %a %uint_1
+; CHECK: OpStore %a %uint_2
+; CHECK: OpStore %a %uint_3
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpStore %a %uint_1
+OpSelectionMerge %merge None
+OpBranchConditional %true %then %else
+%then = OpLabel
+OpStore %a %uint_2
+OpBranch %merge
+%else = OpLabel
+OpStore %a %uint_3
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<DeadStoreElimPass>(text, true);
+}
+
+TEST_F(DeadStoreElimTest, KeepStoreReadBeforeOverwrite) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpStore %a %uint_1
+%x = OpLoad %uint %a
+OpStore %b %x
+OpStore %a %uint_2
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<DeadStoreElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(DeadStoreElimTest, KeepStoreBeforeBarrier) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpStore %a %uint_1
+OpControlBarrier %uint_2 %uint_2 %uint_264
+OpStore %a %uint_2
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<DeadStoreElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(DeadStoreElimTest, KeepStoreOverwrittenOnOnePath) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpStore %a %uint_1
+OpSelectionMerge %merge None
+OpBranchConditional %true %then %merge
+%then = OpLabel
+OpStore %a %uint_2
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<DeadStoreElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(DeadStoreElimTest, IgnoreFunctionStorage) {
+  // Stores to function variables are left to the local store passes.
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%v = OpVariable %_ptr_Function_uint Function
+OpStore %v %uint_1
+OpStore %v %uint_2
+%x = OpLoad %uint %v
+OpStore %a %x
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<DeadStoreElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
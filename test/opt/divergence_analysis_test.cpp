@@ -0,0 +1,313 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/divergence_analysis.h"
+#include "source/opt/ir_builder.h"
+#include "source/opt/ir_context.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using DivergenceAnalysisTest = PassTest<::testing::Test>;
+
+TEST_F(DivergenceAnalysisTest, Sources) {
+  // %10 is the local invocation id, %11 the workgroup id, and %12 a uniform
+  // buffer.
+  const std::string text = R"(
+OpCapability Shader
+OpCapability GroupNonUniform
+OpCapability GroupNonUniformArithmetic
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main" %10 %11
+OpExecutionMode %1 LocalSize 64 1 1
+OpDecorate %10 BuiltIn LocalInvocationId
+OpDecorate %11 BuiltIn WorkgroupId
+OpDecorate %20 Block
+OpMemberDecorate %20 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypeVector %4 3
+%6 = OpTypePointer Input %5
+%7 = OpTypeBool
+%8 = OpConstant %4 0
+%9 = OpConstant %4 1
+%13 = OpConstant %4 3
+%10 = OpVariable %6 Input
+%11 = OpVariable %6 Input
+%20 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %20
+%22 = OpTypePointer Uniform %4
+%12 = OpVariable %21 Uniform
+%23 = OpTypePointer Workgroup %4
+%24 = OpVariable %23 Workgroup
+%1 = OpFunction %2 None %3
+%30 = OpLabel
+%31 = OpLoad %5 %10
+%32 = OpCompositeExtract %4 %31 0
+%33 = OpLoad %5 %11
+%34 = OpCompositeExtract %4 %33 0
+%35 = OpAccessChain %22 %12 %8
+%36 = OpLoad %4 %35
+%37 = OpIAdd %4 %34 %36
+%38 = OpIAdd %4 %32 %36
+%39 = OpAtomicIAdd %4 %24 %9 %8 %9
+%40 = OpGroupNonUniformIAdd %4 %13 Reduce %32
+%41 = OpGroupNonUniformIAdd %4 %13 InclusiveScan %34
+%42 = OpGroupNonUniformElect %7 %13
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  DivergenceAnalysis* divergence = context->GetDivergenceAnalysis();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(31)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(32)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(34)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(36)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(37)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(38)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(39)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(40)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(41)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(42)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(12)));
+}
+
+TEST_F(DivergenceAnalysisTest, PhiAtJoinOfDivergentBranch) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability GroupNonUniform
+OpCapability GroupNonUniformArithmetic
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main" %10 %11
+OpExecutionMode %1 LocalSize 64 1 1
+OpDecorate %10 BuiltIn LocalInvocationId
+OpDecorate %11 BuiltIn WorkgroupId
+OpDecorate %20 Block
+OpMemberDecorate %20 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypeVector %4 3
+%6 = OpTypePointer Input %5
+%7 = OpTypeBool
+%8 = OpConstant %4 0
+%9 = OpConstant %4 1
+%13 = OpConstant %4 3
+%10 = OpVariable %6 Input
+%11 = OpVariable %6 Input
+%20 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %20
+%22 = OpTypePointer Uniform %4
+%12 = OpVariable %21 Uniform
+%23 = OpTypePointer Workgroup %4
+%24 = OpVariable %23 Workgroup
+%1 = OpFunction %2 None %3
+%30 = OpLabel
+%31 = OpLoad %5 %10
+%32 = OpCompositeExtract %4 %31 0
+%33 = OpULessThan %7 %32 %13
+OpSelectionMerge %35 None
+OpBranchConditional %33 %34 %35
+%34 = OpLabel
+OpBranch %35
+%35 = OpLabel
+%36 = OpPhi %4 %8 %30 %9 %34
+%37 = OpLoad %5 %11
+%38 = OpCompositeExtract %4 %37 0
+%39 = OpULessThan %7 %38 %13
+OpSelectionMerge %41 None
+OpBranchConditional %39 %40 %41
+%40 = OpLabel
+OpBranch %41
+%41 = OpLabel
+%42 = OpPhi %4 %8 %35 %9 %40
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  DivergenceAnalysis* divergence = context->GetDivergenceAnalysis();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  EXPECT_TRUE(divergence->IsDivergentBranch(context->cfg()->block(30)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(36)));
+  EXPECT_FALSE(divergence->IsDivergentBranch(context->cfg()->block(35)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(42)));
+}
+
+TEST_F(DivergenceAnalysisTest, ValuesLeavingLoopWithDivergentExit) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability GroupNonUniform
+OpCapability GroupNonUniformArithmetic
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main" %10 %11
+OpExecutionMode %1 LocalSize 64 1 1
+OpDecorate %10 BuiltIn LocalInvocationId
+OpDecorate %11 BuiltIn WorkgroupId
+OpDecorate %20 Block
+OpMemberDecorate %20 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypeVector %4 3
+%6 = OpTypePointer Input %5
+%7 = OpTypeBool
+%8 = OpConstant %4 0
+%9 = OpConstant %4 1
+%13 = OpConstant %4 3
+%10 = OpVariable %6 Input
+%11 = OpVariable %6 Input
+%20 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %20
+%22 = OpTypePointer Uniform %4
+%12 = OpVariable %21 Uniform
+%23 = OpTypePointer Workgroup %4
+%24 = OpVariable %23 Workgroup
+%1 = OpFunction %2 None %3
+%30 = OpLabel
+%31 = OpLoad %5 %10
+%32 = OpCompositeExtract %4 %31 0
+OpBranch %33
+%33 = OpLabel
+%34 = OpPhi %4 %8 %30 %35 %36
+%35 = OpIAdd %4 %34 %9
+%37 = OpULessThan %7 %35 %32
+OpLoopMerge %38 %36 None
+OpBranchConditional %37 %36 %38
+%36 = OpLabel
+OpBranch %33
+%38 = OpLabel
+%39 = OpIAdd %4 %35 %9
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  DivergenceAnalysis* divergence = context->GetDivergenceAnalysis();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  // The counter is the same for the invocations still in the loop, but they
+  // leave it in different iterations.
+  EXPECT_TRUE(divergence->IsDivergentBranch(context->cfg()->block(33)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(34)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(35)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(39)));
+}
+
+TEST_F(DivergenceAnalysisTest, Decorations) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main" %10
+OpExecutionMode %1 LocalSize 64 1 1
+OpDecorate %10 BuiltIn LocalInvocationId
+OpDecorate %32 Uniform
+OpDecorate %34 NonUniformEXT
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypeVector %4 3
+%6 = OpTypePointer Input %5
+%8 = OpConstant %4 0
+%10 = OpVariable %6 Input
+%1 = OpFunction %2 None %3
+%30 = OpLabel
+%31 = OpLoad %5 %10
+%32 = OpCompositeExtract %4 %31 0
+%33 = OpIAdd %4 %32 %8
+%34 = OpIAdd %4 %8 %8
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  DivergenceAnalysis* divergence = context->GetDivergenceAnalysis();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(31)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(32)));
+  EXPECT_TRUE(divergence->IsUniform(def_use_mgr->GetDef(33)));
+  EXPECT_TRUE(divergence->IsDivergent(def_use_mgr->GetDef(34)));
+}
+
+TEST_F(DivergenceAnalysisTest, ValuesCreatedAfterAnalysisAreDivergent) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability GroupNonUniform
+OpCapability GroupNonUniformArithmetic
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main" %10 %11
+OpExecutionMode %1 LocalSize 64 1 1
+OpDecorate %10 BuiltIn LocalInvocationId
+OpDecorate %11 BuiltIn WorkgroupId
+OpDecorate %20 Block
+OpMemberDecorate %20 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypeVector %4 3
+%6 = OpTypePointer Input %5
+%7 = OpTypeBool
+%8 = OpConstant %4 0
+%9 = OpConstant %4 1
+%13 = OpConstant %4 3
+%10 = OpVariable %6 Input
+%11 = OpVariable %6 Input
+%20 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %20
+%22 = OpTypePointer Uniform %4
+%12 = OpVariable %21 Uniform
+%23 = OpTypePointer Workgroup %4
+%24 = OpVariable %23 Workgroup
+%1 = OpFunction %2 None %3
+%30 = OpLabel
+%31 = OpIAdd %4 %8 %9
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  DivergenceAnalysis* divergence = context->GetDivergenceAnalysis();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+  Instruction* add = def_use_mgr->GetDef(31);
+  EXPECT_TRUE(divergence->IsUniform(add));
+
+  // The analysis does not know the new value, although it is uniform.
+  InstructionBuilder builder(
+      context.get(), add,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  Instruction* new_add = builder.AddIAdd(4, 8, 9);
+  EXPECT_TRUE(divergence->IsDivergent(new_add));
+  EXPECT_TRUE(divergence->IsUniform(add));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
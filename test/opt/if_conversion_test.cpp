@@ -467,6 +467,78 @@ OpFunctionEnd
   SinglePassRunAndCheck<IfConversion>(text, text, true, true);
 }
 
+TEST_F(IfConversionTest, SpeculateUnderDivergentBranch) {
+  const std::string text = R"(
+; CHECK: [[add:%\w+]] = OpIAdd %uint
+; CHECK-NEXT: OpSelectionMerge [[merge:%\w+]]
+; CHECK: [[merge]] = OpLabel
+; CHECK-NOT: OpPhi
+; CHECK: [[sel:%\w+]] = OpSelect %uint {{%\w+}} [[add]] %uint_0
+; CHECK: OpStore {{%\w+}} [[sel]]
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %1 "func" %2 %3
+%void = OpTypeVoid
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Output_uint = OpTypePointer Output %uint
+%_ptr_Input_uint = OpTypePointer Input %uint
+%2 = OpVariable %_ptr_Output_uint Output
+%3 = OpVariable %_ptr_Input_uint Input
+%8 = OpTypeFunction %void
+%bool = OpTypeBool
+%1 = OpFunction %void None %8
+%11 = OpLabel
+%in = OpLoad %uint %3
+%cond = OpIEqual %bool %in %uint_0
+OpSelectionMerge %12 None
+OpBranchConditional %cond %13 %12
+%13 = OpLabel
+%14 = OpIAdd %uint %in %uint_1
+OpBranch %12
+%12 = OpLabel
+%15 = OpPhi %uint %uint_0 %11 %14 %13
+OpStore %2 %15
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<IfConversion>(text, true);
+}
+
+TEST_F(IfConversionTest, DontSpeculateLoad) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %1 "func" %2 %3
+%void = OpTypeVoid
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%_ptr_Output_uint = OpTypePointer Output %uint
+%_ptr_Input_uint = OpTypePointer Input %uint
+%2 = OpVariable %_ptr_Output_uint Output
+%3 = OpVariable %_ptr_Input_uint Input
+%8 = OpTypeFunction %void
+%bool = OpTypeBool
+%1 = OpFunction %void None %8
+%11 = OpLabel
+%12 = OpLoad %uint %3
+%13 = OpIEqual %bool %12 %uint_0
+OpSelectionMerge %14 None
+OpBranchConditional %13 %15 %14
+%15 = OpLabel
+%16 = OpLoad %uint %3
+OpBranch %14
+%14 = OpLabel
+%17 = OpPhi %uint %uint_0 %11 %16 %15
+OpStore %2 %17
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<IfConversion>(text, text, true, true);
+}
+
 TEST_F(IfConversionTest, InvalidCommonDominator) {
   const std::string text = R"(OpCapability Shader
 OpCapability Linkage
@@ -0,0 +1,394 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/inline_heuristic_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InlineHeuristicTest = PassTest<::testing::Test>;
+
+TEST_F(InlineHeuristicTest, InlineSmallCallee) {
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %small "small"
+OpName %in "in"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %float %in
+%a = OpFunctionCall %float %small %x
+%b = OpFunctionCall %float %small %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%small = OpFunction %float None %fn_float
+%sx = OpFunctionParameter %float
+%small_entry = OpLabel
+%s0 = OpFMul %float %sx %sx
+%s1 = OpFMul %float %s0 %float_2
+OpReturnValue %s1
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InlineHeuristicPass>(text, true, 1024u);
+}
+
+TEST_F(InlineHeuristicTest, DontInlineLargeCalleeCalledTwice) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %large "large"
+OpName %in "in"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%fn_float = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %float %in
+%a = OpFunctionCall %float %large %x
+%b = OpFunctionCall %float %large %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%large = OpFunction %float None %fn_float
+%lx = OpFunctionParameter %float
+%large_entry = OpLabel
+%l0 = OpFMul %float %lx %lx
+%l1 = OpFMul %float %l0 %lx
+%l2 = OpFMul %float %l1 %lx
+%l3 = OpFMul %float %l2 %lx
+%l4 = OpFMul %float %l3 %lx
+%l5 = OpFMul %float %l4 %lx
+%l6 = OpFMul %float %l5 %lx
+%l7 = OpFMul %float %l6 %lx
+%l8 = OpFMul %float %l7 %lx
+%l9 = OpFMul %float %l8 %lx
+%l10 = OpFMul %float %l9 %lx
+%l11 = OpFMul %float %l10 %lx
+%l12 = OpFMul %float %l11 %lx
+%l13 = OpFMul %float %l12 %lx
+%l14 = OpFMul %float %l13 %lx
+%l15 = OpFMul %float %l14 %lx
+%l16 = OpFMul %float %l15 %lx
+%l17 = OpFMul %float %l16 %lx
+%l18 = OpFMul %float %l17 %lx
+%l19 = OpFMul %float %l18 %lx
+%l20 = OpFMul %float %l19 %lx
+%l21 = OpFMul %float %l20 %lx
+%l22 = OpFMul %float %l21 %lx
+%l23 = OpFMul %float %l22 %lx
+%l24 = OpFMul %float %l23 %lx
+%l25 = OpFMul %float %l24 %lx
+%l26 = OpFMul %float %l25 %lx
+%l27 = OpFMul %float %l26 %lx
+%l28 = OpFMul %float %l27 %lx
+%l29 = OpFMul %float %l28 %lx
+OpReturnValue %l29
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<InlineHeuristicPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false, 1024u);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(InlineHeuristicTest, InlineLargeCalleeCalledOnce) {
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %large "large"
+OpName %in "in"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%fn_float = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %float %in
+%a = OpFunctionCall %float %large %x
+OpStore %out %a
+OpReturn
+OpFunctionEnd
+%large = OpFunction %float None %fn_float
+%lx = OpFunctionParameter %float
+%large_entry = OpLabel
+%l0 = OpFMul %float %lx %lx
+%l1 = OpFMul %float %l0 %lx
+%l2 = OpFMul %float %l1 %lx
+%l3 = OpFMul %float %l2 %lx
+%l4 = OpFMul %float %l3 %lx
+%l5 = OpFMul %float %l4 %lx
+%l6 = OpFMul %float %l5 %lx
+%l7 = OpFMul %float %l6 %lx
+%l8 = OpFMul %float %l7 %lx
+%l9 = OpFMul %float %l8 %lx
+%l10 = OpFMul %float %l9 %lx
+%l11 = OpFMul %float %l10 %lx
+%l12 = OpFMul %float %l11 %lx
+%l13 = OpFMul %float %l12 %lx
+%l14 = OpFMul %float %l13 %lx
+%l15 = OpFMul %float %l14 %lx
+%l16 = OpFMul %float %l15 %lx
+%l17 = OpFMul %float %l16 %lx
+%l18 = OpFMul %float %l17 %lx
+%l19 = OpFMul %float %l18 %lx
+%l20 = OpFMul %float %l19 %lx
+%l21 = OpFMul %float %l20 %lx
+%l22 = OpFMul %float %l21 %lx
+%l23 = OpFMul %float %l22 %lx
+%l24 = OpFMul %float %l23 %lx
+%l25 = OpFMul %float %l24 %lx
+%l26 = OpFMul %float %l25 %lx
+%l27 = OpFMul %float %l26 %lx
+%l28 = OpFMul %float %l27 %lx
+%l29 = OpFMul %float %l28 %lx
+OpReturnValue %l29
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InlineHeuristicPass>(text, true, 0u);
+}
+
+TEST_F(InlineHeuristicTest, InlineLargeCalleeInLoop) {
+  // The threshold is doubled in the loop, so only the call in the loop is
+  // inlined.
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK: [[x:%\w+]] = OpLoad %float %in
+; CHECK-NEXT: OpFunctionCall %float %large [[x]]
+; CHECK: OpLoopMerge
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %large "large"
+OpName %in "in"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%float = OpTypeFloat 32
+%fn_float = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %float %in
+%a = OpFunctionCall %float %large %x
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %inc %continue
+%f = OpPhi %float %a %entry %b %continue
+%cond = OpSLessThan %bool %i %int_4
+OpLoopMerge %merge %continue None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%b = OpFunctionCall %float %large %f
+OpBranch %continue
+%continue = OpLabel
+%inc = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpStore %out %f
+OpReturn
+OpFunctionEnd
+%large = OpFunction %float None %fn_float
+%lx = OpFunctionParameter %float
+%large_entry = OpLabel
+%l0 = OpFMul %float %lx %lx
+%l1 = OpFMul %float %l0 %lx
+%l2 = OpFMul %float %l1 %lx
+%l3 = OpFMul %float %l2 %lx
+%l4 = OpFMul %float %l3 %lx
+%l5 = OpFMul %float %l4 %lx
+%l6 = OpFMul %float %l5 %lx
+%l7 = OpFMul %float %l6 %lx
+%l8 = OpFMul %float %l7 %lx
+%l9 = OpFMul %float %l8 %lx
+%l10 = OpFMul %float %l9 %lx
+%l11 = OpFMul %float %l10 %lx
+%l12 = OpFMul %float %l11 %lx
+%l13 = OpFMul %float %l12 %lx
+%l14 = OpFMul %float %l13 %lx
+%l15 = OpFMul %float %l14 %lx
+%l16 = OpFMul %float %l15 %lx
+%l17 = OpFMul %float %l16 %lx
+%l18 = OpFMul %float %l17 %lx
+%l19 = OpFMul %float %l18 %lx
+%l20 = OpFMul %float %l19 %lx
+%l21 = OpFMul %float %l20 %lx
+%l22 = OpFMul %float %l21 %lx
+%l23 = OpFMul %float %l22 %lx
+%l24 = OpFMul %float %l23 %lx
+%l25 = OpFMul %float %l24 %lx
+%l26 = OpFMul %float %l25 %lx
+%l27 = OpFMul %float %l26 %lx
+%l28 = OpFMul %float %l27 %lx
+%l29 = OpFMul %float %l28 %lx
+OpReturnValue %l29
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InlineHeuristicPass>(text, true, 1024u);
+}
+
+TEST_F(InlineHeuristicTest, RespectSizeBudget) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %small "small"
+OpName %in "in"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %float %in
+%a = OpFunctionCall %float %small %x
+%b = OpFunctionCall %float %small %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%small = OpFunction %float None %fn_float
+%sx = OpFunctionParameter %float
+%small_entry = OpLabel
+%s0 = OpFMul %float %sx %sx
+%s1 = OpFMul %float %s0 %float_2
+OpReturnValue %s1
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<InlineHeuristicPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false, 2u);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(InlineHeuristicTest, AlwaysInlinePointerArguments) {
+  // The budget does not apply to calls that legalization requires to inline.
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NEXT: {{%\w+}} = OpLabel
+; CHECK-NEXT: [[v:%\w+]] = OpVariable %_ptr_Function_float Function
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpStore [[v]] %float_2
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %store "store"
+OpName %in "in"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_2 = OpConstant %float 2
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%_ptr_Function_float = OpTypePointer Function %float
+%fn_ptr = OpTypeFunction %void %_ptr_Function_float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%v = OpVariable %_ptr_Function_float Function
+%c1 = OpFunctionCall %void %store %v
+%c2 = OpFunctionCall %void %store %v
+%ld = OpLoad %float %v
+OpStore %out %ld
+OpReturn
+OpFunctionEnd
+%store = OpFunction %void None %fn_ptr
+%p = OpFunctionParameter %_ptr_Function_float
+%store_entry = OpLabel
+OpStore %p %float_2
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InlineHeuristicPass>(text, true, 0u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -1845,6 +1845,132 @@ OpFunctionEnd
 //
 // TODO(greg-lunarg): Come up with cases to put here :)
 
+const std::string kBindlessPreamble = R"(
+OpCapability Shader
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %MainPs "MainPs" %i_vTextureCoords %_entryPointOutput_vColor
+OpExecutionMode %MainPs OriginUpperLeft
+)";
+
+const std::string kBindlessDefs = R"(
+OpDecorate %g_tColor DescriptorSet 3
+OpDecorate %g_tColor Binding 0
+OpMemberDecorate %PerViewConstantBuffer_t 0 Offset 0
+OpDecorate %PerViewConstantBuffer_t Block
+OpDecorate %g_sAniso DescriptorSet 0
+OpDecorate %i_vTextureCoords Location 0
+OpDecorate %_entryPointOutput_vColor Location 0
+%void = OpTypeVoid
+%10 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%v2float = OpTypeVector %float 2
+%v4float = OpTypeVector %float 4
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%16 = OpTypeImage %float 2D 0 0 0 1 Unknown
+%uint = OpTypeInt 32 0
+%uint_128 = OpConstant %uint 128
+%_arr_16_uint_128 = OpTypeArray %16 %uint_128
+%_ptr_UniformConstant__arr_16_uint_128 = OpTypePointer UniformConstant %_arr_16_uint_128
+%g_tColor = OpVariable %_ptr_UniformConstant__arr_16_uint_128 UniformConstant
+%PerViewConstantBuffer_t = OpTypeStruct %uint
+%_ptr_PushConstant_PerViewConstantBuffer_t = OpTypePointer PushConstant %PerViewConstantBuffer_t
+%_ = OpVariable %_ptr_PushConstant_PerViewConstantBuffer_t PushConstant
+%_ptr_PushConstant_uint = OpTypePointer PushConstant %uint
+%_ptr_UniformConstant_16 = OpTypePointer UniformConstant %16
+%24 = OpTypeSampler
+%_ptr_UniformConstant_24 = OpTypePointer UniformConstant %24
+%g_sAniso = OpVariable %_ptr_UniformConstant_24 UniformConstant
+%26 = OpTypeSampledImage %16
+%_ptr_Input_v2float = OpTypePointer Input %v2float
+%i_vTextureCoords = OpVariable %_ptr_Input_v2float Input
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%_entryPointOutput_vColor = OpVariable %_ptr_Output_v4float Output
+)";
+
+TEST_F(InstBindlessTest, ShareDominatingCheck) {
+  // The second sample uses the same descriptor index as the first one, so it
+  // reuses its bounds test and does not write a second error record.
+  const std::string text = R"(
+; CHECK: [[ult:%\w+]] = OpULessThan %bool %idx %uint_128
+; CHECK: OpBranchConditional [[ult]]
+; CHECK: OpFunctionCall %void
+; CHECK-NOT: OpULessThan %bool %idx
+; CHECK: OpBranchConditional [[ult]] [[valid:%\w+]] [[invalid:%\w+]]
+; CHECK: [[invalid]] = OpLabel
+; CHECK-NEXT: OpBranch
+)" + kBindlessPreamble + R"(
+OpName %idx "idx"
+)" + kBindlessDefs + R"(
+%MainPs = OpFunction %void None %10
+%entry = OpLabel
+%coord = OpLoad %v2float %i_vTextureCoords
+%idx_ptr = OpAccessChain %_ptr_PushConstant_uint %_ %int_0
+%idx = OpLoad %uint %idx_ptr
+%tex_ptr = OpAccessChain %_ptr_UniformConstant_16 %g_tColor %idx
+%sampler = OpLoad %24 %g_sAniso
+%tex1 = OpLoad %16 %tex_ptr
+%si1 = OpSampledImage %26 %tex1 %sampler
+%s1 = OpImageSampleImplicitLod %v4float %si1 %coord
+%tex2 = OpLoad %16 %tex_ptr
+%si2 = OpSampledImage %26 %tex2 %sampler
+%s2 = OpImageSampleImplicitLod %v4float %si2 %coord
+%sum = OpFAdd %v4float %s1 %s2
+OpStore %_entryPointOutput_vColor %sum
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstBindlessCheckPass>(text, true);
+}
+
+TEST_F(InstBindlessTest, HoistLoopInvariantCheck) {
+  // The descriptor index does not change in the loop, so its bounds test is
+  // done once in the preheader.
+  const std::string text = R"(
+; CHECK: [[ult:%\w+]] = OpULessThan %bool %idx %uint_128
+; CHECK-NEXT: OpBranch %header
+; CHECK: OpLoopMerge
+; CHECK-NOT: OpULessThan %bool %idx
+; CHECK: OpBranchConditional [[ult]]
+)" + kBindlessPreamble + R"(
+OpName %idx "idx"
+OpName %header "header"
+)" + kBindlessDefs + R"(
+%MainPs = OpFunction %void None %10
+%entry = OpLabel
+%coord = OpLoad %v2float %i_vTextureCoords
+%idx_ptr = OpAccessChain %_ptr_PushConstant_uint %_ %int_0
+%idx = OpLoad %uint %idx_ptr
+%tex_ptr = OpAccessChain %_ptr_UniformConstant_16 %g_tColor %idx
+%sampler = OpLoad %24 %g_sAniso
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %inc %continue
+%cond = OpSLessThan %bool %i %int_4
+OpLoopMerge %merge %continue None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%tex = OpLoad %16 %tex_ptr
+%si = OpSampledImage %26 %tex %sampler
+%s = OpImageSampleImplicitLod %v4float %si %coord
+OpStore %_entryPointOutput_vColor %s
+OpBranch %continue
+%continue = OpLabel
+%inc = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstBindlessCheckPass>(text, true);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,375 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/inst_profile_pass.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/optimizer.hpp"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InstProfileTest = PassTest<::testing::Test>;
+
+TEST_F(InstProfileTest, CountBlocks) {
+  const std::string text = R"(
+; CHECK: OpDecorate [[buf:%\w+]] DescriptorSet 7
+; CHECK: OpDecorate [[buf]] Binding 1
+; CHECK: %entry = OpLabel
+; CHECK-NEXT: %x = OpVariable
+; CHECK-NEXT: [[ptr0:%\w+]] = OpAccessChain {{%\w+}} [[buf]] %uint_1 %uint_0
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr0]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpStore %x %int_0
+; CHECK: %exit = OpLabel
+; CHECK-NEXT: [[ptr1:%\w+]] = OpAccessChain {{%\w+}} [[buf]] %uint_1 %uint_1
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr1]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpReturn
+
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %entry "entry"
+OpName %x "x"
+OpName %exit "exit"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Function_int = OpTypePointer Function %int
+%in = OpVariable %_ptr_Input_int Input
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpVariable %_ptr_Function_int Function
+OpStore %x %int_0
+OpBranch %exit
+%exit = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstProfilePass>(text, false);
+}
+
+TEST_F(InstProfileTest, CountEdgesOutsideSpanningTree) {
+  // Of the five edges, counting the edge from %else to %merge and the
+  // virtual edge from %merge back to %entry is enough.
+  const std::string text = R"(
+; CHECK: %then = OpLabel
+; CHECK-NOT: OpAtomicIAdd
+; CHECK: %else = OpLabel
+; CHECK-NEXT: [[ptr0:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_0
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr0]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpBranch %merge
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: [[ptr1:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_1
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr1]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpReturn
+
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Function_int = OpTypePointer Function %int
+%in = OpVariable %_ptr_Input_int Input
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%n = OpLoad %int %in
+%cond = OpSLessThan %bool %n %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %cond %then %else
+%then = OpLabel
+OpBranch %merge
+%else = OpLabel
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstProfilePass>(text, false, 7u, true);
+}
+
+TEST_F(InstProfileTest, CountBackEdgeOfLoop) {
+  // A cycle of the loop must be counted, and the edges of the loop are
+  // preferred for the spanning tree, so only the back edge is counted.
+  const std::string text = R"(
+; CHECK: %header = OpLabel
+; CHECK-NOT: OpAtomicIAdd
+; CHECK: %cont = OpLabel
+; CHECK-NEXT: %inc = OpIAdd %int %i %int_1
+; CHECK-NEXT: [[ptr0:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_0
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr0]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpBranch %header
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: [[ptr1:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_1
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr1]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpReturn
+
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %header "header"
+OpName %i "i"
+OpName %cont "cont"
+OpName %inc "inc"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Function_int = OpTypePointer Function %int
+%in = OpVariable %_ptr_Input_int Input
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%n = OpLoad %int %in
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %inc %cont
+%cond = OpSLessThan %bool %i %n
+OpLoopMerge %merge %cont None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+OpBranch %cont
+%cont = OpLabel
+%inc = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstProfilePass>(text, false, 7u, true);
+}
+
+TEST_F(InstProfileTest, SplitCriticalEdgeButNotBackEdge) {
+  // The edges from %header and %cont to %merge and the back edge are all
+  // critical.  The back edge cannot be split, since the new block would be
+  // the back-edge block without post-dominating the continue target, so it
+  // goes in the spanning tree and the edge from %cont to %merge is split.
+  const std::string text = R"(
+; CHECK: %cont = OpLabel
+; CHECK-NEXT: [[ptr0:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_0
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr0]] %uint_1 %uint_0 %uint_1
+; CHECK: OpBranchConditional %again [[split:%\w+]] %header
+; CHECK-NEXT: [[split]] = OpLabel
+; CHECK-NEXT: [[ptr1:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_1
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr1]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpBranch %merge
+; CHECK-NEXT: %merge = OpLabel
+; CHECK-NEXT: [[ptr2:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 {{%\w+}}
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr2]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpReturn
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %header "header"
+OpName %cont "cont"
+OpName %again "again"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Function_int = OpTypePointer Function %int
+%in = OpVariable %_ptr_Input_int Input
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%n = OpLoad %int %in
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %inc %cont
+%cond = OpSLessThan %bool %i %n
+OpLoopMerge %merge %cont None
+OpBranchConditional %cond %cont %merge
+%cont = OpLabel
+%inc = OpIAdd %int %i %int_1
+%again = OpSLessThan %bool %inc %int_1
+OpBranchConditional %again %merge %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstProfilePass>(text, true, 7u, true);
+}
+
+TEST_F(InstProfileTest, DontSplitSwitchEdge) {
+  // The edge from the switch to %merge is critical, but splitting it would
+  // make a case construct of the new block, so the edges from %a and %b are
+  // counted instead.
+  const std::string text = R"(
+; CHECK: OpSwitch %n %merge 0 %a 1 %b
+; CHECK-NEXT: %a = OpLabel
+; CHECK-NEXT: [[ptr0:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_0
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr0]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpBranch %merge
+; CHECK-NEXT: %b = OpLabel
+; CHECK-NEXT: [[ptr1:%\w+]] = OpAccessChain {{%\w+}} {{%\w+}} %uint_1 %uint_1
+; CHECK-NEXT: {{%\w+}} = OpAtomicIAdd %uint [[ptr1]] %uint_1 %uint_0 %uint_1
+; CHECK-NEXT: OpBranch %merge
+; CHECK-NEXT: %merge = OpLabel
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Function_int = OpTypePointer Function %int
+%in = OpVariable %_ptr_Input_int Input
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%n = OpLoad %int %in
+OpSelectionMerge %merge None
+OpSwitch %n %merge 0 %a 1 %b
+%a = OpLabel
+OpBranch %merge
+%b = OpLabel
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstProfilePass>(text, true, 7u, true);
+}
+
+TEST_F(InstProfileTest, ReadBackBlockCounts) {
+  // A loop running |in| times.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Function_int = OpTypePointer Function %int
+%in = OpVariable %_ptr_Input_int Input
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%n = OpLoad %int %in
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %inc %cont
+%cond = OpSLessThan %bool %i %n
+OpLoopMerge %merge %cont None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+OpBranch %cont
+%cont = OpLabel
+%inc = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_1);
+  ASSERT_TRUE(tools.Assemble(text, &binary));
+  ASSERT_EQ(2u, GetProfileCounterCount(SPV_ENV_UNIVERSAL_1_1, binary, true));
+
+  // The back edge was taken 10 times, and the function was called once.
+  const std::vector<uint32_t> counters = {10, 1};
+  std::vector<ProfileBlockCount> counts;
+  ASSERT_TRUE(GetProfileBlockCounts(SPV_ENV_UNIVERSAL_1_1, binary, true,
+                                    counters.data(), counters.size(),
+                                    &counts));
+  std::vector<uint64_t> block_counts;
+  for (const auto& count : counts) block_counts.push_back(count.count);
+  EXPECT_THAT(block_counts, ::testing::ElementsAre(1, 11, 10, 10, 1));
+
+  // The number of counters must match the module.
+  EXPECT_FALSE(GetProfileBlockCounts(SPV_ENV_UNIVERSAL_1_1, binary, true,
+                                     counters.data(), 1, &counts));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
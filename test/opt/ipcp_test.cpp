@@ -0,0 +1,243 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/ipcp_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using IPCPTest = PassTest<::testing::Test>;
+
+TEST_F(IPCPTest, PropagateArgumentSharedByAllCalls) {
+  const std::string text = R"(
+; CHECK: OpName %mode "mode"
+; CHECK: %a = OpFunctionCall %int %f %int_1 %ld
+; CHECK: %b = OpFunctionCall %int %f %int_1 %a
+; CHECK: %f = OpFunction
+; CHECK: %r = OpIMul %int %int_1 %x
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %mode "mode"
+OpName %x "x"
+OpName %r "r"
+OpName %ld "ld"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%fn_int = OpTypeFunction %int %int %int
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %int %in
+%a = OpFunctionCall %int %f %int_1 %ld
+%b = OpFunctionCall %int %f %int_1 %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%f = OpFunction %int None %fn_int
+%mode = OpFunctionParameter %int
+%x = OpFunctionParameter %int
+%f_entry = OpLabel
+%r = OpIMul %int %mode %x
+OpReturnValue %r
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<IPCPPass>(text, true, 1024u);
+}
+
+TEST_F(IPCPTest, SpecializeForEachConstant) {
+  const std::string text = R"(
+; CHECK: %a = OpFunctionCall %int [[f1:%\w+]] %int_1 %ld
+; CHECK: %b = OpFunctionCall %int [[f2:%\w+]] %int_2 %a
+; CHECK: {{%\w+}} = OpFunctionCall %int [[f1]] %int_1 %b
+; CHECK: %f = OpFunction
+; CHECK: %r = OpIMul %int %mode %x
+; CHECK: [[f1]] = OpFunction %int None {{%\w+}}
+; CHECK: OpIMul %int %int_1
+; CHECK: [[f2]] = OpFunction %int None {{%\w+}}
+; CHECK: OpIMul %int %int_2
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %mode "mode"
+OpName %x "x"
+OpName %r "r"
+OpName %ld "ld"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%fn_int = OpTypeFunction %int %int %int
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %int %in
+%a = OpFunctionCall %int %f %int_1 %ld
+%b = OpFunctionCall %int %f %int_2 %a
+%c = OpFunctionCall %int %f %int_1 %b
+OpStore %out %c
+OpReturn
+OpFunctionEnd
+%f = OpFunction %int None %fn_int
+%mode = OpFunctionParameter %int
+%x = OpFunctionParameter %int
+%f_entry = OpLabel
+%r = OpIMul %int %mode %x
+OpReturnValue %r
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<IPCPPass>(text, true, 1024u);
+}
+
+TEST_F(IPCPTest, SpecializeMostCommonConstantFirst) {
+  // The budget only allows one clone, which goes to the constant passed by
+  // the most calls.
+  const std::string text = R"(
+; CHECK: %a = OpFunctionCall %int %f %int_1 %ld
+; CHECK: %b = OpFunctionCall %int [[f2:%\w+]] %int_2 %a
+; CHECK: {{%\w+}} = OpFunctionCall %int [[f2]] %int_2 %b
+; CHECK: [[f2]] = OpFunction %int None {{%\w+}}
+; CHECK: OpIMul %int %int_2
+; CHECK-NOT: OpFunction
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %mode "mode"
+OpName %x "x"
+OpName %r "r"
+OpName %ld "ld"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%fn_int = OpTypeFunction %int %int %int
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %int %in
+%a = OpFunctionCall %int %f %int_1 %ld
+%b = OpFunctionCall %int %f %int_2 %a
+%c = OpFunctionCall %int %f %int_2 %b
+OpStore %out %c
+OpReturn
+OpFunctionEnd
+%f = OpFunction %int None %fn_int
+%mode = OpFunctionParameter %int
+%x = OpFunctionParameter %int
+%f_entry = OpLabel
+%r = OpIMul %int %mode %x
+OpReturnValue %r
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<IPCPPass>(text, true, 3u);
+}
+
+TEST_F(IPCPTest, DontPropagateIntoExportedFunction) {
+  // The exported function may be called with other arguments from outside of
+  // the module, and the budget does not allow a clone.
+  const std::string text = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %mode "mode"
+OpName %x "x"
+OpName %r "r"
+OpName %ld "ld"
+OpName %a "a"
+OpDecorate %f LinkageAttributes "f" Export
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%fn_int = OpTypeFunction %int %int %int
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %int %in
+%a = OpFunctionCall %int %f %int_1 %ld
+OpStore %out %a
+OpReturn
+OpFunctionEnd
+%f = OpFunction %int None %fn_int
+%mode = OpFunctionParameter %int
+%x = OpFunctionParameter %int
+%f_entry = OpLabel
+%r = OpIMul %int %mode %x
+OpReturnValue %r
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<IPCPPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false, 0u);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -16,11 +16,15 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "source/module_index.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/pass.h"
+#include "source/val/validate.h"
+#include "source/val/validation_state.h"
 #include "test/opt/pass_fixture.h"
 #include "test/opt/pass_utils.h"
 
@@ -29,6 +33,7 @@ namespace opt {
 namespace {
 
 using Analysis = IRContext::Analysis;
+using ::testing::ContainerEq;
 using ::testing::Each;
 using ::testing::UnorderedElementsAre;
 
@@ -664,6 +669,127 @@ OpFunctionEnd)";
   EXPECT_EQ(next_id_bound, 0);
   EXPECT_EQ(current_bound, context->module()->id_bound());
 }
+
+// Validates |binary| and returns the module index built by the validator.
+std::unique_ptr<ModuleIndex> IndexModule(const std::vector<uint32_t>& binary) {
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_2);
+  spv_validator_options options = spvValidatorOptionsCreate();
+  std::unique_ptr<val::ValidationState_t> vstate;
+  std::unique_ptr<ModuleIndex> index;
+  if (val::ValidateBinaryAndKeepValidationState(context, options,
+                                                binary.data(), binary.size(),
+                                                nullptr, &vstate) ==
+      SPV_SUCCESS) {
+    index = MakeUnique<ModuleIndex>(*vstate);
+  }
+  spvValidatorOptionsDestroy(options);
+  spvContextDestroy(context);
+  return index;
+}
+
+const char kLoopModule[] = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpSource GLSL 450
+OpName %main "main"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%bool = OpTypeBool
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_10 = OpConstant %int 10
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %next %continue
+OpLoopMerge %merge %continue None
+OpBranch %cond
+%cond = OpLabel
+%cmp = OpSLessThan %bool %i %int_10
+OpBranchConditional %cmp %body %merge
+%body = OpLabel
+%odd = OpBitwiseAnd %int %i %int_1
+%is_odd = OpIEqual %bool %odd %int_1
+OpSelectionMerge %continue None
+OpBranchConditional %is_odd %then %continue
+%then = OpLabel
+OpBranch %continue
+%continue = OpLabel
+%next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+%dead = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST_F(IRContextTest, BuildAnalysesFromModuleIndex) {
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_2);
+  ASSERT_TRUE(tools.Assemble(kLoopModule, &binary));
+  std::unique_ptr<ModuleIndex> index = IndexModule(binary);
+  ASSERT_NE(nullptr, index);
+
+  std::unique_ptr<IRContext> context = BuildModule(
+      SPV_ENV_UNIVERSAL_1_2, nullptr, binary.data(), binary.size());
+  ASSERT_NE(nullptr, context);
+  ASSERT_TRUE(context->BuildAnalysesFromModuleIndex(*index));
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisDefUse |
+                                        IRContext::kAnalysisDominatorAnalysis));
+
+  // The seeded analyses must match the ones computed from the module.
+  analysis::DefUseManager def_use(context->module());
+  EXPECT_TRUE(*context->get_def_use_mgr() == def_use);
+
+  for (auto& fn : *context->module()) {
+    DominatorAnalysis* seeded = context->GetDominatorAnalysis(&fn);
+    DominatorAnalysis computed;
+    computed.InitializeTree(*context->cfg(), &fn);
+    for (auto& a : fn) {
+      EXPECT_EQ(computed.ImmediateDominator(&a), seeded->ImmediateDominator(&a))
+          << "block " << a.id();
+      for (auto& b : fn) {
+        EXPECT_EQ(computed.Dominates(&a, &b), seeded->Dominates(&a, &b))
+            << "blocks " << a.id() << " and " << b.id();
+      }
+    }
+
+    // The children of each node must be in the same order too, so that passes
+    // walking the tree visit the blocks in the same order.
+    auto preorder = [](const DominatorTree& tree) {
+      std::vector<uint32_t> ids;
+      for (const DominatorTreeNode& node : tree) ids.push_back(node.id());
+      return ids;
+    };
+    EXPECT_THAT(preorder(seeded->GetDomTree()),
+                ContainerEq(preorder(computed.GetDomTree())));
+  }
+}
+
+TEST_F(IRContextTest, BuildAnalysesFromModuleIndexOfOtherModule) {
+  // Index the module without its OpName.
+  std::string text = kLoopModule;
+  const std::string name = "OpName %main \"main\"\n";
+  text.erase(text.find(name), name.size());
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_2);
+  ASSERT_TRUE(tools.Assemble(text, &binary));
+  std::unique_ptr<ModuleIndex> index = IndexModule(binary);
+  ASSERT_NE(nullptr, index);
+
+  ASSERT_TRUE(tools.Assemble(kLoopModule, &binary));
+  std::unique_ptr<IRContext> context = BuildModule(
+      SPV_ENV_UNIVERSAL_1_2, nullptr, binary.data(), binary.size());
+  ASSERT_NE(nullptr, context);
+  EXPECT_FALSE(context->BuildAnalysesFromModuleIndex(*index));
+  EXPECT_FALSE(context->AreAnalysesValid(IRContext::kAnalysisDefUse));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,522 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/jump_threading_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using JumpThreadingTest = PassTest<::testing::Test>;
+
+TEST_F(JumpThreadingTest, ThreadPhiOfConstants) {
+  // %p is known on both edges into %m1, so %t1 and %f1 branch to the targets
+  // of %m1, and the first selection ends at %m2.
+  const std::string text = R"(
+; CHECK: OpSelectionMerge %m2 None
+; CHECK-NEXT: OpBranchConditional {{%\w+}} %t1 %f1
+; CHECK: %t1 = OpLabel
+; CHECK-NEXT: OpBranch %t2
+; CHECK: %f1 = OpLabel
+; CHECK-NEXT: OpBranch %f2
+; CHECK-NOT: %p = OpPhi
+; CHECK: %t2 = OpLabel
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %t1 "t1"
+OpName %f1 "f1"
+OpName %m1 "m1"
+OpName %p "p"
+OpName %t2 "t2"
+OpName %f2 "f2"
+OpName %m2 "m2"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %m1 None
+OpBranchConditional %c %t1 %f1
+%t1 = OpLabel
+OpBranch %m1
+%f1 = OpLabel
+OpBranch %m1
+%m1 = OpLabel
+%p = OpPhi %bool %true %t1 %false %f1
+OpSelectionMerge %m2 None
+OpBranchConditional %p %t2 %f2
+%t2 = OpLabel
+OpStore %out %int_1
+OpBranch %m2
+%f2 = OpLabel
+OpStore %out %int_2
+OpBranch %m2
+%m2 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<JumpThreadingPass>(text, true);
+}
+
+TEST_F(JumpThreadingTest, ThreadNegatedPhi) {
+  const std::string text = R"(
+; CHECK: %t1 = OpLabel
+; CHECK-NEXT: OpBranch %f2
+; CHECK: %f1 = OpLabel
+; CHECK-NEXT: OpBranch %t2
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %t1 "t1"
+OpName %f1 "f1"
+OpName %m1 "m1"
+OpName %p "p"
+OpName %t2 "t2"
+OpName %f2 "f2"
+OpName %m2 "m2"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %m1 None
+OpBranchConditional %c %t1 %f1
+%t1 = OpLabel
+OpBranch %m1
+%f1 = OpLabel
+OpBranch %m1
+%m1 = OpLabel
+%p = OpPhi %bool %true %t1 %false %f1
+%not_p = OpLogicalNot %bool %p
+OpSelectionMerge %m2 None
+OpBranchConditional %not_p %t2 %f2
+%t2 = OpLabel
+OpStore %out %int_1
+OpBranch %m2
+%f2 = OpLabel
+OpStore %out %int_2
+OpBranch %m2
+%m2 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<JumpThreadingPass>(text, true);
+}
+
+TEST_F(JumpThreadingTest, CopyTargetOfDecidedEdge) {
+  // The value of %p coming from %f1 is not known, so %f1 still goes through
+  // %m1, which gets a new merge block.  %t1 branches to a copy of %t2.  %m2
+  // is not a return block, so that it is not copied into its predecessors.
+  const std::string text = R"(
+; CHECK: OpSelectionMerge %m2 None
+; CHECK-NEXT: OpBranchConditional {{%\w+}} %t1 %f1
+; CHECK: %t1 = OpLabel
+; CHECK-NEXT: OpBranch [[copy:%\w+]]
+; CHECK: %f1 = OpLabel
+; CHECK-NEXT: OpBranch %m1
+; CHECK: %m1 = OpLabel
+; CHECK-NEXT: %p = OpPhi %bool {{%\w+}} %f1
+; CHECK-NEXT: OpSelectionMerge [[merge:%\w+]] None
+; CHECK-NEXT: OpBranchConditional %p %t2 %f2
+; CHECK: %t2 = OpLabel
+; CHECK-NEXT: OpStore %out %int_1
+; CHECK-NEXT: OpBranch [[merge]]
+; CHECK: %f2 = OpLabel
+; CHECK-NEXT: OpStore %out %int_2
+; CHECK-NEXT: OpBranch [[merge]]
+; CHECK: [[merge]] = OpLabel
+; CHECK-NEXT: OpBranch %m2
+; CHECK: [[copy]] = OpLabel
+; CHECK-NEXT: OpStore %out %int_1
+; CHECK-NEXT: OpBranch %m2
+; CHECK: %m2 = OpLabel
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %t1 "t1"
+OpName %f1 "f1"
+OpName %m1 "m1"
+OpName %p "p"
+OpName %t2 "t2"
+OpName %f2 "f2"
+OpName %m2 "m2"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %m1 None
+OpBranchConditional %c %t1 %f1
+%t1 = OpLabel
+OpBranch %m1
+%f1 = OpLabel
+OpBranch %m1
+%m1 = OpLabel
+%p = OpPhi %bool %true %t1 %c %f1
+OpSelectionMerge %m2 None
+OpBranchConditional %p %t2 %f2
+%t2 = OpLabel
+OpStore %out %int_1
+OpBranch %m2
+%f2 = OpLabel
+OpStore %out %int_2
+OpBranch %m2
+%m2 = OpLabel
+OpBranch %end
+%end = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<JumpThreadingPass>(text, true);
+}
+
+TEST_F(JumpThreadingTest, DontCopyTargetOverBudget) {
+  // The copy of %t2 and the new merge block of %m1 add five instructions.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %t1 "t1"
+OpName %f1 "f1"
+OpName %m1 "m1"
+OpName %p "p"
+OpName %t2 "t2"
+OpName %f2 "f2"
+OpName %m2 "m2"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %m1 None
+OpBranchConditional %c %t1 %f1
+%t1 = OpLabel
+OpBranch %m1
+%f1 = OpLabel
+OpBranch %m1
+%m1 = OpLabel
+%p = OpPhi %bool %true %t1 %c %f1
+OpSelectionMerge %m2 None
+OpBranchConditional %p %t2 %f2
+%t2 = OpLabel
+OpStore %out %int_1
+OpBranch %m2
+%f2 = OpLabel
+OpStore %out %int_2
+OpBranch %m2
+%m2 = OpLabel
+OpBranch %end
+%end = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<JumpThreadingPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false, 4u);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(JumpThreadingTest, BranchDecidedEdgeToMergeBlock) {
+  // %t1 decides that %m1 branches to its merge block %m2, so %t1 branches
+  // there directly, and the phi of %m2 takes the value of that edge.
+  const std::string text = R"(
+; CHECK: %t1 = OpLabel
+; CHECK-NEXT: OpBranch %m2
+; CHECK: %m1 = OpLabel
+; CHECK-NEXT: %p = OpPhi %bool {{%\w+}} %f1
+; CHECK-NEXT: OpSelectionMerge [[merge:%\w+]] None
+; CHECK-NEXT: OpBranchConditional %p %t2 [[merge]]
+; CHECK: %t2 = OpLabel
+; CHECK-NEXT: OpBranch [[merge]]
+; CHECK: [[merge]] = OpLabel
+; CHECK-NEXT: [[phi:%\w+]] = OpPhi %int %int_1 %t2 %int_2 %m1
+; CHECK-NEXT: OpBranch %m2
+; CHECK: %m2 = OpLabel
+; CHECK-NEXT: %v = OpPhi %int [[phi]] [[merge]] %int_2 %t1
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %t1 "t1"
+OpName %f1 "f1"
+OpName %m1 "m1"
+OpName %p "p"
+OpName %t2 "t2"
+OpName %m2 "m2"
+OpName %v "v"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %m1 None
+OpBranchConditional %c %t1 %f1
+%t1 = OpLabel
+OpBranch %m1
+%f1 = OpLabel
+OpBranch %m1
+%m1 = OpLabel
+%p = OpPhi %bool %false %t1 %c %f1
+OpSelectionMerge %m2 None
+OpBranchConditional %p %t2 %m2
+%t2 = OpLabel
+OpBranch %m2
+%m2 = OpLabel
+%v = OpPhi %int %int_1 %t2 %int_2 %m1
+OpStore %out %v
+OpBranch %end
+%end = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<JumpThreadingPass>(text, true);
+}
+
+TEST_F(JumpThreadingTest, DuplicateReturnBlock) {
+  // The return block stays as the merge block of the selection, but can no
+  // longer be reached.
+  const std::string text = R"(
+; CHECK: %then = OpLabel
+; CHECK-NEXT: %a = OpIAdd %int {{%\w+}} %int_1
+; CHECK-NEXT: [[w1:%\w+]] = OpIMul %int %a %int_2
+; CHECK-NEXT: OpStore %out [[w1]]
+; CHECK-NEXT: OpReturn
+; CHECK: %else = OpLabel
+; CHECK-NEXT: %b = OpIAdd %int {{%\w+}} %int_2
+; CHECK-NEXT: [[w2:%\w+]] = OpIMul %int %b %int_2
+; CHECK-NEXT: OpStore %out [[w2]]
+; CHECK-NEXT: OpReturn
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: OpUnreachable
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpName %a "a"
+OpName %b "b"
+OpName %v "v"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%a = OpIAdd %int %x %int_1
+OpBranch %merge
+%else = OpLabel
+%b = OpIAdd %int %x %int_2
+OpBranch %merge
+%merge = OpLabel
+%v = OpPhi %int %a %then %b %else
+%w = OpIMul %int %v %int_2
+OpStore %out %w
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<JumpThreadingPass>(text, true);
+}
+
+TEST_F(JumpThreadingTest, RespectSizeBudget) {
+  // Each copy adds two instructions, so only one fits in the budget.
+  const std::string text = R"(
+; CHECK: %then = OpLabel
+; CHECK: OpReturn
+; CHECK: %else = OpLabel
+; CHECK-NEXT: %b = OpIAdd %int {{%\w+}} %int_2
+; CHECK-NEXT: OpBranch %merge
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: %v = OpPhi %int %b %else
+; CHECK-NEXT: {{%\w+}} = OpIMul %int %v %int_2
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpName %a "a"
+OpName %b "b"
+OpName %v "v"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%false = OpConstantFalse %bool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%a = OpIAdd %int %x %int_1
+OpBranch %merge
+%else = OpLabel
+%b = OpIAdd %int %x %int_2
+OpBranch %merge
+%merge = OpLabel
+%v = OpPhi %int %a %then %b %else
+%w = OpIMul %int %v %int_2
+OpStore %out %w
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<JumpThreadingPass>(text, true, 2u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
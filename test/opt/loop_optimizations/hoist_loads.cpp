@@ -0,0 +1,124 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/licm_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using PassClassTest = PassTest<::testing::Test>;
+
+const std::string kHeader = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpName %main "main"
+OpName %buf "buf"
+OpName %a "a"
+OpDecorate %S BufferBlock
+OpMemberDecorate %S 0 Offset 0
+OpMemberDecorate %S 1 Offset 4
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%uint_2 = OpConstant %uint 2
+%uint_10 = OpConstant %uint 10
+%uint_264 = OpConstant %uint 264
+%S = OpTypeStruct %uint %uint
+%_ptr_Uniform_S = OpTypePointer Uniform %S
+%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+%_ptr_Workgroup_uint = OpTypePointer Workgroup %uint
+%buf = OpVariable %_ptr_Uniform_S Uniform
+%a = OpVariable %_ptr_Workgroup_uint Workgroup
+)";
+
+// Builds a loop whose body runs |load|, which defines %x, and then |body|.
+std::string BuildLoop(const std::string& load, const std::string& body) {
+  return kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%p0 = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+%p1 = OpAccessChain %_ptr_Uniform_uint %buf %uint_1
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %inc %body
+%cond = OpULessThan %bool %i %uint_10
+OpLoopMerge %merge %body None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+)" + load + R"(
+%sum = OpIAdd %uint %x %i
+)" + body + R"(
+%inc = OpIAdd %uint %i %uint_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+}
+
+TEST_F(PassClassTest, HoistLoadWithDisjointStore) {
+  const std::string text = R"(
+; CHECK: [[p0:%\w+]] = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+; CHECK: OpLoad %uint [[p0]]
+; CHECK-NEXT: OpBranch
+; CHECK: OpLoopMerge
+; CHECK-NOT: OpLoad
+; CHECK: OpReturn
+)" + BuildLoop("%x = OpLoad %uint %p0", "OpStore %p1 %sum");
+
+  SinglePassRunAndMatch<LICMPass>(text, true);
+}
+
+TEST_F(PassClassTest, DontHoistLoadWithAliasingStore) {
+  const std::string text = R"(
+; CHECK: OpLoopMerge
+; CHECK: OpLoad %uint
+)" + BuildLoop("%x = OpLoad %uint %p0", "OpStore %p0 %sum");
+
+  SinglePassRunAndMatch<LICMPass>(text, true);
+}
+
+TEST_F(PassClassTest, DontHoistLoadAcrossBarrier) {
+  const std::string text = R"(
+; CHECK: OpLoopMerge
+; CHECK: OpLoad %uint %a
+)" + BuildLoop("%x = OpLoad %uint %a",
+               "OpControlBarrier %uint_2 %uint_2 %uint_264\n"
+               "OpStore %p1 %sum");
+
+  SinglePassRunAndMatch<LICMPass>(text, true);
+}
+
+TEST_F(PassClassTest, DontHoistVolatileLoad) {
+  const std::string text = R"(
+; CHECK: OpLoopMerge
+; CHECK: OpLoad %uint {{%\w+}} Volatile
+)" + BuildLoop("%x = OpLoad %uint %p0 Volatile", "OpStore %p1 %sum");
+
+  SinglePassRunAndMatch<LICMPass>(text, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
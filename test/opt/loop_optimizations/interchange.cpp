@@ -0,0 +1,345 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/loop_interchange.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using LoopInterchangeTest = PassTest<::testing::Test>;
+
+TEST_F(LoopInterchangeTest, InterchangeColumnOrderAccess) {
+  // a[j][i] = 1 walks through a by columns, so the loop over %j becomes the
+  // outer loop, and its bound goes with it.
+  const std::string text = R"(
+; CHECK: %i = OpPhi %int %int_0
+; CHECK-NEXT: {{%\w+}} = OpSLessThan %bool %i %int_8
+; CHECK: %j = OpPhi %int %int_0
+; CHECK-NEXT: {{%\w+}} = OpSLessThan %bool %j %int_4
+; CHECK: [[ptr:%\w+]] = OpAccessChain %_ptr_Private_float %a %i %j
+; CHECK-NEXT: OpStore [[ptr]] %float_1
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %c "c"
+OpName %i "i"
+OpName %j "j"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%int_8 = OpConstant %int 8
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%uint_8 = OpConstant %uint 8
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%arr4 = OpTypeArray %float %uint_4
+%arr8 = OpTypeArray %float %uint_8
+%arr8x4 = OpTypeArray %arr4 %uint_8
+%arr8x8 = OpTypeArray %arr8 %uint_8
+%_ptr_Private_arr8x4 = OpTypePointer Private %arr8x4
+%_ptr_Private_arr8x8 = OpTypePointer Private %arr8x8
+%_ptr_Private_float = OpTypePointer Private %float
+%a = OpVariable %_ptr_Private_arr8x4 Private
+%b = OpVariable %_ptr_Private_arr8x8 Private
+%c = OpVariable %_ptr_Private_arr8x8 Private
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %outer_header
+%outer_header = OpLabel
+%i = OpPhi %int %int_0 %entry %i_next %outer_continue
+%i_cond = OpSLessThan %bool %i %int_4
+OpLoopMerge %outer_merge %outer_continue None
+OpBranchConditional %i_cond %outer_body %outer_merge
+%outer_body = OpLabel
+OpBranch %inner_header
+%inner_header = OpLabel
+%j = OpPhi %int %int_0 %outer_body %j_next %inner_continue
+%j_cond = OpSLessThan %bool %j %int_8
+OpLoopMerge %inner_merge %inner_continue None
+OpBranchConditional %j_cond %inner_body %inner_merge
+%inner_body = OpLabel
+%ptr = OpAccessChain %_ptr_Private_float %a %j %i
+OpStore %ptr %float_1
+OpBranch %inner_continue
+%inner_continue = OpLabel
+%j_next = OpIAdd %int %j %int_1
+OpBranch %inner_header
+%inner_merge = OpLabel
+OpBranch %outer_continue
+%outer_continue = OpLabel
+%i_next = OpIAdd %int %i %int_1
+OpBranch %outer_header
+%outer_merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LoopInterchangePass>(text, true);
+}
+
+TEST_F(LoopInterchangeTest, DontInterchangeRowOrderAccess) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %c "c"
+OpName %i "i"
+OpName %j "j"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%int_8 = OpConstant %int 8
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%uint_8 = OpConstant %uint 8
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%arr4 = OpTypeArray %float %uint_4
+%arr8 = OpTypeArray %float %uint_8
+%arr8x4 = OpTypeArray %arr4 %uint_8
+%arr8x8 = OpTypeArray %arr8 %uint_8
+%_ptr_Private_arr8x4 = OpTypePointer Private %arr8x4
+%_ptr_Private_arr8x8 = OpTypePointer Private %arr8x8
+%_ptr_Private_float = OpTypePointer Private %float
+%a = OpVariable %_ptr_Private_arr8x4 Private
+%b = OpVariable %_ptr_Private_arr8x8 Private
+%c = OpVariable %_ptr_Private_arr8x8 Private
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %outer_header
+%outer_header = OpLabel
+%i = OpPhi %int %int_0 %entry %i_next %outer_continue
+%i_cond = OpSLessThan %bool %i %int_8
+OpLoopMerge %outer_merge %outer_continue None
+OpBranchConditional %i_cond %outer_body %outer_merge
+%outer_body = OpLabel
+OpBranch %inner_header
+%inner_header = OpLabel
+%j = OpPhi %int %int_0 %outer_body %j_next %inner_continue
+%j_cond = OpSLessThan %bool %j %int_4
+OpLoopMerge %inner_merge %inner_continue None
+OpBranchConditional %j_cond %inner_body %inner_merge
+%inner_body = OpLabel
+%ptr = OpAccessChain %_ptr_Private_float %a %i %j
+OpStore %ptr %float_1
+OpBranch %inner_continue
+%inner_continue = OpLabel
+%j_next = OpIAdd %int %j %int_1
+OpBranch %inner_header
+%inner_merge = OpLabel
+OpBranch %outer_continue
+%outer_continue = OpLabel
+%i_next = OpIAdd %int %i %int_1
+OpBranch %outer_header
+%outer_merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<LoopInterchangePass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(LoopInterchangeTest, DontInterchangeReversedDependence) {
+  // The element stored by iteration (i, j) is loaded by iteration
+  // (i + 1, j - 1), which would come first once the loops are interchanged.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %c "c"
+OpName %i "i"
+OpName %j "j"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%int_8 = OpConstant %int 8
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%uint_8 = OpConstant %uint 8
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%arr4 = OpTypeArray %float %uint_4
+%arr8 = OpTypeArray %float %uint_8
+%arr8x4 = OpTypeArray %arr4 %uint_8
+%arr8x8 = OpTypeArray %arr8 %uint_8
+%_ptr_Private_arr8x4 = OpTypePointer Private %arr8x4
+%_ptr_Private_arr8x8 = OpTypePointer Private %arr8x8
+%_ptr_Private_float = OpTypePointer Private %float
+%a = OpVariable %_ptr_Private_arr8x4 Private
+%b = OpVariable %_ptr_Private_arr8x8 Private
+%c = OpVariable %_ptr_Private_arr8x8 Private
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %outer_header
+%outer_header = OpLabel
+%i = OpPhi %int %int_0 %entry %i_next %outer_continue
+%i_cond = OpSLessThan %bool %i %int_4
+OpLoopMerge %outer_merge %outer_continue None
+OpBranchConditional %i_cond %outer_body %outer_merge
+%outer_body = OpLabel
+OpBranch %inner_header
+%inner_header = OpLabel
+%j = OpPhi %int %int_0 %outer_body %j_next %inner_continue
+%j_cond = OpSLessThan %bool %j %int_8
+OpLoopMerge %inner_merge %inner_continue None
+OpBranchConditional %j_cond %inner_body %inner_merge
+%inner_body = OpLabel
+%j_succ = OpIAdd %int %j %int_1
+%i_pred = OpISub %int %i %int_1
+%src = OpAccessChain %_ptr_Private_float %a %j_succ %i_pred
+%value = OpLoad %float %src
+%dst = OpAccessChain %_ptr_Private_float %a %j %i
+OpStore %dst %value
+OpBranch %inner_continue
+%inner_continue = OpLabel
+%j_next = OpIAdd %int %j %int_1
+OpBranch %inner_header
+%inner_merge = OpLabel
+OpBranch %outer_continue
+%outer_continue = OpLabel
+%i_next = OpIAdd %int %i %int_1
+OpBranch %outer_header
+%outer_merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<LoopInterchangePass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(LoopInterchangeTest, TileTranspose) {
+  // b[j][i] = c[i][j] walks through c by rows and through b by columns, so
+  // the loop over %j is split into tiles of 4 iterations, and the loop over
+  // the tiles becomes the outer loop.
+  const std::string text = R"(
+; CHECK: %i = OpPhi %int %int_0
+; CHECK-NEXT: {{%\w+}} = OpSLessThan %bool %i %int_8
+; CHECK: [[ii:%\w+]] = OpPhi %int %int_0
+; CHECK-NEXT: {{%\w+}} = OpSLessThan %bool [[ii]] %int_8
+; CHECK: [[end:%\w+]] = OpIAdd %int %i %int_4
+; CHECK: %j = OpPhi %int %i
+; CHECK-NEXT: {{%\w+}} = OpSLessThan %bool %j [[end]]
+; CHECK: [[src:%\w+]] = OpAccessChain %_ptr_Private_float %c [[ii]] %j
+; CHECK-NEXT: [[value:%\w+]] = OpLoad %float [[src]]
+; CHECK-NEXT: [[dst:%\w+]] = OpAccessChain %_ptr_Private_float %b %j [[ii]]
+; CHECK-NEXT: OpStore [[dst]] [[value]]
+; CHECK: OpIAdd %int [[ii]] %int_1
+; CHECK: OpIAdd %int %i %int_4
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %c "c"
+OpName %i "i"
+OpName %j "j"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%int_8 = OpConstant %int 8
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%uint_8 = OpConstant %uint 8
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%arr4 = OpTypeArray %float %uint_4
+%arr8 = OpTypeArray %float %uint_8
+%arr8x4 = OpTypeArray %arr4 %uint_8
+%arr8x8 = OpTypeArray %arr8 %uint_8
+%_ptr_Private_arr8x4 = OpTypePointer Private %arr8x4
+%_ptr_Private_arr8x8 = OpTypePointer Private %arr8x8
+%_ptr_Private_float = OpTypePointer Private %float
+%a = OpVariable %_ptr_Private_arr8x4 Private
+%b = OpVariable %_ptr_Private_arr8x8 Private
+%c = OpVariable %_ptr_Private_arr8x8 Private
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %outer_header
+%outer_header = OpLabel
+%i = OpPhi %int %int_0 %entry %i_next %outer_continue
+%i_cond = OpSLessThan %bool %i %int_8
+OpLoopMerge %outer_merge %outer_continue None
+OpBranchConditional %i_cond %outer_body %outer_merge
+%outer_body = OpLabel
+OpBranch %inner_header
+%inner_header = OpLabel
+%j = OpPhi %int %int_0 %outer_body %j_next %inner_continue
+%j_cond = OpSLessThan %bool %j %int_8
+OpLoopMerge %inner_merge %inner_continue None
+OpBranchConditional %j_cond %inner_body %inner_merge
+%inner_body = OpLabel
+%src = OpAccessChain %_ptr_Private_float %c %i %j
+%value = OpLoad %float %src
+%dst = OpAccessChain %_ptr_Private_float %b %j %i
+OpStore %dst %value
+OpBranch %inner_continue
+%inner_continue = OpLabel
+%j_next = OpIAdd %int %j %int_1
+OpBranch %inner_header
+%inner_merge = OpLabel
+OpBranch %outer_continue
+%outer_continue = OpLabel
+%i_next = OpIAdd %int %i %int_1
+OpBranch %outer_header
+%outer_merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LoopInterchangePass>(text, true, 4u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
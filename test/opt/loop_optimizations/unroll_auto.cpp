@@ -0,0 +1,144 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/loop_unroller.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using UnrollAutoTest = PassTest<::testing::Test>;
+
+/*
+Generated from the following GLSL, with |N| iterations and the loop control
+|control|.
+#version 330 core
+void main() {
+  float x[N];
+  for (int i = 0; i < N; ++i) {
+    x[i] = 1.0f;
+  }
+}
+*/
+std::string GetLoop(const std::string& trip_count,
+                    const std::string& control) {
+  return R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_n = OpConstant %int )" +
+         trip_count + R"(
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%uint = OpTypeInt 32 0
+%uint_n = OpConstant %uint )" +
+         trip_count + R"(
+%_arr_float = OpTypeArray %float %uint_n
+%_ptr_Function__arr_float = OpTypePointer Function %_arr_float
+%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpVariable %_ptr_Function__arr_float Function
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %inc %continue
+OpLoopMerge %merge %continue )" +
+         control + R"(
+OpBranch %cond_block
+%cond_block = OpLabel
+%cond = OpSLessThan %bool %i %int_n
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%ptr = OpAccessChain %_ptr_Function_float %x %i
+OpStore %ptr %float_1
+OpBranch %continue
+%continue = OpLabel
+%inc = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+}
+
+TEST_F(UnrollAutoTest, FullyUnrollSmallLoop) {
+  const std::string text = R"(
+; CHECK-NOT: OpLoopMerge
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+; CHECK: OpReturn
+)" + GetLoop("4", "None");
+
+  SinglePassRunAndMatch<LoopUnroller>(text, false, static_cast<size_t>(1024));
+}
+
+TEST_F(UnrollAutoTest, PartiallyUnrollLongLoop) {
+  // Fully unrolling the 64 iterations would give too much code, so the body
+  // is replicated 8 times, which divides the trip count.
+  const std::string text = R"(
+; CHECK: OpLoopMerge
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+; CHECK-NOT: OpLoopMerge
+; CHECK: OpReturn
+)" + GetLoop("64", "None");
+
+  SinglePassRunAndMatch<LoopUnroller>(text, false, static_cast<size_t>(1024));
+}
+
+TEST_F(UnrollAutoTest, DontUnrollLoopWithDontUnrollFlag) {
+  const std::string text = GetLoop("4", "DontUnroll");
+
+  auto result = SinglePassRunAndDisassemble<LoopUnroller>(
+      text, /* skip_nop = */ true, /* do_validation = */ false,
+      static_cast<size_t>(1024));
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(UnrollAutoTest, RespectSizeBudget) {
+  // Replicating the body once adds more than 4 instructions.
+  const std::string text = GetLoop("64", "None");
+
+  auto result = SinglePassRunAndDisassemble<LoopUnroller>(
+      text, /* skip_nop = */ true, /* do_validation = */ false,
+      static_cast<size_t>(4));
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
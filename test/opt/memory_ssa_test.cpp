@@ -0,0 +1,278 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/memory_ssa.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using MemorySSATest = PassTest<::testing::Test>;
+
+TEST_F(MemorySSATest, StoreToOtherVariableIsSkipped) {
+  // %6 and %7 are workgroup variables, and %20 is a uniform buffer.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+OpDecorate %19 BufferBlock
+OpMemberDecorate %19 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypePointer Workgroup %4
+%6 = OpVariable %5 Workgroup
+%7 = OpVariable %5 Workgroup
+%8 = OpConstant %4 2
+%9 = OpConstant %4 264
+%10 = OpTypeBool
+%11 = OpConstantTrue %10
+%19 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %19
+%20 = OpVariable %21 Uniform
+%22 = OpConstant %4 0
+%23 = OpTypePointer Uniform %4
+%1 = OpFunction %2 None %3
+%12 = OpLabel
+%13 = OpLoad %4 %6
+OpStore %7 %13
+%14 = OpLoad %4 %6
+OpSelectionMerge %16 None
+OpBranchConditional %11 %15 %16
+%15 = OpLabel
+OpStore %6 %13
+OpBranch %16
+%16 = OpLabel
+%17 = OpLoad %4 %6
+%24 = OpAccessChain %23 %20 %22
+%25 = OpLoad %4 %24
+OpControlBarrier %8 %8 %9
+%18 = OpLoad %4 %6
+%26 = OpLoad %4 %24
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  MemorySSA* memory_ssa =
+      context->GetMemorySSAAnalysis()->Get(&*context->module()->begin());
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  MemoryAccess* first = memory_ssa->GetUse(def_use_mgr->GetDef(13));
+  MemoryAccess* second = memory_ssa->GetUse(def_use_mgr->GetDef(14));
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_EQ(SpvStorageClassWorkgroup, second->partition());
+  EXPECT_EQ(6u, second->pointer_id());
+
+  // The store to %7 defines a new version of workgroup memory, but it does not
+  // write %6.
+  ASSERT_TRUE(second->defining_access()->IsDef());
+  EXPECT_EQ(SpvOpStore, second->defining_access()->instruction()->opcode());
+  EXPECT_TRUE(memory_ssa->GetClobberingAccess(second)->IsLiveOnEntry());
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(first),
+            memory_ssa->GetClobberingAccess(second));
+  EXPECT_EQ(memory_ssa->GetLiveOnEntry(SpvStorageClassWorkgroup),
+            first->defining_access());
+}
+
+TEST_F(MemorySSATest, PhiAtJoin) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+OpDecorate %19 BufferBlock
+OpMemberDecorate %19 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypePointer Workgroup %4
+%6 = OpVariable %5 Workgroup
+%7 = OpVariable %5 Workgroup
+%8 = OpConstant %4 2
+%9 = OpConstant %4 264
+%10 = OpTypeBool
+%11 = OpConstantTrue %10
+%19 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %19
+%20 = OpVariable %21 Uniform
+%22 = OpConstant %4 0
+%23 = OpTypePointer Uniform %4
+%1 = OpFunction %2 None %3
+%12 = OpLabel
+%13 = OpLoad %4 %6
+OpStore %7 %13
+%14 = OpLoad %4 %6
+OpSelectionMerge %16 None
+OpBranchConditional %11 %15 %16
+%15 = OpLabel
+OpStore %6 %13
+OpBranch %16
+%16 = OpLabel
+%17 = OpLoad %4 %6
+%24 = OpAccessChain %23 %20 %22
+%25 = OpLoad %4 %24
+OpControlBarrier %8 %8 %9
+%18 = OpLoad %4 %6
+%26 = OpLoad %4 %24
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  MemorySSA* memory_ssa =
+      context->GetMemorySSAAnalysis()->Get(&*context->module()->begin());
+
+  MemoryAccess* use =
+      memory_ssa->GetUse(context->get_def_use_mgr()->GetDef(17));
+  ASSERT_NE(nullptr, use);
+  MemoryAccess* phi = use->defining_access();
+  ASSERT_TRUE(phi->IsPhi());
+  EXPECT_EQ(phi, memory_ssa->GetPhi(context->cfg()->block(16),
+                                    SpvStorageClassWorkgroup));
+  ASSERT_EQ(2u, phi->incoming().size());
+  EXPECT_EQ(15u, phi->incoming()[1]->block()->id());
+  EXPECT_EQ(SpvOpStore, phi->incoming()[1]->instruction()->opcode());
+
+  // Uniform memory is not written in the function, so its phi is removed.
+  EXPECT_EQ(nullptr, memory_ssa->GetPhi(context->cfg()->block(16),
+                                        SpvStorageClassUniform));
+}
+
+TEST_F(MemorySSATest, BarrierWritesNamedStorageClasses) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+OpDecorate %19 BufferBlock
+OpMemberDecorate %19 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypePointer Workgroup %4
+%6 = OpVariable %5 Workgroup
+%7 = OpVariable %5 Workgroup
+%8 = OpConstant %4 2
+%9 = OpConstant %4 264
+%10 = OpTypeBool
+%11 = OpConstantTrue %10
+%19 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %19
+%20 = OpVariable %21 Uniform
+%22 = OpConstant %4 0
+%23 = OpTypePointer Uniform %4
+%1 = OpFunction %2 None %3
+%12 = OpLabel
+%13 = OpLoad %4 %6
+OpStore %7 %13
+%14 = OpLoad %4 %6
+OpSelectionMerge %16 None
+OpBranchConditional %11 %15 %16
+%15 = OpLabel
+OpStore %6 %13
+OpBranch %16
+%16 = OpLabel
+%17 = OpLoad %4 %6
+%24 = OpAccessChain %23 %20 %22
+%25 = OpLoad %4 %24
+OpControlBarrier %8 %8 %9
+%18 = OpLoad %4 %6
+%26 = OpLoad %4 %24
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  MemorySSA* memory_ssa =
+      context->GetMemorySSAAnalysis()->Get(&*context->module()->begin());
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  // The barrier synchronizes workgroup memory only.
+  MemoryAccess* workgroup_use = memory_ssa->GetUse(def_use_mgr->GetDef(18));
+  ASSERT_NE(nullptr, workgroup_use);
+  EXPECT_EQ(SpvOpControlBarrier,
+            workgroup_use->defining_access()->instruction()->opcode());
+
+  MemoryAccess* uniform_use = memory_ssa->GetUse(def_use_mgr->GetDef(26));
+  ASSERT_NE(nullptr, uniform_use);
+  EXPECT_TRUE(uniform_use->defining_access()->IsLiveOnEntry());
+  EXPECT_EQ(uniform_use->defining_access(),
+            memory_ssa->GetUse(def_use_mgr->GetDef(25))->defining_access());
+}
+
+TEST_F(MemorySSATest, TrivialPhisAreRemoved) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+OpDecorate %19 BufferBlock
+OpMemberDecorate %19 0 Offset 0
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 0
+%5 = OpTypePointer Workgroup %4
+%6 = OpVariable %5 Workgroup
+%7 = OpVariable %5 Workgroup
+%8 = OpConstant %4 2
+%9 = OpConstant %4 264
+%10 = OpTypeBool
+%11 = OpConstantTrue %10
+%19 = OpTypeStruct %4
+%21 = OpTypePointer Uniform %19
+%20 = OpVariable %21 Uniform
+%22 = OpConstant %4 0
+%23 = OpTypePointer Uniform %4
+%1 = OpFunction %2 None %3
+%12 = OpLabel
+OpBranch %13
+%13 = OpLabel
+OpLoopMerge %15 %14 None
+OpBranchConditional %11 %14 %15
+%14 = OpLabel
+%16 = OpLoad %4 %6
+OpBranch %13
+%15 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  MemorySSA* memory_ssa =
+      context->GetMemorySSAAnalysis()->Get(&*context->module()->begin());
+
+  MemoryAccess* use =
+      memory_ssa->GetUse(context->get_def_use_mgr()->GetDef(16));
+  ASSERT_NE(nullptr, use);
+  EXPECT_TRUE(use->defining_access()->IsLiveOnEntry());
+  EXPECT_EQ(nullptr, memory_ssa->GetPhi(context->cfg()->block(13),
+                                        SpvStorageClassWorkgroup));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,302 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/merge_functions_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using MergeFunctionsTest = PassTest<::testing::Test>;
+
+TEST_F(MergeFunctionsTest, MergeIdenticalFunctions) {
+  const std::string text = R"(
+; CHECK-NOT: OpName %f2
+; CHECK: %a = OpFunctionCall %float %f1 %float_1
+; CHECK: %b = OpFunctionCall %float %f1 %a
+; CHECK: %f1 = OpFunction
+; CHECK-NOT: OpFunction %float
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%a = OpFunctionCall %float %f1 %float_1
+%b = OpFunctionCall %float %f2 %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %fn_float
+%f1_x = OpFunctionParameter %float
+%f1_entry = OpLabel
+OpBranch %f1_exit
+%f1_exit = OpLabel
+%f1_r = OpFMul %float %f1_x %float_2
+OpReturnValue %f1_r
+OpFunctionEnd
+%f2 = OpFunction %float None %fn_float
+%f2_x = OpFunctionParameter %float
+%f2_entry = OpLabel
+OpBranch %f2_exit
+%f2_exit = OpLabel
+%f2_r = OpFMul %float %f2_x %float_2
+OpReturnValue %f2_r
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<MergeFunctionsPass>(text, true);
+}
+
+TEST_F(MergeFunctionsTest, MergeCallersOfMergedFunctions) {
+  const std::string text = R"(
+; CHECK: %a = OpFunctionCall %float %g1 %float_1
+; CHECK: %b = OpFunctionCall %float %g1 %a
+; CHECK: %f1 = OpFunction
+; CHECK: %g1 = OpFunction
+; CHECK: OpFunctionCall %float %f1
+; CHECK-NOT: OpFunction %float
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %out Location 0
+OpName %g1 "g1"
+OpName %g2 "g2"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%a = OpFunctionCall %float %g1 %float_1
+%b = OpFunctionCall %float %g2 %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%g1 = OpFunction %float None %fn_float
+%g1_x = OpFunctionParameter %float
+%g1_entry = OpLabel
+%g1_r = OpFunctionCall %float %f1 %g1_x
+OpReturnValue %g1_r
+OpFunctionEnd
+%g2 = OpFunction %float None %fn_float
+%g2_x = OpFunctionParameter %float
+%g2_entry = OpLabel
+%g2_r = OpFunctionCall %float %f2 %g2_x
+OpReturnValue %g2_r
+OpFunctionEnd
+%f1 = OpFunction %float None %fn_float
+%f1_x = OpFunctionParameter %float
+%f1_entry = OpLabel
+OpBranch %f1_exit
+%f1_exit = OpLabel
+%f1_r = OpFMul %float %f1_x %float_2
+OpReturnValue %f1_r
+OpFunctionEnd
+%f2 = OpFunction %float None %fn_float
+%f2_x = OpFunctionParameter %float
+%f2_entry = OpLabel
+OpBranch %f2_exit
+%f2_exit = OpLabel
+%f2_r = OpFMul %float %f2_x %float_2
+OpReturnValue %f2_r
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<MergeFunctionsPass>(text, true);
+}
+
+TEST_F(MergeFunctionsTest, DontMergeDifferentConstants) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%a = OpFunctionCall %float %f1 %float_1
+%b = OpFunctionCall %float %f2 %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %fn_float
+%f1_x = OpFunctionParameter %float
+%f1_entry = OpLabel
+OpBranch %f1_exit
+%f1_exit = OpLabel
+%f1_r = OpFMul %float %f1_x %float_1
+OpReturnValue %f1_r
+OpFunctionEnd
+%f2 = OpFunction %float None %fn_float
+%f2_x = OpFunctionParameter %float
+%f2_entry = OpLabel
+OpBranch %f2_exit
+%f2_exit = OpLabel
+%f2_r = OpFMul %float %f2_x %float_2
+OpReturnValue %f2_r
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<MergeFunctionsPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(MergeFunctionsTest, DontMergeDifferentDecorations) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %out Location 0
+OpDecorate %f2_r NoContraction
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%a = OpFunctionCall %float %f1 %float_1
+%b = OpFunctionCall %float %f2 %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %fn_float
+%f1_x = OpFunctionParameter %float
+%f1_entry = OpLabel
+OpBranch %f1_exit
+%f1_exit = OpLabel
+%f1_r = OpFMul %float %f1_x %float_2
+OpReturnValue %f1_r
+OpFunctionEnd
+%f2 = OpFunction %float None %fn_float
+%f2_x = OpFunctionParameter %float
+%f2_entry = OpLabel
+OpBranch %f2_exit
+%f2_exit = OpLabel
+%f2_r = OpFMul %float %f2_x %float_2
+OpReturnValue %f2_r
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<MergeFunctionsPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(MergeFunctionsTest, KeepExportedFunction) {
+  // %f2 cannot be removed, since it is exported, so it replaces %f1 even
+  // though it comes later.
+  const std::string text = R"(
+; CHECK: %a = OpFunctionCall %float %f2 %float_1
+; CHECK: %b = OpFunctionCall %float %f2 %a
+; CHECK-NOT: %f1 = OpFunction
+; CHECK: %f2 = OpFunction
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %out Location 0
+OpDecorate %f2 LinkageAttributes "f2" Export
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%fn_float = OpTypeFunction %float %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%a = OpFunctionCall %float %f1 %float_1
+%b = OpFunctionCall %float %f2 %a
+OpStore %out %b
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %fn_float
+%f1_x = OpFunctionParameter %float
+%f1_entry = OpLabel
+OpBranch %f1_exit
+%f1_exit = OpLabel
+%f1_r = OpFMul %float %f1_x %float_2
+OpReturnValue %f1_r
+OpFunctionEnd
+%f2 = OpFunction %float None %fn_float
+%f2_x = OpFunctionParameter %float
+%f2_entry = OpLabel
+OpBranch %f2_exit
+%f2_exit = OpLabel
+%f2_r = OpFMul %float %f2_x %float_2
+OpReturnValue %f2_r
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<MergeFunctionsPass>(text, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
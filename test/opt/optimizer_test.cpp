@@ -194,6 +194,8 @@ TEST(Optimizer, CanRegisterPassesFromFlags) {
       "--loop-unroll-partial=3",
       "--loop-peeling",
       "--ccp",
+      "--switch-to-table",
+      "--gvn-pre=32",
       "-O",
       "-Os",
       "--legalize-hlsl"};
@@ -222,6 +224,81 @@ TEST(Optimizer, CanRegisterPassesFromFlags) {
   EXPECT_EQ(msg_level, SPV_MSG_ERROR);
 }
 
+TEST(Optimizer, CanParseProfileText) {
+  std::vector<ProfileBlockCount> profile;
+  EXPECT_TRUE(ParseProfileText("# function block count\n"
+                               "1 10 25\n"
+                               "\n"
+                               "  1 14 0\n",
+                               &profile));
+  ASSERT_EQ(2u, profile.size());
+  EXPECT_EQ(1u, profile[0].function_id);
+  EXPECT_EQ(10u, profile[0].block_id);
+  EXPECT_EQ(25u, profile[0].count);
+  EXPECT_EQ(14u, profile[1].block_id);
+  EXPECT_EQ(0u, profile[1].count);
+  EXPECT_THAT(ProfileToText(profile), Eq("1 10 25\n1 14 0\n"));
+
+  EXPECT_FALSE(ParseProfileText("1 10\n", &profile));
+  EXPECT_FALSE(ParseProfileText("1 10 25 3\n", &profile));
+  EXPECT_FALSE(ParseProfileText("a b c\n", &profile));
+}
+
+TEST(Optimizer, ProfileKeepsColdCallsFromInlining) {
+  // Both calls to %20 would be inlined without a profile, but the block %14
+  // of the second call never ran.
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %1 "main" %2
+OpExecutionMode %1 OriginUpperLeft
+OpDecorate %2 Location 0
+%3 = OpTypeVoid
+%4 = OpTypeFunction %3
+%5 = OpTypeBool
+%6 = OpTypeFloat 32
+%7 = OpTypeFunction %6 %6
+%8 = OpTypePointer Input %6
+%2 = OpVariable %8 Input
+%9 = OpConstant %6 0
+%1 = OpFunction %3 None %4
+%10 = OpLabel
+%11 = OpLoad %6 %2
+%12 = OpFunctionCall %6 %20 %11
+%13 = OpFOrdLessThan %5 %12 %9
+OpSelectionMerge %15 None
+OpBranchConditional %13 %14 %15
+%14 = OpLabel
+%16 = OpFunctionCall %6 %20 %11
+OpBranch %15
+%15 = OpLabel
+OpReturn
+OpFunctionEnd
+%20 = OpFunction %6 None %7
+%21 = OpFunctionParameter %6
+%22 = OpLabel
+%23 = OpFMul %6 %21 %21
+OpReturnValue %23
+OpFunctionEnd
+)";
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools.Assemble(text, &binary,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS));
+
+  std::vector<ProfileBlockCount> profile;
+  ASSERT_TRUE(ParseProfileText("1 10 8\n1 14 0\n1 15 8\n", &profile));
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_1);
+  opt.SetProfile(profile).RegisterPass(CreateInlineHeuristicPass());
+  std::vector<uint32_t> optimized;
+  ASSERT_TRUE(opt.Run(binary.data(), binary.size(), &optimized));
+
+  std::string disassembly;
+  tools.Disassemble(optimized, &disassembly);
+  EXPECT_THAT(disassembly, ::testing::Not(::testing::HasSubstr(
+                               "%12 = OpFunctionCall")));
+  EXPECT_THAT(disassembly, ::testing::HasSubstr("%16 = OpFunctionCall"));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
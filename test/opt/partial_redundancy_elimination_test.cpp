@@ -0,0 +1,263 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/partial_redundancy_elimination.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using PartialRedundancyEliminationTest = PassTest<::testing::Test>;
+
+TEST_F(PartialRedundancyEliminationTest, InsertOnMissingEdge) {
+  const std::string text = R"(
+; CHECK: %else = OpLabel
+; CHECK-NEXT: OpStore %out %int_0
+; CHECK-NEXT: [[copy:%\w+]] = OpIAdd %int %x %int_1
+; CHECK-NEXT: OpBranch %merge
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: [[phi:%\w+]] = OpPhi %int %a %then [[copy]] %else
+; CHECK-NEXT: {{%\w+}} = OpIMul %int [[phi]] %int_2
+; CHECK-NOT: OpIAdd
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %x "x"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpName %a "a"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%a = OpIAdd %int %x %int_1
+OpStore %out %a
+OpBranch %merge
+%else = OpLabel
+OpStore %out %int_0
+OpBranch %merge
+%merge = OpLabel
+%b = OpIAdd %int %x %int_1
+%d = OpIMul %int %b %int_2
+OpStore %out %d
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<PartialRedundancyEliminationPass>(text, true);
+}
+
+TEST_F(PartialRedundancyEliminationTest, MergeValuesOfBothArms) {
+  const std::string text = R"(
+; CHECK: %else = OpLabel
+; CHECK-NEXT: %e = OpIAdd %int %x %int_1
+; CHECK-NEXT: OpStore %out %e
+; CHECK-NEXT: OpBranch %merge
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: [[phi:%\w+]] = OpPhi %int %a %then %e %else
+; CHECK-NEXT: {{%\w+}} = OpIMul %int [[phi]] %int_2
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %x "x"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpName %a "a"
+OpName %e "e"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%a = OpIAdd %int %x %int_1
+OpStore %out %a
+OpBranch %merge
+%else = OpLabel
+%e = OpIAdd %int %x %int_1
+OpStore %out %e
+OpBranch %merge
+%merge = OpLabel
+%b = OpIAdd %int %x %int_1
+%d = OpIMul %int %b %int_2
+OpStore %out %d
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<PartialRedundancyEliminationPass>(text, true);
+}
+
+TEST_F(PartialRedundancyEliminationTest, RespectRegisterPressure) {
+  // The else branch has no register left for the value.
+  const std::string text = R"(
+; CHECK: %else = OpLabel
+; CHECK-NEXT: OpStore %out %int_0
+; CHECK-NEXT: OpBranch %merge
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: {{%\w+}} = OpIAdd %int %x %int_1
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %x "x"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpName %a "a"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%a = OpIAdd %int %x %int_1
+OpStore %out %a
+OpBranch %merge
+%else = OpLabel
+OpStore %out %int_0
+OpBranch %merge
+%merge = OpLabel
+%b = OpIAdd %int %x %int_1
+%d = OpIMul %int %b %int_2
+OpStore %out %d
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<PartialRedundancyEliminationPass>(text, true, 1u);
+}
+
+TEST_F(PartialRedundancyEliminationTest, EliminateFullRedundancy) {
+  const std::string text = R"(
+; CHECK: %a = OpIAdd %int %x %int_1
+; CHECK-NOT: OpIAdd
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: {{%\w+}} = OpIMul %int %a %int_2
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %x "x"
+OpName %then "then"
+OpName %else "else"
+OpName %merge "merge"
+OpName %a "a"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+%a = OpIAdd %int %x %int_1
+%c = OpSGreaterThan %bool %x %int_0
+OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+OpStore %out %a
+OpBranch %merge
+%else = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%b = OpIAdd %int %x %int_1
+%d = OpIMul %int %b %int_2
+OpStore %out %d
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<PartialRedundancyEliminationPass>(text, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,227 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/range_fold_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using RangeFoldTest = PassTest<::testing::Test>;
+
+TEST_F(RangeFoldTest, FoldCheckOnInductionVariable) {
+  const std::string text = R"(
+; CHECK: [[true:%\w+]] = OpConstantTrue %bool
+; CHECK: OpBranchConditional %cond %body %merge
+; CHECK: OpSelectionMerge
+; CHECK-NEXT: OpBranchConditional [[true]] %then %if_merge
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %out "out"
+OpName %i "i"
+OpName %cond "cond"
+OpName %body "body"
+OpName %then "then"
+OpName %if_merge "if_merge"
+OpName %continue "continue"
+OpName %merge "merge"
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%uint_10 = OpConstant %uint 10
+%uint_16 = OpConstant %uint 16
+%_ptr_Output_uint = OpTypePointer Output %uint
+%out = OpVariable %_ptr_Output_uint Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %inc %continue
+%cond = OpULessThan %bool %i %uint_10
+OpLoopMerge %merge %continue None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%in_range = OpULessThan %bool %i %uint_16
+OpSelectionMerge %if_merge None
+OpBranchConditional %in_range %then %if_merge
+%then = OpLabel
+OpStore %out %i
+OpBranch %if_merge
+%if_merge = OpLabel
+OpBranch %continue
+%continue = OpLabel
+%inc = OpIAdd %uint %i %uint_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<RangeFoldPass>(text, true);
+}
+
+TEST_F(RangeFoldTest, RemoveRedundantClamps) {
+  const std::string text = R"(
+; CHECK: [[c:%\w+]] = OpExtInst %uint {{%\w+}} UMin {{%\w+}} %uint_7
+; CHECK: [[y:%\w+]] = OpBitcast %int [[c]]
+; CHECK: OpStore %out [[c]]
+; CHECK-NEXT: OpStore %out [[c]]
+; CHECK-NEXT: OpStore %out [[c]]
+; CHECK-NEXT: OpStore %outi [[y]]
+OpCapability Shader
+%glsl = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %x %out %outi
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+OpName %out "out"
+OpName %outi "outi"
+OpDecorate %x Flat
+OpDecorate %x Location 0
+OpDecorate %out Location 0
+OpDecorate %outi Location 1
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%int = OpTypeInt 32 1
+%uint_0 = OpConstant %uint 0
+%uint_7 = OpConstant %uint 7
+%uint_8 = OpConstant %uint 8
+%uint_15 = OpConstant %uint 15
+%int_0 = OpConstant %int 0
+%int_7 = OpConstant %int 7
+%_ptr_Input_uint = OpTypePointer Input %uint
+%_ptr_Output_uint = OpTypePointer Output %uint
+%_ptr_Output_int = OpTypePointer Output %int
+%x = OpVariable %_ptr_Input_uint Input
+%out = OpVariable %_ptr_Output_uint Output
+%outi = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%c = OpExtInst %uint %glsl UMin %ld %uint_7
+%d = OpExtInst %uint %glsl UMin %c %uint_15
+%m = OpBitwiseAnd %uint %c %uint_7
+%lt = OpULessThan %bool %c %uint_8
+%sel = OpSelect %uint %lt %c %uint_0
+%y = OpBitcast %int %c
+%s = OpExtInst %int %glsl SClamp %y %int_0 %int_7
+OpStore %out %d
+OpStore %out %m
+OpStore %out %sel
+OpStore %outi %s
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<RangeFoldPass>(text, true);
+}
+
+TEST_F(RangeFoldTest, DontFoldWhenValueMayWrap) {
+  // %ld - 1 wraps to 0xFFFFFFFF when %ld is 0.
+  const std::string text = R"(
+OpCapability Shader
+%glsl = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %x %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+OpName %out "out"
+OpDecorate %x Flat
+OpDecorate %x Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_7 = OpConstant %uint 7
+%uint_max = OpConstant %uint 4294967295
+%_ptr_Input_uint = OpTypePointer Input %uint
+%_ptr_Output_uint = OpTypePointer Output %uint
+%x = OpVariable %_ptr_Input_uint Input
+%out = OpVariable %_ptr_Output_uint Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%c = OpExtInst %uint %glsl UMin %ld %uint_7
+%a = OpIAdd %uint %c %uint_max
+%lt = OpULessThan %bool %a %uint_7
+%sel = OpSelect %uint %lt %a %uint_0
+OpStore %out %sel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<RangeFoldPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(RangeFoldTest, DontFoldUnknownComparison) {
+  const std::string text = R"(
+OpCapability Shader
+%glsl = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %x %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+OpName %out "out"
+OpDecorate %x Flat
+OpDecorate %x Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%uint_8 = OpConstant %uint 8
+%_ptr_Input_uint = OpTypePointer Input %uint
+%_ptr_Output_uint = OpTypePointer Output %uint
+%x = OpVariable %_ptr_Input_uint Input
+%out = OpVariable %_ptr_Output_uint Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%c = OpExtInst %uint %glsl UMin %ld %uint_8
+%lt = OpULessThan %bool %c %uint_8
+%sel = OpSelect %uint %lt %c %uint_4
+OpStore %out %sel
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<RangeFoldPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,236 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/opt/assembly_builder.h"
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using RedundantLoadElimTest = PassTest<::testing::Test>;
+
+const std::string kHeader = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %buf "buf"
+OpDecorate %S BufferBlock
+OpMemberDecorate %S 0 Offset 0
+OpMemberDecorate %S 1 Offset 4
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%uint_2 = OpConstant %uint 2
+%uint_72 = OpConstant %uint 72
+%uint_264 = OpConstant %uint 264
+%S = OpTypeStruct %uint %uint
+%_ptr_Uniform_S = OpTypePointer Uniform %S
+%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+%_ptr_Workgroup_uint = OpTypePointer Workgroup %uint
+%buf = OpVariable %_ptr_Uniform_S Uniform
+%a = OpVariable %_ptr_Workgroup_uint Workgroup
+%b = OpVariable %_ptr_Workgroup_uint Workgroup
+)";
+
+TEST_F(RedundantLoadElimTest, ReuseLoadAcrossBlocks) {
+  const std::string text = kHeader + R"(
+; CHECK: [[ld:%\w+]] = OpLoad %uint
+; CHECK-NOT: OpLoad
+; CHECK: OpIAdd %uint [[ld]] [[ld]]
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%p = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+%x = OpLoad %uint %p
+OpSelectionMerge %merge None
+OpBranchConditional %true %then %merge
+%then = OpLabel
+%q = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+%y = OpLoad %uint %q
+%sum = OpIAdd %uint %x %y
+OpStore %a %sum
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<RedundantLoadElimPass>(text, true);
+}
+
+TEST_F(RedundantLoadElimTest, ForwardStoreOverStoreToOtherMember) {
+  const std::string text = kHeader + R"(
+; CHECK: OpStore [[p0:%\w+]] %uint_2
+; CHECK: OpStore [[p1:%\w+]] %uint_1
+; CHECK-NOT: OpLoad %uint [[p0]]
+; CHECK: OpStore %a %uint_2
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%p0 = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+%p1 = OpAccessChain %_ptr_Uniform_uint %buf %uint_1
+OpStore %p0 %uint_2
+OpBranch %next
+%next = OpLabel
+OpStore %p1 %uint_1
+%y = OpLoad %uint %p0
+OpStore %a %y
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<RedundantLoadElimPass>(text, true);
+}
+
+TEST_F(RedundantLoadElimTest, StoreToOtherVariableDoesNotBlock) {
+  const std::string text = kHeader + R"(
+; CHECK: [[ld:%\w+]] = OpLoad %uint %a
+; CHECK-NEXT: OpStore %b [[ld]]
+; CHECK-NEXT: OpStore %b [[ld]]
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %uint %a
+OpStore %b %x
+%y = OpLoad %uint %a
+OpStore %b %y
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<RedundantLoadElimPass>(text, true);
+}
+
+TEST_F(RedundantLoadElimTest, BarrierBlocksElimination) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %uint %a
+OpControlBarrier %uint_2 %uint_2 %uint_264
+%y = OpLoad %uint %a
+%sum = OpIAdd %uint %x %y
+OpStore %b %sum
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<RedundantLoadElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(RedundantLoadElimTest, BarrierOnOtherMemoryDoesNotBlock) {
+  // The barrier only orders uniform memory.
+  const std::string text = kHeader + R"(
+; CHECK: [[ld:%\w+]] = OpLoad %uint %a
+; CHECK-NEXT: OpControlBarrier
+; CHECK-NEXT: OpIAdd %uint [[ld]] [[ld]]
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %uint %a
+OpControlBarrier %uint_2 %uint_2 %uint_72
+%y = OpLoad %uint %a
+%sum = OpIAdd %uint %x %y
+OpStore %b %sum
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<RedundantLoadElimPass>(text, true);
+}
+
+TEST_F(RedundantLoadElimTest, StoreThroughDynamicIndexBlocks) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%p0 = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+%x = OpLoad %uint %p0
+%pi = OpAccessChain %_ptr_Uniform_uint %buf %x
+OpStore %pi %uint_2
+%y = OpLoad %uint %p0
+OpStore %a %y
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<RedundantLoadElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(RedundantLoadElimTest, KeepVolatileLoads) {
+  const std::string text = kHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %uint %a Volatile
+%y = OpLoad %uint %a Volatile
+%sum = OpIAdd %uint %x %y
+OpStore %b %sum
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<RedundantLoadElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(RedundantLoadElimTest, KeepCoherentLoads) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpDecorate %S BufferBlock
+OpMemberDecorate %S 0 Offset 0
+OpMemberDecorate %S 0 Coherent
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%S = OpTypeStruct %uint
+%_ptr_Uniform_S = OpTypePointer Uniform %S
+%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+%_ptr_Workgroup_uint = OpTypePointer Workgroup %uint
+%buf = OpVariable %_ptr_Uniform_S Uniform
+%a = OpVariable %_ptr_Workgroup_uint Workgroup
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%p = OpAccessChain %_ptr_Uniform_uint %buf %uint_0
+%x = OpLoad %uint %p
+%y = OpLoad %uint %p
+%sum = OpIAdd %uint %x %y
+OpStore %a %sum
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<RedundantLoadElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
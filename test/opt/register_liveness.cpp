@@ -1277,6 +1277,89 @@ TEST_F(PassClassTest, FissionSimulation) {
   }
 }
 
+TEST_F(PassClassTest, UnrollSimulation) {
+  const std::string source = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+               OpName %2 "main"
+               OpName %3 "i"
+               OpName %4 "A"
+               OpName %5 "B"
+          %6 = OpTypeVoid
+          %7 = OpTypeFunction %6
+          %8 = OpTypeInt 32 1
+          %9 = OpTypePointer Function %8
+         %10 = OpConstant %8 0
+         %11 = OpConstant %8 10
+         %12 = OpTypeBool
+         %13 = OpTypeFloat 32
+         %14 = OpTypeInt 32 0
+         %15 = OpConstant %14 10
+         %16 = OpTypeArray %13 %15
+         %17 = OpTypePointer Function %16
+         %18 = OpTypePointer Function %13
+         %19 = OpConstant %8 1
+          %2 = OpFunction %6 None %7
+         %20 = OpLabel
+          %3 = OpVariable %9 Function
+          %4 = OpVariable %17 Function
+          %5 = OpVariable %17 Function
+               OpBranch %21
+         %21 = OpLabel
+         %22 = OpPhi %8 %10 %20 %23 %24
+               OpLoopMerge %25 %24 None
+               OpBranch %26
+         %26 = OpLabel
+         %27 = OpSLessThan %12 %22 %11
+               OpBranchConditional %27 %28 %25
+         %28 = OpLabel
+         %29 = OpAccessChain %18 %5 %22
+         %30 = OpLoad %13 %29
+         %31 = OpAccessChain %18 %4 %22
+               OpStore %31 %30
+         %32 = OpAccessChain %18 %4 %22
+         %33 = OpLoad %13 %32
+         %34 = OpAccessChain %18 %5 %22
+               OpStore %34 %33
+               OpBranch %24
+         %24 = OpLabel
+         %23 = OpIAdd %8 %22 %19
+               OpBranch %21
+         %25 = OpLabel
+               OpStore %3 %22
+               OpReturn
+               OpFunctionEnd
+    )";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, source,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  Module* module = context->module();
+  EXPECT_NE(nullptr, module) << "Assembling failed for shader:\n"
+                             << source << std::endl;
+  Function* f = &*module->begin();
+  LivenessAnalysis* liveness_analysis = context->GetLivenessAnalysis();
+  const RegisterLiveness* register_liveness = liveness_analysis->Get(f);
+  LoopDescriptor& ld = *context->GetLoopDescriptor(f);
+
+  RegisterLiveness::RegionRegisterLiveness loop_reg_pressure;
+  register_liveness->ComputeLoopRegisterPressure(*ld[21], &loop_reg_pressure);
+
+  RegisterLiveness::RegionRegisterLiveness sim_result;
+  register_liveness->SimulateUnroll(*ld[21], 1, &sim_result);
+  EXPECT_EQ(sim_result.used_registers_, loop_reg_pressure.used_registers_);
+
+  // %3, %4 and %5 are defined outside of the loop and shared by all the
+  // copies of the body.
+  register_liveness->SimulateUnroll(*ld[21], 4, &sim_result);
+  CompareSets(sim_result.live_in_, {3, 4, 5, 22});
+  EXPECT_EQ(sim_result.used_registers_,
+            3u + 4u * (loop_reg_pressure.used_registers_ - 3u));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,235 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/slp_vectorizer_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using SLPVectorizerTest = PassTest<::testing::Test>;
+
+TEST_F(SLPVectorizerTest, VectorizeComponentwiseMultiply) {
+  const std::string text = R"(
+; CHECK: [[la:%\w+]] = OpLoad %v4float %a
+; CHECK-NEXT: [[lb:%\w+]] = OpLoad %v4float %b
+; CHECK-NEXT: [[mul:%\w+]] = OpFMul %v4float [[la]] [[lb]]
+; CHECK-NEXT: OpStore %o [[mul]]
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %b %o
+OpExecutionMode %main OriginUpperLeft
+OpName %a "a"
+OpName %b "b"
+OpName %o "o"
+OpDecorate %a Location 0
+OpDecorate %b Location 1
+OpDecorate %o Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%_ptr_Input_v4float = OpTypePointer Input %v4float
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%a = OpVariable %_ptr_Input_v4float Input
+%b = OpVariable %_ptr_Input_v4float Input
+%o = OpVariable %_ptr_Output_v4float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%la = OpLoad %v4float %a
+%lb = OpLoad %v4float %b
+%ax = OpCompositeExtract %float %la 0
+%ay = OpCompositeExtract %float %la 1
+%az = OpCompositeExtract %float %la 2
+%aw = OpCompositeExtract %float %la 3
+%bx = OpCompositeExtract %float %lb 0
+%by = OpCompositeExtract %float %lb 1
+%bz = OpCompositeExtract %float %lb 2
+%bw = OpCompositeExtract %float %lb 3
+%mx = OpFMul %float %ax %bx
+%my = OpFMul %float %ay %by
+%mz = OpFMul %float %az %bz
+%mw = OpFMul %float %aw %bw
+%r = OpCompositeConstruct %v4float %mx %my %mz %mw
+OpStore %o %r
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SLPVectorizerPass>(text, true);
+}
+
+TEST_F(SLPVectorizerTest, ShuffleLanesAndPackConstants) {
+  const std::string text = R"(
+; CHECK: [[const:%\w+]] = OpConstantComposite %v4float %float_1 %float_2 %float_3 %float_4
+; CHECK: [[la:%\w+]] = OpLoad %v4float %a
+; CHECK-NEXT: [[shuffle:%\w+]] = OpVectorShuffle %v4float [[la]] [[la]] 1 0 3 2
+; CHECK-NEXT: [[add:%\w+]] = OpFAdd %v4float [[shuffle]] [[const]]
+; CHECK-NEXT: OpStore %o [[add]]
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %o
+OpExecutionMode %main OriginUpperLeft
+OpName %a "a"
+OpName %o "o"
+OpDecorate %a Location 0
+OpDecorate %o Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%float_3 = OpConstant %float 3
+%float_4 = OpConstant %float 4
+%_ptr_Input_v4float = OpTypePointer Input %v4float
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%a = OpVariable %_ptr_Input_v4float Input
+%o = OpVariable %_ptr_Output_v4float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%la = OpLoad %v4float %a
+%ax = OpCompositeExtract %float %la 0
+%ay = OpCompositeExtract %float %la 1
+%az = OpCompositeExtract %float %la 2
+%aw = OpCompositeExtract %float %la 3
+%r0 = OpFAdd %float %ay %float_1
+%r1 = OpFAdd %float %ax %float_2
+%r2 = OpFAdd %float %aw %float_3
+%r3 = OpFAdd %float %az %float_4
+%r = OpCompositeConstruct %v4float %r0 %r1 %r2 %r3
+OpStore %o %r
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SLPVectorizerPass>(text, true);
+}
+
+TEST_F(SLPVectorizerTest, KeepScalarsWithOtherUses) {
+  // The sums are also used on their own, so they stay, but vectorizing the
+  // products still saves instructions.
+  const std::string text = R"(
+; CHECK: [[la:%\w+]] = OpLoad %v4float %a
+; CHECK-NEXT: [[lb:%\w+]] = OpLoad %v4float %b
+; CHECK: [[sx:%\w+]] = OpFAdd %float
+; CHECK: [[add:%\w+]] = OpFAdd %v4float [[la]] [[lb]]
+; CHECK-NEXT: [[mul:%\w+]] = OpFMul %v4float [[add]] [[add]]
+; CHECK-NEXT: OpStore %o [[mul]]
+; CHECK-NEXT: [[first:%\w+]] = OpCompositeConstruct %v4float [[sx]] [[sx]] [[sx]] [[sx]]
+; CHECK-NEXT: OpStore %o [[first]]
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %b %o
+OpExecutionMode %main OriginUpperLeft
+OpName %a "a"
+OpName %b "b"
+OpName %o "o"
+OpDecorate %a Location 0
+OpDecorate %b Location 1
+OpDecorate %o Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%_ptr_Input_v4float = OpTypePointer Input %v4float
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%a = OpVariable %_ptr_Input_v4float Input
+%b = OpVariable %_ptr_Input_v4float Input
+%o = OpVariable %_ptr_Output_v4float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%la = OpLoad %v4float %a
+%lb = OpLoad %v4float %b
+%ax = OpCompositeExtract %float %la 0
+%ay = OpCompositeExtract %float %la 1
+%az = OpCompositeExtract %float %la 2
+%aw = OpCompositeExtract %float %la 3
+%bx = OpCompositeExtract %float %lb 0
+%by = OpCompositeExtract %float %lb 1
+%bz = OpCompositeExtract %float %lb 2
+%bw = OpCompositeExtract %float %lb 3
+%sx = OpFAdd %float %ax %bx
+%sy = OpFAdd %float %ay %by
+%sz = OpFAdd %float %az %bz
+%sw = OpFAdd %float %aw %bw
+%mx = OpFMul %float %sx %sx
+%my = OpFMul %float %sy %sy
+%mz = OpFMul %float %sz %sz
+%mw = OpFMul %float %sw %sw
+%r = OpCompositeConstruct %v4float %mx %my %mz %mw
+OpStore %o %r
+%first = OpCompositeConstruct %v4float %sx %sx %sx %sx
+OpStore %o %first
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SLPVectorizerPass>(text, true);
+}
+
+TEST_F(SLPVectorizerTest, DoNotVectorizeWhenGatheringCostsMore) {
+  // Each operand of the vector multiply would have to be gathered from four
+  // unrelated scalars.
+  const std::string text = R"(
+; CHECK-NOT: OpFMul %v4float
+; CHECK: OpCompositeConstruct %v4float {{%\w+}} {{%\w+}} {{%\w+}} {{%\w+}}
+; CHECK-NEXT: OpStore %o
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %s0 %s1 %s2 %s3 %o
+OpExecutionMode %main OriginUpperLeft
+OpName %o "o"
+OpDecorate %s0 Location 2
+OpDecorate %s1 Location 3
+OpDecorate %s2 Location 4
+OpDecorate %s3 Location 5
+OpDecorate %o Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%s0 = OpVariable %_ptr_Input_float Input
+%s1 = OpVariable %_ptr_Input_float Input
+%s2 = OpVariable %_ptr_Input_float Input
+%s3 = OpVariable %_ptr_Input_float Input
+%o = OpVariable %_ptr_Output_v4float Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%f0 = OpLoad %float %s0
+%f1 = OpLoad %float %s1
+%f2 = OpLoad %float %s2
+%f3 = OpLoad %float %s3
+%m0 = OpFMul %float %f0 %f1
+%m1 = OpFMul %float %f1 %f2
+%m2 = OpFMul %float %f2 %f3
+%m3 = OpFMul %float %f3 %f0
+%r = OpCompositeConstruct %v4float %m0 %m1 %m2 %m3
+OpStore %o %r
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SLPVectorizerPass>(text, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
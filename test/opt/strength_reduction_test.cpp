@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "gmock/gmock.h"
+#include "source/opt/strength_reduction_pass.h"
 #include "test/opt/assembly_builder.h"
 #include "test/opt/pass_fixture.h"
 #include "test/opt/pass_utils.h"
@@ -433,6 +434,387 @@ TEST_F(StrengthReductionBasicTest, BasicTestMultipleReplacements) {
       /* skip_nop = */ true, /* do_validate = */ true);
 }
 
+// Returns the |width|-bit value |val| sign extended to 64 bits.
+int64_t SignExtend(uint64_t val, uint32_t width) {
+  if (width == 64) return static_cast<int64_t>(val);
+  const uint64_t sign = uint64_t(1) << (width - 1);
+  return static_cast<int64_t>((val ^ sign) - sign);
+}
+
+uint64_t Mask(uint32_t width) {
+  return width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+// Returns the high half of the product of the |width|-bit unsigned integers
+// |a| and |b|, as computed by OpUMulExtended.
+uint64_t MultiplyHighUnsigned(uint64_t a, uint64_t b, uint32_t width) {
+  if (width == 32) return (a * b) >> 32;
+  const uint64_t a_lo = a & 0xFFFFFFFF;
+  const uint64_t a_hi = a >> 32;
+  const uint64_t b_lo = b & 0xFFFFFFFF;
+  const uint64_t b_hi = b >> 32;
+  const uint64_t lo_lo = a_lo * b_lo;
+  const uint64_t hi_lo = a_hi * b_lo;
+  const uint64_t lo_hi = a_lo * b_hi;
+  const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+  return (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi;
+}
+
+// Returns the high half of the product of the |width|-bit signed integers |a|
+// and |b|, as computed by OpSMulExtended.
+uint64_t MultiplyHighSigned(uint64_t a, uint64_t b, uint32_t width) {
+  uint64_t high = MultiplyHighUnsigned(a, b, width);
+  if (SignExtend(a, width) < 0) high -= b;
+  if (SignExtend(b, width) < 0) high -= a;
+  return high & Mask(width);
+}
+
+uint64_t ShiftRightArithmetic(uint64_t val, uint32_t shift, uint32_t width) {
+  return static_cast<uint64_t>(SignExtend(val, width) >> shift) & Mask(width);
+}
+
+// Evaluates the sequence the pass generates for the unsigned division of |x|
+// by a constant which is not a power of 2, and whose magic numbers are
+// |magic|.
+uint64_t EmulateUnsignedDivision(uint64_t x, const DivisionMagic& magic,
+                                 uint32_t width) {
+  const uint64_t high = MultiplyHighUnsigned(x, magic.multiplier, width);
+  if (!magic.add) return high >> magic.shift;
+  const uint64_t sum = ((((x - high) & Mask(width)) >> 1) + high);
+  return (sum & Mask(width)) >> (magic.shift - 1);
+}
+
+// Evaluates the sequence the pass generates for the signed division of |x| by
+// the constant |d|, whose magic numbers are |magic|.
+uint64_t EmulateSignedDivision(uint64_t x, uint64_t d,
+                               const DivisionMagic& magic, uint32_t width) {
+  const uint64_t mask = Mask(width);
+  const bool negative = SignExtend(d, width) < 0;
+  const uint64_t abs_d = negative ? (0 - d) & mask : d;
+  if ((abs_d & (abs_d - 1)) == 0) {
+    uint32_t k = 0;
+    while (((abs_d >> k) & 1) == 0) ++k;
+    uint64_t bias = k > 1 ? ShiftRightArithmetic(x, k - 1, width) : x;
+    bias >>= width - k;
+    const uint64_t q = ShiftRightArithmetic((x + bias) & mask, k, width);
+    return negative ? (0 - q) & mask : q;
+  }
+
+  uint64_t q = MultiplyHighSigned(x, magic.multiplier, width);
+  const bool negative_multiplier = SignExtend(magic.multiplier, width) < 0;
+  if (!negative && negative_multiplier) q = (q + x) & mask;
+  if (negative && !negative_multiplier) q = (q - x) & mask;
+  q = ShiftRightArithmetic(q, magic.shift, width);
+  return (q + (q >> (width - 1))) & mask;
+}
+
+// Returns interesting |width|-bit values: small values, values close to powers
+// of 2, and values close to the limits of the signed and unsigned ranges.
+std::vector<uint64_t> EdgeValues(uint32_t width) {
+  const uint64_t mask = Mask(width);
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i <= 1000; ++i) {
+    values.push_back(i);
+    values.push_back((0 - i) & mask);
+  }
+  for (uint32_t bit = 10; bit < width; ++bit) {
+    const uint64_t power = uint64_t(1) << bit;
+    for (uint64_t i = 0; i <= 16; ++i) {
+      values.push_back((power + i) & mask);
+      values.push_back((power - i) & mask);
+      values.push_back((0 - power + i) & mask);
+      values.push_back((0 - power - i) & mask);
+    }
+  }
+  values.push_back(0x55555555);
+  values.push_back(0xAAAAAAAA);
+  values.push_back(0x66666666 & mask);
+  values.push_back(0x123456789ABCDEF0 & mask);
+  return values;
+}
+
+// Checks the quotient and remainders computed with the magic numbers of |d|
+// for all the |dividends|.
+void CheckDivisionByConstant(uint64_t d, uint32_t width,
+                             const std::vector<uint64_t>& dividends) {
+  const uint64_t mask = Mask(width);
+  const int64_t sd = SignExtend(d, width);
+  const bool check_unsigned = d > 1 && (d & (d - 1)) != 0;
+  const bool check_signed = sd != -1 && sd != 0 && sd != 1;
+  const DivisionMagic unsigned_magic =
+      check_unsigned ? ComputeUnsignedDivisionMagic(d, width) : DivisionMagic();
+  const DivisionMagic signed_magic =
+      check_signed ? ComputeSignedDivisionMagic(d, width) : DivisionMagic();
+  for (uint64_t x : dividends) {
+    if (check_unsigned) {
+      ASSERT_EQ(x / d, EmulateUnsignedDivision(x, unsigned_magic, width))
+          << x << " / " << d << " (u" << width << ")";
+    }
+    if (!check_signed) continue;
+    const int64_t sx = SignExtend(x, width);
+    const uint64_t q = EmulateSignedDivision(x, d, signed_magic, width);
+    ASSERT_EQ(static_cast<uint64_t>(sx / sd) & mask, q)
+        << sx << " / " << sd << " (s" << width << ")";
+    // The remainders are computed from the quotient as the pass does.
+    const uint64_t rem = (x - q * d) & mask;
+    ASSERT_EQ(static_cast<uint64_t>(sx % sd) & mask, rem);
+    const int64_t srem = SignExtend(rem, width);
+    const uint64_t mod =
+        (sd > 0 && srem < 0) || (sd < 0 && srem > 0) ? (rem + d) & mask : rem;
+    int64_t expected_mod = sx % sd;
+    if (expected_mod != 0 && (expected_mod < 0) != (sd < 0)) {
+      expected_mod += sd;
+    }
+    ASSERT_EQ(static_cast<uint64_t>(expected_mod) & mask, mod);
+  }
+}
+
+TEST(StrengthReductionDivisionMagicTest, Division32) {
+  const std::vector<uint64_t> values = EdgeValues(32);
+  for (uint64_t d : values) CheckDivisionByConstant(d, 32, values);
+}
+
+TEST(StrengthReductionDivisionMagicTest, Division64) {
+  const std::vector<uint64_t> values = EdgeValues(64);
+  for (uint64_t d : values) CheckDivisionByConstant(d, 64, values);
+}
+
+const std::string kDivisionHeader = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %x %xi %out %outi
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+OpName %xi "xi"
+OpName %out "out"
+OpName %outi "outi"
+OpDecorate %x Flat
+OpDecorate %x Location 0
+OpDecorate %xi Flat
+OpDecorate %xi Location 1
+OpDecorate %out Location 0
+OpDecorate %outi Location 1
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%uint = OpTypeInt 32 0
+%int = OpTypeInt 32 1
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%uint_3 = OpConstant %uint 3
+%uint_7 = OpConstant %uint 7
+%uint_8 = OpConstant %uint 8
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_7 = OpConstant %int 7
+%int_n1 = OpConstant %int -1
+%int_n3 = OpConstant %int -3
+%int_n4 = OpConstant %int -4
+%v2uint = OpTypeVector %uint 2
+%v2uint_3 = OpConstantComposite %v2uint %uint_3 %uint_3
+%_ptr_Input_uint = OpTypePointer Input %uint
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_uint = OpTypePointer Output %uint
+%_ptr_Output_int = OpTypePointer Output %int
+%x = OpVariable %_ptr_Input_uint Input
+%xi = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_uint Output
+%outi = OpVariable %_ptr_Output_int Output
+)";
+
+TEST_F(StrengthReductionBasicTest, UnsignedDivisionAndModulo) {
+  const std::string text = R"(
+; CHECK-DAG: [[m:%\w+]] = OpConstant %uint 2863311531
+; CHECK-DAG: [[pair:%\w+]] = OpTypeStruct %uint %uint
+; CHECK: [[x:%\w+]] = OpLoad %uint %x
+; CHECK-NEXT: [[prod:%\w+]] = OpUMulExtended [[pair]] [[x]] [[m]]
+; CHECK-NEXT: [[hi:%\w+]] = OpCompositeExtract %uint [[prod]] 1
+; CHECK-NEXT: [[q:%\w+]] = OpShiftRightLogical %uint [[hi]] %uint_1
+; CHECK-NEXT: [[prod2:%\w+]] = OpUMulExtended [[pair]] [[x]] [[m]]
+; CHECK-NEXT: [[hi2:%\w+]] = OpCompositeExtract %uint [[prod2]] 1
+; CHECK-NEXT: [[q2:%\w+]] = OpShiftRightLogical %uint [[hi2]] %uint_1
+; CHECK-NEXT: [[p:%\w+]] = OpIMul %uint [[q2]] %uint_3
+; CHECK-NEXT: [[r:%\w+]] = OpISub %uint [[x]] [[p]]
+; CHECK-NEXT: OpStore %out [[q]]
+; CHECK-NEXT: OpStore %out [[r]]
+)" + kDivisionHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%q = OpUDiv %uint %ld %uint_3
+%r = OpUMod %uint %ld %uint_3
+OpStore %out %q
+OpStore %out %r
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, true);
+}
+
+TEST_F(StrengthReductionBasicTest, UnsignedDivisionWithWideMultiplier) {
+  // The multiplier for 7 needs 33 bits.
+  const std::string text = R"(
+; CHECK-DAG: [[m:%\w+]] = OpConstant %uint 613566757
+; CHECK: [[x:%\w+]] = OpLoad %uint %x
+; CHECK-NEXT: [[prod:%\w+]] = OpUMulExtended {{%\w+}} [[x]] [[m]]
+; CHECK-NEXT: [[hi:%\w+]] = OpCompositeExtract %uint [[prod]] 1
+; CHECK-NEXT: [[d:%\w+]] = OpISub %uint [[x]] [[hi]]
+; CHECK-NEXT: [[h:%\w+]] = OpShiftRightLogical %uint [[d]] %uint_1
+; CHECK-NEXT: [[s:%\w+]] = OpIAdd %uint [[h]] [[hi]]
+; CHECK-NEXT: [[q:%\w+]] = OpShiftRightLogical %uint [[s]] %uint_2
+; CHECK-NEXT: OpStore %out [[q]]
+)" + kDivisionHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%q = OpUDiv %uint %ld %uint_7
+OpStore %out %q
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, true);
+}
+
+TEST_F(StrengthReductionBasicTest, SignedDivisionAndModulo) {
+  const std::string text = R"(
+; CHECK-DAG: [[m7:%\w+]] = OpConstant %int -1840700269
+; CHECK-DAG: [[m3:%\w+]] = OpConstant %int 1431655765
+; CHECK: [[x:%\w+]] = OpLoad %int %xi
+; CHECK-NEXT: [[prod:%\w+]] = OpSMulExtended {{%\w+}} [[x]] [[m7]]
+; CHECK-NEXT: [[hi:%\w+]] = OpCompositeExtract %int [[prod]] 1
+; CHECK-NEXT: [[a:%\w+]] = OpIAdd %int [[hi]] [[x]]
+; CHECK-NEXT: [[sh:%\w+]] = OpShiftRightArithmetic %int [[a]] %int_2
+; CHECK-NEXT: [[sign:%\w+]] = OpShiftRightLogical %int [[sh]] %int_31
+; CHECK-NEXT: [[q:%\w+]] = OpIAdd %int [[sh]] [[sign]]
+; CHECK-NEXT: [[prod3:%\w+]] = OpSMulExtended {{%\w+}} [[x]] [[m3]]
+; CHECK-NEXT: [[hi3:%\w+]] = OpCompositeExtract %int [[prod3]] 1
+; CHECK-NEXT: [[a3:%\w+]] = OpISub %int [[hi3]] [[x]]
+; CHECK-NEXT: [[sh3:%\w+]] = OpShiftRightArithmetic %int [[a3]] %int_1
+; CHECK-NEXT: [[sign3:%\w+]] = OpShiftRightLogical %int [[sh3]] %int_31
+; CHECK-NEXT: [[q3:%\w+]] = OpIAdd %int [[sh3]] [[sign3]]
+; CHECK-NEXT: [[p:%\w+]] = OpIMul %int [[q3]] %int_n3
+; CHECK-NEXT: [[r:%\w+]] = OpISub %int [[x]] [[p]]
+; CHECK-NEXT: [[pos:%\w+]] = OpSGreaterThan %bool [[r]] %int_0
+; CHECK-NEXT: [[adj:%\w+]] = OpIAdd %int [[r]] %int_n3
+; CHECK-NEXT: [[mod:%\w+]] = OpSelect %int [[pos]] [[adj]] [[r]]
+; CHECK-NEXT: OpStore %outi [[q]]
+; CHECK-NEXT: OpStore %outi [[mod]]
+)" + kDivisionHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %int %xi
+%q = OpSDiv %int %ld %int_7
+%m = OpSMod %int %ld %int_n3
+OpStore %outi %q
+OpStore %outi %m
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, true);
+}
+
+TEST_F(StrengthReductionBasicTest, DivisionByPowerOf2) {
+  const std::string text = R"(
+; CHECK: [[xi:%\w+]] = OpLoad %int %xi
+; CHECK-NEXT: [[b:%\w+]] = OpShiftRightArithmetic %int [[xi]] %int_1
+; CHECK-NEXT: [[b2:%\w+]] = OpShiftRightLogical %int [[b]] %int_30
+; CHECK-NEXT: [[s:%\w+]] = OpIAdd %int [[xi]] [[b2]]
+; CHECK-NEXT: [[q:%\w+]] = OpShiftRightArithmetic %int [[s]] %int_2
+; CHECK-NEXT: [[n:%\w+]] = OpSNegate %int [[q]]
+; CHECK-NEXT: [[x:%\w+]] = OpLoad %uint %x
+; CHECK-NEXT: [[uq:%\w+]] = OpShiftRightLogical %uint [[x]] %uint_3
+; CHECK-NEXT: [[ur:%\w+]] = OpBitwiseAnd %uint [[x]] %uint_7
+; CHECK-NEXT: OpStore %outi [[n]]
+; CHECK-NEXT: OpStore %out [[uq]]
+; CHECK-NEXT: OpStore %out [[ur]]
+)" + kDivisionHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ldi = OpLoad %int %xi
+%q = OpSDiv %int %ldi %int_n4
+%ld = OpLoad %uint %x
+%uq = OpUDiv %uint %ld %uint_8
+%ur = OpUMod %uint %ld %uint_8
+OpStore %outi %q
+OpStore %out %uq
+OpStore %out %ur
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, true);
+}
+
+TEST_F(StrengthReductionBasicTest, UnsignedDivision64) {
+  const std::string text = R"(
+; CHECK-DAG: [[m:%\w+]] = OpConstant %ulong 14757395258967641293
+; CHECK-DAG: [[pair:%\w+]] = OpTypeStruct %ulong %ulong
+; CHECK: [[w:%\w+]] = OpUConvert %ulong
+; CHECK-NEXT: [[prod:%\w+]] = OpUMulExtended [[pair]] [[w]] [[m]]
+; CHECK-NEXT: [[hi:%\w+]] = OpCompositeExtract %ulong [[prod]] 1
+; CHECK-NEXT: [[q:%\w+]] = OpShiftRightLogical %ulong [[hi]] %ulong_3
+; CHECK-NEXT: OpUConvert %uint [[q]]
+OpCapability Shader
+OpCapability Int64
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %x %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+OpName %out "out"
+OpDecorate %x Flat
+OpDecorate %x Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%uint = OpTypeInt 32 0
+%ulong = OpTypeInt 64 0
+%ulong_10 = OpConstant %ulong 10
+%_ptr_Input_uint = OpTypePointer Input %uint
+%_ptr_Output_uint = OpTypePointer Output %uint
+%x = OpVariable %_ptr_Input_uint Input
+%out = OpVariable %_ptr_Output_uint Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%w = OpUConvert %ulong %ld
+%q = OpUDiv %ulong %w %ulong_10
+%n = OpUConvert %uint %q
+OpStore %out %n
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, true);
+}
+
+TEST_F(StrengthReductionBasicTest, DontReplaceDivisionByUnsupportedValues) {
+  // Division by 0, 1 or -1, by a value that is not a constant, and division
+  // of vectors are left alone.
+  const std::string text = kDivisionHeader + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%ld = OpLoad %uint %x
+%ldi = OpLoad %int %xi
+%a = OpUDiv %uint %ld %uint_0
+%b = OpUDiv %uint %ld %uint_1
+%c = OpSDiv %int %ldi %int_n1
+%d = OpSMod %int %ldi %ldi
+%v = OpCompositeConstruct %v2uint %ld %ld
+%e = OpUDiv %v2uint %v %v2uint_3
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<StrengthReductionPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,319 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/switch_to_table_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using SwitchToTableTest = PassTest<::testing::Test>;
+
+TEST_F(SwitchToTableTest, ConvertPhiOfConstants) {
+  const std::string text = R"(
+; CHECK: [[table:%\w+]] = OpConstantComposite {{%\w+}} %int_10 %int_20 %int_30
+; CHECK: [[var:%\w+]] = OpVariable {{%\w+}} Private [[table]]
+; CHECK: %entry = OpLabel
+; CHECK-NEXT: %x = OpLoad %int %in
+; CHECK-NEXT: [[idx:%\w+]] = OpISub %int %x %int_1
+; CHECK-NEXT: [[in:%\w+]] = OpULessThan %bool [[idx]] %int_3
+; CHECK-NEXT: [[safe:%\w+]] = OpSelect %int [[in]] [[idx]] %int_0
+; CHECK-NEXT: [[ptr:%\w+]] = OpAccessChain %_ptr_Private_int [[var]] [[safe]]
+; CHECK-NEXT: [[entry:%\w+]] = OpLoad %int [[ptr]]
+; CHECK-NEXT: [[v:%\w+]] = OpSelect %int [[in]] [[entry]] %int_0
+; CHECK-NEXT: OpBranch %merge
+; CHECK-NOT: %c1 = OpLabel
+; CHECK-NOT: %default = OpLabel
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: OpStore %out [[v]]
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %entry "entry"
+OpName %x "x"
+OpName %c1 "c1"
+OpName %c2 "c2"
+OpName %default "default"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_3 = OpConstant %int 3
+%int_10 = OpConstant %int 10
+%int_20 = OpConstant %int 20
+%int_30 = OpConstant %int 30
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+OpSelectionMerge %merge None
+OpSwitch %x %default 1 %c1 2 %c2 3 %c3
+%c1 = OpLabel
+OpBranch %merge
+%c2 = OpLabel
+OpBranch %merge
+%c3 = OpLabel
+OpBranch %merge
+%default = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%v = OpPhi %int %int_10 %c1 %int_20 %c2 %int_30 %c3 %int_0 %default
+OpStore %out %v
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SwitchToTablePass>(text, true);
+}
+
+TEST_F(SwitchToTableTest, ConvertStoresOfConstants) {
+  // The missing case 1 selects the default value.
+  const std::string text = R"(
+; CHECK: [[table:%\w+]] = OpConstantComposite {{%\w+}} %int_10 %int_0 %int_20
+; CHECK: [[var:%\w+]] = OpVariable {{%\w+}} Private [[table]]
+; CHECK: %x = OpLoad %int %in
+; CHECK-NEXT: [[in:%\w+]] = OpULessThan %bool %x %int_3
+; CHECK-NEXT: [[safe:%\w+]] = OpSelect %int [[in]] %x %int_0
+; CHECK-NEXT: [[ptr:%\w+]] = OpAccessChain %_ptr_Private_int [[var]] [[safe]]
+; CHECK-NEXT: [[entry:%\w+]] = OpLoad %int [[ptr]]
+; CHECK-NEXT: [[v:%\w+]] = OpSelect %int [[in]] [[entry]] %int_0
+; CHECK-NEXT: OpStore %out [[v]]
+; CHECK-NEXT: OpBranch %merge
+; CHECK-NOT: OpLabel
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: OpReturn
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %entry "entry"
+OpName %x "x"
+OpName %c1 "c1"
+OpName %c2 "c2"
+OpName %default "default"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_3 = OpConstant %int 3
+%int_10 = OpConstant %int 10
+%int_20 = OpConstant %int 20
+%int_30 = OpConstant %int 30
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+OpSelectionMerge %merge None
+OpSwitch %x %default 0 %c1 2 %c2
+%c1 = OpLabel
+OpStore %out %int_10
+OpBranch %merge
+%c2 = OpLabel
+OpStore %out %int_20
+OpBranch %merge
+%default = OpLabel
+OpStore %out %int_0
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SwitchToTablePass>(text, true);
+}
+
+TEST_F(SwitchToTableTest, DontConvertNonConstantValue) {
+  const std::string text = R"(
+; CHECK: OpSwitch %x %default 1 %c1 2 %c2 3 {{%\w+}}
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: OpPhi %int %int_10 %c1
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %entry "entry"
+OpName %x "x"
+OpName %c1 "c1"
+OpName %c2 "c2"
+OpName %default "default"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_3 = OpConstant %int 3
+%int_10 = OpConstant %int 10
+%int_20 = OpConstant %int 20
+%int_30 = OpConstant %int 30
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+OpSelectionMerge %merge None
+OpSwitch %x %default 1 %c1 2 %c2 3 %c3
+%c1 = OpLabel
+OpBranch %merge
+%c2 = OpLabel
+OpBranch %merge
+%c3 = OpLabel
+OpBranch %merge
+%default = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%v = OpPhi %int %int_10 %c1 %int_20 %c2 %int_30 %c3 %x %default
+OpStore %out %v
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SwitchToTablePass>(text, true);
+}
+
+TEST_F(SwitchToTableTest, DontConvertSparseCases) {
+  // A table for cases 1 to 100 would be mostly default values.
+  const std::string text = R"(
+; CHECK-NOT: OpConstantComposite
+; CHECK: OpSwitch %x %default 1 %c1 50 %c2 100 {{%\w+}}
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %entry "entry"
+OpName %x "x"
+OpName %c1 "c1"
+OpName %c2 "c2"
+OpName %default "default"
+OpName %merge "merge"
+OpDecorate %in Flat
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_3 = OpConstant %int 3
+%int_10 = OpConstant %int 10
+%int_20 = OpConstant %int 20
+%int_30 = OpConstant %int 30
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+OpSelectionMerge %merge None
+OpSwitch %x %default 1 %c1 50 %c2 100 %c3
+%c1 = OpLabel
+OpBranch %merge
+%c2 = OpLabel
+OpBranch %merge
+%c3 = OpLabel
+OpBranch %merge
+%default = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%v = OpPhi %int %int_10 %c1 %int_20 %c2 %int_30 %c3 %int_0 %default
+OpStore %out %v
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SwitchToTablePass>(text, true);
+}
+
+TEST_F(SwitchToTableTest, DontConvertInKernel) {
+  // Kernels cannot declare the Private variable holding the table.
+  const std::string text = R"(
+OpCapability Addresses
+OpCapability Kernel
+OpCapability Linkage
+OpMemoryModel Physical32 OpenCL
+OpEntryPoint Kernel %main "main"
+%void = OpTypeVoid
+%int = OpTypeInt 32 0
+%fn = OpTypeFunction %void %int
+%int_10 = OpConstant %int 10
+%int_20 = OpConstant %int 20
+%int_30 = OpConstant %int 30
+%main = OpFunction %void None %fn
+%x = OpFunctionParameter %int
+%entry = OpLabel
+OpSelectionMerge %merge None
+OpSwitch %x %default 0 %c1 1 %c2
+%c1 = OpLabel
+OpBranch %merge
+%c2 = OpLabel
+OpBranch %merge
+%default = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%v = OpPhi %int %int_10 %c1 %int_20 %c2 %int_30 %default
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result = SinglePassRunAndDisassemble<SwitchToTablePass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
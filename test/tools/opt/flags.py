@@ -151,6 +151,7 @@ class TestPerformanceOptimizationPasses(expect.ValidObjectFile1_3,
       'eliminate-local-multi-store',
       'eliminate-dead-code-aggressive',
       'ccp',
+      'switch-to-table',
       'eliminate-dead-code-aggressive',
       'redundancy-elimination',
       'combine-access-chains',
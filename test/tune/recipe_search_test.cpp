@@ -0,0 +1,108 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "tools/tune/recipe_search.h"
+
+namespace spvtools {
+namespace tune {
+namespace {
+
+// The number of random changes each test makes.
+const int kIterations = 2000;
+
+// Returns a recipe of |length| copies of a tunable flag.
+Recipe MakeRecipe(size_t length) { return Recipe(length, "--ccp"); }
+
+TEST(RecipeSearchTest, IsTunableFlag) {
+  EXPECT_TRUE(IsTunableFlag("--ccp"));
+  EXPECT_TRUE(IsTunableFlag("--jump-thread=64"));
+  EXPECT_FALSE(IsTunableFlag("ccp"));
+  EXPECT_FALSE(IsTunableFlag("--ccp=1"));
+  EXPECT_FALSE(IsTunableFlag("--jump-thread"));
+  EXPECT_FALSE(IsTunableFlag("--jump-thread=65"));
+  EXPECT_FALSE(IsTunableFlag("--strip-debug"));
+}
+
+TEST(RecipeSearchTest, MutateNeverEmptiesRecipe) {
+  std::mt19937 rng(1);
+  Recipe recipe = MakeRecipe(1);
+  for (int i = 0; i < kIterations; ++i) {
+    Mutate(&recipe, &rng);
+    ASSERT_FALSE(recipe.empty());
+  }
+}
+
+TEST(RecipeSearchTest, MutateKeepsLengthCap) {
+  std::mt19937 rng(1);
+  Recipe recipe = MakeRecipe(kMaxRecipeLength);
+  for (int i = 0; i < kIterations; ++i) {
+    Mutate(&recipe, &rng);
+    ASSERT_LE(recipe.size(), kMaxRecipeLength);
+  }
+}
+
+TEST(RecipeSearchTest, MutateAddsOnlyTunableFlags) {
+  // Flags of the starting recipe that are not tunable are kept as they are.
+  std::mt19937 rng(1);
+  Recipe recipe = {"--strip-debug", "--jump-thread=16"};
+  for (int i = 0; i < kIterations; ++i) {
+    Mutate(&recipe, &rng);
+    for (const std::string& flag : recipe) {
+      ASSERT_TRUE(flag == "--strip-debug" || IsTunableFlag(flag)) << flag;
+    }
+  }
+}
+
+TEST(RecipeSearchTest, CrossoverNeverReturnsEmptyRecipe) {
+  std::mt19937 rng(1);
+  const Recipe first = MakeRecipe(1);
+  const Recipe second = {"--vector-dce"};
+  for (int i = 0; i < kIterations; ++i) {
+    ASSERT_FALSE(Crossover(first, second, &rng).empty());
+  }
+}
+
+TEST(RecipeSearchTest, CrossoverKeepsLengthCap) {
+  std::mt19937 rng(1);
+  const Recipe first = MakeRecipe(kMaxRecipeLength + 10);
+  const Recipe second = Recipe(kMaxRecipeLength, "--vector-dce");
+  for (int i = 0; i < kIterations; ++i) {
+    ASSERT_LE(Crossover(first, second, &rng).size(), kMaxRecipeLength);
+  }
+}
+
+TEST(RecipeSearchTest, CrossoverTakesFlagsFromParents) {
+  std::mt19937 rng(1);
+  const Recipe first = {"--ccp", "--merge-blocks", "--jump-thread=16"};
+  const Recipe second = {"--vector-dce", "--strip-debug"};
+  for (int i = 0; i < kIterations; ++i) {
+    const Recipe child = Crossover(first, second, &rng);
+    // A prefix of |first|, then a suffix of |second|.
+    size_t j = 0;
+    while (j < child.size() && j < first.size() && child[j] == first[j]) ++j;
+    const size_t suffix = child.size() - j;
+    ASSERT_LE(suffix, second.size());
+    for (size_t k = 0; k < suffix; ++k) {
+      ASSERT_EQ(second[second.size() - suffix + k], child[j + k]);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tune
+}  // namespace spvtools
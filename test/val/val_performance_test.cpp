@@ -0,0 +1,119 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for the per-instruction cost of the validator.
+//
+// These tests only check that the generated modules are valid. They record
+// the average validation time per instruction as test properties, so the
+// numbers can be compared between revisions of the validator, e.g.:
+//
+//   test/val/test_val_performance --gtest_output=xml:perf.xml
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "spirv-tools/libspirv.hpp"
+#include "test/unit_spirv.h"
+#include "test/val/val_fixtures.h"
+
+namespace spvtools {
+namespace val {
+namespace {
+
+using ::testing::HasSubstr;
+
+using ValidatePerformance = spvtest::ValidateBase<uint32_t>;
+
+// Returns a module with |num_types| decorated struct types, each used by a
+// unique function type, a pointer type, a variable and a function. This
+// exercises the id tables, the decoration tables and the type uniqueness
+// checks of the validation state.
+std::string GenerateModule(uint32_t num_types) {
+  std::ostringstream ss;
+  ss << "OpCapability Shader\n"
+     << "OpCapability Linkage\n"
+     << "OpMemoryModel Logical GLSL450\n";
+  for (uint32_t i = 0; i < num_types; ++i) {
+    ss << "OpName %s" << i << " \"s" << i << "\"\n";
+  }
+  for (uint32_t i = 0; i < num_types; ++i) {
+    ss << "OpDecorate %s" << i << " Block\n"
+       << "OpMemberDecorate %s" << i << " 0 Offset 0\n"
+       << "OpMemberDecorate %s" << i << " 1 Offset 4\n";
+  }
+  ss << "%void = OpTypeVoid\n"
+     << "%void_fn = OpTypeFunction %void\n"
+     << "%int = OpTypeInt 32 1\n"
+     << "%float = OpTypeFloat 32\n";
+  for (uint32_t i = 0; i < num_types; ++i) {
+    ss << "%s" << i << " = OpTypeStruct %int %float\n"
+       << "%fn" << i << " = OpTypeFunction %void %s" << i << "\n"
+       << "%p" << i << " = OpTypePointer Private %s" << i << "\n"
+       << "%v" << i << " = OpVariable %p" << i << " Private\n";
+  }
+  for (uint32_t i = 0; i < num_types; ++i) {
+    ss << "%f" << i << " = OpFunction %void None %void_fn\n"
+       << "%l" << i << " = OpLabel\n"
+       << "OpReturn\n"
+       << "OpFunctionEnd\n";
+  }
+  return ss.str();
+}
+
+TEST_P(ValidatePerformance, PerInstruction) {
+  const uint32_t num_types = GetParam();
+  CompileSuccessfully(GenerateModule(num_types));
+
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+  const auto end = std::chrono::steady_clock::now();
+
+  const size_t num_instructions = vstate_->ordered_instructions().size();
+  const double ns_per_instruction =
+      std::chrono::duration<double, std::nano>(end - start).count() /
+      static_cast<double>(num_instructions);
+  RecordProperty("instructions", static_cast<int>(num_instructions));
+  RecordProperty("ns_per_instruction", static_cast<int>(ns_per_instruction));
+}
+
+INSTANTIATE_TEST_CASE_P(ModuleSizes, ValidatePerformance,
+                        ::testing::Values(256u, 1024u, 4096u));
+
+#if defined(SPIRV_TIMER_ENABLED)
+using ValidateTimeReport = spvtest::ValidateBase<bool>;
+
+TEST_F(ValidateTimeReport, ReportsEachPassAndParsePhase) {
+  std::ostringstream report;
+  spvValidatorOptionsSetTimeReport(getValidatorOptions(), &report);
+  CompileSuccessfully(GenerateModule(4));
+  ASSERT_EQ(SPV_SUCCESS, ValidateInstructions());
+  spvValidatorOptionsSetTimeReport(getValidatorOptions(), nullptr);
+
+  const std::string out = report.str();
+  EXPECT_THAT(out, HasSubstr("PASS name"));
+  EXPECT_THAT(out, HasSubstr("Calls"));
+  EXPECT_THAT(out, HasSubstr("Parse extensions"));
+  EXPECT_THAT(out, HasSubstr("Parse instructions"));
+  EXPECT_THAT(out, HasSubstr("ImagePass"));
+  EXPECT_THAT(out, HasSubstr("ValidateDecorations"));
+  EXPECT_THAT(out, HasSubstr("PerformCfgChecks"));
+  EXPECT_THAT(out, HasSubstr("ValidateBuiltIns"));
+}
+#endif  // defined(SPIRV_TIMER_ENABLED)
+
+}  // namespace
+}  // namespace val
+}  // namespace spvtools
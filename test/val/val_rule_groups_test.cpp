@@ -0,0 +1,184 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for selecting the groups of rules checked by the validator.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/unit_spirv.h"
+#include "test/val/val_fixtures.h"
+
+namespace spvtools {
+namespace val {
+namespace {
+
+using ::testing::HasSubstr;
+
+using ValidateRuleGroups = spvtest::ValidateBase<bool>;
+
+const char kHeader[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+)";
+
+const char kTypes[] = R"(
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%u32 = OpTypeInt 32 0
+%f1 = OpConstant %float 1
+%u1 = OpConstant %u32 1
+)";
+
+// Returns a module with a single function whose body is |body|.
+std::string GenerateModule(const std::string& preamble,
+                           const std::string& body) {
+  return std::string(kHeader) + preamble + kTypes + R"(
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+)" + body + R"(
+OpReturn
+OpFunctionEnd
+)";
+}
+
+TEST_F(ValidateRuleGroups, ImageRulesSkipped) {
+  const std::string spirv =
+      GenerateModule("", "%res = OpImageRead %v4float %f1 %u1\n");
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("Expected Image to be of type OpTypeImage"));
+
+  spvValidatorOptionsSetRuleGroups(
+      getValidatorOptions(),
+      spv_validator_rule_group_all & ~spv_validator_rule_group_image);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateRuleGroups, AtomicsRulesSkipped) {
+  const std::string spirv = GenerateModule("", "OpMemoryBarrier %f1 %u1\n");
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("expected Memory Scope to be a 32-bit int"));
+
+  spvValidatorOptionsSetRuleGroups(
+      getValidatorOptions(),
+      spv_validator_rule_group_all & ~spv_validator_rule_group_atomics);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateRuleGroups, ExtensionsRulesSkipped) {
+  const std::string spirv =
+      GenerateModule("%glsl = OpExtInstImport \"GLSL.std.450\"\n",
+                     "%res = OpExtInst %u32 %glsl Sqrt %f1\n");
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  EXPECT_THAT(
+      getDiagnosticString(),
+      HasSubstr("expected Result Type to be a float scalar or vector type"));
+
+  spvValidatorOptionsSetRuleGroups(
+      getValidatorOptions(),
+      spv_validator_rule_group_all & ~spv_validator_rule_group_extensions);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateRuleGroups, DecorationsRulesSkipped) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpCapability VulkanMemoryModelKHR
+OpExtension "SPV_KHR_vulkan_memory_model"
+OpMemoryModel Logical VulkanKHR
+OpDecorate %var Coherent
+%u32 = OpTypeInt 32 0
+%ptr = OpTypePointer Private %u32
+%var = OpVariable %ptr Private
+)";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("is banned when using the Vulkan memory model"));
+
+  spvValidatorOptionsSetRuleGroups(
+      getValidatorOptions(),
+      spv_validator_rule_group_all & ~spv_validator_rule_group_decorations);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateRuleGroups, BuiltInsRulesSkipped) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpDecorate %workgroup_size BuiltIn WorkgroupSize
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%u32 = OpTypeInt 32 0
+%workgroup_size = OpConstant %u32 16
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%copy = OpCopyObject %u32 %workgroup_size
+OpReturn
+OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv, SPV_ENV_VULKAN_1_0);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions(SPV_ENV_VULKAN_1_0));
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("BuiltIn WorkgroupSize variable needs to be a "
+                        "3-component 32-bit int vector"));
+
+  spvValidatorOptionsSetRuleGroups(
+      getValidatorOptions(),
+      spv_validator_rule_group_all & ~spv_validator_rule_group_builtins);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions(SPV_ENV_VULKAN_1_0));
+}
+
+// The structural profile still checks the structural rules.
+TEST_F(ValidateRuleGroups, StructuralRulesAlwaysChecked) {
+  const std::string spirv =
+      GenerateModule("", "%res = OpFAdd %float %f1 %u1\n");
+
+  CompileSuccessfully(spirv);
+  spvValidatorOptionsSetRuleGroups(getValidatorOptions(),
+                                   spv_validator_rule_group_none);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("Expected arithmetic operands to be of Result Type"));
+}
+
+TEST_F(ValidateRuleGroups, StructuralProfileAcceptsValidModule) {
+  const std::string spirv =
+      GenerateModule("", "%res = OpFAdd %float %f1 %f1\n");
+
+  CompileSuccessfully(spirv);
+  spvValidatorOptionsSetRuleGroups(getValidatorOptions(),
+                                   spv_validator_rule_group_none);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+}  // namespace
+}  // namespace val
+}  // namespace spvtools
@@ -182,6 +182,33 @@ TEST_F(ValidationStateTest, CheckEntryPoints) {
             vstate_->FindDef(vstate_->entry_points()[0])->opcode());
 }
 
+// Tests that the per-id tables are indexed by id and grow to hold the largest
+// id registered in them, never past the id bound.
+TEST_F(ValidationStateTest, CheckIdIndexedTables) {
+  std::string spirv = std::string(kHeader) + R"(
+                OpDecorate %struct Block
+                OpMemberDecorate %struct 0 Offset 0
+       %int   = OpTypeInt 32 0
+       %struct = OpTypeStruct %int
+  )";
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+  const ValidationState_t& state = *vstate_;
+  // %int, the largest id, is assigned id 2.
+  EXPECT_EQ(size_t(3), state.all_definitions().size());
+  // Only %struct has decorations; validation may look up %int as well.
+  EXPECT_LE(size_t(2), state.id_decorations().size());
+  EXPECT_GE(size_t(3), state.id_decorations().size());
+  // %struct is assigned id 1 since it is referenced first.
+  EXPECT_EQ(SpvOpTypeStruct, state.all_definitions()[1]->opcode());
+  EXPECT_EQ(nullptr, state.all_definitions()[0]);
+  EXPECT_EQ(size_t(2), state.id_decorations(1).size());
+  EXPECT_TRUE(state.id_decorations(2).empty());
+  // Ids outside of the tables have no decorations and no definition.
+  EXPECT_TRUE(state.id_decorations(100).empty());
+  EXPECT_EQ(nullptr, state.FindDef(100));
+}
+
 TEST_F(ValidationStateTest, CheckStructMemberLimitOption) {
   spvValidatorOptionsSetUniversalLimit(
       options_, spv_validator_limit_max_struct_members, 32000u);
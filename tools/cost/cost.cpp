@@ -0,0 +1,266 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "source/opt/build_module.h"
+#include "source/opt/cost_analysis.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/log.h"
+#include "source/spirv_target_env.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/optimizer.hpp"
+#include "tools/io.h"
+#include "tools/util/cli_consumer.h"
+
+namespace {
+
+const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_3;
+
+void PrintUsage(const char* program) {
+  // NOTE: Please maintain flags in lexicographical order.
+  printf(
+      R"(%s - Estimate the cycles each entry point of a SPIR-V module takes to
+run, without running it.
+
+USAGE: %s [options] [<input>]
+
+The SPIR-V binary is read from <input>. If no file is specified,
+or if <input> is "-", then the binary is read from standard input.
+
+Each block costs the larger of the issue cycles of its instructions and the
+latency of their longest dependency chain, plus the cost of the functions it
+calls.  Blocks are weighted by how often they run, from a profile or from the
+trip counts of loops and static branch probabilities.  Blocks that need more
+registers than the budget pay for the values they spill.
+
+Options (in lexicographical order):
+  --cost-table=<file>
+               Read the cost of opcodes from <file>.  Each line gives the name
+               of an opcode, such as OpFMul, or "default" for the opcodes
+               not listed, followed by its latency and its issue cycles.
+               Text following a '#' is ignored.  Opcodes not in the file keep
+               their built-in cost.
+  -h, --help
+               Print this help.
+  --json
+               Print the estimates as JSON instead of text.
+  --profile=<file>
+               Use the block counts of <file> as the frequencies of the blocks
+               of the functions it covers.  The file is the text written by
+               ProfileToText from the counters recorded by a module
+               instrumented with spirv-opt --inst-profile.
+  --register-budget=<n>
+               The number of values that can be live at the same time without
+               spilling.  Defaults to 64.
+  --spill-cost=<cycles>
+               The cycles a block costs for each value it needs above the
+               register budget.  Defaults to 20.
+  --target-env=<env>
+               Set the target environment. Without this flag the target
+               enviroment defaults to spv1.3.
+               <env> must be one of vulkan1.0, vulkan1.1, opencl2.2, spv1.0,
+               spv1.1, spv1.2, spv1.3, or webgpu0.
+  --trip-count=<n>
+               The trip count assumed for loops whose trip count is not known.
+               Defaults to 8.
+  --version
+               Display version information.
+)",
+      program, program);
+}
+
+// Returns the name of the execution model |model|.
+std::string ExecutionModelName(SpvExecutionModel model) {
+  switch (model) {
+    case SpvExecutionModelVertex:
+      return "Vertex";
+    case SpvExecutionModelTessellationControl:
+      return "TessellationControl";
+    case SpvExecutionModelTessellationEvaluation:
+      return "TessellationEvaluation";
+    case SpvExecutionModelGeometry:
+      return "Geometry";
+    case SpvExecutionModelFragment:
+      return "Fragment";
+    case SpvExecutionModelGLCompute:
+      return "GLCompute";
+    case SpvExecutionModelKernel:
+      return "Kernel";
+    default:
+      return std::to_string(static_cast<uint32_t>(model));
+  }
+}
+
+// Returns |str| as a JSON string literal.
+std::string JsonString(const std::string& str) {
+  std::string result = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      result += escaped;
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+// Reads the whole file named |filename| into |text|.  Returns false and
+// reports the error if it cannot be read.
+bool ReadTextFile(const char* filename, std::string* text) {
+  std::ifstream input_file(filename);
+  if (input_file.fail()) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Could not open file '%s'", filename);
+    return false;
+  }
+  std::stringstream contents;
+  contents << input_file.rdbuf();
+  *text = contents.str();
+  return true;
+}
+
+// Parses the positive integer value of the flag |arg| of the form
+// '--flag=VALUE' into |value|.  Returns false and reports the error if it is
+// not a positive integer.
+bool ParseUintFlag(const char* arg, uint32_t* value) {
+  const char* str = strchr(arg, '=') + 1;
+  char* end = nullptr;
+  long parsed = strtol(str, &end, 10);
+  if (end == str || *end != '\0' || parsed <= 0) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Invalid argument for %s", arg);
+    return false;
+  }
+  *value = static_cast<uint32_t>(parsed);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  const char* in_file = nullptr;
+  spv_target_env target_env = kDefaultEnvironment;
+  spvtools::opt::CostTable table;
+  spvtools::opt::CostOptions options;
+  std::vector<spvtools::ProfileBlockCount> profile;
+  bool has_profile = false;
+  bool json = false;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--version")) {
+      printf("%s\n", spvSoftwareVersionDetailsString());
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--json")) {
+      json = true;
+    } else if (0 == strncmp(cur_arg, "--cost-table=", 13)) {
+      std::string text;
+      std::string error;
+      if (!ReadTextFile(cur_arg + 13, &text)) return 1;
+      if (!table.ParseText(text, &error)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid cost table '%s': %s", cur_arg + 13,
+                         error.c_str());
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--profile=", 10)) {
+      std::string text;
+      if (!ReadTextFile(cur_arg + 10, &text)) return 1;
+      if (!spvtools::ParseProfileText(text, &profile)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid profile file '%s'", cur_arg + 10);
+        return 1;
+      }
+      has_profile = true;
+    } else if (0 == strncmp(cur_arg, "--register-budget=", 18)) {
+      if (!ParseUintFlag(cur_arg, &options.register_budget)) return 1;
+    } else if (0 == strncmp(cur_arg, "--spill-cost=", 13)) {
+      char* end = nullptr;
+      options.spill_cost = strtod(cur_arg + 13, &end);
+      if (end == cur_arg + 13 || *end != '\0' || options.spill_cost < 0) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid argument for %s", cur_arg);
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--target-env=", 13)) {
+      if (!spvParseTargetEnv(cur_arg + 13, &target_env)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid target environment '%s'", cur_arg + 13);
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--trip-count=", 13)) {
+      if (!ParseUintFlag(cur_arg, &options.default_trip_count)) return 1;
+    } else if ('-' == cur_arg[0] && '\0' != cur_arg[1]) {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "Unknown argument '%s'", cur_arg);
+      return 1;
+    } else if (in_file == nullptr) {
+      in_file = cur_arg;
+    } else {
+      spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                      "More than one input file specified");
+      return 1;
+    }
+  }
+
+  std::vector<uint32_t> binary;
+  if (!ReadFile<uint32_t>(in_file, "rb", &binary)) return 1;
+
+  std::unique_ptr<spvtools::opt::IRContext> context =
+      spvtools::BuildModule(target_env, spvtools::utils::CLIMessageConsumer,
+                            binary.data(), binary.size());
+  if (context == nullptr) return 1;
+
+  spvtools::opt::CostAnalysis analysis(context.get(), table, options);
+  if (has_profile) analysis.SetProfile(profile);
+  std::vector<spvtools::opt::EntryPointCost> costs =
+      analysis.EstimateEntryPoints();
+
+  if (json) {
+    printf("{\n  \"entry_points\": [");
+    for (size_t i = 0; i < costs.size(); ++i) {
+      const spvtools::opt::EntryPointCost& cost = costs[i];
+      printf(
+          "%s\n    {\n      \"name\": %s,\n      \"execution_model\": %s,\n"
+          "      \"function_id\": %u,\n      \"cycles\": %.2f,\n"
+          "      \"max_registers\": %zu\n    }",
+          i == 0 ? "" : ",", JsonString(cost.name).c_str(),
+          JsonString(ExecutionModelName(cost.execution_model)).c_str(),
+          cost.function_id, cost.cycles, cost.max_registers);
+    }
+    printf("%s]\n}\n", costs.empty() ? "" : "\n  ");
+  } else {
+    for (const spvtools::opt::EntryPointCost& cost : costs) {
+      printf("%s (%s): %.2f cycles, %zu registers\n", cost.name.c_str(),
+             ExecutionModelName(cost.execution_model).c_str(), cost.cycles,
+             cost.max_registers);
+    }
+  }
+  return 0;
+}
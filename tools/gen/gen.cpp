@@ -0,0 +1,173 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "source/opt/log.h"
+#include "source/spirv_target_env.h"
+#include "spirv-tools/libspirv.hpp"
+#include "tools/gen/module_generator.h"
+#include "tools/io.h"
+#include "tools/util/cli_consumer.h"
+
+namespace {
+
+const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_3;
+
+void PrintUsage(const char* program) {
+  // NOTE: Please maintain flags in lexicographical order.
+  printf(
+      R"(%s - Generate a valid synthetic SPIR-V module of a given shape.
+
+USAGE: %s [options] [-o <output>]
+
+The module has a fragment shader entry point that calls each generated
+function in turn.  Each function has a nest of selections and loops, a
+switch, and a chain of selections whose phis each use the previous one.
+Unused struct types, constants and decorations are added to the module.
+
+The binary is written to <output>. If no file is specified, or if <output>
+is "-", then it is written to standard output.
+
+Options (in lexicographical order):
+  --constants=<n>
+               Declare <n> integer constants.  Defaults to 32.
+  --decorations=<n>
+               Decorate <n> members of the struct types.  Defaults to 16.
+  --entry-point=<name>
+               Name the entry point <name>.  Defaults to main.
+  --functions=<n>
+               Generate <n> functions.  Defaults to 4.
+  -h, --help
+               Print this help.
+  --nesting-depth=<n>
+               Nest selections and loops <n> deep in each function.
+               Defaults to 4.
+  --phi-chain=<n>
+               Chain <n> selections in each function.  Defaults to 8.
+  --scale=<n>
+               Multiply every count but the nesting depth by <n>.
+  --switch-cases=<n>
+               Give the switch of each function <n> cases, or no switch if
+               <n> is 0.  Defaults to 8.
+  --target-env=<env>
+               Set the target environment. Without this flag the target
+               enviroment defaults to spv1.3.
+               <env> must be one of vulkan1.0, vulkan1.1, opencl2.2, spv1.0,
+               spv1.1, spv1.2, spv1.3, or webgpu0.
+  --text
+               Write the assembly instead of the binary.
+  --types=<n>
+               Declare <n> struct types.  Defaults to 16.
+  --version
+               Display version information.
+)",
+      program, program);
+}
+
+// Parses the non-negative integer value of the flag |arg| of the form
+// '--flag=VALUE' into |value|.  Returns false and reports the error if it is
+// not a non-negative integer.
+bool ParseCountFlag(const char* arg, uint32_t* value) {
+  const char* str = strchr(arg, '=') + 1;
+  char* end = nullptr;
+  long parsed = strtol(str, &end, 10);
+  if (end == str || *end != '\0' || parsed < 0) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Invalid argument for %s", arg);
+    return false;
+  }
+  *value = static_cast<uint32_t>(parsed);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  const char* out_file = nullptr;
+  spv_target_env target_env = kDefaultEnvironment;
+  spvtools::gen::ModuleShape shape;
+  uint32_t scale = 1;
+  bool text = false;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--version")) {
+      printf("%s\n", spvSoftwareVersionDetailsString());
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--text")) {
+      text = true;
+    } else if (0 == strcmp(cur_arg, "-o")) {
+      if (argi + 1 >= argc) {
+        spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                        "Missing argument to -o");
+        return 1;
+      }
+      out_file = argv[++argi];
+    } else if (0 == strncmp(cur_arg, "--constants=", 12)) {
+      if (!ParseCountFlag(cur_arg, &shape.constants)) return 1;
+    } else if (0 == strncmp(cur_arg, "--decorations=", 14)) {
+      if (!ParseCountFlag(cur_arg, &shape.decorations)) return 1;
+    } else if (0 == strncmp(cur_arg, "--entry-point=", 14)) {
+      shape.entry_point_name = cur_arg + 14;
+    } else if (0 == strncmp(cur_arg, "--functions=", 12)) {
+      if (!ParseCountFlag(cur_arg, &shape.functions)) return 1;
+    } else if (0 == strncmp(cur_arg, "--nesting-depth=", 16)) {
+      if (!ParseCountFlag(cur_arg, &shape.nesting_depth)) return 1;
+    } else if (0 == strncmp(cur_arg, "--phi-chain=", 12)) {
+      if (!ParseCountFlag(cur_arg, &shape.phi_chain_length)) return 1;
+    } else if (0 == strncmp(cur_arg, "--scale=", 8)) {
+      if (!ParseCountFlag(cur_arg, &scale)) return 1;
+    } else if (0 == strncmp(cur_arg, "--switch-cases=", 15)) {
+      if (!ParseCountFlag(cur_arg, &shape.switch_cases)) return 1;
+    } else if (0 == strncmp(cur_arg, "--target-env=", 13)) {
+      if (!spvParseTargetEnv(cur_arg + 13, &target_env)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid target environment '%s'", cur_arg + 13);
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--types=", 8)) {
+      if (!ParseCountFlag(cur_arg, &shape.types)) return 1;
+    } else {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "Unknown argument '%s'", cur_arg);
+      return 1;
+    }
+  }
+  shape.Scale(scale);
+
+  if (text) {
+    std::string assembly = spvtools::gen::GenerateModuleText(shape);
+    return WriteFile<char>(out_file, "w", assembly.data(), assembly.size())
+               ? 0
+               : 1;
+  }
+
+  std::vector<uint32_t> binary;
+  if (!spvtools::gen::GenerateModule(target_env, shape, &binary)) {
+    spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                    "Could not assemble the generated module");
+    return 1;
+  }
+  return WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())
+             ? 0
+             : 1;
+}
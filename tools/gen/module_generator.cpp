@@ -0,0 +1,313 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/gen/module_generator.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace gen {
+namespace {
+
+// Writes the assembly of a module of a given shape.  Ids are named after
+// what they are: %b for blocks, %v for values, %f for functions, %s for
+// struct types and %c for constants.
+class Generator {
+ public:
+  explicit Generator(const ModuleShape& shape) : shape_(shape) {}
+
+  std::string Generate();
+
+ private:
+  // Returns a new id starting with |prefix|.
+  std::string NewId(const char* prefix) {
+    return "%" + std::string(prefix) + std::to_string(next_id_++);
+  }
+
+  // Starts the block |label|.
+  void StartBlock(const std::string& label) {
+    out_ << label << " = OpLabel\n";
+    block_ = label;
+  }
+
+  // Returns the number of scalar members of each struct type.
+  uint32_t MembersPerStruct() const {
+    if (shape_.types == 0) return 0;
+    return std::max<uint32_t>(
+        1, (shape_.decorations + shape_.types - 1) / shape_.types);
+  }
+
+  void EmitHeader();
+  void EmitTypes();
+  void EmitFunction(uint32_t index);
+  void EmitMain();
+
+  // Emits a nest |depth| deep of selections and loops into the current block,
+  // that computes |result| from |value|.  Ends in the block where |result| is
+  // available.
+  void EmitRegion(uint32_t depth, const std::string& value,
+                  const std::string& result);
+
+  // Emits a switch on |value| with a case for each of the |switch_cases| of
+  // the shape, and returns the value merged from the cases.
+  std::string EmitSwitch(const std::string& value);
+
+  // Emits |phi_chain_length| selections, whose phis each merge the previous
+  // one, starting from |value|.  Returns the last phi.
+  std::string EmitPhiChain(const std::string& value);
+
+  const ModuleShape& shape_;
+  std::ostringstream out_;
+  // The current block.
+  std::string block_;
+  uint32_t next_id_ = 0;
+};
+
+std::string Generator::Generate() {
+  EmitHeader();
+  EmitTypes();
+  for (uint32_t i = 0; i < shape_.functions; ++i) EmitFunction(i);
+  EmitMain();
+  return out_.str();
+}
+
+void Generator::EmitHeader() {
+  out_ << "OpCapability Shader\n"
+       << "OpMemoryModel Logical GLSL450\n"
+       << "OpEntryPoint Fragment %main \"" << shape_.entry_point_name
+       << "\" %in %out\n"
+       << "OpExecutionMode %main OriginUpperLeft\n"
+       << "OpDecorate %in Flat\n"
+       << "OpDecorate %in Location 0\n"
+       << "OpDecorate %out Location 0\n";
+
+  // Struct types other than the first one start with a member of an earlier
+  // struct type.
+  const uint32_t members = MembersPerStruct();
+  for (uint32_t i = 0; i < shape_.decorations && members != 0; ++i) {
+    uint32_t type = i / members;
+    uint32_t member = i % members + (type == 0 ? 0 : 1);
+    out_ << "OpMemberDecorate %s" << type << " " << member
+         << " RelaxedPrecision\n";
+  }
+}
+
+void Generator::EmitTypes() {
+  out_ << "%void = OpTypeVoid\n"
+       << "%bool = OpTypeBool\n"
+       << "%int = OpTypeInt 32 1\n"
+       << "%float = OpTypeFloat 32\n"
+       << "%fn_void = OpTypeFunction %void\n"
+       << "%fn_int = OpTypeFunction %int %int\n"
+       << "%_ptr_Input_int = OpTypePointer Input %int\n"
+       << "%_ptr_Output_int = OpTypePointer Output %int\n"
+       << "%in = OpVariable %_ptr_Input_int Input\n"
+       << "%out = OpVariable %_ptr_Output_int Output\n";
+  for (uint32_t i = 0; i <= 4; ++i) {
+    out_ << "%int_" << i << " = OpConstant %int " << i << "\n";
+  }
+  for (uint32_t i = 0; i < shape_.constants; ++i) {
+    out_ << "%c" << i << " = OpConstant %int " << 1000 + i << "\n";
+  }
+
+  // The parent of each struct type is the one at half its index, so that the
+  // types form a balanced tree rather than a chain as deep as the number of
+  // types.
+  const uint32_t members = MembersPerStruct();
+  for (uint32_t i = 0; i < shape_.types; ++i) {
+    out_ << "%s" << i << " = OpTypeStruct";
+    if (i != 0) out_ << " %s" << (i - 1) / 2;
+    for (uint32_t j = 0; j < members; ++j) {
+      out_ << (j % 2 == 0 ? " %int" : " %float");
+    }
+    out_ << "\n";
+  }
+}
+
+void Generator::EmitFunction(uint32_t index) {
+  std::string param = "%p" + std::to_string(index);
+  out_ << "%f" << index << " = OpFunction %int None %fn_int\n"
+       << param << " = OpFunctionParameter %int\n";
+  StartBlock(NewId("b"));
+  std::string value = NewId("v");
+  EmitRegion(shape_.nesting_depth, param, value);
+  if (shape_.switch_cases != 0) value = EmitSwitch(value);
+  value = EmitPhiChain(value);
+  out_ << "OpReturnValue " << value << "\n"
+       << "OpFunctionEnd\n";
+}
+
+void Generator::EmitMain() {
+  out_ << "%main = OpFunction %void None %fn_void\n";
+  StartBlock(NewId("b"));
+  std::string value = NewId("v");
+  out_ << value << " = OpLoad %int %in\n";
+  for (uint32_t i = 0; i < shape_.functions; ++i) {
+    std::string result = NewId("v");
+    out_ << result << " = OpFunctionCall %int %f" << i << " " << value << "\n";
+    value = result;
+  }
+  out_ << "OpStore %out " << value << "\n"
+       << "OpReturn\n"
+       << "OpFunctionEnd\n";
+}
+
+void Generator::EmitRegion(uint32_t depth, const std::string& value,
+                           const std::string& result) {
+  if (depth == 0) {
+    out_ << result << " = OpIAdd %int " << value << " %int_1\n";
+    return;
+  }
+
+  if (depth % 2 == 1) {
+    // A selection whose then branch holds the rest of the nest.
+    std::string condition = NewId("v");
+    std::string then_label = NewId("b");
+    std::string else_label = NewId("b");
+    std::string merge_label = NewId("b");
+    std::string then_value = NewId("v");
+    std::string else_value = NewId("v");
+    out_ << condition << " = OpSGreaterThan %bool " << value << " %int_0\n"
+         << "OpSelectionMerge " << merge_label << " None\n"
+         << "OpBranchConditional " << condition << " " << then_label << " "
+         << else_label << "\n";
+    StartBlock(then_label);
+    EmitRegion(depth - 1, value, then_value);
+    std::string then_end = block_;
+    out_ << "OpBranch " << merge_label << "\n";
+    StartBlock(else_label);
+    out_ << else_value << " = OpISub %int " << value << " %int_1\n"
+         << "OpBranch " << merge_label << "\n";
+    StartBlock(merge_label);
+    out_ << result << " = OpPhi %int " << then_value << " " << then_end << " "
+         << else_value << " " << else_label << "\n";
+    return;
+  }
+
+  // A loop of 4 iterations whose body holds the rest of the nest, and whose
+  // header phi |result| accumulates the value.
+  std::string preheader = block_;
+  std::string header = NewId("b");
+  std::string body = NewId("b");
+  std::string continue_label = NewId("b");
+  std::string merge_label = NewId("b");
+  std::string induction = NewId("v");
+  std::string next_induction = NewId("v");
+  std::string next_value = NewId("v");
+  std::string condition = NewId("v");
+  out_ << "OpBranch " << header << "\n";
+  StartBlock(header);
+  out_ << induction << " = OpPhi %int %int_0 " << preheader << " "
+       << next_induction << " " << continue_label << "\n"
+       << result << " = OpPhi %int " << value << " " << preheader << " "
+       << next_value << " " << continue_label << "\n"
+       << condition << " = OpSLessThan %bool " << induction << " %int_4\n"
+       << "OpLoopMerge " << merge_label << " " << continue_label << " None\n"
+       << "OpBranchConditional " << condition << " " << body << " "
+       << merge_label << "\n";
+  StartBlock(body);
+  EmitRegion(depth - 1, result, next_value);
+  out_ << "OpBranch " << continue_label << "\n";
+  StartBlock(continue_label);
+  out_ << next_induction << " = OpIAdd %int " << induction << " %int_1\n"
+       << "OpBranch " << header << "\n";
+  StartBlock(merge_label);
+}
+
+std::string Generator::EmitSwitch(const std::string& value) {
+  std::string default_label = NewId("b");
+  std::string merge_label = NewId("b");
+  std::vector<std::string> case_labels;
+  for (uint32_t i = 0; i < shape_.switch_cases; ++i)
+    case_labels.push_back(NewId("b"));
+
+  out_ << "OpSelectionMerge " << merge_label << " None\n"
+       << "OpSwitch " << value << " " << default_label;
+  for (uint32_t i = 0; i < shape_.switch_cases; ++i)
+    out_ << " " << i << " " << case_labels[i];
+  out_ << "\n";
+
+  std::string result = NewId("v");
+  std::ostringstream phi;
+  phi << result << " = OpPhi %int";
+  for (uint32_t i = 0; i < shape_.switch_cases; ++i) {
+    StartBlock(case_labels[i]);
+    std::string case_value = NewId("v");
+    if (i % 2 == 0) {
+      out_ << case_value << " = OpIMul %int " << value << " %int_3\n";
+    } else {
+      out_ << case_value << " = OpISub %int " << value << " %int_2\n";
+    }
+    out_ << "OpBranch " << merge_label << "\n";
+    phi << " " << case_value << " " << case_labels[i];
+  }
+  StartBlock(default_label);
+  out_ << "OpBranch " << merge_label << "\n";
+  phi << " " << value << " " << default_label;
+
+  StartBlock(merge_label);
+  out_ << phi.str() << "\n";
+  return result;
+}
+
+std::string Generator::EmitPhiChain(const std::string& value) {
+  std::string current = value;
+  for (uint32_t i = 0; i < shape_.phi_chain_length; ++i) {
+    std::string predecessor = block_;
+    std::string condition = NewId("v");
+    std::string then_label = NewId("b");
+    std::string merge_label = NewId("b");
+    std::string then_value = NewId("v");
+    std::string phi = NewId("v");
+    out_ << condition << " = OpSGreaterThan %bool " << current << " %int_0\n"
+         << "OpSelectionMerge " << merge_label << " None\n"
+         << "OpBranchConditional " << condition << " " << then_label << " "
+         << merge_label << "\n";
+    StartBlock(then_label);
+    out_ << then_value << " = OpIAdd %int " << current << " %int_1\n"
+         << "OpBranch " << merge_label << "\n";
+    StartBlock(merge_label);
+    out_ << phi << " = OpPhi %int " << then_value << " " << then_label << " "
+         << current << " " << predecessor << "\n";
+    current = phi;
+  }
+  return current;
+}
+
+}  // namespace
+
+void ModuleShape::Scale(uint32_t factor) {
+  functions *= factor;
+  switch_cases *= factor;
+  phi_chain_length *= factor;
+  types *= factor;
+  constants *= factor;
+  decorations *= factor;
+}
+
+std::string GenerateModuleText(const ModuleShape& shape) {
+  return Generator(shape).Generate();
+}
+
+bool GenerateModule(spv_target_env env, const ModuleShape& shape,
+                    std::vector<uint32_t>* binary) {
+  SpirvTools tools(env);
+  return tools.Assemble(GenerateModuleText(shape), binary);
+}
+
+}  // namespace gen
+}  // namespace spvtools
@@ -0,0 +1,61 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLS_GEN_MODULE_GENERATOR_H_
+#define TOOLS_GEN_MODULE_GENERATOR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "spirv-tools/libspirv.h"
+
+namespace spvtools {
+namespace gen {
+
+// The shape of a synthetic module.  The module has a fragment shader entry
+// point that calls |functions| functions in turn.  Each function has a nest
+// of selections and loops |nesting_depth| deep, followed by a switch with
+// |switch_cases| cases, and by |phi_chain_length| selections whose phis each
+// use the previous one.
+struct ModuleShape {
+  uint32_t functions = 4;
+  uint32_t nesting_depth = 4;
+  uint32_t switch_cases = 8;
+  uint32_t phi_chain_length = 8;
+  // Struct types that are declared but not used.  Each struct contains an
+  // earlier one, so that the types form a tree.
+  uint32_t types = 16;
+  // Integer constants that are declared but not used.
+  uint32_t constants = 32;
+  // RelaxedPrecision decorations, on the members of the struct types.
+  uint32_t decorations = 16;
+  std::string entry_point_name = "main";
+
+  // Multiplies every count but the nesting depth by |factor|.
+  void Scale(uint32_t factor);
+};
+
+// Returns the assembly of a valid module of shape |shape|.
+std::string GenerateModuleText(const ModuleShape& shape);
+
+// Writes the binary of a valid module of shape |shape| to |binary|.  Returns
+// false if it cannot be assembled for |env|.
+bool GenerateModule(spv_target_env env, const ModuleShape& shape,
+                    std::vector<uint32_t>* binary);
+
+}  // namespace gen
+}  // namespace spvtools
+
+#endif  // TOOLS_GEN_MODULE_GENERATOR_H_
@@ -0,0 +1,430 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/opt/log.h"
+#include "source/spirv_target_env.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/linker.hpp"
+#include "spirv-tools/optimizer.hpp"
+#include "tools/gen/module_generator.h"
+#include "tools/util/cli_consumer.h"
+
+#if defined(SPIRV_SCALE_MARKV)
+#include "source/comp/markv.h"
+#include "tools/comp/markv_model_factory.h"
+#endif
+
+namespace {
+
+const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_3;
+
+// Components faster than this at the largest scale are not flagged, as their
+// time is mostly noise.
+const double kMinFlaggedSeconds = 0.001;
+
+// Passes that are not in the -O and -Os recipes but are measured too.
+const char* kExtraPasses[] = {
+    "compact-ids",
+    "eliminate-dead-functions",
+    "gvn-pre",
+    "jump-thread",
+    "local-redundancy-elimination",
+    "loop-invariant-code-motion",
+    "loop-peeling",
+    "loop-unroll-auto",
+    "loop-unswitch",
+    "strength-reduction",
+};
+
+// The modules a component runs on at one scale.  The second one has a
+// different entry point name, so that the two can be linked.
+struct Inputs {
+  std::vector<uint32_t> first;
+  std::vector<uint32_t> second;
+};
+
+// A component whose time is measured.  |run| returns false if it fails.
+struct Component {
+  std::string name;
+  std::function<bool(const Inputs&)> run;
+  // The fastest time of each scale at which it ran, in seconds, or a
+  // negative value if it failed.
+  std::vector<double> seconds;
+};
+
+void PrintUsage(const char* program) {
+  // NOTE: Please maintain flags in lexicographical order.
+  printf(
+      R"(%s - Measure how the time of the validator, of each optimizer pass,
+of the linker and of the MARK-V codec grows with the size of the module.
+
+USAGE: %s [options]
+
+Synthetic modules are generated at scales 1, 2, 4, ... up to --max-scale, as
+spirv-gen --scale does, and each component is timed on them.  A component is
+flagged when its time grows faster than O(n log n), n being the size of the
+module, between the two largest scales at which it ran.  The MARK-V codec is
+only measured when SPIRV_BUILD_COMPRESSION is enabled.
+
+Returns 1 if the generated modules are not valid, or if any component fails
+or is flagged.
+
+Options (in lexicographical order):
+  --dimension=<dimension>
+               Which part of the shape of the module grows.  <dimension> is
+               one of all (the default), constants, decorations, functions,
+               nesting, phis, switch or types.
+  -h, --help
+               Print this help.
+  --max-scale=<n>
+               The largest scale.  Defaults to 64.
+  --max-seconds=<seconds>
+               A component that takes longer than this at one scale is not run
+               at larger ones.  Defaults to 10.
+  --pass=<flag>
+               Measure the optimizer pass of spirv-opt flag <flag>, such as
+               ccp or scalar-replacement=100, instead of every pass of the -O
+               and -Os recipes and the loop passes.  May be repeated.
+  --repeat=<n>
+               Time each component <n> times at each scale and keep the
+               fastest.  Defaults to 3.
+  --slack=<factor>
+               Flag a component when its time grows more than <factor> times
+               as fast as n log n.  Defaults to 1.5.
+  --target-env=<env>
+               Set the target environment. Without this flag the target
+               enviroment defaults to spv1.3.
+               <env> must be one of vulkan1.0, vulkan1.1, opencl2.2, spv1.0,
+               spv1.1, spv1.2, spv1.3, or webgpu0.
+  --version
+               Display version information.
+)",
+      program, program);
+}
+
+// Parses the positive integer value of the flag |arg| of the form
+// '--flag=VALUE' into |value|.  Returns false and reports the error if it is
+// not a positive integer.
+bool ParseUintFlag(const char* arg, uint32_t* value) {
+  const char* str = strchr(arg, '=') + 1;
+  char* end = nullptr;
+  long parsed = strtol(str, &end, 10);
+  if (end == str || *end != '\0' || parsed <= 0) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Invalid argument for %s", arg);
+    return false;
+  }
+  *value = static_cast<uint32_t>(parsed);
+  return true;
+}
+
+// Parses the positive value of the flag |arg| of the form '--flag=VALUE' into
+// |value|.  Returns false and reports the error if it is not positive.
+bool ParseDoubleFlag(const char* arg, double* value) {
+  const char* str = strchr(arg, '=') + 1;
+  char* end = nullptr;
+  *value = strtod(str, &end);
+  if (end == str || *end != '\0' || *value <= 0) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Invalid argument for %s", arg);
+    return false;
+  }
+  return true;
+}
+
+// Grows the |dimension| of |shape| by |factor|.  Returns false if |dimension|
+// is not a known dimension.
+bool ScaleShape(const std::string& dimension, uint32_t factor,
+                spvtools::gen::ModuleShape* shape) {
+  if (dimension == "all") {
+    shape->Scale(factor);
+  } else if (dimension == "constants") {
+    shape->constants *= factor;
+  } else if (dimension == "decorations") {
+    shape->decorations *= factor;
+  } else if (dimension == "functions") {
+    shape->functions *= factor;
+  } else if (dimension == "nesting") {
+    shape->nesting_depth *= factor;
+  } else if (dimension == "phis") {
+    shape->phi_chain_length *= factor;
+  } else if (dimension == "switch") {
+    shape->switch_cases *= factor;
+  } else if (dimension == "types") {
+    shape->types *= factor;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns the fastest of |repeat| runs of |component| on |inputs|, in
+// seconds, or a negative value if it fails.
+double TimeComponent(const Component& component, const Inputs& inputs,
+                     uint32_t repeat) {
+  double best = std::numeric_limits<double>::infinity();
+  for (uint32_t i = 0; i < repeat; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    if (!component.run(inputs)) return -1;
+    best = std::min(best, std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+  }
+  return best;
+}
+
+// Returns the pass flags measured by default: those of the -O and -Os
+// recipes, once each, and the extra passes.
+std::vector<std::string> GetDefaultPasses(spv_target_env env) {
+  std::vector<std::string> passes;
+  auto add_pass = [&passes](const std::string& pass) {
+    if (std::find(passes.begin(), passes.end(), pass) == passes.end())
+      passes.push_back(pass);
+  };
+  spvtools::Optimizer performance(env);
+  performance.RegisterPerformancePasses();
+  for (const char* name : performance.GetPassNames()) add_pass(name);
+  spvtools::Optimizer size(env);
+  size.RegisterSizePasses();
+  for (const char* name : size.GetPassNames()) add_pass(name);
+  for (const char* name : kExtraPasses) add_pass(name);
+  return passes;
+}
+
+// Returns the components to measure: the validator, the passes of |passes|,
+// the linker and, if it is built, the MARK-V codec.
+std::vector<Component> GetComponents(spv_target_env env,
+                                     const std::vector<std::string>& passes) {
+  std::vector<Component> components;
+  components.push_back({"validator",
+                        [env](const Inputs& inputs) {
+                          spvtools::SpirvTools tools(env);
+                          return tools.Validate(inputs.first);
+                        },
+                        {}});
+  for (const std::string& pass : passes) {
+    std::string flag = "--" + pass;
+    components.push_back({pass,
+                          [env, flag](const Inputs& inputs) {
+                            spvtools::Optimizer optimizer(env);
+                            spvtools::OptimizerOptions options;
+                            options.set_run_validator(false);
+                            std::vector<uint32_t> optimized;
+                            return optimizer.RegisterPassesFromFlags({flag}) &&
+                                   optimizer.Run(inputs.first.data(),
+                                                 inputs.first.size(),
+                                                 &optimized, options);
+                          },
+                          {}});
+  }
+  components.push_back({"linker",
+                        [env](const Inputs& inputs) {
+                          spvtools::Context context(env);
+                          std::vector<uint32_t> linked;
+                          return spvtools::Link(context,
+                                                {inputs.first, inputs.second},
+                                                &linked) == SPV_SUCCESS;
+                        },
+                        {}});
+#if defined(SPIRV_SCALE_MARKV)
+  std::shared_ptr<spvtools::comp::MarkvModel> model =
+      spvtools::comp::CreateMarkvModel(spvtools::comp::kMarkvModelShaderMid);
+  components.push_back(
+      {"markv",
+       [env, model](const Inputs& inputs) {
+         spv_context context = spvContextCreate(env);
+         std::vector<uint8_t> markv;
+         spv_result_t result = spvtools::comp::SpirvToMarkv(
+             context, inputs.first, spvtools::comp::MarkvCodecOptions(),
+             *model, [](spv_message_level_t, const char*,
+                        const spv_position_t&, const char*) {},
+             spvtools::comp::MarkvLogConsumer(),
+             spvtools::comp::MarkvDebugConsumer(), &markv);
+         spvContextDestroy(context);
+         return result == SPV_SUCCESS;
+       },
+       {}});
+#endif
+  return components;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  spv_target_env target_env = kDefaultEnvironment;
+  std::string dimension = "all";
+  std::vector<std::string> passes;
+  uint32_t max_scale = 64;
+  uint32_t repeat = 3;
+  double max_seconds = 10;
+  double slack = 1.5;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--version")) {
+      printf("%s\n", spvSoftwareVersionDetailsString());
+      return 0;
+    } else if (0 == strncmp(cur_arg, "--dimension=", 12)) {
+      dimension = cur_arg + 12;
+      spvtools::gen::ModuleShape shape;
+      if (!ScaleShape(dimension, 1, &shape)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid dimension '%s'", dimension.c_str());
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--max-scale=", 12)) {
+      if (!ParseUintFlag(cur_arg, &max_scale)) return 1;
+    } else if (0 == strncmp(cur_arg, "--max-seconds=", 14)) {
+      if (!ParseDoubleFlag(cur_arg, &max_seconds)) return 1;
+    } else if (0 == strncmp(cur_arg, "--pass=", 7)) {
+      passes.push_back(cur_arg + 7);
+    } else if (0 == strncmp(cur_arg, "--repeat=", 9)) {
+      if (!ParseUintFlag(cur_arg, &repeat)) return 1;
+    } else if (0 == strncmp(cur_arg, "--slack=", 8)) {
+      if (!ParseDoubleFlag(cur_arg, &slack)) return 1;
+    } else if (0 == strncmp(cur_arg, "--target-env=", 13)) {
+      if (!spvParseTargetEnv(cur_arg + 13, &target_env)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid target environment '%s'", cur_arg + 13);
+        return 1;
+      }
+    } else {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "Unknown argument '%s'", cur_arg);
+      return 1;
+    }
+  }
+
+  if (passes.empty()) passes = GetDefaultPasses(target_env);
+  for (const std::string& pass : passes) {
+    spvtools::Optimizer optimizer(target_env);
+    optimizer.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
+    if (!optimizer.RegisterPassesFromFlags({"--" + pass})) return 1;
+  }
+  std::vector<Component> components = GetComponents(target_env, passes);
+
+  // Time every component at each scale.
+  std::vector<uint32_t> scales;
+  std::vector<size_t> sizes;
+  for (uint32_t scale = 1; scale <= max_scale; scale *= 2) {
+    spvtools::gen::ModuleShape shape;
+    ScaleShape(dimension, scale, &shape);
+    Inputs inputs;
+    bool generated = spvtools::gen::GenerateModule(target_env, shape,
+                                                   &inputs.first);
+    shape.entry_point_name = "main2";
+    generated = generated && spvtools::gen::GenerateModule(target_env, shape,
+                                                           &inputs.second);
+    if (!generated) {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "Could not generate the module at scale %u", scale);
+      return 1;
+    }
+    // The timings are only meaningful if the generator gives valid modules.
+    spvtools::SpirvTools tools(target_env);
+    tools.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
+    if (!tools.Validate(inputs.first)) {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "The module generated at scale %u is not valid",
+                       scale);
+      return 1;
+    }
+    scales.push_back(scale);
+    sizes.push_back(inputs.first.size());
+    fprintf(stderr, "Scale %ux: %zu words\n", scale, inputs.first.size());
+
+    for (Component& component : components) {
+      // Stop after a failure or a run that is too slow.
+      if (!component.seconds.empty() &&
+          (component.seconds.back() < 0 ||
+           component.seconds.back() > max_seconds)) {
+        continue;
+      }
+      component.seconds.push_back(TimeComponent(component, inputs, repeat));
+    }
+    if (scale > std::numeric_limits<uint32_t>::max() / 2) break;
+  }
+
+  printf("%-32s", "component (ms)");
+  for (uint32_t scale : scales) printf(" %9ux", scale);
+  printf(" %10s\n", "exponent");
+
+  std::vector<std::string> flagged;
+  std::string failed;
+  for (const Component& component : components) {
+    printf("%-32s", component.name.c_str());
+    for (size_t i = 0; i < scales.size(); ++i) {
+      if (i >= component.seconds.size()) {
+        printf(" %10s", "-");
+      } else if (component.seconds[i] < 0) {
+        printf(" %10s", "failed");
+        failed += " " + component.name;
+      } else {
+        printf(" %10.2f", component.seconds[i] * 1000);
+      }
+    }
+
+    // Compare the growth between the two largest scales with n log n.
+    size_t last = component.seconds.size();
+    if (last < 2 || component.seconds[last - 1] < 0 ||
+        component.seconds[last - 2] <= 0 ||
+        sizes[last - 1] <= sizes[last - 2]) {
+      printf("\n");
+      continue;
+    }
+    double size_ratio =
+        static_cast<double>(sizes[last - 1]) / sizes[last - 2];
+    double time_ratio =
+        component.seconds[last - 1] / component.seconds[last - 2];
+    double nlogn_ratio = size_ratio * std::log2(sizes[last - 1]) /
+                         std::log2(sizes[last - 2]);
+    printf(" %10.2f", std::log(time_ratio) / std::log(size_ratio));
+    if (component.seconds[last - 1] >= kMinFlaggedSeconds &&
+        time_ratio > slack * nlogn_ratio) {
+      printf("  super-linear");
+      flagged.push_back(component.name);
+    }
+    printf("\n");
+  }
+
+  if (flagged.empty()) {
+    printf("\nNo component grows faster than O(n log n).\n");
+  } else {
+    printf("\n%zu components grow faster than O(n log n):", flagged.size());
+    for (const std::string& name : flagged) printf(" %s", name.c_str());
+    printf("\n");
+  }
+  if (!failed.empty()) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Components failed on the generated modules:%s",
+                     failed.c_str());
+    return 1;
+  }
+  return flagged.empty() ? 0 : 1;
+}
@@ -104,6 +104,10 @@ Options (in lexicographical order):
                Cleanup the control flow graph. This will remove any unnecessary
                code from the CFG like unreachable code. Performed on entry
                point call tree functions and exported functions.
+  --code-sink
+               Does register-pressure-aware code sinking.  Moves instructions
+               without side effects into the successor block that uses them,
+               when this lowers the number of live values.
   --combine-access-chains
                Combines chained access chains to produce a single instruction
                where possible.
@@ -142,6 +146,9 @@ Options (in lexicographical order):
                Deletes unreferenced inserts into composites, most notably
                unused stores to vector components, that are not removed by
                aggressive dead code elimination.
+  --eliminate-dead-stores
+               Deletes stores to memory outside of the Function storage class
+               that are always overwritten before the memory can be read.
   --eliminate-dead-variables
                Deletes module scope variables that are not referenced.
   --eliminate-insert-extract
@@ -162,6 +169,10 @@ Options (in lexicographical order):
                only stored once. Performed on variables referenceed only with
                loads and stores. Performed only on entry point call tree
                functions.
+  --eliminate-redundant-loads
+               Replace loads whose value is already available from a store
+               or an earlier load of the same address, across blocks and in
+               any storage class.
   --flatten-decorations
                Replace decoration groups with repeated OpDecorate and
                OpMemberDecorate instructions.
@@ -172,12 +183,47 @@ Options (in lexicographical order):
   --freeze-spec-const
                Freeze the values of specialization constants to their default
                values.
+  --gvn-pre[=<max_registers>]
+               Removes the computations of values that are already computed on
+               every path reaching them.  Computes the value on the paths where
+               it is missing, when it is computed on some of them, and merges
+               the values with a phi.  Values are not made live out of blocks
+               that already need <max_registers> registers, 64 by default.
   --if-conversion
                Convert if-then-else like assignments into OpSelect.
   --inline-entry-points-exhaustive
                Exhaustively inline all function calls in entry point call tree
                functions. Currently does not inline calls to functions with
                early return in a loop.
+  --inline-heuristic[=<budget>]
+               Inlines the function calls in entry point call tree functions
+               that the cost model finds profitable, from the size of the
+               callee, its number of call sites, the constant arguments and
+               the loop depth of the call.  Calls passing or returning opaque
+               types or pointers are always inlined.  The other inlined calls
+               grow the module by at most <budget> instructions, 1024 by
+               default.
+  --inst-profile[=<blocks|edges>]
+               Instruments the module to count the executions of its blocks,
+               or of the edges between them, in a storage buffer at binding 1
+               of descriptor set 7.  Counting the edges needs fewer counters.
+               The counts are read back with GetProfileBlockCounts.
+  --ipcp[=<budget>]
+               Propagates the constant arguments of function calls into the
+               called functions, and clones functions for the combinations of
+               constant arguments shared by the most calls.  The clones add at
+               most <budget> instructions to the module, 1024 by default.
+               Runs --ccp and --eliminate-dead-branches afterwards to fold the
+               specialized code, then --eliminate-dead-functions to remove
+               the functions no longer called.
+  --jump-thread[=<budget>]
+               Branches the predecessors of a selection merge block directly
+               to the targets of its conditional branch, when each of them
+               decides the condition, and removes the block.  When only some
+               of them decide it, branches those to copies of small targets.
+               Loops are left as they are.  Also copies small return blocks
+               into their predecessors.  The copies add at most <budget>
+               instructions to each function, 64 by default.
   --legalize-hlsl
                Runs a series of optimizations that attempts to take SPIR-V
                generated by an HLSL front-end and generates legal Vulkan SPIR-V.
@@ -200,11 +246,21 @@ Options (in lexicographical order):
                registers too much, while reducing the number of loads from
                memory. Takes an additional positive integer argument to set
                the maximum number of registers.
+  --loop-interchange
+               Swaps the loops of perfect nests of two loops when the memory
+               accesses of the body are closer together along the outer loop,
+               and the dependences between iterations allow it.
   --loop-invariant-code-motion
                Identifies code in loops that has the same value for every
                iteration of the loop, and move it to the loop pre-header.
   --loop-unroll
                Fully unrolls loops marked with the Unroll flag
+  --loop-unroll-auto[=<budget>]
+               Fully or partially unrolls the loops for which the cost model
+               finds it profitable, from their trip count, their size and the
+               estimated register pressure.  Loops with the DontUnroll flag
+               are left alone.  Each function grows by at most <budget>
+               instructions, 1024 by default.
   --loop-unroll-partial
                Partially unrolls loops marked with the Unroll flag. Takes an
                additional non-0 integer argument to set the unroll factor, or
@@ -217,6 +273,11 @@ Options (in lexicographical order):
                growth threshold. The threshold prevents the loop peeling
                from happening if the code size increase created by
                the optimization is above the threshold.
+  --loop-tile=<size>
+               Splits the inner loop of perfect nests of two loops into tiles
+               of <size> iterations, and moves the loop over the tiles out of
+               the outer loop, when the body accesses memory contiguously
+               along both loops.  <size> must be a positive integer.
   --max-id-bound=<n>
                Sets the maximum value for the id bound for the moudle.  The
                default is the minimum value for this limit, 0x3FFFFF.  See
@@ -225,6 +286,9 @@ Options (in lexicographical order):
                Join two blocks into a single block if the second has the
                first as its only predecessor. Performed only on entry point
                call tree functions.
+  --merge-functions
+               Replaces the functions that are identical except for their ids
+               by a single copy.  Entry points and exported functions are kept.
   --merge-return
                Changes functions that have multiple return statements so they
                have a single return statement.
@@ -292,6 +356,19 @@ Options (in lexicographical order):
   --private-to-local
                Change the scope of private variables that are used in a single
                function to that function.
+  --profile-use=<file>
+               Optimizes with the block execution counts of the profile in
+               <file>, which must come from the input module.  Each line of
+               the profile gives the id of a function, the id of a block and
+               its count.  Lines starting with the character '#' are
+               comments.  Calls in blocks that never ran are not inlined by
+               --inline-heuristic, loops that never ran are not unrolled by
+               --loop-unroll-auto, and --if-conversion does not speculate
+               the rarely taken side of a branch.
+  --range-fold
+               Replaces integer comparisons, clamps and min/max operations
+               whose result is known from the range of their operands. The
+               ranges come from constants and loop trip counts.
   --reduce-load-size
                Replaces loads of composite objects where not every component is
                used by loads of just the elements that are used.
@@ -332,6 +409,11 @@ Options (in lexicographical order):
                Will not validate the SPIR-V before optimizing.  If the SPIR-V
                is invalid, the optimizer may fail or generate incorrect code.
                This options should be used rarely, and with caution.
+  --slp-vectorize
+               Replaces the identical scalar operations computing the
+               components of a vector by vector operations, when this saves
+               instructions.  Runs --vector-dce and --simplify-instructions
+               afterwards to clean up the result.
   --strength-reduction
                Replaces instructions with equivalent and less expensive ones.
   --strip-debug
@@ -339,6 +421,10 @@ Options (in lexicographical order):
   --strip-reflect
                Remove all reflection information.  For now, this covers
                reflection information defined by SPV_GOOGLE_hlsl_functionality1.
+  --switch-to-table
+               Replaces each switch whose cases only select constant scalars,
+               as phi values or as stores to the same pointer, by a load from
+               a constant array and a select of the default value.
   --target-env=<env>
                Set the target environment. Without this flag the target
                enviroment defaults to spv1.3.
@@ -420,6 +506,30 @@ bool ReadFlagsFromFile(const char* oconfig_flag,
   return true;
 }
 
+// Reads the execution profile in the file named in |profile_flag|, of the
+// form '--profile-use=FILENAME', into |profile|.  Returns false and reports
+// the error if the file cannot be read or is not a valid profile.
+bool ReadProfileFile(const char* profile_flag,
+                     std::vector<spvtools::ProfileBlockCount>* profile) {
+  const char* fname = strchr(profile_flag, '=') + 1;
+  std::ifstream input_file;
+  input_file.open(fname);
+  if (input_file.fail()) {
+    spvtools::Errorf(opt_diagnostic, nullptr, {}, "Could not open file '%s'",
+                     fname);
+    return false;
+  }
+
+  std::stringstream text;
+  text << input_file.rdbuf();
+  if (!spvtools::ParseProfileText(text.str(), profile)) {
+    spvtools::Errorf(opt_diagnostic, nullptr, {}, "Invalid profile file '%s'",
+                     fname);
+    return false;
+  }
+  return true;
+}
+
 OptStatus ParseFlags(int argc, const char** argv,
                      spvtools::Optimizer* optimizer, const char** in_file,
                      const char** out_file,
@@ -553,6 +663,13 @@ OptStatus ParseFlags(int argc, const char** argv,
         optimizer->SetPrintAll(&std::cerr);
       } else if (0 == strcmp(cur_arg, "--time-report")) {
         optimizer->SetTimeReport(&std::cerr);
+      } else if (0 == strncmp(cur_arg, "--profile-use=",
+                              sizeof("--profile-use=") - 1)) {
+        std::vector<spvtools::ProfileBlockCount> profile;
+        if (!ReadProfileFile(cur_arg, &profile)) {
+          return {OPT_STOP, 1};
+        }
+        optimizer->SetProfile(profile);
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         validator_options->SetRelaxStructStore(true);
       } else if (0 == strncmp(cur_arg, "--max-id-bound=",
@@ -100,10 +100,10 @@ class StatsAggregator {
     if (inst->opcode() != SpvOpConstant) return;
 
     const uint32_t type_id = inst->GetOperandAs<uint32_t>(0);
-    const auto type_decl_it = vstate_->all_definitions().find(type_id);
-    assert(type_decl_it != vstate_->all_definitions().end());
+    const val::Instruction* type_decl = vstate_->FindDef(type_id);
+    assert(type_decl);
 
-    const val::Instruction& type_decl_inst = *type_decl_it->second;
+    const val::Instruction& type_decl_inst = *type_decl;
     const SpvOp type_op = type_decl_inst.opcode();
     if (type_op == SpvOpTypeInt) {
       const uint32_t bit_width = type_decl_inst.GetOperandAs<uint32_t>(1);
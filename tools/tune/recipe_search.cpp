@@ -0,0 +1,168 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/tune/recipe_search.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace spvtools {
+namespace tune {
+namespace {
+
+// A flag that the search may add to a recipe.  Flags with values take one of
+// them as argument.  Unused values are 0.
+struct TunableFlag {
+  const char* name;
+  uint32_t values[4];
+};
+
+const TunableFlag kTunableFlags[] = {
+    {"ccp", {}},
+    {"cfg-cleanup", {}},
+    {"code-sink", {}},
+    {"combine-access-chains", {}},
+    {"convert-local-access-chains", {}},
+    {"copy-propagate-arrays", {}},
+    {"eliminate-dead-branches", {}},
+    {"eliminate-dead-code-aggressive", {}},
+    {"eliminate-dead-inserts", {}},
+    {"eliminate-local-multi-store", {}},
+    {"eliminate-local-single-block", {}},
+    {"eliminate-local-single-store", {}},
+    {"gvn-pre", {16, 32, 64, 128}},
+    {"if-conversion", {}},
+    {"inline-entry-points-exhaustive", {}},
+    {"jump-thread", {16, 64, 256}},
+    {"local-redundancy-elimination", {}},
+    {"loop-invariant-code-motion", {}},
+    {"loop-peeling", {}},
+    {"loop-peeling-threshold", {100, 500, 1000, 4000}},
+    {"loop-unroll-auto", {256, 1024, 4096}},
+    {"loop-unroll-partial", {2, 4, 8}},
+    {"merge-blocks", {}},
+    {"merge-return", {}},
+    {"private-to-local", {}},
+    {"redundancy-elimination", {}},
+    {"reduce-load-size", {}},
+    {"scalar-replacement", {10, 50, 100, 250}},
+    {"simplify-instructions", {}},
+    {"strength-reduction", {}},
+    {"switch-to-table", {}},
+    {"vector-dce", {}},
+};
+
+// Returns the tunable flag named |name|, or nullptr if there is none.
+const TunableFlag* FindTunableFlag(const std::string& name) {
+  for (const TunableFlag& flag : kTunableFlags) {
+    if (name == flag.name) return &flag;
+  }
+  return nullptr;
+}
+
+// Returns the number of values of |flag|.
+size_t CountValues(const TunableFlag& flag) {
+  size_t count = 0;
+  while (count < 4 && flag.values[count] != 0) ++count;
+  return count;
+}
+
+// Returns |flag| with a random value, if it takes one.
+std::string MakeFlag(const TunableFlag& flag, std::mt19937* rng) {
+  std::string result = std::string("--") + flag.name;
+  size_t num_values = CountValues(flag);
+  if (num_values != 0) {
+    result += "=" + std::to_string(flag.values[RandomIndex(num_values, rng)]);
+  }
+  return result;
+}
+
+}  // namespace
+
+size_t RandomIndex(size_t n, std::mt19937* rng) {
+  return std::uniform_int_distribution<size_t>(0, n - 1)(*rng);
+}
+
+bool IsTunableFlag(const std::string& flag) {
+  if (flag.compare(0, 2, "--") != 0) return false;
+  const size_t equal = flag.find('=');
+  const TunableFlag* tunable = FindTunableFlag(flag.substr(2, equal - 2));
+  if (tunable == nullptr) return false;
+  const size_t num_values = CountValues(*tunable);
+  if (equal == std::string::npos) return num_values == 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    if (flag.substr(equal + 1) == std::to_string(tunable->values[i]))
+      return true;
+  }
+  return false;
+}
+
+void Mutate(Recipe* recipe, std::mt19937* rng) {
+  switch (RandomIndex(4, rng)) {
+    case 1:
+      if (recipe->size() > 1) {
+        recipe->erase(recipe->begin() + RandomIndex(recipe->size(), rng));
+        return;
+      }
+      break;
+    case 2:
+      if (recipe->size() > 1) {
+        size_t i = RandomIndex(recipe->size() - 1, rng);
+        std::swap((*recipe)[i], (*recipe)[i + 1]);
+        return;
+      }
+      break;
+    case 3: {
+      std::vector<size_t> with_values;
+      for (size_t i = 0; i < recipe->size(); ++i) {
+        const std::string& flag = (*recipe)[i];
+        size_t equal = flag.find('=');
+        if (equal == std::string::npos) continue;
+        const TunableFlag* tunable = FindTunableFlag(flag.substr(2, equal - 2));
+        if (tunable != nullptr && CountValues(*tunable) > 1)
+          with_values.push_back(i);
+      }
+      if (!with_values.empty()) {
+        size_t i = with_values[RandomIndex(with_values.size(), rng)];
+        const std::string& flag = (*recipe)[i];
+        (*recipe)[i] = MakeFlag(
+            *FindTunableFlag(flag.substr(2, flag.find('=') - 2)), rng);
+        return;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  // Insert a flag, which is always possible below the length limit.
+  if (recipe->size() >= kMaxRecipeLength) return;
+  const size_t num_flags = sizeof(kTunableFlags) / sizeof(kTunableFlags[0]);
+  recipe->insert(recipe->begin() + RandomIndex(recipe->size() + 1, rng),
+                 MakeFlag(kTunableFlags[RandomIndex(num_flags, rng)], rng));
+}
+
+Recipe Crossover(const Recipe& first, const Recipe& second,
+                 std::mt19937* rng) {
+  size_t first_end = RandomIndex(first.size() + 1, rng);
+  size_t second_begin = RandomIndex(second.size() + 1, rng);
+  Recipe child(first.begin(), first.begin() + first_end);
+  child.insert(child.end(), second.begin() + second_begin, second.end());
+  if (child.empty()) child = first;
+  if (child.size() > kMaxRecipeLength) child.resize(kMaxRecipeLength);
+  return child;
+}
+
+}  // namespace tune
+}  // namespace spvtools
@@ -0,0 +1,52 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLS_TUNE_RECIPE_SEARCH_H_
+#define TOOLS_TUNE_RECIPE_SEARCH_H_
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace spvtools {
+namespace tune {
+
+// A sequence of spirv-opt flags, in the format of -Oconfig files.
+using Recipe = std::vector<std::string>;
+
+// The longest recipe the search builds.
+const size_t kMaxRecipeLength = 96;
+
+// Returns a random number in [0, |n|).
+size_t RandomIndex(size_t n, std::mt19937* rng);
+
+// Returns true if |flag| is one of the flags the search adds to recipes, with
+// one of its values if it takes one.
+bool IsTunableFlag(const std::string& flag);
+
+// Applies one random change to |recipe|: inserts a flag, removes one, swaps
+// two neighbors or changes the value of a flag.  Never removes the last flag
+// and never makes |recipe| longer than |kMaxRecipeLength|.
+void Mutate(Recipe* recipe, std::mt19937* rng);
+
+// Returns a recipe made of a prefix of |first| followed by a suffix of
+// |second|, or |first| itself if that recipe would be empty.  The result is
+// cut to |kMaxRecipeLength| flags.
+Recipe Crossover(const Recipe& first, const Recipe& second, std::mt19937* rng);
+
+}  // namespace tune
+}  // namespace spvtools
+
+#endif  // TOOLS_TUNE_RECIPE_SEARCH_H_
@@ -0,0 +1,539 @@
+// Copyright (c) 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "source/opt/build_module.h"
+#include "source/opt/cost_analysis.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/log.h"
+#include "source/opt/loop_peeling.h"
+#include "source/spirv_target_env.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/optimizer.hpp"
+#include "tools/io.h"
+#include "tools/tune/recipe_search.h"
+#include "tools/util/cli_consumer.h"
+
+namespace {
+
+using spvtools::tune::Crossover;
+using spvtools::tune::Mutate;
+using spvtools::tune::RandomIndex;
+using spvtools::tune::Recipe;
+
+const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_3;
+
+// The number of candidates compared to select a parent in the genetic search,
+// and the number of the best candidates kept unchanged in each generation.
+const size_t kTournamentSize = 3;
+const size_t kEliteCount = 2;
+
+enum class Objective { kCycles, kInstructions, kSize };
+
+enum class Search { kGenetic, kGreedy };
+
+struct Candidate {
+  Recipe recipe;
+  double score;
+};
+
+// A module of the corpus, and the value of the objective before it is
+// optimized.
+struct CorpusModule {
+  std::string file_name;
+  std::vector<uint32_t> binary;
+  double baseline;
+};
+
+void PrintUsage(const char* program) {
+  // NOTE: Please maintain flags in lexicographical order.
+  printf(
+      R"(%s - Search for the spirv-opt recipe that best optimizes a corpus of
+SPIR-V modules, and write it as an -Oconfig file.
+
+USAGE: %s [options] <input> [<input> ...]
+
+The search starts from the -O recipe, or from the -Os recipe when it
+optimizes for size, and changes it by inserting, removing and reordering
+passes, and by changing their arguments.  Each candidate recipe is run on
+every module of the corpus, in parallel.  Its score is the mean, over the
+modules, of the objective after optimization divided by the objective before
+it, plus the time the optimizer takes if --time-weight is given.  Candidates
+that fail to optimize a module, or produce an invalid one, are discarded.
+
+The best recipe is written to the output, one flag per line, for use with
+spirv-opt -Oconfig=<file>.
+
+Options (in lexicographical order):
+  --cost-table=<file>
+               Read the cost of opcodes used by the cycles objective from
+               <file>, in the format accepted by spirv-cost.
+  --generations=<n>
+               Stop after <n> generations of candidates.  Defaults to 20.
+  -h, --help
+               Print this help.
+  --jobs=<n>
+               Optimize up to <n> modules at the same time.  Defaults to the
+               number of hardware threads.
+  -o <file>
+               Write the best recipe to <file> instead of standard output.
+  --objective=<objective>
+               What the recipe minimizes.  <objective> is one of:
+                 cycles        the cycles of the entry points estimated by
+                               the spirv-cost model (the default)
+                 instructions  the number of instructions
+                 size          the number of words of the binary
+  --population=<n>
+               The number of candidates in each generation.  Defaults to 16.
+  --search=<strategy>
+               How candidates are generated.  <strategy> is one of:
+                 genetic  each generation crosses over and mutates the best
+                          candidates of the previous one (the default)
+                 greedy   each generation mutates the best candidate so far
+  --seed=<n>
+               The seed of the random choices of the search.  Defaults to 1,
+               so that runs can be reproduced.
+  --start=<file>
+               Start from the recipe in the -Oconfig file <file>.
+  --target-env=<env>
+               Set the target environment. Without this flag the target
+               enviroment defaults to spv1.3.
+               <env> must be one of vulkan1.0, vulkan1.1, opencl2.2, spv1.0,
+               spv1.1, spv1.2, spv1.3, or webgpu0.
+  --time-weight=<w>
+               Add <w> to the score for each millisecond the optimizer takes
+               on average per module.  Defaults to 0.
+  --version
+               Display version information.
+)",
+      program, program);
+}
+
+// Reads the whole file named |filename| into |text|.  Returns false and
+// reports the error if it cannot be read.
+bool ReadTextFile(const char* filename, std::string* text) {
+  std::ifstream input_file(filename);
+  if (input_file.fail()) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Could not open file '%s'", filename);
+    return false;
+  }
+  std::stringstream contents;
+  contents << input_file.rdbuf();
+  *text = contents.str();
+  return true;
+}
+
+// Parses the positive integer value of the flag |arg| of the form
+// '--flag=VALUE' into |value|.  Returns false and reports the error if it is
+// not a positive integer.
+bool ParseUintFlag(const char* arg, uint32_t* value) {
+  const char* str = strchr(arg, '=') + 1;
+  char* end = nullptr;
+  long parsed = strtol(str, &end, 10);
+  if (end == str || *end != '\0' || parsed <= 0) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Invalid argument for %s", arg);
+    return false;
+  }
+  *value = static_cast<uint32_t>(parsed);
+  return true;
+}
+
+// Runs candidate recipes on a corpus and scores them.
+class Evaluator {
+ public:
+  Evaluator(spv_target_env env, Objective objective,
+            const spvtools::opt::CostTable& cost_table, uint32_t jobs,
+            double time_weight)
+      : env_(env),
+        objective_(objective),
+        cost_table_(cost_table),
+        jobs_(jobs),
+        time_weight_(time_weight),
+        peeling_threshold_(
+            spvtools::opt::LoopPeelingPass::GetLoopPeelingThreshold()) {}
+
+  // Reads and validates the module in |file_name| and adds it to the corpus.
+  // Returns false and reports the error if it cannot be read or is invalid.
+  bool AddModule(const char* file_name);
+
+  // Returns the score of |recipe| on the corpus, or infinity if it fails on
+  // one of its modules.  Lower is better.
+  double Evaluate(const Recipe& recipe);
+
+ private:
+  // Returns the value of the objective for |binary|, or a negative value if
+  // it cannot be computed.
+  double Measure(const std::vector<uint32_t>& binary) const;
+
+  spv_target_env env_;
+  Objective objective_;
+  spvtools::opt::CostTable cost_table_;
+  uint32_t jobs_;
+  double time_weight_;
+  // The loop peeling threshold is global, so every recipe sets it, to keep a
+  // previous recipe from changing it.
+  size_t peeling_threshold_;
+
+  std::vector<CorpusModule> corpus_;
+  // The score of the recipes already evaluated, by their flags.
+  std::map<Recipe, double> scores_;
+};
+
+bool Evaluator::AddModule(const char* file_name) {
+  CorpusModule module;
+  module.file_name = file_name;
+  if (!ReadFile<uint32_t>(file_name, "rb", &module.binary)) return false;
+
+  spvtools::SpirvTools tools(env_);
+  tools.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
+  if (!tools.Validate(module.binary)) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Module '%s' is not valid", file_name);
+    return false;
+  }
+  module.baseline = Measure(module.binary);
+  if (module.baseline < 0) {
+    spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                     "Could not measure module '%s'", file_name);
+    return false;
+  }
+  corpus_.push_back(std::move(module));
+  return true;
+}
+
+double Evaluator::Measure(const std::vector<uint32_t>& binary) const {
+  if (objective_ == Objective::kSize) return static_cast<double>(binary.size());
+
+  std::unique_ptr<spvtools::opt::IRContext> context =
+      spvtools::BuildModule(env_, nullptr, binary.data(), binary.size());
+  if (context == nullptr) return -1;
+  if (objective_ == Objective::kInstructions) {
+    double count = 0;
+    context->module()->ForEachInst(
+        [&count](const spvtools::opt::Instruction*) { ++count; });
+    return count;
+  }
+  double cycles = 0;
+  spvtools::opt::CostAnalysis analysis(context.get(), cost_table_);
+  for (const spvtools::opt::EntryPointCost& cost :
+       analysis.EstimateEntryPoints()) {
+    cycles += cost.cycles;
+  }
+  return cycles;
+}
+
+double Evaluator::Evaluate(const Recipe& recipe) {
+  auto it = scores_.find(recipe);
+  if (it != scores_.end()) return it->second;
+  const double kInvalid = std::numeric_limits<double>::infinity();
+
+  // The flags are registered here rather than in the worker threads, as some
+  // of them set global state.
+  std::vector<std::string> flags = {"--loop-peeling-threshold=" +
+                                    std::to_string(peeling_threshold_)};
+  flags.insert(flags.end(), recipe.begin(), recipe.end());
+  std::vector<std::unique_ptr<spvtools::Optimizer>> optimizers;
+  for (size_t i = 0; i < corpus_.size(); ++i) {
+    optimizers.emplace_back(new spvtools::Optimizer(env_));
+    if (!optimizers.back()->RegisterPassesFromFlags(flags)) {
+      scores_[recipe] = kInvalid;
+      return kInvalid;
+    }
+  }
+
+  std::vector<double> ratios(corpus_.size(), -1);
+  std::vector<double> milliseconds(corpus_.size(), 0);
+  std::atomic<size_t> next_module(0);
+  auto work = [this, &optimizers, &ratios, &milliseconds, &next_module]() {
+    spvtools::OptimizerOptions options;
+    // The corpus has been validated when it was read.
+    options.set_run_validator(false);
+    spvtools::SpirvTools tools(env_);
+    for (size_t i = next_module++; i < corpus_.size(); i = next_module++) {
+      const CorpusModule& module = corpus_[i];
+      std::vector<uint32_t> optimized;
+      auto start = std::chrono::steady_clock::now();
+      bool ok = optimizers[i]->Run(module.binary.data(), module.binary.size(),
+                                   &optimized, options);
+      milliseconds[i] = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+      if (!ok || !tools.Validate(optimized)) continue;
+      double value = Measure(optimized);
+      if (value >= 0) ratios[i] = value / std::max(module.baseline, 1.0);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (uint32_t i = 1; i < std::min<size_t>(jobs_, corpus_.size()); ++i)
+    workers.emplace_back(work);
+  work();
+  for (std::thread& worker : workers) worker.join();
+
+  double score = 0;
+  for (size_t i = 0; i < corpus_.size(); ++i) {
+    if (ratios[i] < 0) {
+      scores_[recipe] = kInvalid;
+      return kInvalid;
+    }
+    score += ratios[i] + time_weight_ * milliseconds[i];
+  }
+  score /= corpus_.size();
+  scores_[recipe] = score;
+  return score;
+}
+
+// Returns the best of |kTournamentSize| random candidates of |population|.
+const Candidate& SelectParent(const std::vector<Candidate>& population,
+                              std::mt19937* rng) {
+  const Candidate* best = &population[RandomIndex(population.size(), rng)];
+  for (size_t i = 1; i < kTournamentSize; ++i) {
+    const Candidate& other = population[RandomIndex(population.size(), rng)];
+    if (other.score < best->score) best = &other;
+  }
+  return *best;
+}
+
+// Returns |recipe| changed by 1 to 3 random mutations.
+Recipe MakeMutant(const Recipe& recipe, std::mt19937* rng) {
+  Recipe mutant = recipe;
+  for (size_t i = RandomIndex(3, rng); i < 3; ++i) Mutate(&mutant, rng);
+  return mutant;
+}
+
+// Searches for the recipe with the lowest score, starting from |start|, and
+// returns it.
+Candidate Tune(const Recipe& start, Search search, uint32_t generations,
+               uint32_t population_size, uint32_t seed, Evaluator* evaluator) {
+  std::mt19937 rng(seed);
+  Candidate best = {start, evaluator->Evaluate(start)};
+  fprintf(stderr, "Initial recipe: score %.4f, %zu flags\n", best.score,
+          best.recipe.size());
+
+  std::vector<Candidate> population = {best};
+  while (population.size() < population_size) {
+    Recipe mutant = MakeMutant(start, &rng);
+    population.push_back({mutant, evaluator->Evaluate(mutant)});
+    if (population.back().score < best.score) best = population.back();
+  }
+
+  for (uint32_t generation = 1; generation <= generations; ++generation) {
+    std::vector<Candidate> next;
+    if (search == Search::kGreedy) {
+      next.push_back(best);
+      while (next.size() < population_size) {
+        Recipe mutant = MakeMutant(best.recipe, &rng);
+        next.push_back({mutant, evaluator->Evaluate(mutant)});
+      }
+    } else {
+      std::stable_sort(population.begin(), population.end(),
+                       [](const Candidate& a, const Candidate& b) {
+                         return a.score < b.score;
+                       });
+      for (size_t i = 0; i < kEliteCount && i < population.size(); ++i)
+        next.push_back(population[i]);
+      while (next.size() < population_size) {
+        Recipe child = Crossover(SelectParent(population, &rng).recipe,
+                                 SelectParent(population, &rng).recipe, &rng);
+        Mutate(&child, &rng);
+        next.push_back({child, evaluator->Evaluate(child)});
+      }
+    }
+    population = std::move(next);
+    for (const Candidate& candidate : population) {
+      if (candidate.score < best.score) best = candidate;
+    }
+    fprintf(stderr, "Generation %u: best score %.4f, %zu flags\n", generation,
+            best.score, best.recipe.size());
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  std::vector<const char*> in_files;
+  const char* out_file = nullptr;
+  const char* start_file = nullptr;
+  spv_target_env target_env = kDefaultEnvironment;
+  spvtools::opt::CostTable cost_table;
+  Objective objective = Objective::kCycles;
+  Search search = Search::kGenetic;
+  uint32_t generations = 20;
+  uint32_t population = 16;
+  uint32_t seed = 1;
+  uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  double time_weight = 0;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--version")) {
+      printf("%s\n", spvSoftwareVersionDetailsString());
+      return 0;
+    } else if (0 == strcmp(cur_arg, "-o")) {
+      if (argi + 1 >= argc) {
+        spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                        "Missing argument to -o");
+        return 1;
+      }
+      out_file = argv[++argi];
+    } else if (0 == strncmp(cur_arg, "--cost-table=", 13)) {
+      std::string text;
+      std::string error;
+      if (!ReadTextFile(cur_arg + 13, &text)) return 1;
+      if (!cost_table.ParseText(text, &error)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid cost table '%s': %s", cur_arg + 13,
+                         error.c_str());
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--generations=", 14)) {
+      if (!ParseUintFlag(cur_arg, &generations)) return 1;
+    } else if (0 == strncmp(cur_arg, "--jobs=", 7)) {
+      if (!ParseUintFlag(cur_arg, &jobs)) return 1;
+    } else if (0 == strncmp(cur_arg, "--objective=", 12)) {
+      const char* value = cur_arg + 12;
+      if (0 == strcmp(value, "cycles")) {
+        objective = Objective::kCycles;
+      } else if (0 == strcmp(value, "instructions")) {
+        objective = Objective::kInstructions;
+      } else if (0 == strcmp(value, "size")) {
+        objective = Objective::kSize;
+      } else {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid objective '%s'", value);
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--population=", 13)) {
+      if (!ParseUintFlag(cur_arg, &population)) return 1;
+    } else if (0 == strncmp(cur_arg, "--search=", 9)) {
+      const char* value = cur_arg + 9;
+      if (0 == strcmp(value, "genetic")) {
+        search = Search::kGenetic;
+      } else if (0 == strcmp(value, "greedy")) {
+        search = Search::kGreedy;
+      } else {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid search strategy '%s'", value);
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--seed=", 7)) {
+      if (!ParseUintFlag(cur_arg, &seed)) return 1;
+    } else if (0 == strncmp(cur_arg, "--start=", 8)) {
+      start_file = cur_arg + 8;
+    } else if (0 == strncmp(cur_arg, "--target-env=", 13)) {
+      if (!spvParseTargetEnv(cur_arg + 13, &target_env)) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid target environment '%s'", cur_arg + 13);
+        return 1;
+      }
+    } else if (0 == strncmp(cur_arg, "--time-weight=", 14)) {
+      char* end = nullptr;
+      time_weight = strtod(cur_arg + 14, &end);
+      if (end == cur_arg + 14 || *end != '\0' || time_weight < 0) {
+        spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                         "Invalid argument for %s", cur_arg);
+        return 1;
+      }
+    } else if ('-' == cur_arg[0]) {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "Unknown argument '%s'", cur_arg);
+      return 1;
+    } else {
+      in_files.push_back(cur_arg);
+    }
+  }
+
+  if (in_files.empty()) {
+    spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                    "No input files specified");
+    return 1;
+  }
+
+  Recipe start;
+  if (start_file != nullptr) {
+    std::string text;
+    if (!ReadTextFile(start_file, &text)) return 1;
+    std::istringstream flags(text);
+    std::string flag;
+    while (flags >> flag) start.push_back(flag);
+  } else {
+    spvtools::Optimizer optimizer(target_env);
+    if (objective == Objective::kSize) {
+      optimizer.RegisterSizePasses();
+    } else {
+      optimizer.RegisterPerformancePasses();
+    }
+    for (const char* name : optimizer.GetPassNames()) {
+      start.push_back(std::string("--") + name);
+    }
+  }
+  spvtools::Optimizer start_optimizer(target_env);
+  start_optimizer.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
+  if (start.empty() || !start_optimizer.RegisterPassesFromFlags(start)) {
+    spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                    "Invalid initial recipe");
+    return 1;
+  }
+
+  Evaluator evaluator(target_env, objective, cost_table, jobs, time_weight);
+  for (const char* in_file : in_files) {
+    if (!evaluator.AddModule(in_file)) return 1;
+  }
+
+  Candidate best =
+      Tune(start, search, generations, population, seed, &evaluator);
+  if (best.score == std::numeric_limits<double>::infinity()) {
+    spvtools::Error(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                    "No recipe optimizes every module of the corpus");
+    return 1;
+  }
+
+  std::ofstream out_stream;
+  if (out_file != nullptr) {
+    out_stream.open(out_file);
+    if (out_stream.fail()) {
+      spvtools::Errorf(spvtools::utils::CLIMessageConsumer, nullptr, {},
+                       "Could not open file '%s'", out_file);
+      return 1;
+    }
+  }
+  for (const std::string& flag : best.recipe) {
+    if (out_file != nullptr) {
+      out_stream << flag << "\n";
+    } else {
+      printf("%s\n", flag.c_str());
+    }
+  }
+  return 0;
+}
@@ -16,6 +16,7 @@
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "source/spirv_target_env.h"
@@ -60,6 +61,21 @@ Options:
   --relax-struct-store             Allow store from one struct type to a
                                    different type with compatible layout and
                                    members.
+  --rule-groups[=]<list>           {all|none|<group>[,<group>...]}
+                                   Check only the given groups of rules,
+                                   where <group> is one of decorations,
+                                   builtins, image, atomics or extensions.
+                                   The structural rules (ids, layout order,
+                                   CFG, type consistency) are always
+                                   checked. Defaults to "all".
+  --time-report                    Print the resource utilization of each
+                                   validation pass (e.g., CPU time, RSS
+                                   delta, number of calls) to standard error
+                                   output. Passes that run on each
+                                   instruction are aggregated across all
+                                   instructions, and the parsing phases are
+                                   reported separately. Only available on
+                                   systems supporting timers.
   --version                        Display validator version information.
   --target-env                     {vulkan1.0|vulkan1.1|opencl2.2|spv1.0|spv1.1|spv1.2|spv1.3|webgpu0}
                                    Use Vulkan 1.0, Vulkan 1.1, OpenCL 2.2, SPIR-V 1.0,
@@ -68,6 +84,41 @@ Options:
       argv0, argv0);
 }
 
+// Parses a comma separated list of rule group names into a bitwise OR of
+// spv_validator_rule_group values. Returns false if a name is not recognized.
+bool ParseRuleGroups(const char* str, uint32_t* groups) {
+  struct {
+    const char* name;
+    uint32_t group;
+  } kGroups[] = {{"all", spv_validator_rule_group_all},
+                 {"none", spv_validator_rule_group_none},
+                 {"decorations", spv_validator_rule_group_decorations},
+                 {"builtins", spv_validator_rule_group_builtins},
+                 {"image", spv_validator_rule_group_image},
+                 {"atomics", spv_validator_rule_group_atomics},
+                 {"extensions", spv_validator_rule_group_extensions}};
+
+  *groups = 0;
+  std::string list(str);
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) end = list.size();
+    const std::string name = list.substr(start, end - start);
+    bool found = false;
+    for (const auto& group : kGroups) {
+      if (name == group.name) {
+        *groups |= group.group;
+        found = true;
+        break;
+      }
+    }
+    if (!found) return false;
+    start = end + 1;
+  }
+  return true;
+}
+
 int main(int argc, char** argv) {
   const char* inFile = nullptr;
   spv_target_env target_env = SPV_ENV_UNIVERSAL_1_3;
@@ -140,6 +191,30 @@ int main(int argc, char** argv) {
         options.SetSkipBlockLayout(true);
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         options.SetRelaxStructStore(true);
+      } else if (0 == strcmp(cur_arg, "--rule-groups") ||
+                 0 == strncmp(cur_arg, "--rule-groups=", 14)) {
+        // The list is either joined to the flag by '=' or the next argument.
+        const char* groups_str = nullptr;
+        if (cur_arg[13] == '=') {
+          groups_str = cur_arg + 14;
+        } else if (argi + 1 < argc) {
+          groups_str = argv[++argi];
+        }
+        uint32_t groups = 0;
+        if (!groups_str) {
+          fprintf(stderr, "error: Missing argument to --rule-groups\n");
+          continue_processing = false;
+          return_code = 1;
+        } else if (!ParseRuleGroups(groups_str, &groups)) {
+          fprintf(stderr, "error: Unrecognized rule groups: %s\n",
+                  groups_str);
+          continue_processing = false;
+          return_code = 1;
+        } else {
+          options.SetRuleGroups(groups);
+        }
+      } else if (0 == strcmp(cur_arg, "--time-report")) {
+        options.SetTimeReport(&std::cerr);
       } else if (0 == cur_arg[1]) {
         // Setting a filename of "-" to indicate stdin.
         if (!inFile) {